@@ -0,0 +1,279 @@
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use,
+# copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following
+# conditions:
+#
+# This permission notice shall be included in all copies or
+# substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+# KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+# WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHOR(S) BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+# AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+# OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+""" Auditing serial tests for whether they can run concurrently
+
+Tests that aren't marked run_concurrent run one at a time.  An audit runs
+each of them on its own twice, to learn what it does when undisturbed, and
+then several times alongside randomly chosen concurrent tests.  A test whose
+status, subtests and (if it is deterministic) output never change, and that
+never changes those of the tests run alongside it, is safe.  When a round
+disagrees, the test is run again with each of that round's tests in turn to
+find the pairs that interfere.
+
+The verdicts are written to an audit file, with the fingerprint of each test
+audited (see framework.incremental).  Auditing again with the same file only
+revisits tests whose fingerprint changed, and piglit-run's --safe-tests
+option runs the tests the file calls safe concurrently.
+
+"""
+
+from __future__ import print_function
+import copy
+import os
+import random
+import multiprocessing.dummy
+try:
+    import simplejson as json
+except ImportError:
+    import json
+
+from framework.results import TestResult
+
+__all__ = ['Audit',
+           'SafeTests',
+           'load_audit',
+           'write_audit',
+           'SAFE',
+           'UNSAFE',
+           'UNSTABLE']
+
+AUDIT_VERSION = 1
+
+SAFE = 'safe'
+UNSAFE = 'unsafe'
+UNSTABLE = 'unstable'
+
+
+def load_audit(filename):
+    """ Return the contents of an audit file, or an empty audit if the file
+    doesn't exist
+    """
+    if not os.path.exists(filename):
+        return {'version': AUDIT_VERSION, 'tests': {}, 'interference': []}
+
+    with open(filename, 'r') as f:
+        audit = json.load(f)
+    if audit.get('version') != AUDIT_VERSION:
+        raise ValueError('{0} is not a version {1} audit file'.format(
+            filename, AUDIT_VERSION))
+    return audit
+
+
+def write_audit(filename, audit):
+    """ Write an audit file, replacing the old one only once it's complete """
+    with open(filename + '.tmp', 'w') as f:
+        json.dump(audit, f, indent=4, sort_keys=True)
+    os.rename(filename + '.tmp', filename)
+
+
+def _run(test):
+    """ Run a copy of test and return what it did """
+    test = copy.copy(test)
+    test.result = TestResult({'result': 'fail'})
+    test.run()
+    return {'result': str(test.result['result']),
+            'subtest': dict((k, str(v)) for k, v in
+                            test.result.get('subtest', {}).iteritems()),
+            'out': test.result.get('out', '') + test.result.get('err', '')}
+
+
+class Audit(object):
+    """ Audit the serial tests of a test list
+
+    Arguments:
+    tests -- a dictionary of test names to exectest.Test objects, as in
+             TestProfile.test_list
+    rounds -- how many times to run each test alongside others
+    load -- how many concurrent tests to run alongside it each time
+
+    Keyword Arguments:
+    fingerprint -- a callable returning a test's fingerprint, as
+                   incremental.Fingerprinter, or None to revisit every test
+    previous -- the contents of an earlier audit file, as from load_audit()
+    seed -- the seed for choosing which tests run alongside which
+    revisit_all -- If True audit every serial test, even unchanged ones
+
+    """
+    def __init__(self, tests, rounds, load, fingerprint=None, previous=None,
+                 seed=None, revisit_all=False):
+        self.tests = tests
+        self.rounds = rounds
+        self.load = load
+        self.fingerprint = fingerprint
+        self.previous = previous or {'tests': {}, 'interference': []}
+        self.random = random.Random(seed)
+        self.revisit_all = revisit_all
+        self.__isolated = {}
+
+    def candidates(self):
+        """ Return the names of the serial tests that need auditing
+
+        A test needs it unless the previous audit saw it with the same
+        fingerprint.
+
+        """
+        names = []
+        for name, test in sorted(self.tests.iteritems()):
+            if test.run_concurrent:
+                continue
+            record = self.previous['tests'].get(name)
+            if (self.revisit_all or self.fingerprint is None or
+                    record is None or
+                    record.get('fingerprint') != self.fingerprint(test)):
+                names.append(name)
+        return names
+
+    def isolated(self, name):
+        """ Return what a test does on its own
+
+        Returns the outcome of the first of two runs, whether the two runs
+        agree, and whether their output was the same.
+
+        """
+        if name not in self.__isolated:
+            first = _run(self.tests[name])
+            second = _run(self.tests[name])
+            self.__isolated[name] = (first,
+                                     self._agrees(first, second, False),
+                                     first['out'] == second['out'])
+        return self.__isolated[name]
+
+    @staticmethod
+    def _agrees(expected, outcome, compare_out):
+        """ Return whether outcome is the same as expected """
+        return (expected['result'] == outcome['result'] and
+                expected['subtest'] == outcome['subtest'] and
+                (not compare_out or expected['out'] == outcome['out']))
+
+    def _disturbed(self, names):
+        """ Run names all at once, and return those that behaved differently
+        from when run on their own
+        """
+        pool = multiprocessing.dummy.Pool(len(names))
+        outcomes = pool.map(_run, [self.tests[n] for n in names])
+        pool.close()
+        pool.join()
+
+        disturbed = []
+        for name, outcome in zip(names, outcomes):
+            # A test that is flaky on its own can't tell
+            expected, stable, deterministic = self.isolated(name)
+            if stable and not self._agrees(expected, outcome, deterministic):
+                disturbed.append(name)
+        return disturbed
+
+    def audit_test(self, name):
+        """ Audit a test
+
+        Returns the record for the audit file, and a list of the pairs
+        of tests found to interfere.
+
+        """
+        record = {'fingerprint': (self.fingerprint(self.tests[name])
+                                  if self.fingerprint else None),
+                  'rounds': 0}
+        interference = []
+
+        if not self.isolated(name)[1]:
+            # Flaky on its own, so the rounds couldn't tell anything
+            record['verdict'] = UNSTABLE
+            return record, interference
+
+        pool = sorted(n for n, t in self.tests.iteritems()
+                      if t.run_concurrent)
+        for _ in xrange(self.rounds):
+            load = self.random.sample(pool, min(self.load, len(pool)))
+            record['rounds'] += 1
+            if not self._disturbed([name] + load):
+                continue
+
+            # Find the culprits by running the test with each of the
+            # round's tests alone
+            for other in load:
+                for victim in self._disturbed([name, other]):
+                    interference.append({'test': name, 'with': other,
+                                         'affected': victim,
+                                         'confirmed': True})
+            if not interference:
+                # Only the round as a whole interferes
+                interference.extend({'test': name, 'with': other,
+                                     'affected': None, 'confirmed': False}
+                                    for other in load)
+            break
+
+        record['verdict'] = UNSAFE if interference else SAFE
+        return record, interference
+
+    def run(self, report=None):
+        """ Audit the candidates, and return the new contents of the audit
+        file
+
+        Records of tests that weren't revisited are kept, including those
+        of tests that the test list doesn't have, so that auditing part of
+        a profile doesn't forget about the rest.
+
+        Keyword Arguments:
+        report -- a callable given each test's name and record when it has
+                  been audited
+
+        """
+        names = self.candidates()
+        tests = dict((n, r) for n, r in self.previous['tests'].iteritems()
+                     if n not in names)
+        interference = [i for i in self.previous['interference']
+                        if i['test'] in tests]
+
+        for name in names:
+            record, pairs = self.audit_test(name)
+            tests[name] = record
+            interference.extend(pairs)
+            if report is not None:
+                report(name, record)
+
+        return {'version': AUDIT_VERSION, 'tests': tests,
+                'interference': interference}
+
+
+class SafeTests(object):
+    """ The tests an audit file calls safe to run concurrently
+
+    Arguments:
+    audit -- the contents of an audit file, as from load_audit()
+
+    """
+    def __init__(self, audit):
+        self.tests = dict((n, r.get('fingerprint')) for n, r
+                          in audit['tests'].iteritems()
+                          if r['verdict'] == SAFE)
+
+    def is_safe(self, name, fingerprint):
+        """ Return whether a test was audited safe
+
+        A test that changed since it was audited isn't safe any more.  If
+        the fingerprint of the test or of the audited test isn't known,
+        only the name counts.
+
+        """
+        if name not in self.tests:
+            return False
+        audited = self.tests[name]
+        return audited is None or fingerprint is None or audited == fingerprint
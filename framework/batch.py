@@ -0,0 +1,230 @@
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use,
+# copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following
+# conditions:
+#
+# This permission notice shall be included in all copies or
+# substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+# KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+# WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHOR(S) BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+# AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+# OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+""" Run a group of an external suite's tests in one invocation
+
+External conformance suites spend a long time initialising, so running them
+once per test is slow.  A BatchTest hands a whole list of subtests to the
+suite at once, through a list file, and splits the output back up into one
+result per subtest.  The results are stored as subtests of the batch: a run
+that batches 'suite/group' has one test of that name, with a subtest
+'test' for each of its tests, where a run without batches has a test
+'suite/group/test' for each.  Results of the two kinds of run don't compare
+with each other.
+
+A suite's list file format and the line that starts each of its subtests'
+output have to be checked against the suite's real output before it can use
+BatchTest.
+
+If the suite crashes or runs out of time the subtest it was running is
+marked as such, and the suite is started again on the subtests it didn't
+get to.
+
+"""
+
+import os
+import errno
+import signal
+import itertools
+import subprocess
+import tempfile
+import threading
+import abc
+
+import framework.status as status
+from framework.exectest import Test, Popen
+
+__all__ = ['BatchTest']
+
+
+class BatchTest(Test):
+    """ Abstract base class for running several subtests in one process
+
+    Subclasses provide the command line that runs a list file, the format
+    of that file, how to tell what a subtest's result is, and start_re, a
+    regular expression matching the line that starts each subtest's output
+    with the subtest's name in its 'name' group.  list_suffix is the suffix
+    of the list file, for suites that tell list files apart by it.
+
+    Arguments:
+    subtests -- the names of the subtests, in the order to run them
+
+    Keyword Arguments:
+    timeout -- seconds a single invocation of the suite may take, or None
+    run_concurrent -- If True the batch is thread safe. Default: False
+
+    """
+    __metaclass__ = abc.ABCMeta
+    start_re = None
+    list_suffix = ''
+
+    def __init__(self, subtests, timeout=None, run_concurrent=False):
+        # The command changes with each invocation, see batch_command()
+        super(BatchTest, self).__init__(['true'], run_concurrent)
+        self.subtests = list(subtests)
+        self.timeout = timeout
+
+    @abc.abstractmethod
+    def batch_command(self, listfile):
+        """ Return the command that runs the subtests listed in listfile """
+
+    @abc.abstractmethod
+    def write_list(self, f, subtests):
+        """ Write the names of subtests to the list file f """
+
+    def split_output(self, out):
+        """ Split the output of the suite into that of each subtest
+
+        Return a list of (subtest, output) pairs for the subtests that
+        started, in the order they ran.  A subtest's output starts at a
+        match of start_re, whose 'name' group is the subtest's name.
+
+        """
+        matches = [m for m in self.start_re.finditer(out)
+                   if m.group('name') in self.subtests]
+        return [(m.group('name'),
+                 out[m.start():matches[i + 1].start()
+                     if i + 1 < len(matches) else len(out)])
+                for i, m in enumerate(matches)]
+
+    @abc.abstractmethod
+    def interpret_subtest(self, out):
+        """ Return the status of a subtest that finished, given its output """
+
+    def interpret_result(self):
+        # Results are set for each subtest by run()
+        pass
+
+    def _invoke(self, subtests):
+        """ Run the suite on subtests
+
+        Return the output, the return code and whether the invocation
+        timed out.
+
+        """
+        fd, listfile = tempfile.mkstemp(prefix='piglit-batch-',
+                                         suffix=self.list_suffix)
+        try:
+            with os.fdopen(fd, 'w') as f:
+                self.write_list(f, subtests)
+
+            self.command = self.batch_command(listfile)
+            # The same environment Test gives a single test
+            env = dict()
+            for key, value in itertools.chain(os.environ.iteritems(),
+                                              self.OPTS.env.iteritems(),
+                                              self.env.iteritems()):
+                env[key] = str(value)
+
+            proc = Popen(self.command,
+                         stdout=subprocess.PIPE,
+                         stderr=subprocess.STDOUT,
+                         cwd=self.cwd,
+                         env=env,
+                         universal_newlines=True,
+                         preexec_fn=os.setsid)
+
+            # Kill the suite's whole process group, so that nothing it
+            # started keeps the output open
+            timed_out = threading.Event()
+            def kill():
+                timed_out.set()
+                try:
+                    os.killpg(proc.pid, signal.SIGKILL)
+                except OSError:
+                    pass
+
+            timer = None
+            if self.timeout:
+                timer = threading.Timer(self.timeout, kill)
+                timer.start()
+            out = proc.communicate()[0]
+            if timer is not None:
+                timer.cancel()
+            self.rusage = proc.rusage
+
+            return out, proc.returncode, timed_out.is_set()
+        finally:
+            os.remove(listfile)
+
+    def run(self):
+        """ Run the subtests, starting the suite again after crashes """
+        self.command = self.batch_command('<list file>')
+        self.result['command'] = ' '.join(self.command)
+        self.result['subtest'] = {}
+        self.result['out'] = ''
+        self.result['err'] = ''
+        self.result['returncode'] = 0
+        self.result['invocations'] = 0
+
+        remaining = self.subtests
+        while remaining:
+            try:
+                out, returncode, timed_out = self._invoke(remaining)
+            except OSError as e:
+                if e.errno != errno.ENOENT:
+                    raise
+                # The suite isn't installed
+                self.result['result'] = 'skip'
+                self.result['out'] = "Test executable not found.\n"
+                return
+
+            self.result['invocations'] += 1
+            self.result['out'] += out.decode('utf-8', 'replace')
+            if returncode != 0:
+                self.result['returncode'] = returncode
+
+            started = self.split_output(out)
+            for name, subtest_out in started[:-1]:
+                self.result['subtest'][name] = self.interpret_subtest(
+                    subtest_out)
+
+            if started:
+                name, subtest_out = started[-1]
+                if timed_out:
+                    self.result['subtest'][name] = 'timeout'
+                elif returncode < 0:
+                    self.result['subtest'][name] = 'crash'
+                else:
+                    self.result['subtest'][name] = self.interpret_subtest(
+                        subtest_out)
+
+            left = [s for s in remaining if s not in self.result['subtest']]
+            if len(left) == len(remaining) or not (timed_out or
+                                                   returncode < 0):
+                # The suite stopped without running the rest, or without
+                # getting anywhere; starting it again won't help.
+                remaining = left
+                break
+            remaining = left
+
+        for name in remaining:
+            if timed_out:
+                self.result['subtest'][name] = 'timeout'
+            elif returncode < 0:
+                self.result['subtest'][name] = 'crash'
+            else:
+                self.result['subtest'][name] = 'fail'
+
+        # The batch is as bad as its worst subtest that wasn't skipped
+        ran = [status.status_lookup(s) for s in
+               self.result['subtest'].itervalues() if s != 'skip']
+        self.result['result'] = str(max(ran, key=int)) if ran else 'skip'
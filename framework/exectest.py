@@ -42,6 +42,7 @@ from framework.results import TestResult
 
 __all__ = ['Test',
            'PiglitTest',
+           'Popen',
            'TEST_BIN_DIR']
 
 if 'PIGLIT_BUILD_DIR' in os.environ:
@@ -51,6 +52,32 @@ else:
                                                  '../bin'))
 
 
+class Popen(subprocess.Popen):
+    """ A subprocess.Popen that records the resource usage of the process
+
+    Once the process has been waited for, rusage is a dict of the user and
+    system CPU time in seconds and the maximum resident set size in
+    kilobytes, or None where os.wait4() is not available.
+
+    """
+    rusage = None
+
+    def wait(self):
+        if self.returncode is None and hasattr(os, 'wait4'):
+            while True:
+                try:
+                    _, sts, usage = os.wait4(self.pid, 0)
+                    break
+                except OSError as e:
+                    if e.errno != errno.EINTR:
+                        raise
+            self.rusage = {'utime': usage.ru_utime,
+                           'stime': usage.ru_stime,
+                           'maxrss': usage.ru_maxrss}
+            self._handle_exitstatus(sts)
+        return super(Popen, self).wait()
+
+
 class Test(object):
     """ Abstract base class for Test classes
 
@@ -73,7 +100,7 @@ class Test(object):
     OPTS = Options()
     __metaclass__ = abc.ABCMeta
     __slots__ = ['run_concurrent', 'env', 'result', 'cwd', '_command',
-                 '_test_hook_execute_run']
+                 '_test_hook_execute_run', 'rusage']
 
     def __init__(self, command, run_concurrent=False):
         self._command = None
@@ -82,16 +109,18 @@ class Test(object):
         self.env = {}
         self.result = TestResult({'result': 'fail'})
         self.cwd = None
+        self.rusage = None
 
         # This is a hook for doing some testing on execute right before
         # self.run is called.
         self._test_hook_execute_run = lambda: None
 
-    def execute(self, path, log, json_writer, dmesg):
+    def execute(self, path, log, json_writer, dmesg, reruns=None):
         """ Run a test
 
         Run a test, but with features. This times the test, uses dmesg checking
-        (if requested), and runs the logger.
+        (if requested), reruns it if its status changed (if requested), and
+        runs the logger.
 
         Arguments:
         path -- the name of the test
@@ -99,8 +128,11 @@ class Test(object):
         json_writer -- a results.JSONWriter instance
         dmesg -- a dmesg.BaseDmesg derived class
 
+        Keyword Arguments:
+        reruns -- a flaky.Reruns instance, or None to never rerun
+
         """
-        log_current = log.pre_log(path if self.OPTS.verbose else None)
+        log_current = log.pre_log(path)
 
         # Run the test
         if self.OPTS.execute:
@@ -111,6 +143,8 @@ class Test(object):
                 self.run()
                 self.result['time'] = time.time() - time_start
                 self.result = dmesg.update_result(self.result)
+                if reruns is not None:
+                    reruns.check(path, self)
             # This is a rare case where a bare exception is okay, since we're
             # using it to log exceptions
             except:
@@ -121,13 +155,29 @@ class Test(object):
                     traceback.format_tb(exception[2]))
 
             log.log(path, self.result['result'])
-            log.post_log(log_current, self.result['result'])
+            log.post_log(log_current, self.result['result'], self.rusage)
 
-            json_writer.write_dict_item(path, self.result)
+            json_writer.write_test(path, self.result)
         else:
             log.log(path, 'dry-run')
             log.post_log(log_current, 'dry-run')
 
+    def carry_forward(self, path, log, json_writer, result):
+        """ Record a result from an earlier run instead of running the test
+
+        Arguments:
+        path -- the name of the test
+        log -- a log.Log instance
+        json_writer -- a results.JSONWriter instance
+        result -- the results.TestResult to record
+
+        """
+        log_current = log.pre_log(path)
+        self.result = result
+        log.log(path, str(self.result['result']))
+        log.post_log(log_current, str(self.result['result']))
+        json_writer.write_test(path, self.result)
+
     @property
     def command(self):
         assert self._command
@@ -239,14 +289,15 @@ class Test(object):
             fullenv[key] = str(value)
 
         try:
-            proc = subprocess.Popen(self.command,
-                                    stdout=subprocess.PIPE,
-                                    stderr=subprocess.PIPE,
-                                    cwd=self.cwd,
-                                    env=fullenv,
-                                    universal_newlines=True)
+            proc = Popen(self.command,
+                         stdout=subprocess.PIPE,
+                         stderr=subprocess.PIPE,
+                         cwd=self.cwd,
+                         env=fullenv,
+                         universal_newlines=True)
             out, err = proc.communicate()
             returncode = proc.returncode
+            self.rusage = proc.rusage
         except OSError as e:
             # Different sets of tests get built under
             # different build configurations.  If
@@ -0,0 +1,135 @@
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use,
+# copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following
+# conditions:
+#
+# This permission notice shall be included in all copies or
+# substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+# KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+# WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHOR(S) BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+# AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+# OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+""" Rerunning tests that changed status to tell flakes from real changes
+
+When a test's status differs from its status in a baseline run, the test is
+run again, up to a fixed number of times.  If every attempt agrees the
+change is stable, and classified as a regression or a fix; if any attempt
+disagrees the test is flaky.  Every attempt is kept in the result under
+'attempts', and the verdict under 'classification'.
+
+"""
+
+import copy
+import time
+import multiprocessing.dummy
+
+import framework.status as status
+from framework.results import TestResult
+
+__all__ = ['Reruns',
+           'classify',
+           'STABLE_REGRESSION',
+           'STABLE_FIX',
+           'STABLE_CHANGE',
+           'FLAKY']
+
+STABLE_REGRESSION = 'stable-regression'
+STABLE_FIX = 'stable-fix'
+STABLE_CHANGE = 'stable-change'
+FLAKY = 'flaky'
+
+
+def classify(expected, statuses):
+    """ Classify a change of status
+
+    Arguments:
+    expected -- the status in the baseline
+    statuses -- the statuses of every attempt, first one first
+
+    """
+    statuses = [status.status_lookup(str(s)) for s in statuses]
+    expected = status.status_lookup(str(expected))
+    first = statuses[0]
+
+    if any(s != first for s in statuses[1:]):
+        return FLAKY
+    elif first > expected:
+        return STABLE_REGRESSION
+    elif first < expected:
+        return STABLE_FIX
+    return STABLE_CHANGE
+
+
+class Reruns(object):
+    """ Policy for rerunning tests whose status changed
+
+    Attempts at a test that is safe to run concurrently are made all at
+    once.  Otherwise they are made one after the other, stopping as soon
+    as one disagrees with the first run since the test is flaky then.
+
+    Arguments:
+    baseline -- a results.TestrunResult to compare statuses with
+    count -- the maximum number of times to rerun a test
+    concurrent -- False if attempts must never run in parallel
+
+    """
+    def __init__(self, baseline, count, concurrent=True):
+        self.tests = baseline.tests
+        self.count = count
+        self.concurrent = concurrent
+
+    @staticmethod
+    def _attempt(test):
+        """ Run a copy of test and return what happened """
+        test = copy.copy(test)
+        test.result = TestResult({'result': 'fail'})
+        time_start = time.time()
+        test.run()
+        return {'result': str(test.result['result']),
+                'time': time.time() - time_start,
+                'returncode': test.result.get('returncode')}
+
+    def check(self, path, test):
+        """ Rerun test if its status differs from the baseline's
+
+        Records the attempts and the classification in test.result.
+
+        Arguments:
+        path -- the name of the test
+        test -- an exectest.Test that has just been run
+
+        """
+        expected = self.tests.get(path)
+        if self.count <= 0 or expected is None:
+            return
+        if str(test.result['result']) == str(expected['result']):
+            return
+
+        attempts = [{'result': str(test.result['result']),
+                     'time': test.result.get('time'),
+                     'returncode': test.result.get('returncode')}]
+
+        if self.concurrent and test.run_concurrent and self.count > 1:
+            pool = multiprocessing.dummy.Pool(self.count)
+            attempts.extend(pool.map(self._attempt, [test] * self.count))
+            pool.close()
+            pool.join()
+        else:
+            for _ in xrange(self.count):
+                attempts.append(self._attempt(test))
+                if attempts[-1]['result'] != attempts[0]['result']:
+                    break
+
+        test.result['attempts'] = attempts
+        test.result['classification'] = classify(
+            expected['result'], [a['result'] for a in attempts])
@@ -24,6 +24,7 @@
 
 import os
 
+from .core import PIGLIT_CONFIG
 from .exectest import Test, TEST_BIN_DIR
 
 
@@ -34,6 +35,10 @@ class GleanTest(Test):
     This class descendes from exectest.Test, and provides methods for running
     glean tests.
 
+    If the 'jobs' option of the [glean] section of piglit.conf is set, glean
+    is asked to test up to that many visuals concurrently, each in its own
+    process.
+
     """
     GLOBAL_PARAMS = []
     _EXECUTABLE = os.path.join(TEST_BIN_DIR, "glean")
@@ -45,7 +50,10 @@ class GleanTest(Test):
 
     @Test.command.getter
     def command(self):
-        return super(GleanTest, self).command + self.GLOBAL_PARAMS
+        command = super(GleanTest, self).command + self.GLOBAL_PARAMS
+        if PIGLIT_CONFIG.has_option('glean', 'jobs'):
+            command = command + ['--jobs', PIGLIT_CONFIG.get('glean', 'jobs')]
+        return command
 
     def interpret_result(self):
         if self.result['returncode'] != 0 or 'FAIL' in self.result['out']:
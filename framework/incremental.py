@@ -0,0 +1,194 @@
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use,
+# copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following
+# conditions:
+#
+# This permission notice shall be included in all copies or
+# substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+# KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+# WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHOR(S) BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+# AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+# OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+""" Support for incremental runs
+
+Every test run records a fingerprint of each test: a hash of the files the
+test's command line names (the test binary, shader_test files, scripts...),
+the command line itself, the environment it runs in, piglit's own shared
+libraries and the identity of the GL driver.  An incremental run is given
+the results of an earlier run as its baseline, and copies forward the result
+of every test whose fingerprint is unchanged instead of running it again.
+
+"""
+
+from __future__ import print_function
+import copy
+import glob
+import hashlib
+import os
+import re
+import subprocess
+import threading
+from distutils.spawn import find_executable
+
+from framework.results import TestResult
+
+__all__ = ['Fingerprinter',
+           'Baseline',
+           'probe_driver']
+
+# Environment variables from outside of piglit that change what a test does
+ENV_PREFIXES = ('PIGLIT_', 'MESA_', 'LIBGL_', 'GALLIUM_', 'LP_', 'ST_',
+                'INTEL_', 'RADEON_', 'R600_', 'NOUVEAU_', 'vblank_mode')
+
+# Environment variables that differ between runs without changing results
+VOLATILE_ENV = frozenset(['PIGLIT_CONTEXT_CACHE', 'PIGLIT_REFERENCE_CACHE'])
+
+# The lines of wflinfo and glxinfo output that identify the driver
+_DRIVER_LINE = re.compile(
+    r'^OpenGL (vendor|renderer|version|core profile version) string:.*$',
+    re.MULTILINE)
+
+
+def probe_driver(platform):
+    """ Return a string identifying the GL driver, or None
+
+    Asks wflinfo for the vendor, renderer and version strings of the
+    driver, and falls back to glxinfo on GLX platforms.  For development
+    builds of Mesa the version string includes the git revision, so
+    rebuilding the driver changes its identity.
+
+    Arguments:
+    platform -- the platform passed to waffle, as in PIGLIT_PLATFORM
+
+    """
+    waffle_platform = 'glx' if platform == 'mixed_glx_egl' else platform
+    probes = [['wflinfo', '--platform', waffle_platform, '--api', 'gl']]
+    if waffle_platform == 'glx':
+        probes.append(['glxinfo'])
+
+    for command in probes:
+        try:
+            with open(os.devnull, 'w') as devnull:
+                output = subprocess.check_output(command, stderr=devnull)
+        except (OSError, subprocess.CalledProcessError):
+            continue
+
+        lines = [m.group(0).strip() for m in _DRIVER_LINE.finditer(output)]
+        if lines:
+            return '\n'.join(lines)
+
+    return None
+
+
+class Fingerprinter(object):
+    """ Compute the fingerprints of tests
+
+    Files are hashed once per run, the first time a test names them, so
+    tests sharing a binary only pay for reading it once.
+
+    Arguments:
+    driver -- a string identifying the driver, as from probe_driver()
+    lib_dir -- directory holding piglit's shared libraries, which every
+               test binary links against
+
+    """
+    def __init__(self, driver, lib_dir):
+        self.__digests = {}
+        self.__lock = threading.Lock()
+
+        base = hashlib.sha1()
+        base.update(driver)
+        for lib in sorted(glob.glob(os.path.join(lib_dir, '*'))):
+            if os.path.isfile(lib):
+                base.update('\0' + os.path.basename(lib) + '\0')
+                base.update(self._file_digest(lib))
+        self.__base = base.digest()
+
+    def _file_digest(self, filename):
+        """ Return the hash of the contents of filename, reading it once """
+        filename = os.path.realpath(filename)
+        with self.__lock:
+            digest = self.__digests.get(filename)
+        if digest is not None:
+            return digest
+
+        sha = hashlib.sha1()
+        with open(filename, 'rb') as f:
+            for block in iter(lambda: f.read(1 << 16), b''):
+                sha.update(block)
+        digest = sha.digest()
+
+        with self.__lock:
+            self.__digests[filename] = digest
+        return digest
+
+    def __call__(self, test):
+        """ Return the fingerprint of an exectest.Test as a hex string """
+        sha = hashlib.sha1(self.__base)
+        command = test.command
+        cwd = test.cwd or os.getcwd()
+
+        for i, arg in enumerate(command):
+            sha.update('\0arg\0' + arg)
+
+            filename = os.path.join(cwd, arg)
+            if not os.path.isfile(filename) and i == 0:
+                filename = find_executable(arg) or filename
+            if os.path.isfile(filename):
+                sha.update(self._file_digest(filename))
+
+        env = dict((k, v) for k, v in os.environ.iteritems()
+                   if k.startswith(ENV_PREFIXES))
+        env.update(test.OPTS.env)
+        env.update(test.env)
+        for key in sorted(env):
+            if key not in VOLATILE_ENV:
+                sha.update('\0env\0{0}={1}'.format(key, env[key]))
+
+        return sha.hexdigest()
+
+
+class Baseline(object):
+    """ The results of an earlier run to copy unchanged tests forward from
+
+    Arguments:
+    results -- a results.TestrunResult
+    force_rerun -- a list of regular expressions; tests whose names match
+                   any of them are run even if their fingerprint is
+                   unchanged
+
+    """
+    def __init__(self, results, force_rerun=None):
+        self.name = results.name
+        self.tests = results.tests
+        self.force_rerun = [re.compile(x) for x in force_rerun or []]
+
+    def lookup(self, name, fingerprint):
+        """ Return the result to carry forward for a test, or None
+
+        The returned result is a copy of the baseline's, with a
+        'carried_forward' key naming the run that actually produced it.
+
+        """
+        if fingerprint is None:
+            return None
+        if any(r.search(name) for r in self.force_rerun):
+            return None
+
+        result = self.tests.get(name)
+        if result is None or result.get('fingerprint') != fingerprint:
+            return None
+
+        result = copy.deepcopy(dict(result, result=str(result['result'])))
+        result.setdefault('carried_forward', self.name)
+        return TestResult(result)
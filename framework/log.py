@@ -20,8 +20,20 @@
 # IN THE SOFTWARE.
 #
 
+from __future__ import print_function
+import os
 import sys
+import stat
+import time
+import errno
+import fcntl
+import socket
+import threading
 import collections
+try:
+    import simplejson as json
+except ImportError:
+    import json
 from .threads import synchronized_self
 
 
@@ -30,10 +42,16 @@ class Log(object):
 
     Arguments:
     total -- The total number of tests to run.
+    verbose -- If True print a line before and after each test
+
+    Keyword Arguments:
+    events -- an EventStream to report the tests to as well, or None
 
     """
-    def __init__(self, total, verbose):
+    def __init__(self, total, verbose, events=None):
         self.__total = total
+        self.__verbose = verbose
+        self.__events = events
         self.__complete = 0
         self.__running = []
         self.__generator = (x for x in xrange(self.__total))
@@ -102,13 +120,16 @@ class Log(object):
                                                    'result': result}))
 
     @synchronized_self
-    def post_log(self, value, result):
+    def post_log(self, value, result, rusage=None):
         """ Used to mark a test as complete in the log
 
         Arguments:
         value -- the test number to mark complete
         result -- the result of the completed test
 
+        Keyword Arguments:
+        rusage -- the resource usage of the test's process, if known
+
         """
         # Mark running complete
         assert value in self.__running
@@ -120,6 +141,9 @@ class Log(object):
         assert result in self.__summary_keys
         self.__summary[result] += 1
 
+        if self.__events is not None:
+            self.__events.test_end(value, result, rusage)
+
     @synchronized_self
     def log(self, name, result):
         """ Print to the screen 
@@ -136,20 +160,187 @@ class Log(object):
         """ Hook to run before log()
         
         Returns a new number to know what processes are running, if running is
-        set it will print a running message for the test
+        set and the log is verbose it will print a running message for the
+        test
 
         Keyword Arguments:
-        running -- the name of a test to print is running. If Falsy then
+        running -- the name of the test that is starting. If Falsy then
                    nothing will be printed. Default: None
         
         """
-        if running:
+        if running and self.__verbose:
             self.__print(running, 'running')
 
         x = self.__generator.next()
         self.__running.append(x)
+
+        if self.__events is not None:
+            self.__events.test_start(x, running)
         return x
 
     def summary(self):
         self._write_output(self.__summary_output.format(**{'percent': self._percent(),
                                                            'summary': self._summary()}))
+        if self.__events is not None:
+            self.__events.close()
+
+
+class EventStream(object):
+    """ Report the progress of a run as JSON objects, one per line
+
+    The events are 'run-start', 'test-start', 'test-end' (with the result,
+    duration and resource usage of the test), 'progress' every interval
+    seconds (with the throughput, the number of busy workers, the number of
+    tests still queued, and an estimate of the time left) and 'run-end'.
+
+    The estimate uses the durations of the tests in an earlier run when
+    given, and the durations of the tests run so far otherwise; it's divided
+    by the number of tests that have been running at once on average.
+
+    If the stream can't be written to, for instance because the reader went
+    away, a warning is printed and no more events are sent.
+
+    Arguments:
+    sink -- the name of a file, FIFO or UNIX socket to write to.  A FIFO
+            must already have a reader.
+
+    Keyword Arguments:
+    durations -- a dict of test names to durations in seconds, or None
+    interval -- seconds between progress events, or 0 for none. Default: 5
+    append -- If True append to a file rather than replacing it
+
+    """
+    def __init__(self, sink, durations=None, interval=5, append=False):
+        self.__file = self.__open_sink(sink, append)
+        self.__durations = durations or {}
+        self.__interval = interval
+        self.__timer = None
+        self.__start = None
+        self.__total = 0
+        self.__started = 0
+        self.__complete = 0
+        self.__busy = 0.0
+        self.__running = {}
+        self.__remaining_known = 0.0
+        self.__remaining_unknown = 0
+        self.__default = None
+
+    @staticmethod
+    def __open_sink(sink, append):
+        """ Open sink for writing, whatever kind of file it is """
+        try:
+            mode = os.stat(sink).st_mode
+        except OSError:
+            mode = 0
+
+        if stat.S_ISSOCK(mode):
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            sock.connect(sink)
+            return sock.makefile('w')
+        elif stat.S_ISFIFO(mode):
+            # Opening a FIFO without a reader would block forever
+            fd = os.open(sink, os.O_WRONLY | os.O_NONBLOCK)
+            fcntl.fcntl(fd, fcntl.F_SETFL,
+                        fcntl.fcntl(fd, fcntl.F_GETFL) & ~os.O_NONBLOCK)
+            return os.fdopen(fd, 'w')
+        return open(sink, 'a' if append else 'w')
+
+    def __send(self, event, **kwargs):
+        """ Write an event """
+        if self.__file is None:
+            return
+        kwargs['event'] = event
+        kwargs['time'] = time.time()
+        try:
+            self.__file.write(json.dumps(kwargs) + '\n')
+            self.__file.flush()
+        except (IOError, socket.error) as e:
+            print("Warning: cannot write events, no more will be sent: "
+                  "{}".format(e), file=sys.stderr)
+            self.__file = None
+
+    def eta(self):
+        """ Return an estimate of the seconds left in the run, or None """
+        now = time.time()
+        elapsed = now - self.__start
+        running = sum(now - t for _, t in self.__running.itervalues())
+        busy = self.__busy + running
+
+        default = self.__default
+        if default is None and self.__complete:
+            default = self.__busy / self.__complete
+        if default is None and self.__remaining_unknown:
+            return None
+
+        left = max(0.0, self.__remaining_known +
+                   self.__remaining_unknown * (default or 0) - running)
+        if elapsed > 0 and busy > 0:
+            return left / max(1.0, busy / elapsed)
+        return left
+
+    @synchronized_self
+    def start(self, names):
+        """ Start the run of the tests in names """
+        self.__start = time.time()
+        self.__total = len(names)
+        known = [self.__durations[n] for n in names if n in self.__durations]
+        if known:
+            self.__default = sum(known) / len(known)
+        self.__remaining_known = sum(known)
+        self.__remaining_unknown = self.__total - len(known)
+        self.__send('run-start', total=self.__total, eta=self.eta())
+        self.__schedule()
+
+    def __schedule(self):
+        """ Arrange for the next progress event """
+        if self.__interval > 0:
+            self.__timer = threading.Timer(self.__interval, self.progress)
+            self.__timer.daemon = True
+            self.__timer.start()
+
+    @synchronized_self
+    def progress(self):
+        """ Send a progress event, and schedule the next one """
+        elapsed = time.time() - self.__start
+        self.__send('progress',
+                    complete=self.__complete,
+                    total=self.__total,
+                    tests_per_sec=self.__complete / elapsed if elapsed else 0,
+                    busy=len(self.__running),
+                    queued=self.__total - self.__started,
+                    eta=self.eta())
+        if self.__file is not None and self.__timer is not None:
+            self.__schedule()
+
+    @synchronized_self
+    def test_start(self, number, name):
+        """ Record that test number, called name, started """
+        self.__started += 1
+        self.__running[number] = (name, time.time())
+        self.__send('test-start', test=name)
+
+    @synchronized_self
+    def test_end(self, number, result, rusage=None):
+        """ Record that test number ended with result """
+        name, started = self.__running.pop(number)
+        duration = time.time() - started
+        self.__complete += 1
+        self.__busy += duration
+        if name in self.__durations:
+            self.__remaining_known -= self.__durations[name]
+        else:
+            self.__remaining_unknown -= 1
+        self.__send('test-end', test=name, result=str(result),
+                    duration=duration, rusage=rusage)
+
+    @synchronized_self
+    def close(self):
+        """ End the run """
+        if self.__timer is not None:
+            self.__timer.cancel()
+            self.__timer = None
+        self.__send('run-end', complete=self.__complete, total=self.__total,
+                    duration=time.time() - self.__start)
+        if self.__file is not None:
+            self.__file.close()
+            self.__file = None
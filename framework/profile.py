@@ -71,6 +71,19 @@ class TestProfile(object):
         self._dmesg = None
         self.dmesg = False
         self.results_dir = None
+        # Set by piglit-run to record fingerprints and to carry unchanged
+        # tests forward from a baseline, see framework.incremental
+        self.fingerprint = None
+        self.baseline = None
+        # Set by piglit-run to rerun tests whose status changed, see
+        # framework.flaky
+        self.reruns = None
+        # Set by piglit-run to report progress as a stream of events, see
+        # framework.log.EventStream
+        self.events = None
+        # Set by piglit-run to run serial tests that a concurrency audit
+        # found safe concurrently, see framework.audit.SafeTests
+        self.safe_tests = None
 
     @property
     def dmesg(self):
@@ -192,7 +205,15 @@ class TestProfile(object):
         chunksize = 1
 
         self._prepare_test_list(opts)
-        log = Log(len(self.test_list), opts.verbose)
+        if self.safe_tests is not None:
+            for name, test in self.test_list.iteritems():
+                if not test.run_concurrent and self.safe_tests.is_safe(
+                        name, self.fingerprint(test) if self.fingerprint
+                        else None):
+                    test.run_concurrent = True
+        if self.events is not None:
+            self.events.start(self.test_list.keys())
+        log = Log(len(self.test_list), opts.verbose, self.events)
 
         def test(pair):
             """ Function to call test.execute from .map
@@ -201,7 +222,15 @@ class TestProfile(object):
 
             """
             name, test = pair
-            test.execute(name, log, json_writer, self.dmesg)
+            if self.fingerprint is not None:
+                fingerprint = self.fingerprint(test)
+                if self.baseline is not None:
+                    result = self.baseline.lookup(name, fingerprint)
+                    if result is not None:
+                        test.carry_forward(name, log, json_writer, result)
+                        return
+                test.result['fingerprint'] = fingerprint
+            test.execute(name, log, json_writer, self.dmesg, self.reruns)
 
         def run_threads(pool, testlist):
             """ Open a pool, close it, and join it """
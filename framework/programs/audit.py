@@ -0,0 +1,136 @@
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without
+# restriction, including without limitation the rights to use,
+# copy, modify, merge, publish, distribute, sublicense, and/or
+# sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following
+# conditions:
+#
+# This permission notice shall be included in all copies or
+# substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+# KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+# WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+# PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHOR(S) BE
+# LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+# AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+# OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+
+from __future__ import print_function
+import argparse
+import multiprocessing
+import os
+import os.path as path
+import sys
+
+import framework.core as core
+import framework.profile
+import framework.exectest
+import framework.audit
+from framework.programs.run import _setup_incremental
+
+__all__ = ['audit']
+
+
+def audit(input_):
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-t", "--include-tests",
+                        default=[],
+                        action="append",
+                        metavar="<regex>",
+                        help="Audit only matching tests "
+                             "(can be used more than once)")
+    parser.add_argument("-x", "--exclude-tests",
+                        default=[],
+                        action="append",
+                        metavar="<regex>",
+                        help="Exclude matching tests "
+                             "(can be used more than once)")
+    parser.add_argument("-p", "--platform",
+                        choices=["glx", "x11_egl", "wayland", "gbm",
+                                 "surfaceless_egl", "mixed_glx_egl"],
+                        default=os.environ.get("PIGLIT_PLATFORM",
+                                               "mixed_glx_egl"),
+                        help="Name of windows system passed to waffle")
+    parser.add_argument("-f", "--config",
+                        dest="config_file",
+                        type=argparse.FileType("r"),
+                        help="Optionally specify a piglit config file to use. "
+                             "Default is piglit.conf")
+    parser.add_argument("-r", "--rounds",
+                        type=int,
+                        default=5,
+                        metavar="<count>",
+                        help="How many times to run each serial test "
+                             "alongside concurrent ones. Default: 5")
+    parser.add_argument("-l", "--load",
+                        type=int,
+                        default=multiprocessing.cpu_count(),
+                        metavar="<count>",
+                        help="How many concurrent tests to run alongside it. "
+                             "Default: the number of CPUs")
+    parser.add_argument("-s", "--seed",
+                        type=int,
+                        metavar="<seed>",
+                        help="Seed for choosing the concurrent tests, to "
+                             "repeat an audit")
+    parser.add_argument("--all",
+                        action="store_true",
+                        help="Revisit every serial test, not only those that "
+                             "changed since the audit file was written")
+    parser.add_argument("test_profile",
+                        metavar="<Path to one or more test profile(s)>",
+                        nargs='+',
+                        help="Path to testfile to audit")
+    parser.add_argument("audit_file",
+                        type=path.realpath,
+                        metavar="<Audit File>",
+                        help="The audit file to update, for piglit run's "
+                             "--safe-tests")
+    args = parser.parse_args(input_)
+
+    core.get_config(args.config_file)
+
+    opts = core.Options(exclude_filter=args.exclude_tests,
+                        include_filter=args.include_tests)
+    opts.env['PIGLIT_PLATFORM'] = args.platform
+    framework.exectest.Test.OPTS = opts
+
+    piglit_dir = path.dirname(path.realpath(sys.argv[0]))
+    os.chdir(piglit_dir)
+
+    profile = framework.profile.merge_test_profiles(args.test_profile)
+    profile._prepare_test_list(opts)
+    _setup_incremental(profile, args.platform, None, [])
+
+    auditor = framework.audit.Audit(profile.test_list, args.rounds, args.load,
+                                    fingerprint=profile.fingerprint,
+                                    previous=framework.audit.load_audit(
+                                        args.audit_file),
+                                    seed=args.seed, revisit_all=args.all)
+
+    def report(name, record):
+        print("{0}: {1}".format(name, record['verdict']))
+        sys.stdout.flush()
+
+    result = auditor.run(report)
+    framework.audit.write_audit(args.audit_file, result)
+
+    for pair in result['interference']:
+        if pair['confirmed']:
+            print("interference: {0} with {1} changes {2}".format(
+                pair['test'], pair['with'], pair['affected']))
+        else:
+            print("interference: {0} with {1} and others".format(
+                pair['test'], pair['with']))
+
+    verdicts = [r['verdict'] for r in result['tests'].itervalues()]
+    print("Audited {0} serial tests: {1} safe, {2} unsafe, {3} unstable\n"
+          "The audit has been written to {4}".format(
+              len(verdicts), verdicts.count(framework.audit.SAFE),
+              verdicts.count(framework.audit.UNSAFE),
+              verdicts.count(framework.audit.UNSTABLE), args.audit_file))
@@ -30,11 +30,69 @@ import time
 import framework.core as core
 import framework.results
 import framework.profile
+import framework.exectest
+import framework.incremental
+import framework.flaky
+import framework.log
+import framework.audit
 
 __all__ = ['run',
            'resume']
 
 
+def _setup_incremental(profile, platform, baseline, force_rerun):
+    """ Record fingerprints, and carry tests forward from a baseline
+
+    Arguments:
+    profile -- the TestProfile to run
+    platform -- the platform passed to waffle
+    baseline -- a results.TestrunResult to carry tests forward from, or None
+    force_rerun -- regular expressions of tests never to carry forward
+
+    """
+    driver = framework.incremental.probe_driver(platform)
+    if driver is None:
+        # Without knowing the driver a fingerprint can't tell that it
+        # changed, so record no fingerprints rather than wrong ones.
+        print("Warning: Could not identify the GL driver with wflinfo or "
+              "glxinfo, tests will not be fingerprinted", file=sys.stderr)
+        if baseline is not None:
+            print("Warning: Running all tests instead of only changed ones",
+                  file=sys.stderr)
+        return
+
+    profile.fingerprint = framework.incremental.Fingerprinter(
+        driver, path.join(framework.exectest.TEST_BIN_DIR, '..', 'lib'))
+    if baseline is not None:
+        profile.baseline = framework.incremental.Baseline(baseline,
+                                                          force_rerun)
+
+
+def _setup_events(profile, sink, baseline, append=False):
+    """ Report progress as a stream of events
+
+    Arguments:
+    profile -- the TestProfile to run
+    sink -- the file, FIFO or UNIX socket to write events to
+    baseline -- a results.TestrunResult with the durations to estimate the
+                time left from, or None
+
+    Keyword Arguments:
+    append -- If True append to a file rather than replacing it
+
+    """
+    durations = {}
+    if baseline is not None:
+        durations = dict((name, result['time']) for name, result
+                         in baseline.tests.iteritems() if 'time' in result)
+    try:
+        profile.events = framework.log.EventStream(sink, durations,
+                                                   append=append)
+    except (IOError, OSError) as e:
+        print("Warning: Could not open {} for events: {}".format(sink, e),
+              file=sys.stderr)
+
+
 def run(input_):
     parser = argparse.ArgumentParser()
     parser.add_argument("-n", "--name",
@@ -72,7 +130,7 @@ def run(input_):
                              help="Disable concurrent test runs")
     parser.add_argument("-p", "--platform",
                         choices=["glx", "x11_egl", "wayland", "gbm",
-                                 "mixed_glx_egl"],
+                                 "surfaceless_egl", "mixed_glx_egl"],
                         # If an explicit choice isn't made check the
                         # environment, and if that fails select the glx/x11_egl
                         # mixed profile
@@ -95,6 +153,46 @@ def run(input_):
                         action="store_true",
                         help="Produce a line of output for each test before "
                              "and after it runs")
+    parser.add_argument("-i", "--incremental",
+                        type=path.realpath,
+                        metavar="<Baseline Path>",
+                        help="Only run tests that changed since the given "
+                             "results, and copy the results of the others "
+                             "forward")
+    parser.add_argument("--force-rerun",
+                        default=[],
+                        action="append",
+                        metavar="<regex>",
+                        help="With --incremental, run matching tests even if "
+                             "they are unchanged (can be used more than once)")
+    parser.add_argument("--reruns",
+                        type=int,
+                        default=0,
+                        metavar="<count>",
+                        help="Rerun tests whose status differs from the "
+                             "baseline up to this many times, to tell flaky "
+                             "tests from real changes")
+    parser.add_argument("-b", "--baseline",
+                        type=path.realpath,
+                        metavar="<Baseline Path>",
+                        help="Results to compare statuses with for --reruns, "
+                             "and to estimate the time left from. "
+                             "Default: the --incremental baseline")
+    parser.add_argument("--events",
+                        type=path.realpath,
+                        metavar="<File, FIFO or socket>",
+                        help="Write a JSON object for each test started and "
+                             "finished, and for the progress of the run, "
+                             "one per line")
+    parser.add_argument("--safe-tests",
+                        type=path.realpath,
+                        metavar="<Audit File>",
+                        help="Also run concurrently the serial tests that "
+                             "'piglit audit' found safe to")
+    parser.add_argument("-z", "--compression",
+                        choices=sorted(framework.results.COMPRESSION),
+                        default="none",
+                        help="Compress the results file")
     parser.add_argument("test_profile",
                         metavar="<Path to one or more test profile(s)>",
                         nargs='+',
@@ -131,6 +229,19 @@ def run(input_):
     # Read the config file
     core.get_config(args.config_file)
 
+    # Load the baseline before the results file is opened, they may be the
+    # same file
+    baseline = None
+    if args.incremental:
+        baseline = framework.results.load_results(args.incremental)
+    if args.reruns > 0 and not args.baseline:
+        args.baseline = args.incremental
+    if args.reruns > 0 and not args.baseline:
+        parser.error("--reruns needs -b/--baseline or -i/--incremental")
+    rerun_baseline = None
+    if args.reruns > 0 or (args.events and args.baseline):
+        rerun_baseline = framework.results.load_results(args.baseline)
+
     # Pass arguments into Options
     opts = core.Options(concurrent=args.concurrency,
                         exclude_filter=args.exclude_tests,
@@ -143,10 +254,22 @@ def run(input_):
     # Set the platform to pass to waffle
     opts.env['PIGLIT_PLATFORM'] = args.platform
 
+    # Let test processes share which GL context flavor they ended up with,
+    # and the reference images they rendered.  The context cache is kept
+    # per run on purpose: its keys name the display and how the driver is
+    # selected, but not the driver's version, so a cache that outlived
+    # the run could keep a driver that has since gained core profile
+    # support on compatibility contexts.
+    opts.env['PIGLIT_CONTEXT_CACHE'] = path.join(
+        path.abspath(args.results_path), 'context-cache')
+    opts.env['PIGLIT_REFERENCE_CACHE'] = path.join(
+        path.abspath(args.results_path), 'reference-cache')
+
     # Change working directory to the root of the piglit directory
     piglit_dir = path.dirname(path.realpath(sys.argv[0]))
     os.chdir(piglit_dir)
     core.checkDir(args.results_path, False)
+    core.checkDir(opts.env['PIGLIT_REFERENCE_CACHE'], False)
 
     results = framework.results.TestrunResult()
 
@@ -156,9 +279,17 @@ def run(input_):
     else:
         results.name = path.basename(args.results_path)
 
-    # Begin json.
-    result_filepath = path.join(args.results_path, 'results.json')
-    result_file = open(result_filepath, 'w')
+    # Begin json.  Remove results files left by earlier runs that were
+    # compressed differently, since they would be loaded first.
+    for suffix, _ in framework.results.COMPRESSION.itervalues():
+        stale = path.join(args.results_path, 'results.json' + suffix)
+        if path.exists(stale):
+            os.remove(stale)
+    result_filepath = path.join(
+        args.results_path,
+        'results.json' + framework.results.COMPRESSION[args.compression][0])
+    result_file = framework.results.open_results(result_filepath, 'w',
+                                                 args.compression)
     json_writer = framework.results.JSONWriter(result_file)
 
     # Create a dictionary to pass to initialize json, it needs the contents of
@@ -168,6 +299,20 @@ def run(input_):
         options[key] = value
     if args.platform:
         options['platform'] = args.platform
+    if args.incremental:
+        options['incremental'] = args.incremental
+        options['force_rerun'] = args.force_rerun
+    if args.reruns > 0:
+        options['reruns'] = args.reruns
+        options['baseline'] = args.baseline
+    if args.compression != 'none':
+        options['compression'] = args.compression
+    if args.safe_tests:
+        options['safe_tests'] = args.safe_tests
+    if args.events:
+        options['events'] = args.events
+        if args.baseline:
+            options['baseline'] = args.baseline
     json_writer.initialize_json(options, results.name,
                                 core.collect_system_info())
 
@@ -176,6 +321,15 @@ def run(input_):
 
     profile = framework.profile.merge_test_profiles(args.test_profile)
     profile.results_dir = args.results_path
+    _setup_incremental(profile, args.platform, baseline, args.force_rerun)
+    if rerun_baseline is not None and args.reruns > 0:
+        profile.reruns = framework.flaky.Reruns(
+            rerun_baseline, args.reruns, args.concurrency != "none")
+    if args.events:
+        _setup_events(profile, args.events, rerun_baseline or baseline)
+    if args.safe_tests:
+        profile.safe_tests = framework.audit.SafeTests(
+            framework.audit.load_audit(args.safe_tests))
 
     time_start = time.time()
     # Set the dmesg type
@@ -210,6 +364,14 @@ def resume(input_):
     args = parser.parse_args(input_)
 
     results = framework.results.load_results(args.results_path)
+    baseline = None
+    if results.options.get('incremental'):
+        baseline = framework.results.load_results(
+            results.options['incremental'])
+    rerun_baseline = None
+    if results.options.get('baseline'):
+        rerun_baseline = framework.results.load_results(
+            results.options['baseline'])
     opts = core.Options(concurrent=results.options['concurrent'],
                         exclude_filter=results.options['exclude_filter'],
                         include_filter=results.options['filter'],
@@ -221,9 +383,15 @@ def resume(input_):
     core.get_config(args.config_file)
 
     opts.env['PIGLIT_PLATFORM'] = results.options['platform']
-
-    results_path = path.join(args.results_path, 'results.json')
-    json_writer = framework.results.JSONWriter(open(results_path, 'w+'))
+    opts.env['PIGLIT_CONTEXT_CACHE'] = path.join(
+        path.abspath(args.results_path), 'context-cache')
+    opts.env['PIGLIT_REFERENCE_CACHE'] = path.join(
+        path.abspath(args.results_path), 'reference-cache')
+    core.checkDir(opts.env['PIGLIT_REFERENCE_CACHE'], False)
+
+    results_path = framework.results.get_results_file(args.results_path)
+    json_writer = framework.results.JSONWriter(framework.results.open_results(
+        results_path, 'w', results.options.get('compression')))
     json_writer.initialize_json(results.options, results.name,
                                 core.collect_system_info())
 
@@ -231,11 +399,23 @@ def resume(input_):
     json_writer.open_dict()
 
     for key, value in results.tests.iteritems():
-        json_writer.write_dict_item(key, value)
+        json_writer.write_test(key, value)
         opts.exclude_tests.add(key)
 
     profile = framework.profile.merge_test_profiles(results.options['profile'])
     profile.results_dir = args.results_path
+    _setup_incremental(profile, results.options['platform'], baseline,
+                       results.options.get('force_rerun'))
+    if rerun_baseline is not None and results.options.get('reruns'):
+        profile.reruns = framework.flaky.Reruns(
+            rerun_baseline, results.options['reruns'],
+            opts.concurrent != "none")
+    if results.options.get('events'):
+        _setup_events(profile, results.options['events'],
+                      rerun_baseline or baseline, append=True)
+    if results.options.get('safe_tests'):
+        profile.safe_tests = framework.audit.SafeTests(
+            framework.audit.load_audit(results.options['safe_tests']))
     if opts.dmesg:
         profile.dmesg = opts.dmesg
 
@@ -58,6 +58,21 @@ def html(input_):
                              "given as arguments. This speeds up HTML "
                              "generation, but reduces the info in the HTML "
                              "pages. May be used multiple times")
+    parser.add_argument("-u", "--update",
+                        action="store_true",
+                        help="Update the summary in an existing directory, "
+                             "only writing the pages that changed")
+    parser.add_argument("-j", "--jobs",
+                        type=int,
+                        default=None,
+                        metavar="<count>",
+                        help="Number of processes rendering pages. "
+                             "Default: the number of CPUs")
+    parser.add_argument("--lazy-details",
+                        action="store_true",
+                        help="Instead of a page for each test, write a "
+                             "JSON index of the tests that a single page "
+                             "displays in the browser")
     parser.add_argument("summaryDir",
                         metavar="<Summary Directory>",
                         help="Directory to put HTML files in")
@@ -87,7 +102,7 @@ def html(input_):
         shutil.rmtree(args.summaryDir)
 
     # If the requested directory doesn't exist, create it or throw an error
-    core.checkDir(args.summaryDir, not args.overwrite)
+    core.checkDir(args.summaryDir, not (args.overwrite or args.update))
 
     # Merge args.list and args.resultsFiles
     if args.list:
@@ -95,7 +110,8 @@ def html(input_):
 
     # Create the HTML output
     output = summary.Summary(args.resultsFiles)
-    output.generate_html(args.summaryDir, args.exclude_details)
+    output.generate_html(args.summaryDir, args.exclude_details, args.jobs,
+                         args.update, args.lazy_details)
 
 
 class _Writer:
@@ -221,6 +237,10 @@ def console(input_):
                            action="store_true",
                            help="Only display the summary, not the individual "
                                 "test results")
+    excGroup1.add_argument("-f", "--flakes",
+                           action="store_true",
+                           help="Only display how often each test was found "
+                                "flaky by piglit-run --reruns, flakiest first")
     parser.add_argument("-l", "--list",
                         action="store",
                         help="Use test results from a list file")
@@ -243,4 +263,7 @@ def console(input_):
 
     # Generate the output
     output = summary.Summary(args.results)
-    output.generate_text(args.diff, args.summary)
+    if args.flakes:
+        output.generate_flakes()
+    else:
+        output.generate_text(args.diff, args.summary)
@@ -24,6 +24,10 @@
 from __future__ import print_function
 import os
 import sys
+import bz2
+import gzip
+import zlib
+import hashlib
 from cStringIO import StringIO
 try:
     import simplejson as json
@@ -37,12 +41,73 @@ __all__ = [
     'TestrunResult',
     'TestResult',
     'JSONWriter',
+    'COMPRESSION',
+    'open_results',
+    'get_results_file',
     'load_results',
 ]
 
 # The current version of the JSON results
 CURRENT_JSON_VERSION = 1
 
+# Ways of compressing results files, by name, as the suffix added to the
+# file name and the function opening such a file
+COMPRESSION = {
+    'none': ('', open),
+    'gz': ('.gz', gzip.open),
+    'bz2': ('.bz2', bz2.BZ2File),
+}
+
+# The magic numbers that start compressed files
+_MAGIC = {
+    'gz': '\x1f\x8b',
+    'bz2': 'BZh',
+}
+
+# Test fields that can hold large strings repeated between tests, and the
+# length from which a string is worth storing only once
+BLOB_FIELDS = ['out', 'err', 'environment', 'command', 'dmesg', 'traceback']
+BLOB_MIN_LENGTH = 64
+
+
+def _blob_hash(value):
+    """ Return the hash a blob is referenced by """
+    return hashlib.sha1(value.encode('utf-8')).hexdigest()
+
+
+def _expand_blobs(tests):
+    """ Replace references to blobs in tests by the blobs themselves
+
+    JSONWriter.write_test() writes a repeated string in full the first time
+    only, and later as {"blob": <hash of the string>}.  The blob table is
+    made of the strings that were written in full.
+
+    """
+    refs = set()
+    for test in tests.itervalues():
+        for field in BLOB_FIELDS:
+            if isinstance(test.get(field), dict):
+                refs.add(test[field]['blob'])
+    if not refs:
+        return
+
+    blobs = {}
+    for test in tests.itervalues():
+        for field in BLOB_FIELDS:
+            value = test.get(field)
+            if (isinstance(value, basestring) and
+                    len(value) >= BLOB_MIN_LENGTH):
+                blobs[_blob_hash(value)] = value
+
+    for test in tests.itervalues():
+        for field in BLOB_FIELDS:
+            if isinstance(test.get(field), dict):
+                try:
+                    test[field] = blobs[test[field]['blob']]
+                except KeyError:
+                    raise Exception('missing blob in results file: ' +
+                                    test[field]['blob'])
+
 
 def _piglit_encoder(obj):
     """ Encoder for piglit that can transform additional classes into json
@@ -122,6 +187,9 @@ class JSONWriter(object):
         #
         self.__is_collection_empty = []
 
+        # Hashes of the blobs already written in full by write_test()
+        self.__blobs = set()
+
         # self._open_containers
         #
         # A FILO stack that stores container information, each time
@@ -221,6 +289,29 @@ class JSONWriter(object):
         # Write value.
         self.__write(value)
 
+    @synchronized_self
+    def write_test(self, name, result):
+        """ Write a test result, storing repeated large strings once
+
+        The first time a large string is written by write_test() it is
+        written as is, afterwards it's written as a reference to the first
+        copy.  Since the first copy always comes first in the file, even a
+        file that is repaired after a crash has every string it refers to.
+
+        """
+        value = dict(result)
+        for field in BLOB_FIELDS:
+            blob = value.get(field)
+            if (isinstance(blob, basestring) and
+                    len(blob) >= BLOB_MIN_LENGTH):
+                digest = _blob_hash(blob)
+                if digest in self.__blobs:
+                    value[field] = {'blob': digest}
+                else:
+                    self.__blobs.add(digest)
+
+        self.write_dict_item(name, value)
+
     @synchronized_self
     def write_dict_key(self, key):
         # Write comma if this is not the initial item in the dict.
@@ -320,6 +411,8 @@ class TestrunResult(object):
 
             self.__dict__.update(raw_dict)
 
+            _expand_blobs(self.tests)
+
             # Replace each raw dict in self.tests with a TestResult.
             for (path, result) in self.tests.items():
                 self.tests[path] = TestResult(result)
@@ -367,7 +460,7 @@ class TestrunResult(object):
 
         if safe_line_num is None:
             raise Exception('failed to repair corrupt result file: ' +
-                            file_.name)
+                            getattr(file_, 'name', '<compressed>'))
 
         # Remove corrupt lines.
         lines = lines[0:(safe_line_num + 1)]
@@ -387,11 +480,71 @@ class TestrunResult(object):
         return new_file
 
     def write(self, file_):
-        """ Write only values of the serialized_keys out to file """
-        with open(file_, 'w') as f:
-            json.dump(dict((k, v) for k, v in self.__dict__.iteritems()
-                           if k in self.serialized_keys),
-                      f, default=_piglit_encoder, indent=JSONWriter.INDENT)
+        """ Write only values of the serialized_keys out to file
+
+        file_ is either the name of a file or an open file
+
+        """
+        if hasattr(file_, 'write'):
+            self.__write(file_)
+        else:
+            with open(file_, 'w') as f:
+                self.__write(f)
+
+    def __write(self, f):
+        json.dump(dict((k, v) for k, v in self.__dict__.iteritems()
+                       if k in self.serialized_keys),
+                  f, default=_piglit_encoder, indent=JSONWriter.INDENT)
+
+
+def open_results(filename, mode='r', compression=None):
+    """ Open a results file, compressed or not
+
+    When reading, compression is found from the contents of the file and
+    the whole file is read into memory.  A compressed file whose end is
+    missing, since the run writing it was interrupted, is read as far as
+    it goes, so that TestrunResult can repair it like an uncompressed one.
+
+    Arguments:
+    filename -- the name of the file to open
+    mode -- 'r' to read the file, 'w' to write it
+    compression -- a key of COMPRESSION, used when writing
+
+    """
+    if mode != 'r':
+        return COMPRESSION[compression or 'none'][1](filename, mode)
+
+    # Read the file once, so that pipes work too
+    with open(filename, 'rb') as f:
+        contents = f.read()
+
+    if contents.startswith(_MAGIC['gz']):
+        contents = zlib.decompressobj(16 + zlib.MAX_WBITS).decompress(
+            contents)
+    elif contents.startswith(_MAGIC['bz2']):
+        contents = bz2.BZ2Decompressor().decompress(contents)
+    return StringIO(contents)
+
+
+def get_results_file(filename):
+    """ Return the results file in a results directory
+
+    If filename isn't a directory it is returned as it is.
+
+    """
+    if not os.path.isdir(filename):
+        return filename
+
+    # If there are both old and new results in a directory pick the new
+    # ones first
+    for suffix, _ in sorted(COMPRESSION.itervalues()):
+        name = 'results.json' + suffix
+        if os.path.exists(os.path.join(filename, name)):
+            return os.path.join(filename, name)
+    # Version 0 results are called 'main'
+    if os.path.exists(os.path.join(filename, 'main')):
+        return os.path.join(filename, 'main')
+    raise Exception("No results found")
 
 
 def load_results(filename):
@@ -401,26 +554,18 @@ def load_results(filename):
 
     It makes quite a few assumptions, first it assumes that it has been passed
     a folder, if that fails then it looks for a plain text json file called
-    "main"
+    "main".  Results files may be compressed with any of COMPRESSION.
 
     """
     # This will load any file or file-like thing. That would include pipes and
     # file descriptors
-    if not os.path.isdir(filename):
-        filepath = filename
-    else:
-        # If there are both old and new results in a directory pick the new
-        # ones first
-        if os.path.exists(os.path.join(filename, 'results.json')):
-            filepath = os.path.join(filename, 'results.json')
-        # Version 0 results are called 'main'
-        elif os.path.exists(os.path.join(filename, 'main')):
-            filepath = os.path.join(filename, 'main')
-        else:
-            raise Exception("No results found")
+    filepath = get_results_file(filename)
 
-    with open(filepath, 'r') as f:
+    f = open_results(filepath)
+    try:
         testrun = TestrunResult(f)
+    finally:
+        f.close()
 
     return update_results(testrun, filepath)
 
@@ -29,12 +29,18 @@ import collections
 import tempfile
 import datetime
 import re
+import errno
+import hashlib
+import json
+import multiprocessing
+import urllib
 from mako.template import Template
 
 # a local variable status exists, prevent accidental overloading by renaming
 # the module
 import framework.status as so
 import framework.results
+import framework.flaky as flaky
 
 
 __all__ = [
@@ -52,6 +58,86 @@ def normalize_href(href):
     return href.replace('\\', '/')
 
 
+def _file_digest(filename):
+    """ Return the SHA-1 of the contents of filename """
+    with open(filename, 'rb') as f:
+        return hashlib.sha1(f.read()).hexdigest()
+
+
+def _page_digest(template_digest, kwargs):
+    """ Return a digest of everything that goes into rendering a page """
+    return hashlib.sha1(template_digest + json.dumps(
+        kwargs, sort_keys=True, default=str)).hexdigest()
+
+
+def _results_mtime(filename):
+    """ Return the modification time of a results file or directory """
+    return path.getmtime(framework.results.get_results_file(filename))
+
+
+# Templates compiled by the process, by file name
+_TEMPLATES = {}
+
+
+def _render_pages(pages):
+    """ Render a list of (template file, output file, arguments) """
+    for template, filename, kwargs in pages:
+        if template not in _TEMPLATES:
+            _TEMPLATES[template] = Template(
+                filename=template,
+                output_encoding="utf-8",
+                module_directory=Summary.TEMP_DIR)
+
+        # os.makedirs is very annoying, it throws an OSError if the path
+        # requested already exists, which another process may just have done
+        try:
+            os.makedirs(path.dirname(filename))
+        except OSError as e:
+            if e.errno != errno.EEXIST:
+                raise
+
+        with open(filename, 'w') as out:
+            out.write(_TEMPLATES[template].render(**kwargs))
+
+
+class _PageCache(object):
+    """
+    Remembers a digest of the inputs of each page written to a summary
+    directory, so that updating the summary can skip the pages that would
+    not change.
+    """
+    FILENAME = "summary-cache.json"
+
+    def __init__(self, destination, update):
+        self.__destination = destination
+        self.__old = {}
+        self.__new = {}
+
+        if update:
+            try:
+                with open(path.join(destination, self.FILENAME), 'r') as f:
+                    self.__old = json.load(f)
+            except (IOError, ValueError):
+                pass
+
+    def is_current(self, filename, digest, inputs_mtime):
+        """
+        Return True if filename is newer than its inputs and was written
+        from inputs with the same digest.
+        """
+        key = path.relpath(filename, self.__destination)
+        self.__new[key] = digest
+        try:
+            return (self.__old.get(key) == digest and
+                    path.getmtime(filename) >= inputs_mtime)
+        except OSError:
+            return False
+
+    def save(self):
+        with open(path.join(self.__destination, self.FILENAME), 'w') as f:
+            json.dump(self.__new, f)
+
+
 class HTMLIndex(list):
     """
     Builds HTML output to be passed to the index mako template, which will be
@@ -65,6 +151,8 @@ class HTMLIndex(list):
         Steps through the list of groups and tests from all of the results and
         generates a list of dicts that are passed to mako and turned into HTML
         """
+        # Link tests to the details viewer rather than to their own pages
+        self._lazy_details = summary.lazy_details
 
         def returnList(open, close):
             """
@@ -185,11 +273,10 @@ class HTMLIndex(list):
                 except KeyError:
                     href = key
 
-                href = escape_filename(href)
-
                 try:
                     self._testResult(each.name, href,
-                                     summary.status[each.name][key])
+                                     summary.status[each.name][key],
+                                     key in summary.carried[each.name])
                 except KeyError:
                     self.append({'type': 'other',
                                  'text': '<td class="skip">Not Run</td>'})
@@ -240,27 +327,34 @@ class HTMLIndex(list):
                      'indent': (1.75 * depth),
                      'text': groupname})
 
-    def _testResult(self, group, href, text):
+    def _testResult(self, group, href, text, carried=False):
         """
         Helper function for writing the results of tests
 
         This function writes the cells other than the left-most cell,
         displaying pass/fail/crash/etc and formatting the cell to the
-        correct color.
+        correct color. Results carried forward from an earlier run by an
+        incremental run are marked as such.
         """
         # "Not Run" is not a valid class, if it apears set the class to skip
         if text == so.NOTRUN:
             css = 'skip'
             href = None
+        elif self._lazy_details:
+            css = text
+            href = "{0}#{1}".format(
+                normalize_href(posixpath.join(group, "viewer.html")),
+                urllib.quote(normalize_href(href)))
         else:
             css = text
-            href = posixpath.join(group, href + ".html")
+            href = posixpath.join(group, escape_filename(href) + ".html")
             href = normalize_href(href)
 
         self.append({'type': 'testResult',
                      'class': css,
                      'href': href,
-                     'text': text})
+                     'text': text,
+                     'carried': carried})
 
 
 class Summary:
@@ -288,13 +382,21 @@ class Summary:
         # Create a Result object for each piglit result and append it to the
         # results list
         self.results = [framework.results.load_results(i) for i in resultfiles]
+        self.result_files = list(resultfiles)
+        self.lazy_details = False
 
         self.status = {}
         self.fractions = {}
         self.totals = {}
+        # Tests (and subtests) whose results an incremental run copied
+        # forward from an earlier run instead of running them
+        self.carried = {}
+        # For each test, the number of runs that found it flaky and the
+        # number of runs it is in
+        self.flakes = collections.defaultdict(lambda: [0, 0])
         self.tests = {'all': set(), 'changes': set(), 'problems': set(),
                       'skipped': set(), 'regressions': set(), 'fixes': set(),
-                      'enabled': set(), 'disabled': set()}
+                      'enabled': set(), 'disabled': set(), 'flaky': set()}
 
         def fgh(test, result):
             """ Helper for updating the fractions and status lists """
@@ -321,6 +423,7 @@ class Summary:
             # short names
             fraction = self.fractions[results.name]
             status = self.status[results.name]
+            carried = self.carried[results.name] = set()
 
             # store the results to be appeneded to results. Adding them in the
             # loop will cause a RuntimeError
@@ -333,6 +436,14 @@ class Summary:
                 # test profiles.
                 assert key[0] != '/'
 
+                if 'carried_forward' in value:
+                    carried.add(key)
+
+                self.flakes[key][1] += 1
+                if value.get('classification') == flaky.FLAKY:
+                    self.flakes[key][0] += 1
+                    self.tests['flaky'].add(key)
+
                 # Treat a test with subtests as if it is a group, assign the
                 # subtests' statuses and fractions down to the test, and then
                 # proceed like normal.
@@ -345,6 +456,8 @@ class Summary:
                         fraction[subt] = subv.fraction
                         status[subt] = subv
                         temp_results.update({subt: {'result': subv}})
+                        if key in carried:
+                            carried.add(subt)
 
                         self.tests['all'].add(subt)
                         while subt != '':
@@ -422,7 +535,8 @@ class Summary:
         for test in results.tests.itervalues():
             self.totals[str(test['result'])] += 1
 
-    def generate_html(self, destination, exclude):
+    def generate_html(self, destination, exclude, jobs=None, update=False,
+                      lazy_details=False):
         """
         Produce HTML summaries.
 
@@ -431,7 +545,16 @@ class Summary:
         The beauty of this approach is that mako is leveraged to do the
         heavy lifting, this method just passes it a bunch of dicts and lists
         of dicts, which mako turns into pretty HTML.
+
+        The pages of individual tests are rendered by jobs processes (by
+        default one per CPU).  With update, destination may hold an earlier
+        summary, and pages whose contents would not change are not written
+        again.  With lazy_details no page is written per test; each results
+        gets a compact JSON index of its tests instead, which a static page
+        shows in the browser.
         """
+        self.lazy_details = lazy_details
+        cache = _PageCache(destination, update)
 
         # Copy static files
         shutil.copy(path.join(self.TEMPLATE_DIR, "index.css"),
@@ -439,22 +562,26 @@ class Summary:
         shutil.copy(path.join(self.TEMPLATE_DIR, "result.css"),
                     path.join(destination, "result.css"))
 
-        # Create the mako object for creating the test/index.html file
-        testindex = Template(filename=path.join(self.TEMPLATE_DIR, "testrun_info.mako"),
-                             output_encoding="utf-8",
-                             module_directory=self.TEMP_DIR)
-
-        # Create the mako object for the individual result files
-        testfile = Template(filename=path.join(self.TEMPLATE_DIR, "test_result.mako"),
-                            output_encoding="utf-8",
-                            module_directory=self.TEMP_DIR)
+        # The mako templates for the test/index.html file and for the
+        # individual result files
+        testindex = path.join(self.TEMPLATE_DIR, "testrun_info.mako")
+        testfile = path.join(self.TEMPLATE_DIR, "test_result.mako")
+        templates_mtime = max(path.getmtime(testindex),
+                              path.getmtime(testfile))
+        testfile_digest = _file_digest(testfile)
 
         result_css = path.join(destination, "result.css")
         index = path.join(destination, "index.html")
 
+        # Pages to render, as (template, output file, arguments)
+        renders = []
+
         # Iterate across the tests creating the various test specific files
-        for each in self.results:
-            os.mkdir(path.join(destination, each.name))
+        for each, resultfile in itertools.izip(self.results,
+                                               self.result_files):
+            if not path.exists(path.join(destination, each.name)):
+                os.mkdir(path.join(destination, each.name))
+            inputs_mtime = max(templates_mtime, _results_mtime(resultfile))
 
             if each.time_elapsed is not None:
                 time = datetime.timedelta(0, each.time_elapsed)
@@ -463,14 +590,20 @@ class Summary:
 
             self.__find_totals(each)
 
-            with open(path.join(destination, each.name, "index.html"), 'w') as out:
-                out.write(testindex.render(name=each.name,
-                                           totals=self.totals,
-                                           time=time,
-                                           options=each.options,
-                                           uname=each.uname,
-                                           glxinfo=each.glxinfo,
-                                           lspci=each.lspci))
+            renders.append((testindex,
+                          path.join(destination, each.name, "index.html"),
+                          dict(name=each.name,
+                               totals=self.totals,
+                               time=time,
+                               options=each.options,
+                               uname=each.uname,
+                               glxinfo=each.glxinfo,
+                               lspci=each.lspci)))
+
+            if lazy_details:
+                self.__write_details_index(destination, each, exclude, cache,
+                                           inputs_mtime)
+                continue
 
             # Then build the individual test results
             for key, value in each.tests.iteritems():
@@ -478,21 +611,34 @@ class Summary:
                 temp_path = path.dirname(html_path)
 
                 if value['result'] not in exclude:
-                    # os.makedirs is very annoying, it throws an OSError if
-                    # the path requested already exists, so do this check to
-                    # ensure that it doesn't
-                    if not path.exists(temp_path):
-                        os.makedirs(temp_path)
-
+                    value = dict(value, result=str(value['result']))
                     if value.get('time') is not None:
                         value['time'] = datetime.timedelta(0, value['time'])
 
-                    with open(html_path, 'w') as out:
-                        out.write(testfile.render(
-                            testname=key,
-                            value=value,
-                            css=path.relpath(result_css, temp_path),
-                            index=path.relpath(index, temp_path)))
+                    kwargs = dict(testname=key,
+                                  value=value,
+                                  css=path.relpath(result_css, temp_path),
+                                  index=path.relpath(index, temp_path))
+                    if not cache.is_current(html_path,
+                                            _page_digest(testfile_digest,
+                                                         kwargs),
+                                            inputs_mtime):
+                        renders.append((testfile, html_path, kwargs))
+
+        # Render in chunks, to keep the cost of passing them to the
+        # processes low
+        chunks = [renders[i:i + 64] for i in xrange(0, len(renders), 64)]
+        if jobs == 1 or len(chunks) < 2:
+            for chunk in chunks:
+                _render_pages(chunk)
+        else:
+            pool = multiprocessing.Pool(jobs)
+            for _ in pool.imap_unordered(_render_pages, chunks):
+                pass
+            pool.close()
+            pool.join()
+
+        cache.save()
 
         # Finally build the root html files: index, regressions, etc
         index = Template(filename=path.join(self.TEMPLATE_DIR, "index.mako"),
@@ -504,7 +650,7 @@ class Summary:
                                 module_directory=self.TEMP_DIR)
 
         pages = frozenset(['changes', 'problems', 'skipped', 'fixes',
-                           'regressions', 'enabled', 'disabled'])
+                           'regressions', 'enabled', 'disabled', 'flaky'])
 
         # Index.html is a bit of a special case since there is index, all, and
         # alltests, where the other pages all use the same name. ie,
@@ -531,22 +677,65 @@ class Summary:
                 else:
                     out.write(empty_status.render(page=page, pages=pages))
 
+    def flake_rates(self):
+        """ Return (test, flaky runs, runs) for every test found flaky
+
+        Sorted from the highest flake rate to the lowest, so that a
+        scheduler can quarantine or deprioritise the tests at the top.
+        """
+        return sorted(((t, f[0], f[1]) for t, f in self.flakes.iteritems()
+                       if f[0]),
+                      key=lambda x: (-float(x[1]) / x[2], x[0]))
+
+    def generate_flakes(self):
+        """ Write the flake rate of each flaky test to the console """
+        for test, flaky_runs, runs in self.flake_rates():
+            print("{0}: flaky in {1} of {2} runs".format(test, flaky_runs,
+                                                          runs))
+
+    def __write_details_index(self, destination, results, exclude, cache,
+                              inputs_mtime):
+        """
+        Private: Write the details of each test in results as a JavaScript
+        object literal, and the page that shows them.
+        """
+        details = dict((key, dict(value, result=str(value['result'])))
+                       for key, value in results.tests.iteritems()
+                       if value['result'] not in exclude)
+        contents = "var piglitResults = {0};\n".format(
+            json.dumps(details, sort_keys=True, separators=(',', ':'),
+                       default=str))
+
+        filename = path.join(destination, results.name, "results.js")
+        if not cache.is_current(filename, hashlib.sha1(contents).hexdigest(),
+                                inputs_mtime):
+            with open(filename, 'w') as out:
+                out.write(contents)
+
+        shutil.copy(path.join(self.TEMPLATE_DIR, "test_viewer.html"),
+                    path.join(destination, results.name, "viewer.html"))
+
     def generate_text(self, diff, summary):
         """ Write summary information to the console """
         self.__find_totals(self.results[-1])
 
+        def statuses(test):
+            """ The status of test in each run, marking carried results """
+            return ' '.join(
+                str(i.tests.get(test, {'result': so.SKIP})['result']) +
+                (' (carried)' if test in self.carried[i.name] else '')
+                for i in self.results)
+
         # Print the name of the test and the status from each test run
         if not summary:
             if diff:
                 for test in self.tests['changes']:
-                    print("%(test)s: %(statuses)s" % {'test': test, 'statuses':
-                          ' '.join([str(i.tests.get(test, {'result': so.SKIP})
-                                    ['result']) for i in self.results])})
+                    print("%(test)s: %(statuses)s" % {'test': test,
+                          'statuses': statuses(test)})
             else:
                 for test in self.tests['all']:
-                    print("%(test)s: %(statuses)s" % {'test': test, 'statuses':
-                          ' '.join([str(i.tests.get(test, {'result': so.SKIP})
-                                    ['result']) for i in self.results])})
+                    print("%(test)s: %(statuses)s" % {'test': test,
+                          'statuses': statuses(test)})
 
         # Print the summary
         print("summary:\n"
@@ -565,3 +754,10 @@ class Summary:
                       **dict((k, len(v)) for k, v in self.tests.iteritems())))
 
         print("      total: {}".format(sum(self.totals.itervalues())))
+        if self.carried[self.results[-1].name]:
+            print("    carried: {}".format(
+                len(self.carried[self.results[-1].name])))
+        flaky_tests = [t for t in self.results[-1].tests.itervalues()
+                       if t.get('classification') == flaky.FLAKY]
+        if flaky_tests:
+            print("      flaky: {}".format(len(flaky_tests)))
@@ -0,0 +1,131 @@
+# Copyright (c) 2014 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+""" Tests for the audit module """
+
+import os
+import nose.tools as nt
+import framework.audit as audit
+import framework.tests.utils as utils
+from framework.exectest import Test
+
+
+class ShellTest(Test):
+    """ A Test that runs a shell command and passes if it succeeds """
+    def __init__(self, script, run_concurrent=False):
+        super(ShellTest, self).__init__(['sh', '-c', script], run_concurrent)
+
+    def interpret_result(self):
+        self.result['result'] = ('pass' if self.result['returncode'] == 0
+                                 else 'fail')
+
+
+def locking(tdir):
+    """ Return a script that fails if another copy of it is running """
+    lock = os.path.join(tdir, 'lock')
+    return 'mkdir {0} && sleep 0.5 && rmdir {0}'.format(lock)
+
+
+def test_safe():
+    """ Audit finds a test that runs fine alongside others safe """
+    tests = {'serial': ShellTest('echo serial'),
+             'load': ShellTest('echo load', run_concurrent=True)}
+    result = audit.Audit(tests, 2, 1).run()
+    nt.assert_equal(result['tests']['serial']['verdict'], audit.SAFE)
+    nt.assert_equal(result['tests']['serial']['rounds'], 2)
+    nt.assert_equal(result['interference'], [])
+
+
+def test_unsafe():
+    """ Audit finds the test that interferes with a serial test """
+    with utils.tempdir() as tdir:
+        tests = {'serial': ShellTest(locking(tdir)),
+                 'harmless': ShellTest('true', run_concurrent=True),
+                 'culprit': ShellTest(locking(tdir), run_concurrent=True)}
+        result = audit.Audit(tests, 1, 2).run()
+
+    nt.assert_equal(result['tests']['serial']['verdict'], audit.UNSAFE)
+    nt.assert_equal([(i['test'], i['with'], i['confirmed'])
+                     for i in result['interference']],
+                    [('serial', 'culprit', True)])
+
+
+def test_unstable():
+    """ Audit doesn't judge a test that is flaky on its own """
+    with utils.tempdir() as tdir:
+        flip = os.path.join(tdir, 'flip')
+        tests = {'serial': ShellTest(
+            'if [ -e {0} ]; then rm {0}; false; else touch {0}; fi'.format(
+                flip))}
+        result = audit.Audit(tests, 1, 1).run()
+    nt.assert_equal(result['tests']['serial']['verdict'], audit.UNSTABLE)
+
+
+def test_only_changed_revisited():
+    """ Audit only revisits tests whose fingerprint changed """
+    tests = {'same': ShellTest('true'), 'changed': ShellTest('true'),
+             'new': ShellTest('true'),
+             'concurrent': ShellTest('true', run_concurrent=True)}
+    previous = {'tests': {'same': {'fingerprint': 'same'},
+                          'changed': {'fingerprint': 'old'}},
+                'interference': []}
+    auditor = audit.Audit(tests, 1, 1,
+                          fingerprint=lambda t: [n for n, x in
+                                                 tests.iteritems()
+                                                 if x is t][0],
+                          previous=previous)
+    nt.assert_equal(auditor.candidates(), ['changed', 'new'])
+
+
+def test_keeps_unvisited():
+    """ Audit keeps the records and pairs of tests it didn't revisit """
+    pair = {'test': 'other', 'with': 'foo', 'affected': 'other',
+            'confirmed': True}
+    previous = {'tests': {'other': {'fingerprint': None,
+                                    'verdict': audit.UNSAFE}},
+                'interference': [pair]}
+    result = audit.Audit({'serial': ShellTest('true')}, 1, 1,
+                         previous=previous).run()
+    nt.assert_equal(result['tests']['other']['verdict'], audit.UNSAFE)
+    nt.assert_equal(result['interference'], [pair])
+
+
+def test_audit_file_roundtrip():
+    """ write_audit() and load_audit() round trip """
+    with utils.tempdir() as tdir:
+        filename = os.path.join(tdir, 'audit.json')
+        nt.assert_equal(audit.load_audit(filename)['tests'], {})
+        result = audit.Audit({'serial': ShellTest('true')}, 1, 1).run()
+        audit.write_audit(filename, result)
+        nt.assert_equal(audit.load_audit(filename), result)
+
+
+def test_safe_tests():
+    """ SafeTests only calls tests audited safe, and unchanged, safe """
+    safe = audit.SafeTests({'tests': {
+        'a': {'fingerprint': 'fa', 'verdict': audit.SAFE},
+        'b': {'fingerprint': 'fb', 'verdict': audit.UNSAFE},
+        'c': {'fingerprint': None, 'verdict': audit.SAFE}}})
+    nt.assert_true(safe.is_safe('a', 'fa'))
+    nt.assert_true(safe.is_safe('a', None))
+    nt.assert_false(safe.is_safe('a', 'changed'))
+    nt.assert_false(safe.is_safe('b', 'fb'))
+    nt.assert_true(safe.is_safe('c', 'anything'))
+    nt.assert_false(safe.is_safe('d', None))
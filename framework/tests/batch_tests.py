@@ -0,0 +1,118 @@
+# Copyright (c) 2014 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+""" Tests for the batch module """
+
+import re
+import nose.tools as nt
+from framework.batch import BatchTest
+
+# A suite that runs the tests named in its list file, one per line.  Tests
+# named 'crash' crash it, tests named 'hang' hang it, and the rest pass if
+# their name starts with 'p' and fail otherwise.
+SUITE = r'''
+while read name; do
+    echo "Test: $name"
+    case $name in
+        crash) kill -SEGV $$ ;;
+        hang) sleep 10 ;;
+        p*) echo "Passed" ;;
+        *) echo "Failed" ;;
+    esac
+done < "$1"
+'''
+
+
+class FakeBatch(BatchTest):
+    """ A BatchTest running SUITE """
+    start_re = re.compile(r'^Test: (?P<name>\S+)', re.MULTILINE)
+
+    def batch_command(self, listfile):
+        return ['sh', '-c', SUITE, 'suite', listfile]
+
+    def write_list(self, f, subtests):
+        f.write('\n'.join(subtests) + '\n')
+
+    def interpret_subtest(self, out):
+        return 'pass' if 'Passed' in out else 'fail'
+
+
+def run_batch(subtests, timeout=None):
+    test = FakeBatch(subtests, timeout=timeout)
+    test.run()
+    return test.result
+
+
+def test_split_output():
+    """ BatchTest.split_output() splits at each subtest's start """
+    test = FakeBatch(['a', 'b'])
+    nt.assert_equal(test.split_output('Test: a\nfoo\nTest: b\nbar\n'),
+                    [('a', 'Test: a\nfoo\n'), ('b', 'Test: b\nbar\n')])
+
+
+def test_results():
+    """ BatchTest gives each subtest its own result from one invocation """
+    result = run_batch(['pa', 'fb', 'pc'])
+    nt.assert_equal(result['subtest'], {'pa': 'pass', 'fb': 'fail',
+                                        'pc': 'pass'})
+    nt.assert_equal(result['invocations'], 1)
+    nt.assert_equal(result['result'], 'fail')
+
+
+def test_crash_resumes():
+    """ BatchTest marks the crashing subtest and runs the rest again """
+    result = run_batch(['pa', 'crash', 'pb'])
+    nt.assert_equal(result['subtest'], {'pa': 'pass', 'crash': 'crash',
+                                        'pb': 'pass'})
+    nt.assert_equal(result['invocations'], 2)
+    nt.assert_equal(result['result'], 'crash')
+
+
+def test_timeout_resumes():
+    """ BatchTest marks the subtest that ran out of time and goes on """
+    result = run_batch(['pa', 'hang', 'pb'], timeout=1)
+    nt.assert_equal(result['subtest'], {'pa': 'pass', 'hang': 'timeout',
+                                        'pb': 'pass'})
+    nt.assert_equal(result['result'], 'timeout')
+
+
+def test_missing_suite():
+    """ BatchTest skips when the suite isn't installed """
+    class Missing(FakeBatch):
+        def batch_command(self, listfile):
+            return ['/nonexistent/suite', listfile]
+
+    test = Missing(['pa'])
+    test.run()
+    nt.assert_equal(test.result['result'], 'skip')
+
+
+def test_list_suffix():
+    """ BatchTest names the list file with list_suffix """
+    class SuffixBatch(FakeBatch):
+        list_suffix = '.run'
+
+        def batch_command(self, listfile):
+            return ['sh', '-c', 'case "$1" in *.run) echo "Test: pa"; '
+                    'echo Passed ;; esac', 'suite', listfile]
+
+    test = SuffixBatch(['pa'])
+    test.run()
+    nt.assert_equal(test.result['subtest'], {'pa': 'pass'})
@@ -74,7 +74,7 @@ class DummyJsonWriter(object):
     def __init__(self):
         self.result = None
 
-    def write_dict_item(self, _, result):
+    def write_test(self, _, result):
         self.result = result
 
 
@@ -0,0 +1,115 @@
+# Copyright (c) 2014 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+""" Tests for the flaky module """
+
+import copy
+import json
+import nose.tools as nt
+import framework.flaky as flaky
+import framework.results as results
+import framework.summary as summary
+import framework.tests.utils as utils
+from framework.exectest import Test
+
+
+class SequenceTest(Test):
+    """ A Test whose runs report the statuses in self.statuses in turn """
+    statuses = []
+
+    def interpret_result(self):
+        self.result['result'] = SequenceTest.statuses.pop(0)
+
+
+def run_sequence(expected, statuses, count=3, concurrent=False):
+    """ Run a SequenceTest and check it against a baseline """
+    data = copy.deepcopy(utils.JSON_DATA)
+    data['tests']['sometest']['result'] = expected
+    with utils.with_tempfile(json.dumps(data)) as tfile:
+        reruns = flaky.Reruns(results.load_results(tfile), count, concurrent)
+
+    SequenceTest.statuses = list(statuses)
+    test = SequenceTest(['true'], run_concurrent=concurrent)
+    test.run()
+    reruns.check('sometest', test)
+    return test.result
+
+
+def test_classify_regression():
+    """ classify() finds a stable regression """
+    nt.assert_equal(flaky.classify('pass', ['fail', 'fail', 'fail']),
+                    flaky.STABLE_REGRESSION)
+
+
+def test_classify_fix():
+    """ classify() finds a stable fix """
+    nt.assert_equal(flaky.classify('crash', ['pass', 'pass']),
+                    flaky.STABLE_FIX)
+
+
+def test_classify_flaky():
+    """ classify() finds a flaky test """
+    nt.assert_equal(flaky.classify('pass', ['fail', 'pass']), flaky.FLAKY)
+
+
+def test_check_unchanged():
+    """ Reruns.check() doesn't rerun a test whose status is unchanged """
+    result = run_sequence('pass', ['pass'])
+    nt.assert_not_in('attempts', result)
+    nt.assert_not_in('classification', result)
+
+
+def test_check_stable():
+    """ Reruns.check() reruns a changed test the given number of times """
+    result = run_sequence('pass', ['fail'] * 4)
+    nt.assert_equal(len(result['attempts']), 4)
+    nt.assert_equal(result['classification'], flaky.STABLE_REGRESSION)
+
+
+def test_check_stops_when_flaky():
+    """ Reruns.check() stops rerunning once a test is known to be flaky """
+    result = run_sequence('pass', ['fail', 'fail', 'pass', 'fail'])
+    nt.assert_equal([a['result'] for a in result['attempts']],
+                    ['fail', 'fail', 'pass'])
+    nt.assert_equal(result['classification'], flaky.FLAKY)
+    nt.assert_equal(result['result'], 'fail')
+
+
+def test_check_concurrent():
+    """ Reruns.check() makes all attempts at a concurrent test """
+    result = run_sequence('pass', ['fail', 'pass', 'fail', 'fail'],
+                          concurrent=True)
+    nt.assert_equal(len(result['attempts']), 4)
+    nt.assert_equal(result['classification'], flaky.FLAKY)
+
+
+def test_summary_flake_rates():
+    """ Summary counts the runs that found each test flaky """
+    data = copy.deepcopy(utils.JSON_DATA)
+    data['tests']['sometest']['classification'] = flaky.FLAKY
+    stable = copy.deepcopy(utils.JSON_DATA)
+    stable['name'] = 'stable'
+
+    with utils.with_tempfile(json.dumps(data)) as flakyfile:
+        with utils.with_tempfile(json.dumps(stable)) as stablefile:
+            summ = summary.Summary([flakyfile, stablefile])
+
+    nt.assert_equal(summ.flake_rates(), [('sometest', 1, 2)])
+    nt.assert_equal(summ.tests['flaky'], set(['sometest']))
@@ -23,6 +23,7 @@
 from __future__ import print_function
 import os
 from nose.plugins.skip import SkipTest
+import framework.core as core
 from framework.gleantest import GleanTest
 
 
@@ -51,6 +52,17 @@ def test_GLOBAL_PARAMS_assignment():
     assert test1.command == test2.command
 
 
+def test_jobs_from_config():
+    """ GleanTest passes --jobs when piglit.conf sets [glean] jobs """
+    core.PIGLIT_CONFIG.add_section('glean')
+    try:
+        core.PIGLIT_CONFIG.set('glean', 'jobs', '4')
+        test = GleanTest('basic')
+        assert test.command[-2:] == ['--jobs', '4'], test.command
+    finally:
+        core.PIGLIT_CONFIG.remove_section('glean')
+
+
 def test_bad_returncode():
     """ Result is 'Fail' when returncode is not 0
 
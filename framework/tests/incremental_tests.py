@@ -0,0 +1,153 @@
+# Copyright (c) 2014 Intel Corporation
+
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+""" Tests for the incremental module """
+
+import os
+import json
+import copy
+import nose.tools as nt
+import framework.incremental as incremental
+import framework.results as results
+import framework.summary as summary
+import framework.tests.utils as utils
+from framework.exectest import Test
+
+
+class TestTest(Test):
+    """ A Test with a dummy interpret_result """
+    def interpret_result(self):
+        pass
+
+
+def fingerprint_in(tdir, command, env=None, driver='driver'):
+    """ Fingerprint a TestTest with cwd set to tdir """
+    test = TestTest(command)
+    test.cwd = tdir
+    test.env = env or {}
+    return incremental.Fingerprinter(driver, tdir)(test)
+
+
+def write_file(filename, contents):
+    with open(filename, 'w') as f:
+        f.write(contents)
+
+
+def make_baseline(fingerprint, force_rerun=None):
+    data = copy.deepcopy(utils.JSON_DATA)
+    data['tests']['sometest']['fingerprint'] = fingerprint
+    with utils.with_tempfile(json.dumps(data)) as tfile:
+        return incremental.Baseline(results.load_results(tfile), force_rerun)
+
+
+def test_fingerprint_stable():
+    """ Fingerprinter gives the same test the same fingerprint """
+    with utils.tempdir() as tdir:
+        write_file(os.path.join(tdir, 'a.shader_test'), 'foo')
+        nt.assert_equal(fingerprint_in(tdir, ['foo', 'a.shader_test']),
+                        fingerprint_in(tdir, ['foo', 'a.shader_test']))
+
+
+def test_fingerprint_file_contents():
+    """ Fingerprinter notices a change in a file the command names """
+    with utils.tempdir() as tdir:
+        write_file(os.path.join(tdir, 'a.shader_test'), 'foo')
+        old = fingerprint_in(tdir, ['foo', 'a.shader_test'])
+        write_file(os.path.join(tdir, 'a.shader_test'), 'bar')
+        nt.assert_not_equal(old, fingerprint_in(tdir, ['foo', 'a.shader_test']))
+
+
+def test_fingerprint_command():
+    """ Fingerprinter notices a change in the command line """
+    with utils.tempdir() as tdir:
+        nt.assert_not_equal(fingerprint_in(tdir, ['foo', '-auto']),
+                            fingerprint_in(tdir, ['foo', '-fbo']))
+
+
+def test_fingerprint_env():
+    """ Fingerprinter notices a change in the environment """
+    with utils.tempdir() as tdir:
+        nt.assert_not_equal(fingerprint_in(tdir, ['foo'], {'A': '1'}),
+                            fingerprint_in(tdir, ['foo'], {'A': '2'}))
+
+
+def test_fingerprint_volatile_env():
+    """ Fingerprinter ignores the context cache, which is per run """
+    with utils.tempdir() as tdir:
+        nt.assert_equal(
+            fingerprint_in(tdir, ['foo'], {'PIGLIT_CONTEXT_CACHE': 'a'}),
+            fingerprint_in(tdir, ['foo'], {'PIGLIT_CONTEXT_CACHE': 'b'}))
+
+
+def test_fingerprint_driver():
+    """ Fingerprinter notices a change of driver """
+    with utils.tempdir() as tdir:
+        nt.assert_not_equal(fingerprint_in(tdir, ['foo'], driver='a'),
+                            fingerprint_in(tdir, ['foo'], driver='b'))
+
+
+def test_fingerprint_libs():
+    """ Fingerprinter notices a change in piglit's libraries """
+    with utils.tempdir() as tdir:
+        write_file(os.path.join(tdir, 'libpiglitutil.so'), 'foo')
+        old = fingerprint_in(tdir, ['foo'])
+        write_file(os.path.join(tdir, 'libpiglitutil.so'), 'bar')
+        nt.assert_not_equal(old, fingerprint_in(tdir, ['foo']))
+
+
+def test_baseline_carries_matching():
+    """ Baseline.lookup() returns the result of an unchanged test """
+    result = make_baseline('abc').lookup('sometest', 'abc')
+    nt.assert_equal(result['result'], 'pass')
+    nt.assert_equal(result['carried_forward'], utils.JSON_DATA['name'])
+
+
+def test_baseline_mismatch():
+    """ Baseline.lookup() returns None for a changed test """
+    nt.assert_is_none(make_baseline('abc').lookup('sometest', 'abd'))
+
+
+def test_baseline_new_test():
+    """ Baseline.lookup() returns None for a test not in the baseline """
+    nt.assert_is_none(make_baseline('abc').lookup('newtest', 'abc'))
+
+
+def test_baseline_force_rerun():
+    """ Baseline.lookup() returns None for tests matching --force-rerun """
+    baseline = make_baseline('abc', ['^some'])
+    nt.assert_is_none(baseline.lookup('sometest', 'abc'))
+
+
+def test_baseline_keeps_origin():
+    """ Baseline.lookup() keeps the run a result was first carried from """
+    baseline = make_baseline('abc')
+    baseline.tests['sometest']['carried_forward'] = 'older'
+    nt.assert_equal(baseline.lookup('sometest', 'abc')['carried_forward'],
+                    'older')
+
+
+def test_summary_marks_carried():
+    """ Summary records which results were carried forward """
+    data = copy.deepcopy(utils.JSON_DATA)
+    data['tests']['sometest']['carried_forward'] = 'baseline'
+    data['tests']['ran'] = {'result': 'pass'}
+    with utils.with_tempfile(json.dumps(data)) as tfile:
+        summ = summary.Summary([tfile])
+        nt.assert_equal(summ.carried[data['name']], set(['sometest']))
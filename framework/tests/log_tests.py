@@ -20,11 +20,14 @@
 
 """ Module provides tests for log.py module """
 
+import os
 import sys
+import json
+import socket
 import itertools
 from types import *  # This is a special * safe module
 import nose.tools as nt
-from framework.log import Log
+from framework.log import Log, EventStream
 import framework.tests.utils as utils
 
 valid_statuses = ('pass', 'fail', 'crash', 'warn', 'dmesg-warn',
@@ -96,3 +99,58 @@ def test_post_log_increment_summary_bad():
     log = Log(100, False)
     ret = log.pre_log()
     log.post_log(ret, 'fails')
+
+
+def read_events(filename):
+    with open(filename) as f:
+        return [json.loads(l) for l in f]
+
+
+def test_events():
+    """ EventStream reports the start and end of each test """
+    with utils.tempdir() as tdir:
+        filename = os.path.join(tdir, 'events')
+        events = EventStream(filename, interval=0)
+        events.start(['a'])
+        log = Log(1, False, events)
+        log.post_log(log.pre_log('a'), 'pass', {'utime': 1.0})
+        log.summary()
+        got = read_events(filename)
+
+    nt.assert_equal([e['event'] for e in got],
+                    ['run-start', 'test-start', 'test-end', 'run-end'])
+    nt.assert_equal(got[2]['test'], 'a')
+    nt.assert_equal(got[2]['result'], 'pass')
+    nt.assert_equal(got[2]['rusage'], {'utime': 1.0})
+
+
+def test_events_eta():
+    """ EventStream estimates the time left from earlier durations """
+    with utils.tempdir() as tdir:
+        events = EventStream(os.path.join(tdir, 'events'),
+                             {'a': 10.0, 'b': 20.0}, interval=0)
+        events.start(['a', 'b', 'c'])
+        # c is unknown, and assumed to take as long as the average
+        nt.assert_almost_equal(events.eta(), 45.0, places=1)
+        events.test_start(0, 'b')
+        events.test_end(0, 'pass')
+        nt.assert_almost_equal(events.eta(), 25.0, places=1)
+        events.close()
+
+
+def test_events_socket():
+    """ EventStream writes to a UNIX socket """
+    with utils.tempdir() as tdir:
+        filename = os.path.join(tdir, 'socket')
+        server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        server.bind(filename)
+        server.listen(1)
+        events = EventStream(filename, interval=0)
+        conn, _ = server.accept()
+        events.start([])
+        events.close()
+        got = conn.makefile().read()
+        server.close()
+
+    nt.assert_equal([json.loads(l)['event'] for l in got.splitlines()],
+                    ['run-start', 'run-end'])
@@ -159,3 +159,68 @@ def test_update_results_old():
         res = results.update_results(base, f.name)
 
     nt.assert_equal(res.results_version, results.CURRENT_JSON_VERSION)
+
+
+def write_results(filename, tests, compression='none'):
+    """ Write tests to a results file with JSONWriter """
+    writer = results.JSONWriter(
+        results.open_results(filename, 'w', compression))
+    writer.initialize_json({}, 'compressed', {})
+    writer.write_dict_key('tests')
+    writer.open_dict()
+    for name, test in sorted(tests.iteritems()):
+        writer.write_test(name, test)
+    writer.close_dict()
+    writer.close_json()
+
+
+def check_load_compressed(compression):
+    """ load_results() loads a compressed results directory """
+    with utils.tempdir() as tdir:
+        write_results(
+            os.path.join(tdir, 'results.json' +
+                         results.COMPRESSION[compression][0]),
+            {'sometest': {'result': 'pass'}}, compression)
+        result = results.load_results(tdir)
+
+    nt.assert_equal(result.tests['sometest']['result'], 'pass')
+
+
+def test_load_compressed():
+    """ Generate tests loading each kind of compressed results """
+    for compression in results.COMPRESSION:
+        check_load_compressed.description = \
+            "load_results() loads {} compressed results".format(compression)
+        yield check_load_compressed, compression
+
+
+def test_repair_compressed():
+    """ load_results() repairs a compressed file whose end is missing """
+    tests = dict(('test{}'.format(i), {'result': 'pass', 'out': str(i) * 100})
+                 for i in xrange(10))
+    with utils.tempdir() as tdir:
+        filename = os.path.join(tdir, 'results.json.gz')
+        write_results(filename, tests, 'gz')
+        with open(filename, 'rb') as f:
+            contents = f.read()
+        with open(filename, 'wb') as f:
+            f.write(contents[:len(contents) * 3 / 4])
+        result = results.load_results(filename)
+
+    nt.assert_in('test0', result.tests)
+    nt.assert_not_in('test9', result.tests)
+
+
+def test_write_test_blobs():
+    """ JSONWriter.write_test() writes a repeated string once """
+    out = 'a driver warning that every test prints ' * 4
+    with utils.tempdir() as tdir:
+        filename = os.path.join(tdir, 'results.json')
+        write_results(filename, {'a': {'result': 'pass', 'out': out},
+                                 'b': {'result': 'fail', 'out': out}})
+        with open(filename) as f:
+            nt.assert_equal(f.read().count(out), 1)
+        result = results.load_results(filename)
+
+    nt.assert_equal(result.tests['a']['out'], out)
+    nt.assert_equal(result.tests['b']['out'], out)
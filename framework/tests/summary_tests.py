@@ -22,6 +22,7 @@
 """ Module providing tests for the summary module """
 
 from __future__ import print_function
+import os
 import json
 import copy
 import nose.tools as nt
@@ -150,3 +151,35 @@ def subtest_not_skip_notrun(summary_):
     print(summary_.results[0].tests['is_skip'])
     nt.eq_(summary_.status['fake-tests']['is_skip'], 'skip',
         msg="Status should be skip but was changed")
+
+
+def test_page_cache_current():
+    """ A page written from the same inputs is current on update """
+    with utils.tempdir() as tdir:
+        page = os.path.join(tdir, 'page.html')
+        with open(page, 'w') as f:
+            f.write('foo')
+
+        cache = summary._PageCache(tdir, False)
+        nt.assert_false(cache.is_current(page, 'abc', 0))
+        cache.save()
+
+        cache = summary._PageCache(tdir, True)
+        nt.assert_true(cache.is_current(page, 'abc', 0))
+        nt.assert_false(cache.is_current(page, 'abd', 0))
+
+
+def test_page_cache_older_than_inputs():
+    """ A page older than its inputs is not current on update """
+    with utils.tempdir() as tdir:
+        page = os.path.join(tdir, 'page.html')
+        with open(page, 'w') as f:
+            f.write('foo')
+
+        cache = summary._PageCache(tdir, False)
+        cache.is_current(page, 'abc', 0)
+        cache.save()
+
+        cache = summary._PageCache(tdir, True)
+        nt.assert_false(cache.is_current(page, 'abc',
+                                         os.path.getmtime(page) + 1))
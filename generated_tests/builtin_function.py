@@ -51,6 +51,7 @@
 import collections
 import itertools
 import numpy as np
+import os
 
 
 # Floating point types used by Python and numpy
@@ -207,10 +208,30 @@ TestVector = collections.namedtuple(
     'TestVector', ('arguments', 'result', 'tolerance'))
 
 
+# Cache for glsl_type_of(), keyed by the Python type of scalars and
+# by (dtype, shape) for arrays.  Generating the test suite looks up
+# the types of a few hundred thousand values, almost all of them of a
+# handful of distinct kinds.
+_glsl_type_cache = {}
+
+
 def glsl_type_of(value):
     """Return the GLSL type corresponding to the given native numpy
     value, as a GlslBuiltinType.
     """
+    if isinstance(value, np.ndarray):
+        key = (value.dtype, value.shape)
+    else:
+        key = type(value)
+    try:
+        return _glsl_type_cache[key]
+    except KeyError:
+        result = _glsl_type_cache[key] = _compute_glsl_type_of(value)
+        return result
+
+
+def _compute_glsl_type_of(value):
+    """Uncached implementation of glsl_type_of()."""
     if isinstance(value, FLOATING_TYPES):
         return glsl_float
     elif isinstance(value, (bool, np.bool_)):
@@ -315,6 +336,24 @@ test_suite = {}
 # The functions below shouldn't be necessary to call from outside this
 # file.  They exist solely to populate test_suite with test vectors.
 
+def _elementwise(func):
+    """Mark func as safe to apply to whole arrays of arguments at once.
+
+    func must compute each element of its result from the
+    corresponding elements of its arguments, in the same way it would
+    for scalars, and must never return None.  _simulate_function()
+    evaluates such functions once over all of their inputs instead of
+    once per input.  numpy ufuncs are always treated as elementwise.
+    """
+    wrapper = lambda *args: func(*args)
+    wrapper.elementwise = True
+    return wrapper
+
+
+def _is_elementwise(func):
+    return isinstance(func, np.ufunc) or getattr(func, 'elementwise', False)
+
+
 # Functions that simulate GLSL built-in functions (in the cases where
 # the GLSL built-in functions have no python or numpy equivalent, or
 # in cases where there is a behavioral difference).  These functions
@@ -427,12 +466,14 @@ def _pow(x, y):
     return np.power(x, y)
 
 
+@_elementwise
 def _exp2(x):
     # exp2() is not available in versions of numpy < 1.3.0 so we
     # emulate it with power().
     return np.power(2, x)
 
 
+@_elementwise
 def _trunc(x):
     # trunc() rounds toward zero.  It is not available in version
     # 1.2.1 of numpy so we emulate it with floor(), sign(), and abs().
@@ -570,6 +611,27 @@ def _cross_product_tolerance(arguments, result):
     return 1e-5 * np.linalg.norm(arguments[0]) * np.linalg.norm(arguments[1])
 
 
+def _scalar_tolerances(tolerance_function, results):
+    """Compute tolerance_function for every element of results, an
+    array of float32 scalar results, in a single batch.  The values
+    are bit-identical to calling tolerance_function on each result in
+    turn.
+
+    Returns None if tolerance_function has no batched form.
+    """
+    # np.linalg.norm() of a float32 scalar squares it and takes the
+    # square root in float32 before the result is scaled in float64,
+    # so round the same way here.
+    norms = np.sqrt(results * results).astype(np.float64)
+    if tolerance_function is _strict_tolerance:
+        return np.array(1e-5 * norms, dtype=np.float32)
+    elif tolerance_function is _trig_tolerance:
+        # fmax() matches max() in ignoring a NaN second argument.
+        return np.array(np.fmax(1e-4, 1e-3 * norms), dtype=np.float32)
+    else:
+        return None
+
+
 def _simulate_function(test_inputs, python_equivalent, tolerance_function):
     """Construct test vectors by simulating a GLSL function on a list
     of possible inputs, and return a list of test vectors.
@@ -592,6 +654,32 @@ def _simulate_function(test_inputs, python_equivalent, tolerance_function):
     tolerance.  It should take the set of arguments and the expected
     result as its parameters.  It is only used for functions that
     return floating point values.
+
+    If python_equivalent is elementwise (see _elementwise()) and all
+    of the inputs are scalars, it is evaluated once over the whole
+    set of inputs rather than once per input.  Setting
+    PIGLIT_CHECK_BUILTIN_BATCHING in the environment also runs the
+    per-input simulation and checks that both produce identical test
+    vectors.
+    """
+    if _is_elementwise(python_equivalent) and test_inputs and \
+       all(glsl_type_of(x).is_scalar for x in test_inputs[0]):
+        test_vectors = _simulate_elementwise_function(
+            test_inputs, python_equivalent, tolerance_function)
+        if test_vectors is not None:
+            if os.environ.get('PIGLIT_CHECK_BUILTIN_BATCHING'):
+                _check_batched_test_vectors(
+                    test_vectors, _simulate_scalar_function(
+                        test_inputs, python_equivalent, tolerance_function))
+            return test_vectors
+    return _simulate_scalar_function(
+        test_inputs, python_equivalent, tolerance_function)
+
+
+def _simulate_scalar_function(test_inputs, python_equivalent,
+                              tolerance_function):
+    """Implementation of _simulate_function() that calls
+    python_equivalent once per input.
     """
     test_vectors = []
     for inputs in test_inputs:
@@ -607,6 +695,54 @@ def _simulate_function(test_inputs, python_equivalent, tolerance_function):
     return test_vectors
 
 
+def _simulate_elementwise_function(test_inputs, python_equivalent,
+                                   tolerance_function):
+    """Batched form of _simulate_function() for elementwise functions
+    of scalars.  Each argument is gathered into a 64 bit array, the
+    function is applied once, and the results are rounded to 32 bits
+    as a whole.
+
+    Returns None if the inputs can't be batched, in which case the
+    caller falls back to simulating one input at a time.
+    """
+    arity = len(test_inputs[0])
+    columns = []
+    for i in xrange(arity):
+        column = np.array([inputs[i] for inputs in test_inputs])
+        if column.dtype == object or column.ndim != 1:
+            return None
+        columns.append(extend_to_64_bits(column))
+    expected_outputs = round_to_32_bits(python_equivalent(*columns))
+    if not isinstance(expected_outputs, np.ndarray) or \
+       expected_outputs.shape != (len(test_inputs),):
+        return None
+
+    if expected_outputs.dtype == np.float32:
+        tolerances = _scalar_tolerances(tolerance_function, expected_outputs)
+        if tolerances is None:
+            tolerances = [np.float32(tolerance_function(inputs, output))
+                          for inputs, output
+                          in itertools.izip(test_inputs, expected_outputs)]
+    else:
+        tolerances = itertools.repeat(np.float32(0.0))
+    return [TestVector(inputs, output, tolerance)
+            for inputs, output, tolerance
+            in itertools.izip(test_inputs, expected_outputs, tolerances)]
+
+
+def _check_batched_test_vectors(batched, expected):
+    """Raise an exception unless the test vectors computed by
+    _simulate_elementwise_function() are bit-identical, in value and
+    type, to those computed one input at a time.
+    """
+    def key(test_vector):
+        return [(type(x), np.asarray(x).tostring())
+                for x in (test_vector.result, test_vector.tolerance)]
+    if len(batched) != len(expected) or \
+       any(key(a) != key(b) for a, b in itertools.izip(batched, expected)):
+        raise Exception('Batched simulation differs from scalar simulation')
+
+
 def _vectorize_test_vectors(test_vectors, scalar_arg_indices, vector_length):
     """Build a new set of test vectors by combining elements of
     test_vectors into vectors of length vector_length. For example,
@@ -638,43 +774,43 @@ def _vectorize_test_vectors(test_vectors, scalar_arg_indices, vector_length):
             groups[key].append(tv)
         return groups
 
-    def partition_vectors(test_vectors, partition_size):
-        """Partition test_vectors into lists of length partition_size.
-        If partition_size does not evenly divide the number of test
-        vectors, wrap around as necessary to ensure that every input
-        test vector is included.
+    def partition_indices(count, partition_size):
+        """Return an array whose rows are the indices of each
+        partition of count test vectors into lists of length
+        partition_size.  If partition_size does not evenly divide the
+        number of test vectors, wrap around as necessary to ensure
+        that every input test vector is included.
         """
-        for i in xrange(0, len(test_vectors), partition_size):
-            partition = []
-            for j in xrange(partition_size):
-                partition.append(test_vectors[(i + j) % len(test_vectors)])
-            yield partition
+        starts = np.arange(0, count, partition_size)
+        return (starts[:, np.newaxis] + np.arange(partition_size)) % count
 
     def merge_vectors(test_vectors):
         """Merge the given set of test vectors (whose arguments and
-        result are scalars) into a single test vector whose arguments
-        and result are vectors.  For argument indices in
-        scalar_arg_indices, leave the argument as a scalar.
+        result are scalars) into vector test vectors, one per
+        partition.  For argument indices in scalar_arg_indices, leave
+        the argument as a scalar.
+
+        The arguments, results and tolerances are gathered into arrays
+        once, and each partition is sliced out of them.
         """
         arity = len(test_vectors[0].arguments)
-        arguments = []
-        for j in xrange(arity):
-            if j in scalar_arg_indices:
-                arguments.append(test_vectors[0].arguments[j])
-            else:
-                arguments.append(
-                    np.array([tv.arguments[j] for tv in test_vectors]))
-        result = np.array([tv.result for tv in test_vectors])
-        tolerance = np.float32(
-            np.linalg.norm([tv.tolerance for tv in test_vectors]))
-        return TestVector(arguments, result, tolerance)
+        columns = [np.array([tv.arguments[j] for tv in test_vectors])
+                   for j in xrange(arity)]
+        results = np.array([tv.result for tv in test_vectors])
+        tolerances = np.array([tv.tolerance for tv in test_vectors])
+        for indices in partition_indices(len(test_vectors), vector_length):
+            arguments = []
+            for j in xrange(arity):
+                if j in scalar_arg_indices:
+                    arguments.append(test_vectors[0].arguments[j])
+                else:
+                    arguments.append(columns[j][indices])
+            tolerance = np.float32(np.linalg.norm(tolerances[indices]))
+            yield TestVector(arguments, results[indices], tolerance)
     vectorized_test_vectors = []
     groups = make_groups(test_vectors)
     for key in sorted(groups.keys()):
-        test_vectors = groups[key]
-        vectorized_test_vectors.extend(
-            merge_vectors(partition)
-            for partition in partition_vectors(test_vectors, vector_length))
+        vectorized_test_vectors.extend(merge_vectors(groups[key]))
     return vectorized_test_vectors
 
 
@@ -831,7 +967,7 @@ def _make_componentwise_test_vectors(test_suite_dict):
     f('exp2', 1, 110, _exp2, None, [np.linspace(-2.0, 2.0, 4)])
     f('log2', 1, 110, np.log2, None, [np.linspace(0.01, 2.0, 4)])
     f('sqrt', 1, 110, np.sqrt, None, [np.linspace(0.0, 2.0, 4)])
-    f('inversesqrt', 1, 110, lambda x: 1.0/np.sqrt(x), None,
+    f('inversesqrt', 1, 110, _elementwise(lambda x: 1.0/np.sqrt(x)), None,
       [np.linspace(0.1, 2.0, 4)])
     f('abs', 1, 110, np.abs, None, [np.linspace(-1.5, 1.5, 5)])
     f('abs', 1, 130, np.abs, None, [ints])
@@ -848,13 +984,15 @@ def _make_componentwise_test_vectors(test_suite_dict):
     # values.  In both cases, we can use numpy's round() function,
     # because it rounds half-integer values to even, and all other
     # values to nearest.
-    f('round', 1, 130, np.round, None, [np.linspace(-2.0, 2.0, 8)])
-    f('roundEven', 1, 130, np.round, None, [np.linspace(-2.0, 2.0, 25)])
+    f('round', 1, 130, _elementwise(np.round), None,
+      [np.linspace(-2.0, 2.0, 8)])
+    f('roundEven', 1, 130, _elementwise(np.round), None,
+      [np.linspace(-2.0, 2.0, 25)])
 
     f('ceil', 1, 110, np.ceil, None, [np.linspace(-2.0, 2.0, 4)])
-    f('fract', 1, 110, lambda x: x-np.floor(x), None,
+    f('fract', 1, 110, _elementwise(lambda x: x-np.floor(x)), None,
       [np.linspace(-2.0, 2.0, 4)])
-    f('mod', 2, 110, lambda x, y: x-y*np.floor(x/y), [1],
+    f('mod', 2, 110, _elementwise(lambda x, y: x-y*np.floor(x/y)), [1],
       [np.linspace(-1.9, 1.9, 4), np.linspace(-2.0, 2.0, 4)])
     f('min', 2, 110, min, [1],
       [np.linspace(-2.0, 2.0, 4), np.linspace(-2.0, 2.0, 4)])
@@ -892,7 +1030,7 @@ def _make_componentwise_test_vectors(test_suite_dict):
       np.linspace(-1.5, 1.5, 3), np.linspace(-1.5, 1.5, 3)])
     f('clamp', 3, 130, _clamp, [1, 2], [ints, ints, ints])
     f('clamp', 3, 130, _clamp, [1, 2], [uints, uints, uints])
-    f('mix', 3, 110, lambda x, y, a: x*(1-a)+y*a, [2],
+    f('mix', 3, 110, _elementwise(lambda x, y, a: x*(1-a)+y*a), [2],
       [np.linspace(-2.0, 2.0, 2), np.linspace(-3.0, 3.0, 2),
        np.linspace(0.0, 1.0, 4)])
     f('mix', 3, 130, lambda x, y, a: y if a else x, None,
@@ -947,12 +1085,12 @@ def _make_vector_relational_test_vectors(test_suite_dict):
                     _vectorize_test_vectors(
                         scalar_test_vectors, (), vector_length))
 
-    f('lessThan', 2, 110, lambda x, y: x < y, 'viu')
-    f('lessThanEqual', 2, 110, lambda x, y: x <= y, 'viu')
-    f('greaterThan', 2, 110, lambda x, y: x > y, 'viu')
-    f('greaterThanEqual', 2, 110, lambda x, y: x >= y, 'viu')
-    f('equal', 2, 110, lambda x, y: x == y, 'viub')
-    f('notEqual', 2, 110, lambda x, y: x != y, 'viub')
+    f('lessThan', 2, 110, _elementwise(lambda x, y: x < y), 'viu')
+    f('lessThanEqual', 2, 110, _elementwise(lambda x, y: x <= y), 'viu')
+    f('greaterThan', 2, 110, _elementwise(lambda x, y: x > y), 'viu')
+    f('greaterThanEqual', 2, 110, _elementwise(lambda x, y: x >= y), 'viu')
+    f('equal', 2, 110, _elementwise(lambda x, y: x == y), 'viub')
+    f('notEqual', 2, 110, _elementwise(lambda x, y: x != y), 'viub')
     f('not', 1, 110, lambda x: not x, 'b')
 _make_vector_relational_test_vectors(test_suite)
 
@@ -9,6 +9,8 @@ import os
 import sys
 
 from collections import namedtuple
+from cStringIO import StringIO
+from generator_utils import write_if_changed, generate
 from mako.template import Template
 from math import copysign, fabs, fmod, frexp, isinf, isnan, modf
 from numpy import int8, int16, int32, uint8, uint16, uint32, float32
@@ -1414,18 +1416,17 @@ class ShaderTest:
             "built-in-functions",
             "{0}-{1}.shader_test".format(execution_stage, func_info.name))
 
-    @property
     def filename(self):
         return self.__filename
 
     def write_file(self):
-        dirname = os.path.dirname(self.filename)
-        if not os.path.exists(dirname):
-            os.makedirs(dirname)
-
-        with open(self.filename, "w") as buffer:
-            ctx = mako.runtime.Context(buffer, func=self.__func_info)
-            self.__template.render_context(ctx)
+        """Write the test, unless the file already holds it.  Returns True
+        if it was written.
+        """
+        buffer = StringIO()
+        ctx = mako.runtime.Context(buffer, func=self.__func_info)
+        self.__template.render_context(ctx)
+        return write_if_changed(self.filename(), buffer.getvalue())
 
 
 def main():
@@ -1446,15 +1447,8 @@ def main():
         parser.print_help()
         sys.exit(1)
 
-    for test in ShaderTest.all_tests():
-        print(test.filename)
-
-        # Some test files take a long time to generate, so provide status
-        # updates to the user immediately.
-        sys.stdout.flush()
-
-        if not options.names_only:
-            test.write_file()
+    generate(ShaderTest.all_tests(), ShaderTest.write_file,
+             options.names_only)
 
 if __name__ == '__main__':
     main()
@@ -40,11 +40,19 @@
 # For built-in functions whose result type is a matrix, the test
 # checks one column at a time.
 #
+# With the optional argument --batched, the tests instead load the
+# test vectors into uniform arrays, a batch at a time, and evaluate a
+# whole batch with a single draw of one point per vector along the
+# bottom row of the window.  The shader compares each result with its
+# expected value and outputs green or red, and "probe each rgba"
+# reports every failing vector from a single readback.
+#
 # This program outputs, to stdout, the name of each file it generates.
 # With the optional argument --names-only, it only outputs the names
 # of the files; it doesn't generate them.
 
 from builtin_function import *
+from generator_utils import write_if_changed, generate
 import abc
 import numpy
 import optparse
@@ -53,6 +61,18 @@ import os.path
 import sys
 
 
+# Width of shader_runner's window, and so the largest batch of test
+# vectors a batched test draws at once.
+WINDOW_WIDTH = 250
+
+# Uniform components a batched test may use in the shader stage under
+# test.  This is the minimum GL 3.0 requires of each stage.
+BATCH_UNIFORM_COMPONENTS = 1024
+
+GREEN = 'vec4(0.0, 1.0, 0.0, 1.0)'
+RED = 'vec4(1.0, 0.0, 0.0, 1.0)'
+
+
 def compute_offset_and_scale(test_vectors):
     """Compute scale and offset values such that for each result in
     test_vectors, (result - offset) * scale is in the range [0.25,
@@ -130,6 +150,31 @@ class Comparator(object):
         single test vector.
         """
 
+    @abc.abstractmethod
+    def make_batched_declarations(self, batch_size):
+        """Return the declarations of the uniform arrays that hold the
+        expected results of a batch of batch_size test vectors.
+        """
+
+    @abc.abstractmethod
+    def make_batched_result_handler(self, invocation, output_var):
+        """Return the shader code that compares the result with
+        element i of the expected arrays and stores green or red in
+        output_var.
+        """
+
+    @abc.abstractmethod
+    def make_batched_uniforms(self, index, test_vector):
+        """Return the shader_runner commands that set element index of
+        the expected arrays for test_vector.
+        """
+
+    def batched_uniform_slots(self):
+        """Return the number of vec4 uniform slots that one test
+        vector's expectations take up in a batched test.
+        """
+        return 1
+
     def testname_suffix(self):
         """Return a string to be used as a suffix on the test name to
         distinguish it from tests using other comparators."""
@@ -173,6 +218,22 @@ class BoolComparator(Comparator):
             shader_runner_format(self.convert_to_float(test_vector.result)))
         return test
 
+    def make_batched_declarations(self, batch_size):
+        return 'uniform {0} expected[{1}];\n'.format(
+            self.__signature.rettype, batch_size)
+
+    def make_batched_result_handler(self, invocation, output_var):
+        statements = '  {0} result = {1};\n'.format(
+            self.__signature.rettype, invocation)
+        statements += '  {0} = result == expected[i] ? {1} : {2};\n'.format(
+            output_var, GREEN, RED)
+        return statements
+
+    def make_batched_uniforms(self, index, test_vector):
+        return 'uniform {0} expected[{1}] {2}\n'.format(
+            shader_runner_type(self.__signature.rettype), index,
+            shader_runner_format(column_major_values(test_vector.result)))
+
 
 class BoolIfComparator(Comparator):
     """Comparator that tests functions returning bools by evaluating
@@ -214,6 +275,22 @@ class BoolIfComparator(Comparator):
             shader_runner_format(self.convert_to_float(test_vector.result)))
         return test
 
+    def make_batched_declarations(self, batch_size):
+        return 'uniform bool expected[{0}];\n'.format(batch_size)
+
+    def make_batched_result_handler(self, invocation, output_var):
+        statements = '  if({0})\n'.format(invocation)
+        statements += '    {0} = expected[i] ? {1} : {2};\n'.format(
+            output_var, GREEN, RED)
+        statements += '  else\n'
+        statements += '    {0} = expected[i] ? {1} : {2};\n'.format(
+            output_var, RED, GREEN)
+        return statements
+
+    def make_batched_uniforms(self, index, test_vector):
+        return 'uniform int expected[{0}] {1}\n'.format(
+            index, shader_runner_format([test_vector.result]))
+
     def testname_suffix(self):
         return '-using-if'
 
@@ -234,23 +311,39 @@ class IntComparator(Comparator):
     def make_additional_declarations(self):
         return 'uniform {0} expected;\n'.format(self.__signature.rettype)
 
-    def make_result_handler(self, invocation, output_var):
+    def make_result_handler(self, invocation, output_var, index=''):
         statements = '  {0} result = {1};\n'.format(
             self.__signature.rettype, invocation)
         statements += '  {v} = {cond} ? {green} : {red};\n'.format(
-            v=output_var, cond='result == expected',
-            green='vec4(0.0, 1.0, 0.0, 1.0)',
-            red='vec4(1.0, 0.0, 0.0, 1.0)')
+            v=output_var, cond='result == expected' + index,
+            green=GREEN, red=RED)
         return statements
 
-    def make_result_test(self, test_num, test_vector, draw):
-        test = 'uniform {0} expected {1}\n'.format(
-            shader_runner_type(self.__signature.rettype),
+    def make_expected_uniforms(self, index, test_vector):
+        return 'uniform {0} expected{1} {2}\n'.format(
+            shader_runner_type(self.__signature.rettype), index,
             shader_runner_format(column_major_values(test_vector.result)))
+
+    def make_result_test(self, test_num, test_vector, draw):
+        test = self.make_expected_uniforms('', test_vector)
         test += draw
         test += 'probe rgba {0} 0 0.0 1.0 0.0 1.0\n'.format(test_num)
         return test
 
+    def make_batched_declarations(self, batch_size):
+        return 'uniform {0} expected[{1}];\n'.format(
+            self.__signature.rettype, batch_size)
+
+    def make_batched_result_handler(self, invocation, output_var):
+        return self.make_result_handler(invocation, output_var, '[i]')
+
+    def make_batched_uniforms(self, index, test_vector):
+        return self.make_expected_uniforms(
+            '[{0}]'.format(index), test_vector)
+
+    def batched_uniform_slots(self):
+        return self.__signature.rettype.num_cols
+
 
 class FloatComparator(Comparator):
     """Comparator that tests functions returning floats or vecs using a
@@ -289,37 +382,59 @@ class FloatComparator(Comparator):
                 for col_indexer in col_indexers
                 for row_indexer in row_indexers]
 
-    def make_result_handler(self, invocation, output_var):
+    def make_result_handler(self, invocation, output_var, index=''):
+        expected = 'expected' + index
+        tolerance = 'tolerance' + index
         statements = '  {0} result = {1};\n'.format(
             self.__signature.rettype, invocation)
         # Can't use distance when testing itself, or when the rettype
         # is a matrix.
         if self.__signature.name == 'distance' or \
                 self.__signature.rettype.is_matrix:
-            statements += '  {0} residual = result - expected;\n'.format(
-                self.__signature.rettype)
+            statements += '  {0} residual = result - {1};\n'.format(
+                self.__signature.rettype, expected)
             statements += '  float error_sq = {0};\n'.format(
                 ' + '.join(
                     'residual{0} * residual{0}'.format(indexer)
                     for indexer in self.make_indexers()))
-            condition = 'error_sq <= tolerance * tolerance'
+            condition = 'error_sq <= {0} * {0}'.format(tolerance)
         else:
-            condition = 'distance(result, expected) <= tolerance'
+            condition = 'distance(result, {0}) <= {1}'.format(
+                expected, tolerance)
         statements += '  {v} = {cond} ? {green} : {red};\n'.format(
-            v=output_var, cond=condition, green='vec4(0.0, 1.0, 0.0, 1.0)',
-            red='vec4(1.0, 0.0, 0.0, 1.0)')
+            v=output_var, cond=condition, green=GREEN, red=RED)
         return statements
 
-    def make_result_test(self, test_num, test_vector, draw):
-        test = 'uniform {0} expected {1}\n'.format(
-            shader_runner_type(self.__signature.rettype),
+    def make_expected_uniforms(self, index, test_vector):
+        uniforms = 'uniform {0} expected{1} {2}\n'.format(
+            shader_runner_type(self.__signature.rettype), index,
             shader_runner_format(column_major_values(test_vector.result)))
-        test += 'uniform float tolerance {0}\n'.format(
-            shader_runner_format([test_vector.tolerance]))
+        uniforms += 'uniform float tolerance{0} {1}\n'.format(
+            index, shader_runner_format([test_vector.tolerance]))
+        return uniforms
+
+    def make_result_test(self, test_num, test_vector, draw):
+        test = self.make_expected_uniforms('', test_vector)
         test += draw
         test += 'probe rgba {0} 0 0.0 1.0 0.0 1.0\n'.format(test_num)
         return test
 
+    def make_batched_declarations(self, batch_size):
+        decls = 'uniform float tolerance[{0}];\n'.format(batch_size)
+        decls += 'uniform {0} expected[{1}];\n'.format(
+            self.__signature.rettype, batch_size)
+        return decls
+
+    def make_batched_result_handler(self, invocation, output_var):
+        return self.make_result_handler(invocation, output_var, '[i]')
+
+    def make_batched_uniforms(self, index, test_vector):
+        return self.make_expected_uniforms(
+            '[{0}]'.format(index), test_vector)
+
+    def batched_uniform_slots(self):
+        return self.__signature.rettype.num_cols + 1
+
 
 class ShaderTest(object):
     """Class used to build a test of a single built-in.  This is an
@@ -329,7 +444,7 @@ class ShaderTest(object):
     """
     __metaclass__ = abc.ABCMeta
 
-    def __init__(self, signature, test_vectors, use_if):
+    def __init__(self, signature, test_vectors, use_if, batched=False):
         """Prepare to build a test for a single built-in.  signature
         is the signature of the built-in (a key from the
         builtin_function.test_suite dict), and test_vectors is the
@@ -340,9 +455,14 @@ class ShaderTest(object):
         If use_if is True, then the generated test checks the result
         by using it in an if statement--this only works for builtins
         returning bool.
+
+        If batched is True, then the generated test evaluates a batch
+        of test vectors per draw, as described at the top of this
+        file.
         """
         self._signature = signature
         self._test_vectors = test_vectors
+        self._batched = batched
         if use_if:
             self._comparator = BoolIfComparator(signature)
         elif signature.rettype.base_type == glsl_bool:
@@ -363,6 +483,24 @@ class ShaderTest(object):
         else:
             return 'draw rect -1 -1 2 2\n'
 
+    def batch_size(self):
+        """Return the number of test vectors a batched test evaluates
+        per draw.  Every uniform array element is counted as taking a
+        vec4 slot per column, as some implementations store them.
+        """
+        slots = sum(argtype.num_cols for argtype in self._signature.argtypes)
+        slots += self._comparator.batched_uniform_slots()
+        return min(WINDOW_WIDTH, len(self._test_vectors),
+                   BATCH_UNIFORM_COMPONENTS // (4 * slots))
+
+    def batched_position(self):
+        """Return the GLSL expression for the clip-space position of
+        the point evaluating the test vector at element index of the
+        batch: the centre of pixel (index, 0).
+        """
+        return 'vec4(index * {0} - {1}, -{1}, 0.0, 1.0)'.format(
+            2.0 / WINDOW_WIDTH, 1.0 - 1.0 / WINDOW_WIDTH)
+
     def make_additional_requirements(self):
         """Return a string that should be included in the test's
         [require] section.
@@ -413,23 +551,42 @@ class ShaderTest(object):
         vec4.  suffix_statements is a string containing any additional
         statements that need to be inside the main() funciton of the
         shader, after the built-in function is called.
+
+        In a batched test the arguments are uniform arrays, and
+        prefix_statements must set int i to the index of the test
+        vector to evaluate.
         """
+        if self._batched:
+            array_size = '[{0}]'.format(self.batch_size())
+            index = '[i]'
+        else:
+            array_size = ''
+            index = ''
         shader = ''
         if self._signature.extension:
             shader += '#extension GL_{0} : require\n'.format(self._signature.extension)
         shader += additional_declarations
         for i in xrange(len(self._signature.argtypes)):
-            shader += 'uniform {0} arg{1};\n'.format(
-                self._signature.argtypes[i], i)
-        shader += self._comparator.make_additional_declarations()
+            shader += 'uniform {0} arg{1}{2};\n'.format(
+                self._signature.argtypes[i], i, array_size)
+        if self._batched:
+            shader += self._comparator.make_batched_declarations(
+                self.batch_size())
+        else:
+            shader += self._comparator.make_additional_declarations()
         shader += '\n'
         shader += 'void main()\n'
         shader += '{\n'
         shader += prefix_statements
         invocation = self._signature.template.format(
-            *['arg{0}'.format(i)
+            *['arg{0}{1}'.format(i, index)
               for i in xrange(len(self._signature.argtypes))])
-        shader += self._comparator.make_result_handler(invocation, output_var)
+        if self._batched:
+            shader += self._comparator.make_batched_result_handler(
+                invocation, output_var)
+        else:
+            shader += self._comparator.make_result_handler(
+                invocation, output_var)
         shader += suffix_statements
         shader += '}\n'
         return shader
@@ -438,6 +595,8 @@ class ShaderTest(object):
         """Make the complete shader_runner test file, and return it as
         a string.
         """
+        if self._batched:
+            return self.make_batched_test()
         test = ''
         for test_num, test_vector in enumerate(self._test_vectors):
             for i in xrange(len(test_vector.arguments)):
@@ -451,7 +610,52 @@ class ShaderTest(object):
                 test_num % 250, test_vector, self.draw_command())
         return test
 
+    def make_batched_test(self):
+        """Make the [test] section of a batched test: for each batch,
+        set the uniform array elements of its test vectors, draw one
+        point per vector and probe them all.
+        """
+        test = ''
+        batch_size = self.batch_size()
+        for first in xrange(0, len(self._test_vectors), batch_size):
+            batch = self._test_vectors[first:first + batch_size]
+            for index, test_vector in enumerate(batch):
+                for i in xrange(len(test_vector.arguments)):
+                    test += 'uniform {0} arg{1}[{2}] {3}\n'.format(
+                        shader_runner_type(self._signature.argtypes[i]),
+                        i, index, shader_runner_format(
+                            column_major_values(test_vector.arguments[i])))
+                test += self._comparator.make_batched_uniforms(
+                    index, test_vector)
+            test += 'draw arrays GL_POINTS 0 {0}\n'.format(len(batch))
+            test += 'probe each rgba (0, 0, {0}, 1) ' \
+                '(0.0, 1.0, 0.0, 1.0)\n'.format(len(batch))
+        return test
+
+    def make_batched_input(self, output_var=None):
+        """Return the vertex shader declarations of a batched test:
+        the index attribute, which gives each point's element of the
+        batch, and output_var if any.
+        """
+        if self.glsl_version() >= 140:
+            decls = 'in float index;\n'
+            if output_var:
+                decls += 'out {0};\n'.format(output_var)
+        else:
+            decls = 'attribute float index;\n'
+            if output_var:
+                decls += 'varying {0};\n'.format(output_var)
+        return decls
+
     def make_vbo_data(self):
+        if self._batched:
+            vbo = '[vertex data]\n'
+            vbo += 'index/float/1\n'
+            for index in xrange(self.batch_size()):
+                vbo += '{0}\n'.format(index)
+            vbo += '\n'
+            return vbo
+
         # Starting with GLSL 1.40/GL 3.1, we need to use VBOs and
         # vertex shader input bindings for our vertex data instead of
         # the piglit drawing utilities and gl_Vertex.
@@ -480,7 +684,9 @@ class ShaderTest(object):
                 self._comparator.testname_suffix()))
 
     def generate_shader_test(self):
-        """Generate the test and write it to the output file."""
+        """Generate the test and write it to the output file, unless
+        the file already holds it.  Returns True if it was written.
+        """
         shader_test = '[require]\n'
         shader_test += 'GLSL >= {0:1.2f}\n'.format(
             float(self.glsl_version()) / 100)
@@ -505,12 +711,7 @@ class ShaderTest(object):
         shader_test += self.make_vbo_data()
         shader_test += '[test]\n'
         shader_test += self.make_test()
-        filename = self.filename()
-        dirname = os.path.dirname(filename)
-        if not os.path.exists(dirname):
-            os.makedirs(dirname)
-        with open(filename, 'w') as f:
-            f.write(shader_test)
+        return write_if_changed(self.filename(), shader_test)
 
 
 class VertexShaderTest(ShaderTest):
@@ -520,8 +721,20 @@ class VertexShaderTest(ShaderTest):
     def test_prefix(self):
         return 'vs'
 
+    def make_additional_requirements(self):
+        if self._batched:
+            return 'GL_MAX_VERTEX_UNIFORM_COMPONENTS >= {0}\n'.format(
+                BATCH_UNIFORM_COMPONENTS)
+        return ''
+
     def make_vertex_shader(self):
-        if self.glsl_version() >= 140:
+        if self._batched:
+            return self.make_test_shader(
+                self.make_batched_input('vec4 color'),
+                '  gl_Position = {0};\n'.format(self.batched_position()) +
+                '  int i = int(index);\n',
+                'color', '')
+        elif self.glsl_version() >= 140:
             return self.make_test_shader(
                 'in vec4 vertex;\n' +
                 'out vec4 color;\n',
@@ -555,6 +768,16 @@ class GeometryShaderTest(ShaderTest):
         return max(150, ShaderTest.glsl_version(self))
 
     def make_vertex_shader(self):
+        if self._batched:
+            shader = self.make_batched_input('float index_to_gs')
+            shader += "void main()\n"
+            shader += "{\n"
+            shader += "     gl_Position = {0};\n".format(
+                self.batched_position())
+            shader += "     index_to_gs = index;\n"
+            shader += "}\n"
+            return shader
+
         shader = ''
         shader += "in vec4 vertex;\n"
         shader += "out vec4 vertex_to_gs;\n"
@@ -567,6 +790,19 @@ class GeometryShaderTest(ShaderTest):
         return shader
 
     def make_geometry_shader(self):
+        if self._batched:
+            return self.make_test_shader(
+                'layout(points) in;\n'
+                'layout(points, max_vertices = 1) out;\n'
+                'in float index_to_gs[1];\n'
+                'out vec4 color;\n',
+                '  vec4 tmp_color;\n'
+                '  int i = int(index_to_gs[0]);\n',
+                'tmp_color',
+                '  gl_Position = gl_in[0].gl_Position;\n'
+                '  color = tmp_color;\n'
+                '  EmitVertex();\n')
+
         additional_declarations = ''
         additional_declarations += 'layout(triangles) in;\n'
         additional_declarations \
@@ -601,7 +837,22 @@ class FragmentShaderTest(ShaderTest):
     def test_prefix(self):
         return 'fs'
 
+    def make_additional_requirements(self):
+        if self._batched:
+            return 'GL_MAX_FRAGMENT_UNIFORM_COMPONENTS >= {0}\n'.format(
+                BATCH_UNIFORM_COMPONENTS)
+        return ''
+
     def make_vertex_shader(self):
+        if self._batched:
+            shader = self.make_batched_input()
+            shader += "void main()\n"
+            shader += "{\n"
+            shader += "        gl_Position = {0};\n".format(
+                self.batched_position())
+            shader += "}\n"
+            return shader
+
         shader = ""
         if self.glsl_version() >= 140:
             shader += "in vec4 vertex;\n"
@@ -617,33 +868,41 @@ class FragmentShaderTest(ShaderTest):
         return shader
 
     def make_fragment_shader(self):
+        if self._batched:
+            return self.make_test_shader(
+                '', '  int i = int(gl_FragCoord.x);\n', 'gl_FragColor', '')
         return self.make_test_shader('', '', 'gl_FragColor', '')
 
 
-def all_tests():
+def all_tests(batched=False):
     for use_if in [False, True]:
         for signature, test_vectors in sorted(test_suite.items()):
             if use_if and signature.rettype != glsl_bool:
                 continue
-            yield VertexShaderTest(signature, test_vectors, use_if)
-            yield GeometryShaderTest(signature, test_vectors, use_if)
-            yield FragmentShaderTest(signature, test_vectors, use_if)
+            yield VertexShaderTest(signature, test_vectors, use_if, batched)
+            yield GeometryShaderTest(signature, test_vectors, use_if,
+                                     batched)
+            yield FragmentShaderTest(signature, test_vectors, use_if,
+                                     batched)
 
 
 def main():
     desc = 'Generate shader tests that test built-in functions using uniforms'
-    usage = 'usage: %prog [-h] [--names-only]'
+    usage = 'usage: %prog [-h] [--names-only] [--batched]'
     parser = optparse.OptionParser(description=desc, usage=usage)
     parser.add_option(
         '--names-only',
         dest='names_only',
         action='store_true',
         help="Don't output files, just generate a list of filenames to stdout")
+    parser.add_option(
+        '--batched',
+        dest='batched',
+        action='store_true',
+        help='Evaluate a batch of test vectors per draw, rather than one')
     options, args = parser.parse_args()
-    for test in all_tests():
-        if not options.names_only:
-            test.generate_shader_test()
-        print test.filename()
+    generate(all_tests(options.batched), ShaderTest.generate_shader_test,
+             options.names_only)
 
 
 if __name__ == '__main__':
@@ -45,6 +45,7 @@
 # of the files; it doesn't generate them.
 
 from builtin_function_fp64 import *
+from generator_utils import write_if_changed, generate
 import abc
 import numpy
 import optparse
@@ -480,7 +481,9 @@ class ShaderTest(object):
                 self._comparator.testname_suffix()))
 
     def generate_shader_test(self):
-        """Generate the test and write it to the output file."""
+        """Generate the test and write it to the output file, unless
+        the file already holds it.  Returns True if it was written.
+        """
         shader_test = '[require]\n'
         shader_test += 'GLSL >= {0:1.2f}\n'.format(
             float(self.glsl_version()) / 100)
@@ -505,12 +508,7 @@ class ShaderTest(object):
         shader_test += self.make_vbo_data()
         shader_test += '[test]\n'
         shader_test += self.make_test()
-        filename = self.filename()
-        dirname = os.path.dirname(filename)
-        if not os.path.exists(dirname):
-            os.makedirs(dirname)
-        with open(filename, 'w') as f:
-            f.write(shader_test)
+        return write_if_changed(self.filename(), shader_test)
 
 
 class VertexShaderTest(ShaderTest):
@@ -640,10 +638,7 @@ def main():
         action='store_true',
         help="Don't output files, just generate a list of filenames to stdout")
     options, args = parser.parse_args()
-    for test in all_tests():
-        if not options.names_only:
-            test.generate_shader_test()
-        print test.filename()
+    generate(all_tests(), ShaderTest.generate_shader_test, options.names_only)
 
 
 if __name__ == '__main__':
@@ -22,10 +22,11 @@
 
 from __future__ import print_function
 import re
-import os
 import textwrap
 import mako.template
 
+from generator_utils import write_if_changed
+
 TEMPLATE = mako.template.Template(textwrap.dedent("""
     [require]
     GLSL >= 1.20
@@ -90,20 +91,14 @@ TEST_VECTORS = [
 
 def main():
     """ Main function """
-    try:
-        os.makedirs('spec/glsl-1.20/execution/built-in-functions')
-    except OSError:
-        pass
-
     for test_id, x in enumerate(TEST_VECTORS, start=2):
         # make equal tests
         name = ("spec/glsl-1.20/execution/built-in-functions/"
                 "glsl-const-builtin-equal-{0:02d}.shader_test".format(test_id))
         print(name)
 
-        with open(name, 'w') as f:
-            f.write(TEMPLATE.render_unicode(
-                func='equal', input=x[0:2], expected=x[2]))
+        write_if_changed(name, TEMPLATE.render_unicode(
+            func='equal', input=x[0:2], expected=x[2]))
 
         # make notEqual tests
         name = ("spec/glsl-1.20/execution/built-in-functions/"
@@ -118,9 +113,8 @@ def main():
 
         print(name)
 
-        with open(name, 'w') as f:
-            f.write(TEMPLATE.render_unicode(
-                func='notEqual', input=x[0:2], expected=expected))
+        write_if_changed(name, TEMPLATE.render_unicode(
+            func='notEqual', input=x[0:2], expected=expected))
 
 if __name__ == "__main__":
     main()
@@ -35,6 +35,7 @@
 # of the files; it doesn't generate them.
 
 from builtin_function import *
+from generator_utils import write_if_changed, generate
 import abc
 import optparse
 import os
@@ -176,7 +177,9 @@ class ParserTest(object):
                 self.__signature.name, argtype_names, self.test_suffix()))
 
     def generate_parser_test(self):
-        """Generate the test and write it to the output file."""
+        """Generate the test and write it to the output file, unless
+        the file already holds it.  Returns True if it was written.
+        """
         parser_test = '/* [config]\n'
         parser_test += ' * expect_result: pass\n'
         parser_test += ' * glsl_version: {0:1.2f}\n'.format(
@@ -196,12 +199,7 @@ class ParserTest(object):
                 glsl_constant(test_vector.result))
         parser_test += ' */\n'
         parser_test += self.make_shader()
-        filename = self.filename()
-        dirname = os.path.dirname(filename)
-        if not os.path.exists(dirname):
-            os.makedirs(dirname)
-        with open(filename, 'w') as f:
-            f.write(parser_test)
+        return write_if_changed(self.filename(), parser_test)
 
 
 class VertexParserTest(ParserTest):
@@ -262,10 +260,7 @@ def main():
                            "filenames to stdout")
     options, args = parser.parse_args()
 
-    for test in all_tests():
-        if not options.names_only:
-            test.generate_parser_test()
-        print test.filename()
+    generate(all_tests(), ParserTest.generate_parser_test, options.names_only)
 
 
 if __name__ == '__main__':
@@ -65,6 +65,8 @@
 
 import os
 
+from generator_utils import write_if_changed, generate
+
 
 class Test(object):
     def __init__(self, interpolation_qualifier, variable, shade_model,
@@ -322,12 +324,7 @@ class Test(object):
         for x, y, r, g, b, a in self.probe_data():
             test += ('relative probe rgba ({0}, {1}) ({2}, {3}, {4}, {5})\n'
                      .format(x, y, r, g, b, a))
-        filename = self.filename()
-        dirname = os.path.dirname(filename)
-        if not os.path.exists(dirname):
-            os.makedirs(dirname)
-        with open(filename, 'w') as f:
-            f.write(test)
+        return write_if_changed(self.filename(), test)
 
 
 def all_tests():
@@ -342,9 +339,7 @@ def all_tests():
 
 
 def main():
-    for test in all_tests():
-        test.generate()
-        print test.filename()
+    generate(all_tests(), Test.generate)
 
 
 if __name__ == '__main__':
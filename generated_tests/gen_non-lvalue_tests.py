@@ -23,6 +23,8 @@
 
 import os
 
+from generator_utils import write_if_changed, generate
+
 
 class Test(object):
     def __init__(self, type_name, op, usage, shader_target):
@@ -137,12 +139,7 @@ void main()
                            var_as_vec4=var_as_vec4,
                            mode=mode)
 
-        filename = self.filename()
-        dirname = os.path.dirname(filename)
-        if not os.path.exists(dirname):
-            os.makedirs(dirname)
-        with open(filename, 'w') as f:
-            f.write(test)
+        return write_if_changed(self.filename(), test)
 
 
 def all_tests():
@@ -155,9 +152,7 @@ def all_tests():
 
 
 def main():
-    for test in all_tests():
-        test.generate()
-        print test.filename()
+    generate(all_tests(), Test.generate)
 
 
 if __name__ == '__main__':
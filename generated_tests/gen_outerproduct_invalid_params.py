@@ -19,10 +19,11 @@
 # SOFTWARE.
 
 from __future__ import print_function
-import os
 import textwrap
 import mako.template
 
+from generator_utils import write_if_changed
+
 
 def main():
     """ Generate tests """
@@ -40,19 +41,13 @@ def main():
     }
     """))
 
-    try:
-        os.makedirs('spec/glsl-1.20/compiler/built-in-functions')
-    except OSError:
-        pass
-
     for type_ in ['int', 'float', 'bool', 'bvec2', 'bvec3', 'bvec4', 'mat2',
                   'mat2x2', 'mat2x3', 'mat2x4', 'mat3', 'mat3x2', 'mat3x3',
                   'mat3x4', 'mat4', 'mat4x2', 'mat4x3', 'mat4x4']:
         name = ('spec/glsl-1.20/compiler/built-in-functions/'
                 'outerProduct-{0}.vert'.format(type_))
         print(name)
-        with open(name, 'w+') as f:
-            f.write(template.render_unicode(type=type_))
+        write_if_changed(name, template.render_unicode(type=type_))
 
 
 if __name__ == '__main__':
@@ -26,17 +26,14 @@ import itertools
 import collections
 import mako.template
 
+from generator_utils import write_if_changed
+
 Parameters = collections.namedtuple(
     'Paramters', ['columns', 'rows', 'vec_type', 'matrix'])
 
 
 def main():
     """ Generate tests """
-    try:
-        os.makedirs('spec/glsl-1.20/execution')
-    except OSError:
-        pass
-
     name = ('spec/glsl-1.20/execution/'
             '{shader}-outerProduct-{type}{mat}{vec}.shader_test')
 
@@ -66,10 +63,8 @@ def main():
 
                     print(_name)
 
-                    with open(_name, 'w+') as f:
-                        f.write(template.render_unicode(params=params,
-                                                        type=type,
-                                                        shader=shader))
+                    write_if_changed(_name, template.render_unicode(
+                        params=params, type=type, shader=shader))
 
 if __name__ == '__main__':
     main()
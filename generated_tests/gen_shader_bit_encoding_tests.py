@@ -25,6 +25,7 @@ import struct
 import os
 import os.path
 from mako.template import Template
+from generator_utils import write_if_changed
 from textwrap import dedent
 
 def floatBitsToInt(f):
@@ -241,25 +242,20 @@ for api, requirement in requirements.iteritems():
                                                                         modifier_name))
                 print filename
 
-                dirname = os.path.dirname(filename)
-                if not os.path.exists(dirname):
-                    os.makedirs(dirname)
-
                 if in_modifier_func == 'neg':
                     in_modifier_func = '-'
                 elif in_modifier_func == 'neg_abs':
                     in_modifier_func = '-abs'
 
-                f = open(filename, 'w')
-                f.write(template.render(version=version,
-                                        extensions=extensions,
-                                        execution_stage=execution_stage,
-                                        func=func,
-                                        modifier_func=modifier_func,
-                                        in_modifier_func=in_modifier_func,
-                                        in_func=in_func,
-                                        out_func=out_func,
-                                        input_type=input_type,
-                                        output_type=output_type,
-                                        test_data=test_data))
-                f.close()
+                write_if_changed(filename, template.render(
+                    version=version,
+                    extensions=extensions,
+                    execution_stage=execution_stage,
+                    func=func,
+                    modifier_func=modifier_func,
+                    in_modifier_func=in_modifier_func,
+                    in_func=in_func,
+                    out_func=out_func,
+                    input_type=input_type,
+                    output_type=output_type,
+                    test_data=test_data))
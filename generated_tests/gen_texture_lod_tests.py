@@ -21,11 +21,12 @@
 """ Generate spec/ARB_shader_texture_lod tests """
 
 from __future__ import print_function
-import os
 import textwrap
 import collections
 import mako.template
 
+from generator_utils import write_if_changed
+
 Parameters = collections.namedtuple(
     'Parameters', ['coord', 'grad', 'dimensions', 'mode'])
 
@@ -81,8 +82,7 @@ def gen_frag_lod_test(parameter, filename):
       gl_FragColor = ${param.mode}Lod(s, coord, lod);
     }
     """))
-    with open(filename, 'w+') as f:
-        f.write(template.render_unicode(param=parameter))
+    write_if_changed(filename, template.render_unicode(param=parameter))
 
 
 def gen_frag_grad_test(parameter, filename):
@@ -106,10 +106,9 @@ def gen_frag_grad_test(parameter, filename):
       gl_FragColor = ${param.mode}GradARB(s, coord, dPdx, dPdy);
     }
     """))
-    with open(filename, 'w+') as f:
-        f.write(template.render_unicode(
-            param=parameter,
-            extensions=get_extensions(parameter.mode)))
+    write_if_changed(filename, template.render_unicode(
+        param=parameter,
+        extensions=get_extensions(parameter.mode)))
 
 
 def gen_vert_grad_test(parameter, filename):
@@ -136,10 +135,9 @@ def gen_vert_grad_test(parameter, filename):
       color = ${param.mode}GradARB(s, coord, dPdx, dPdy);
     }
     """))
-    with open(filename, 'w+') as f:
-        f.write(template.render_unicode(
-            param=parameter,
-            extensions=get_extensions(parameter.mode)))
+    write_if_changed(filename, template.render_unicode(
+        param=parameter,
+        extensions=get_extensions(parameter.mode)))
 
 
 def main():
@@ -148,11 +146,6 @@ def main():
     Writes tests to generated_tests/spec/arb_shader_texture_lod/ directory
 
     """
-    try:
-        os.makedirs('spec/arb_shader_texture_lod/compiler')
-    except OSError:
-        pass
-
     for params in LOD_TESTS:
         name = ("spec/arb_shader_texture_lod/compiler/"
                 "tex_lod-{mode}-{dimensions}-{coord}.frag".format(
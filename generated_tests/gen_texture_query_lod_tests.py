@@ -24,6 +24,7 @@
 import os
 import os.path
 from mako.template import Template
+from generator_utils import write_if_changed
 from textwrap import dedent
 
 sampler_type_to_coord_type = {
@@ -125,10 +126,6 @@ for api, requirement in requirements.iteritems():
                                                                      file_extension))
             print filename
 
-            dirname = os.path.dirname(filename)
-            if not os.path.exists(dirname):
-                os.makedirs(dirname)
-
             version = requirement['version']
             extensions = [requirement['extension']] if requirement['extension'] else []
 
@@ -139,11 +136,10 @@ for api, requirement in requirements.iteritems():
                     'usamplerCubeArray', 'samplerCubeArrayShadow']:
                 extensions += ['GL_ARB_texture_cube_map_array']
 
-            f = open(filename, "w")
-            f.write(template.render(version=version,
-                                    extensions=extensions,
-                                    execution_stage=execution_stage,
-                                    sampler_type=sampler_type,
-                                    coord_type=coord_type,
-                                    Lod=Lod))
-            f.close()
+            write_if_changed(filename, template.render(
+                version=version,
+                extensions=extensions,
+                execution_stage=execution_stage,
+                sampler_type=sampler_type,
+                coord_type=coord_type,
+                Lod=Lod))
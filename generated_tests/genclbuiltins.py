@@ -2,6 +2,9 @@ __all__ = ['gen', 'DATA_SIZES', 'MAX_VALUES', 'MAX', 'MIN', 'BMIN', 'BMAX',
            'SMIN', 'SMAX', 'UMIN', 'UMAX', 'TYPE', 'T', 'U', 'B']
 
 import os
+from cStringIO import StringIO
+
+from generator_utils import write_if_changed
 
 
 DATA_SIZES = {
@@ -348,10 +351,6 @@ def print_test(f, fnName, argType, functionDef, tests, testIdx, vecSize, tss):
 
 
 def gen(types, minVersions, functions, testDefs, dirName):
-    # Create the output directory if required
-    if not os.path.exists(dirName):
-        os.makedirs(dirName)
-
     # Loop over all data types being tested. Create one output file per data
     # type
     for dataType in types:
@@ -372,7 +371,7 @@ def gen(types, minVersions, functions, testDefs, dirName):
 
             fileName = os.path.join(dirName, fileName)
 
-            f = open(fileName, 'w')
+            f = StringIO()
             print(fileName)
             # Write the file header
             f.write('/*!\n' +
@@ -405,6 +404,6 @@ def gen(types, minVersions, functions, testDefs, dirName):
             # Generate the actual kernels
             generate_kernels(f, dataType, fnName, functionDef)
 
-        f.close()
+            write_if_changed(fileName, f.getvalue())
 
 
@@ -25,13 +25,14 @@
 
 import os
 import textwrap
+from cStringIO import StringIO
+
+from generator_utils import write_if_changed
 
 TYPES = ['char', 'uchar', 'short', 'ushort', 'int', 'uint', 'long', 'ulong', 'float', 'double']
 VEC_SIZES = ['', '2', '4', '8', '16']
 
 dirName = os.path.join("cl", "store")
-if not os.path.exists(dirName):
-    os.makedirs(dirName)
 
 
 def gen_array(size):
@@ -54,12 +55,13 @@ def print_config(f, type_name, addr_space):
     .format(type_name=type_name, addr_space=addr_space)))
 
 
-def begin_test(type_name, addr_space):
+def write_test(type_name, addr_space, tests):
     fileName = os.path.join(dirName, 'store-' + type_name + '-' + addr_space + '.program_test')
     print(fileName)
-    f = open(fileName, 'w')
+    f = StringIO()
     print_config(f, type_name, addr_space)
-    return f
+    f.write(tests)
+    write_if_changed(fileName, f.getvalue())
 
 
 for t in TYPES:
@@ -69,8 +71,7 @@ for t in TYPES:
         else:
             size = int(s)
         type_name = t + s
-        f = begin_test(type_name, 'global')
-        f.write(textwrap.dedent("""
+        write_test(type_name, 'global', textwrap.dedent("""
         [test]
         name: global address space
         global_size: 1 0 0
@@ -85,10 +86,7 @@ for t in TYPES:
         arg_in:  1 buffer {type_name}[8] {gen_array}
         """.format(type_name=type_name, gen_array=gen_array(size))))
 
-        f.close()
-
-        f = begin_test(type_name, 'local')
-        f.write(textwrap.dedent("""
+        write_test(type_name, 'local', textwrap.dedent("""
         [test]
         name: local address space
         global_size: 8 0 0
@@ -97,5 +95,3 @@ for t in TYPES:
         arg_out: 0 buffer {type_name}[8] {gen_array}
         arg_in:  1 buffer {type_name}[8] {gen_array}
         """.format(type_name=type_name, gen_array=gen_array(size))))
-
-        f.close()
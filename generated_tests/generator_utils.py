@@ -0,0 +1,235 @@
+# coding=utf-8
+#
+# Copyright © 2014 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+# DEALINGS IN THE SOFTWARE.
+
+# Helpers shared by the test generators.
+#
+# write_if_changed() only touches a generated file when its contents
+# differ from what is already on disk, so regenerating after an
+# unrelated change to builtin_function.py leaves the mtimes of
+# unchanged tests alone and the install step has nothing to redo for
+# them.
+#
+# generate() drives a generator's list of tests through a pool of
+# worker processes and prints the file names, in order, to stdout for
+# the .list file that CMake uses to track the generator.
+#
+# The number of worker processes defaults to the number of CPUs and
+# can be overridden with PIGLIT_GENERATOR_JOBS (1 disables the pool).
+#
+# Run as a script, this module runs a generator and writes a report of
+# how many files it wrote, how many were already up to date, and how
+# long it took:
+#
+#   generator_utils.py --report <report file> <generator> [args...]
+#
+# and prints the reports of several generators, slowest first:
+#
+#   generator_utils.py --summarize <report file>...
+#
+# generated_tests/CMakeLists.txt runs every generator this way, and
+# its gen-tests-report target prints the summary.
+
+import errno
+import itertools
+import multiprocessing
+import os
+import os.path
+import runpy
+import sys
+import time
+
+__all__ = ['write_if_changed', 'generate']
+
+# How many files write_if_changed() has written and found up to date,
+# in this process and in the workers of finished run_jobs() calls.
+_counts = {'written': 0, 'unchanged': 0}
+
+
+def write_if_changed(filename, contents):
+    """Write contents to filename, creating its directory if needed,
+    unless the file already holds exactly those contents.
+
+    The file is written to a temporary name and renamed into place so
+    an interrupted build never leaves a truncated test behind.
+
+    Returns True if the file was written, False if it was up to date.
+    """
+    try:
+        with open(filename, 'r') as f:
+            if f.read() == contents:
+                _counts['unchanged'] += 1
+                return False
+    except IOError as e:
+        if e.errno != errno.ENOENT:
+            raise
+
+    dirname = os.path.dirname(filename)
+    if dirname:
+        try:
+            os.makedirs(dirname)
+        except OSError as e:
+            # Another worker may have created it first.
+            if e.errno != errno.EEXIST:
+                raise
+
+    tmpname = '{0}.{1}.tmp'.format(filename, os.getpid())
+    with open(tmpname, 'w') as f:
+        f.write(contents)
+    if sys.platform == 'win32' and os.path.exists(filename):
+        os.remove(filename)
+    os.rename(tmpname, filename)
+    _counts['written'] += 1
+    return True
+
+
+# The (function, items) pair being processed by run_jobs().  Worker
+# processes inherit it when the pool forks, so only item indices and
+# results need to be pickled; the test objects themselves hold
+# lambdas and can't be.
+_jobs = None
+
+
+def _run_job(index):
+    """Return the result of the job, and what it added to _counts, which
+    the worker's copy of _counts can't pass back by itself.
+    """
+    func, items = _jobs
+    before = dict(_counts)
+    result = func(items[index])
+    return result, dict((k, v - before[k]) for k, v in _counts.iteritems())
+
+
+def _num_jobs():
+    jobs = os.environ.get('PIGLIT_GENERATOR_JOBS')
+    if jobs:
+        return max(1, int(jobs))
+    try:
+        return multiprocessing.cpu_count()
+    except NotImplementedError:
+        return 1
+
+
+def run_jobs(func, items):
+    """Call func on each of items and yield the results in order.
+
+    The calls are spread over a pool of worker processes when the
+    platform can fork them; otherwise they run in this process.
+    """
+    global _jobs
+
+    items = list(items)
+    jobs = min(_num_jobs(), len(items))
+    if jobs <= 1 or not hasattr(os, 'fork'):
+        for item in items:
+            yield func(item)
+        return
+
+    _jobs = (func, items)
+    pool = multiprocessing.Pool(jobs)
+    try:
+        chunksize = max(1, len(items) // (jobs * 8))
+        for result, counts in pool.imap(_run_job, xrange(len(items)),
+                                        chunksize):
+            for k, v in counts.iteritems():
+                _counts[k] += v
+            yield result
+        pool.close()
+    except:
+        pool.terminate()
+        raise
+    finally:
+        pool.join()
+        _jobs = None
+
+
+def generate(tests, write_test, names_only=False):
+    """Generate every test in tests and print its filename to stdout.
+
+    write_test is called with each test, possibly in a worker process,
+    to write its file.  Each test must have a filename() method.  If
+    names_only is set, nothing is written and only the names are
+    printed.
+    """
+    tests = list(tests)
+
+    if names_only:
+        results = itertools.repeat(None)
+    else:
+        results = run_jobs(write_test, tests)
+
+    for test, _ in itertools.izip(tests, results):
+        print test.filename()
+
+
+def _run_with_report(report, argv):
+    """Run the generator script argv[0] with arguments argv[1:], as if
+    it had been run directly, and write its report line to report.
+    """
+    script = argv[0]
+    start = time.time()
+    sys.argv = list(argv)
+    sys.path[0] = os.path.dirname(os.path.abspath(script))
+    runpy.run_path(script, run_name='__main__')
+    sys.stdout.flush()
+
+    with open(report, 'w') as f:
+        f.write('{0} {1} {2} {3:.2f}\n'.format(
+            os.path.basename(script), _counts['written'],
+            _counts['unchanged'], time.time() - start))
+
+
+def _summarize(reports):
+    """Print the reports, slowest generator first."""
+    rows = []
+    for report in reports:
+        with open(report, 'r') as f:
+            name, written, unchanged, seconds = f.read().split()
+        rows.append((float(seconds), name, int(written), int(unchanged)))
+
+    print '{0:<48} {1:>8} {2:>10} {3:>9}'.format(
+        'generator', 'written', 'unchanged', 'seconds')
+    for seconds, name, written, unchanged in sorted(rows, reverse=True):
+        print '{0:<48} {1:>8} {2:>10} {3:>9.2f}'.format(
+            name, written, unchanged, seconds)
+    print '{0:<48} {1:>8} {2:>10} {3:>9.2f}'.format(
+        'total', sum(r[2] for r in rows), sum(r[3] for r in rows),
+        sum(r[0] for r in rows))
+
+
+def main():
+    if len(sys.argv) >= 4 and sys.argv[1] == '--report':
+        _run_with_report(sys.argv[2], sys.argv[3:])
+    elif len(sys.argv) >= 2 and sys.argv[1] == '--summarize':
+        _summarize(sys.argv[2:])
+    else:
+        sys.stderr.write(
+            'usage: {0} --report <report file> <generator> [args...]\n'
+            '       {0} --summarize <report file>...\n'.format(sys.argv[0]))
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    # The generator imports this module under its own name, and that
+    # copy is the one whose counts get reported.
+    import generator_utils
+    generator_utils.main()
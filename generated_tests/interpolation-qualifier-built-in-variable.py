@@ -25,6 +25,7 @@ import struct
 import os
 import os.path
 from mako.template import Template
+from generator_utils import write_if_changed
 from textwrap import dedent
 
 interpolation_modes = [
@@ -113,16 +114,11 @@ for fs_mode in interpolation_modes:
                                                                          vertex_shader_to_fragment_shader_variable_map[var]))
             print filename
 
-            dirname = os.path.dirname(filename)
-            if not os.path.exists(dirname):
-                os.makedirs(dirname)
-
-            f = open(filename, 'w')
-            f.write(template.render(vs_mode=vs_mode,
-                                    vs_variable=var,
-                                    fs_mode=fs_mode,
-                                    fs_variable=vertex_shader_to_fragment_shader_variable_map[var]))
-            f.close()
+            write_if_changed(filename, template.render(
+                vs_mode=vs_mode,
+                vs_variable=var,
+                fs_mode=fs_mode,
+                fs_variable=vertex_shader_to_fragment_shader_variable_map[var]))
 
 template = Template(dedent("""\
     # Section 4.3.7 (Interpolation) of the GLSL 1.30 spec says:
@@ -176,14 +172,9 @@ for vs_mode in interpolation_modes:
                                                                         vertex_shader_to_fragment_shader_variable_map[var]))
         print filename
 
-        dirname = os.path.dirname(filename)
-        if not os.path.exists(dirname):
-            os.makedirs(dirname)
-
-        f = open(filename, 'w')
-        f.write(template.render(vs_mode=vs_mode,
-                                vs_variable=var))
-        f.close()
+        write_if_changed(filename, template.render(
+            vs_mode=vs_mode,
+            vs_variable=var))
 
 template = Template(dedent("""\
     # Section 4.3.7 (Interpolation) of the GLSL 1.30 spec says:
@@ -237,16 +228,11 @@ for fs_mode in interpolation_modes:
                                                                         vertex_shader_to_fragment_shader_variable_map[var]))
         print filename
 
-        dirname = os.path.dirname(filename)
-        if not os.path.exists(dirname):
-            os.makedirs(dirname)
-
-        f = open(filename, 'w')
-        f.write(template.render(vs_mode=vs_mode,
-                                vs_variable=var,
-                                fs_mode=fs_mode,
-                                fs_variable=vertex_shader_to_fragment_shader_variable_map[var]))
-        f.close()
+        write_if_changed(filename, template.render(
+            vs_mode=vs_mode,
+            vs_variable=var,
+            fs_mode=fs_mode,
+            fs_variable=vertex_shader_to_fragment_shader_variable_map[var]))
 
 
 template = Template(dedent("""\
@@ -308,16 +294,11 @@ for fs_mode in interpolation_modes:
                                                                                        vertex_shader_to_fragment_shader_variable_map[var]))
             print filename
 
-            dirname = os.path.dirname(filename)
-            if not os.path.exists(dirname):
-                os.makedirs(dirname)
-
-            f = open(filename, 'w')
-            f.write(template.render(vs_mode=vs_mode,
-                                    vs_variable=var,
-                                    fs_mode=fs_mode,
-                                    fs_variable=vertex_shader_to_fragment_shader_variable_map[var]))
-            f.close()
+            write_if_changed(filename, template.render(
+                vs_mode=vs_mode,
+                vs_variable=var,
+                fs_mode=fs_mode,
+                fs_variable=vertex_shader_to_fragment_shader_variable_map[var]))
 
 
 template = Template(dedent("""\
@@ -377,14 +358,9 @@ for fs_mode in interpolation_modes:
                                                                          other_side))
             print filename
 
-            dirname = os.path.dirname(filename)
-            if not os.path.exists(dirname):
-                os.makedirs(dirname)
-
-            f = open(filename, 'w')
-            f.write(template.render(vs_mode=vs_mode,
-                                    this_side_variable=this_side,
-                                    other_side_variable=other_side,
-                                    fs_mode=fs_mode,
-                                    fs_variable=vertex_shader_to_fragment_shader_variable_map[this_side]))
-            f.close()
+            write_if_changed(filename, template.render(
+                vs_mode=vs_mode,
+                this_side_variable=this_side,
+                other_side_variable=other_side,
+                fs_mode=fs_mode,
+                fs_variable=vertex_shader_to_fragment_shader_variable_map[this_side]))
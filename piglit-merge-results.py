@@ -27,7 +27,7 @@ import sys
 import os.path
 
 sys.path.append(os.path.dirname(os.path.realpath(sys.argv[0])))
-import framework.core as core
+import framework.results
 
 
 def main():
@@ -38,10 +38,10 @@ def main():
                         help="Space seperated list of results files")
     args = parser.parse_args()
 
-    combined = core.load_results(args.results.pop(0))
+    combined = framework.results.load_results(args.results.pop(0))
 
     for resultsDir in args.results:
-        results = core.load_results(resultsDir)
+        results = framework.results.load_results(resultsDir)
 
         for testname, result in results.tests.items():
             combined.tests[testname] = result
@@ -57,7 +57,12 @@
             <b>${line['text']}</b>
           </td>
         % elif line['type'] == "testResult":
+          ## Results carried forward by an incremental run get an extra class
+          % if line['carried']:
+          <td class="${line['class']} carried" title="carried forward">
+          % else:
           <td class="${line['class']}">
+          % endif
           ## If the result is in the excluded results page list from
           ## argparse, just print the text, otherwise add the link
           % if line['class'] not in exclude and line['href'] is not None:
@@ -67,6 +72,9 @@
           % else:
             ${line['text']}
           % endif
+          % if line['carried']:
+            <br /><small>(carried)</small>
+          % endif
           </td>
         % elif line['type'] == "subtestResult":
           <td class="${line['class']}">
@@ -12,6 +12,9 @@
     <h2>Overview</h2>
     <div>
       <p><b>Result:</b> ${value.get('status', 'None')}</p>
+    % if value.get('carried_forward') is not None:
+      <p><b>Carried forward from:</b> ${value['carried_forward'] | h}</p>
+    % endif
     </div>
     <p><a href="${index}">Back to summary</a></p>
     <h2>Details</h2>
@@ -28,6 +31,28 @@
         <td>Time</td>
         <td>${value.get('time', 'None')}</b>
       </tr>
+    % if value.get('attempts'):
+      <tr>
+        <td>Reruns</td>
+        <td>
+          <p>${value.get('classification', 'None')}</p>
+          <table>
+            <tr>
+              <th>Result</th>
+              <th>Returncode</th>
+              <th>Time</th>
+            </tr>
+          % for attempt in value['attempts']:
+            <tr>
+              <td>${attempt['result']}</td>
+              <td>${attempt.get('returncode', 'None')}</td>
+              <td>${attempt.get('time', 'None')}</td>
+            </tr>
+          % endfor
+          </table>
+        </td>
+      </tr>
+    % endif
     % if value.get('images', None):
       <tr>
         <td>Images</td>
@@ -124,6 +124,7 @@ glean['orthoPosTinyQuads'] = GleanTest('orthoPosTinyQuads')
 glean['orthoPosHLines'] = GleanTest('orthoPosHLines')
 glean['orthoPosVLines'] = GleanTest('orthoPosVLines')
 glean['orthoPosPoints'] = GleanTest('orthoPosPoints')
+glean['packConv'] = GleanTest('packConv')
 glean['paths'] = GleanTest('paths')
 glean['pbo'] = GleanTest('pbo')
 glean['polygonOffset'] = GleanTest('polygonOffset')
@@ -704,6 +705,7 @@ add_plain_test(gl11, 'lineloop')
 add_plain_test(gl11, 'linestipple')
 add_plain_test(gl11, 'longprim')
 add_concurrent_test(gl11, 'masked-clear')
+add_concurrent_test(gl11, 'packed-float-conversions')
 add_plain_test(gl11, 'point-line-no-cull')
 add_plain_test(gl11, 'polygon-mode')
 add_concurrent_test(gl11, 'polygon-mode-offset')
@@ -729,6 +731,7 @@ gl11['GL_SELECT - stencil-test enabled'] = PiglitTest(['select', 'stencil'])
 gl11['GL_SELECT - alpha-test enabled'] = PiglitTest(['select', 'alpha'])
 gl11['GL_SELECT - scissor-test enabled'] = PiglitTest(['select', 'scissor'])
 add_plain_test(gl11, 'stencil-drawpixels')
+add_concurrent_test(gl11, 'subtest-jobs')
 add_plain_test(gl11, 'texgen')
 add_plain_test(gl11, 'two-sided-lighting')
 add_plain_test(gl11, 'user-clip')
@@ -978,6 +981,8 @@ spec['!OpenGL 4.2/required-renderbuffer-attachment-formats'] = concurrent_test('
 spec['!OpenGL 4.2/required-sized-texture-formats'] = concurrent_test('gl-3.0-required-sized-texture-formats 42')
 spec['!OpenGL 4.2/required-texture-attachment-formats'] = concurrent_test('gl-3.0-required-texture-attachment-formats 42')
 
+spec['!OpenGL 4.3/probe-gpu'] = concurrent_test('probe-gpu')
+
 # Group spec/glsl-es-1.00
 spec['glsl-es-1.00'] = {}
 import_glsl_parser_tests(spec['glsl-es-1.00'],
@@ -2316,6 +2321,9 @@ add_concurrent_test(arb_texture_compression_bptc, 'compressedteximage GL_COMPRES
 add_concurrent_test(arb_texture_compression_bptc, 'compressedteximage GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM')
 add_concurrent_test(arb_texture_compression_bptc, 'compressedteximage GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT')
 add_concurrent_test(arb_texture_compression_bptc, 'compressedteximage GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT')
+add_concurrent_test(arb_texture_compression_bptc, 'compressed-random-blocks GL_COMPRESSED_RGBA_BPTC_UNORM')
+add_concurrent_test(arb_texture_compression_bptc, 'compressed-random-blocks GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT')
+add_concurrent_test(arb_texture_compression_bptc, 'compressed-random-blocks GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT')
 
 ext_vertex_array_bgra = {}
 spec['EXT_vertex_array_bgra'] = ext_vertex_array_bgra
@@ -2799,6 +2807,7 @@ add_plain_test(arb_texture_cube_map, 'cubemap-shader')
 arb_texture_cube_map['cubemap-shader lod'] = PiglitTest(['cubemap-shader', '-auto', 'lod'])
 arb_texture_cube_map['cubemap-shader bias'] = PiglitTest(['cubemap-shader', '-auto', 'bias'])
 add_concurrent_test(arb_texture_cube_map, 'getteximage-targets CUBE')
+add_concurrent_test(arb_texture_cube_map, 'ktx-cubemap')
 
 arb_texture_cube_map_array = {}
 spec['ARB_texture_cube_map_array'] = arb_texture_cube_map_array
@@ -2842,6 +2851,10 @@ add_concurrent_test(ext_texture_compression_rgtc, 'compressedteximage GL_COMPRES
 add_concurrent_test(ext_texture_compression_rgtc, 'compressedteximage GL_COMPRESSED_RED_GREEN_RGTC2_EXT')
 add_concurrent_test(ext_texture_compression_rgtc, 'compressedteximage GL_COMPRESSED_SIGNED_RED_RGTC1_EXT')
 add_concurrent_test(ext_texture_compression_rgtc, 'compressedteximage GL_COMPRESSED_SIGNED_RED_GREEN_RGTC2_EXT')
+add_concurrent_test(ext_texture_compression_rgtc, 'compressed-random-blocks GL_COMPRESSED_RED_RGTC1')
+add_concurrent_test(ext_texture_compression_rgtc, 'compressed-random-blocks GL_COMPRESSED_SIGNED_RED_RGTC1')
+add_concurrent_test(ext_texture_compression_rgtc, 'compressed-random-blocks GL_COMPRESSED_RG_RGTC2')
+add_concurrent_test(ext_texture_compression_rgtc, 'compressed-random-blocks GL_COMPRESSED_SIGNED_RG_RGTC2')
 add_fbo_generatemipmap_extension(ext_texture_compression_rgtc, 'GL_EXT_texture_compression_rgtc', 'fbo-generatemipmap-formats')
 add_fbo_generatemipmap_extension(ext_texture_compression_rgtc, 'GL_EXT_texture_compression_rgtc-signed', 'fbo-generatemipmap-formats-signed')
 add_texwrap_format_tests(ext_texture_compression_rgtc, 'GL_EXT_texture_compression_rgtc')
@@ -2855,6 +2868,10 @@ add_concurrent_test(ext_texture_compression_s3tc, 'compressedteximage GL_COMPRES
 add_concurrent_test(ext_texture_compression_s3tc, 'compressedteximage GL_COMPRESSED_RGBA_S3TC_DXT1_EXT')
 add_concurrent_test(ext_texture_compression_s3tc, 'compressedteximage GL_COMPRESSED_RGBA_S3TC_DXT3_EXT')
 add_concurrent_test(ext_texture_compression_s3tc, 'compressedteximage GL_COMPRESSED_RGBA_S3TC_DXT5_EXT')
+add_concurrent_test(ext_texture_compression_s3tc, 'compressed-random-blocks GL_COMPRESSED_RGB_S3TC_DXT1_EXT')
+add_concurrent_test(ext_texture_compression_s3tc, 'compressed-random-blocks GL_COMPRESSED_RGBA_S3TC_DXT1_EXT')
+add_concurrent_test(ext_texture_compression_s3tc, 'compressed-random-blocks GL_COMPRESSED_RGBA_S3TC_DXT3_EXT')
+add_concurrent_test(ext_texture_compression_s3tc, 'compressed-random-blocks GL_COMPRESSED_RGBA_S3TC_DXT5_EXT')
 add_fbo_generatemipmap_extension(ext_texture_compression_s3tc, 'GL_EXT_texture_compression_s3tc', 'fbo-generatemipmap-formats')
 add_texwrap_format_tests(ext_texture_compression_s3tc, 'GL_EXT_texture_compression_s3tc')
 ext_texture_compression_s3tc['invalid formats'] = concurrent_test('arb_texture_compression-invalid-formats s3tc')
@@ -4001,6 +4018,9 @@ egl14['eglQuerySurface EGL_BAD_SURFACE'] = plain_test('egl-query-surface --bad-s
 egl14['eglQuerySurface EGL_HEIGHT'] = plain_test('egl-query-surface --attr=EGL_HEIGHT')
 egl14['eglQuerySurface EGL_WIDTH'] = plain_test('egl-query-surface --attr=EGL_WIDTH')
 egl14['eglTerminate then unbind context'] = plain_test('egl-terminate-then-unbind-context')
+for workload in ['compile', 'texture-upload', 'buffer-map', 'draw']:
+    egl14['multi-context stress ' + workload] = plain_test(
+        'egl-multi-context-stress -workload ' + workload + ' -auto')
 
 egl_nok_swap_region = {}
 spec['EGL_NOK_swap_region'] = egl_nok_swap_region
@@ -4076,6 +4096,7 @@ for tex_format in ('rgb8', 'srgb8', 'rgba8', 'srgb8-alpha8', 'r11', 'rg11', 'rgb
         test_name = ' ' .join(['oes_compressed_etc2_texture-miptree', tex_format, context])
         executable = '{0}'.format(test_name)
         arb_es3_compatibility[test_name] = concurrent_test(executable)
+add_concurrent_test(arb_es3_compatibility, 'compressed-random-blocks GL_ETC1_RGB8_OES')
 
 add_shader_test_dir(spec, os.path.join(generatedTestDir, 'spec'),
                     recursive=True)
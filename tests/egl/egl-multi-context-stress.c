@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ *
+ * Run GL workloads on 1, 2, 4, ... up to N threads at once, each thread in
+ * its own EGL context, and print how throughput scales with the number of
+ * threads.
+ *
+ * Usage: egl-multi-context-stress [-workload NAME] [-threads N]
+ *                                 [-seconds S] [-share] [-min-scaling F]
+ *
+ * -workload picks one of compile, texture-upload, buffer-map and draw;
+ * by default all of them run, each as a subtest.  -share puts all contexts
+ * in one share group.  With -min-scaling a workload fails unless running it
+ * on N threads is at least F times N as fast as running it on one; without
+ * it, only GL errors make workloads fail.
+ */
+
+#include "piglit-egl-stress.h"
+
+static void
+usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-workload NAME] [-threads N] "
+		"[-seconds S] [-share] [-min-scaling F] [-auto]\n", name);
+	piglit_report_result(PIGLIT_FAIL);
+}
+
+static enum piglit_result
+run_workload(const struct piglit_egl_stress_workload *workload,
+	     unsigned max_threads, double seconds, bool share,
+	     double min_scaling)
+{
+	struct piglit_egl_stress_config config;
+	struct piglit_egl_stress_stats stats;
+	enum piglit_result result = PIGLIT_SKIP;
+	double base = 0, speedup = 0;
+	unsigned n;
+
+	config.workload = workload;
+	config.seconds = seconds;
+	config.share_group = share;
+
+	printf("%s: threads, iterations/s, speedup, efficiency\n",
+	       workload->name);
+	for (n = 1; ; n = n * 2 < max_threads ? n * 2 : max_threads) {
+		config.num_threads = n;
+		piglit_egl_stress_run(&config, &stats);
+		piglit_egl_stress_print_stats(&config, &stats);
+		piglit_merge_result(&result, stats.result);
+		if (stats.result != PIGLIT_PASS)
+			return result;
+
+		if (n == 1)
+			base = stats.throughput;
+		speedup = base > 0 ? stats.throughput / base : 0;
+		printf("%s: %u, %.1f, %.2f, %.0f%%\n", workload->name, n,
+		       stats.throughput, speedup, 100 * speedup / n);
+
+		if (n == max_threads)
+			break;
+	}
+
+	if (min_scaling > 0 && speedup < min_scaling * max_threads) {
+		printf("%s: %u threads are %.2f times as fast as one, "
+		       "expected at least %.2f\n", workload->name,
+		       max_threads, speedup, min_scaling * max_threads);
+		result = PIGLIT_FAIL;
+	}
+	return result;
+}
+
+int
+main(int argc, char **argv)
+{
+	const struct piglit_egl_stress_workload *workload = NULL;
+	enum piglit_result result = PIGLIT_SKIP;
+	unsigned max_threads = 4;
+	double seconds = 0.5;
+	double min_scaling = 0;
+	bool share = false;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (streq(argv[i], "-workload") && i + 1 < argc) {
+			workload = piglit_egl_stress_find_workload(argv[++i]);
+			if (workload == NULL)
+				usage(argv[0]);
+		} else if (streq(argv[i], "-threads") && i + 1 < argc) {
+			max_threads = atoi(argv[++i]);
+			if (max_threads < 1 ||
+			    max_threads > PIGLIT_EGL_STRESS_MAX_THREADS)
+				usage(argv[0]);
+		} else if (streq(argv[i], "-seconds") && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		} else if (streq(argv[i], "-min-scaling") && i + 1 < argc) {
+			min_scaling = atof(argv[++i]);
+		} else if (streq(argv[i], "-share")) {
+			share = true;
+		} else if (!streq(argv[i], "-auto")) {
+			usage(argv[0]);
+		}
+	}
+
+	piglit_egl_stress_init();
+
+	if (workload != NULL) {
+		result = run_workload(workload, max_threads, seconds, share,
+				      min_scaling);
+	} else {
+		for (i = 0; piglit_egl_stress_workloads[i] != NULL; i++) {
+			enum piglit_result subtest =
+				run_workload(piglit_egl_stress_workloads[i],
+					     max_threads, seconds, share,
+					     min_scaling);
+
+			piglit_report_subtest_result(subtest, "%s",
+				piglit_egl_stress_workloads[i]->name);
+			piglit_merge_result(&result, subtest);
+		}
+	}
+
+	piglit_report_result(result);
+	return 0;
+}
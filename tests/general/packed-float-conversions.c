@@ -0,0 +1,337 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file packed-float-conversions.c
+ *
+ * Checks the array versions of piglit's half float, RGB9_E5 and
+ * R11F_G11F_B10F converters, which may use SIMD instructions, against
+ * the scalar versions they must match bit for bit.  This tests piglit
+ * itself rather than the GL implementation.
+ *
+ * By default every half float and a sample of 2^20 32-bit patterns
+ * (plus special values) are converted.  With -exhaustive all 2^32
+ * patterns are, which takes several minutes.  For RGB texels the pattern
+ * goes in red and rotated copies of it in green and blue, so every
+ * pattern is seen in every channel.
+ *
+ * With -benchmark the throughput of both versions is printed as well.
+ */
+
+#include "piglit-util-gl.h"
+#include "rgb9e5.h"
+#include "r11g11b10f.h"
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 10;
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGB | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+#define CHUNK 65536
+#define SAMPLES (1 << 20)
+#define SAMPLE_STRIDE 4093u
+
+static const uint32_t special_values[] = {
+	0x00000000, 0x80000000, /* zeros */
+	0x00000001, 0x807fffff, /* float denorms */
+	0x7f800000, 0xff800000, /* infinities */
+	0x7f800001, 0x7fc00000, 0xffffffff, /* NaNs */
+	0x33800000, 0x387fffff, /* smallest half denorm, below half normals */
+	0x477fe000, 0x477ff000, 0x477fffff, 0x47800000, /* near 65504 */
+	0x477e0000, 0x477e0001, 0x477c0000, 0x477c0001, /* near 65024, 64512 */
+	0x477f8000, /* largest RGB9_E5 value */
+	0x3effffff, 0x3f000000, 0x3f7fffff, 0x3f800000,
+};
+
+struct buffers {
+	uint32_t bits[CHUNK];
+	float rgb[CHUNK * 3];
+	unsigned short half[CHUNK * 3];
+	unsigned packed[CHUNK];
+	float out[CHUNK * 3];
+};
+
+static bool exhaustive;
+static bool benchmark;
+
+enum piglit_result
+piglit_display(void)
+{
+	/* UNREACHED */
+	return PIGLIT_FAIL;
+}
+
+static uint32_t
+rotate(uint32_t x, int n)
+{
+	return (x << n) | (x >> (32 - n));
+}
+
+static float
+bits_to_float(uint32_t bits)
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static uint32_t
+float_to_bits(float f)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+static void
+fill_chunk(struct buffers *b, uint64_t first, uint32_t stride)
+{
+	int i;
+
+	for (i = 0; i < CHUNK; i++)
+		b->bits[i] = (uint32_t) ((first + i) * stride);
+
+	if (first == 0)
+		memcpy(b->bits, special_values, sizeof(special_values));
+
+	for (i = 0; i < CHUNK; i++) {
+		b->rgb[i * 3 + 0] = bits_to_float(b->bits[i]);
+		b->rgb[i * 3 + 1] = bits_to_float(rotate(b->bits[i], 11));
+		b->rgb[i * 3 + 2] = bits_to_float(rotate(b->bits[i], 22));
+	}
+}
+
+/** Equal bit patterns, or both NaN if \a any_nan. */
+static bool
+same_float(float a, float b, bool any_nan)
+{
+	if (any_nan && a != a && b != b)
+		return true;
+	return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static bool
+check_float3(const char *name, uint32_t input, const float *expected,
+	     const float *observed, bool any_nan)
+{
+	int c;
+
+	for (c = 0; c < 3; c++) {
+		if (!same_float(expected[c], observed[c], any_nan)) {
+			printf("%s of 0x%08x: expected %g %g %g, "
+			       "observed %g %g %g\n", name, input,
+			       expected[0], expected[1], expected[2],
+			       observed[0], observed[1], observed[2]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool
+check_packed(const char *name, const float *rgb, unsigned expected,
+	     unsigned observed)
+{
+	if (expected == observed)
+		return true;
+
+	printf("%s of (%g, %g, %g): expected 0x%08x, observed 0x%08x\n",
+	       name, rgb[0], rgb[1], rgb[2], expected, observed);
+	return false;
+}
+
+static bool
+check_chunk(struct buffers *b, bool pass[3])
+{
+	float expected[3];
+	int i;
+
+	piglit_half_from_float_array(b->rgb, CHUNK * 3, b->half);
+	for (i = 0; pass[0] && i < CHUNK * 3; i++) {
+		const unsigned short h = piglit_half_from_float(b->rgb[i]);
+
+		if (h != b->half[i]) {
+			printf("half of %g (0x%08x): expected 0x%04x, "
+			       "observed 0x%04x\n", b->rgb[i],
+			       float_to_bits(b->rgb[i]), h, b->half[i]);
+			pass[0] = false;
+		}
+	}
+
+	float3_to_rgb9e5_array(b->rgb, CHUNK, b->packed);
+	for (i = 0; pass[1] && i < CHUNK; i++) {
+		pass[1] = check_packed("RGB9_E5", &b->rgb[i * 3],
+				       float3_to_rgb9e5(&b->rgb[i * 3]),
+				       b->packed[i]);
+	}
+
+	rgb9e5_to_float3_array(b->bits, CHUNK, b->out);
+	for (i = 0; pass[1] && i < CHUNK; i++) {
+		rgb9e5_to_float3(b->bits[i], expected);
+		pass[1] = check_float3("RGB9_E5 decoding", b->bits[i],
+				       expected, &b->out[i * 3], false);
+	}
+
+	float3_to_r11g11b10f_array(b->rgb, CHUNK, b->packed);
+	for (i = 0; pass[2] && i < CHUNK; i++) {
+		pass[2] = check_packed("R11F_G11F_B10F", &b->rgb[i * 3],
+				       float3_to_r11g11b10f(&b->rgb[i * 3]),
+				       b->packed[i]);
+	}
+
+	r11g11b10f_to_float3_array(b->bits, CHUNK, b->out);
+	for (i = 0; pass[2] && i < CHUNK; i++) {
+		r11g11b10f_to_float3(b->bits[i], expected);
+		pass[2] = check_float3("R11F_G11F_B10F decoding", b->bits[i],
+				       expected, &b->out[i * 3], true);
+	}
+
+	return pass[0] || pass[1] || pass[2];
+}
+
+static bool
+check_half_decoding(void)
+{
+	unsigned short h[CHUNK];
+	float out[CHUNK];
+	int i;
+
+	for (i = 0; i < CHUNK; i++)
+		h[i] = i;
+
+	piglit_float_from_half_array(h, CHUNK, out);
+	for (i = 0; i < CHUNK; i++) {
+		const float expected = piglit_float_from_half(h[i]);
+
+		if (!same_float(expected, out[i], false)) {
+			printf("float of half 0x%04x: expected %g, "
+			       "observed %g\n", h[i], expected, out[i]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+report_rate(const char *name, int64_t scalar_usec, int64_t array_usec,
+	    int count)
+{
+	printf("%-32s scalar %8.1f Mvalues/s, array %8.1f Mvalues/s\n",
+	       name, count / (double) MAX2(scalar_usec, 1),
+	       count / (double) MAX2(array_usec, 1));
+}
+
+/**
+ * Time \a stmt_scalar, done for each i in a chunk, against
+ * \a stmt_array, done once per chunk.
+ */
+#define TIME(name, stmt_scalar, stmt_array)				\
+	do {								\
+		int64_t t0, t1, t2;					\
+		int r, i;						\
+		t0 = piglit_get_microseconds();				\
+		for (r = 0; r < REPEAT; r++)				\
+			for (i = 0; i < CHUNK; i++)			\
+				stmt_scalar;				\
+		t1 = piglit_get_microseconds();				\
+		for (r = 0; r < REPEAT; r++)				\
+			stmt_array;					\
+		t2 = piglit_get_microseconds();				\
+		report_rate(name, t1 - t0, t2 - t1, REPEAT * CHUNK);	\
+	} while (0)
+
+#define REPEAT 64
+
+static void
+run_benchmark(struct buffers *b)
+{
+	unsigned short *h = b->half;
+
+	fill_chunk(b, 1, SAMPLE_STRIDE);
+
+	TIME("float -> half",
+	     h[i] = piglit_half_from_float(b->rgb[i]),
+	     piglit_half_from_float_array(b->rgb, CHUNK, h));
+	TIME("half -> float",
+	     b->out[i] = piglit_float_from_half(h[i]),
+	     piglit_float_from_half_array(h, CHUNK, b->out));
+	TIME("float3 -> RGB9_E5",
+	     b->packed[i] = float3_to_rgb9e5(&b->rgb[i * 3]),
+	     float3_to_rgb9e5_array(b->rgb, CHUNK, b->packed));
+	TIME("RGB9_E5 -> float3",
+	     rgb9e5_to_float3(b->bits[i], &b->out[i * 3]),
+	     rgb9e5_to_float3_array(b->bits, CHUNK, b->out));
+	TIME("float3 -> R11F_G11F_B10F",
+	     b->packed[i] = float3_to_r11g11b10f(&b->rgb[i * 3]),
+	     float3_to_r11g11b10f_array(b->rgb, CHUNK, b->packed));
+	TIME("R11F_G11F_B10F -> float3",
+	     r11g11b10f_to_float3(b->bits[i], &b->out[i * 3]),
+	     r11g11b10f_to_float3_array(b->bits, CHUNK, b->out));
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	static const char *names[3] = {
+		"half float", "RGB9_E5", "R11F_G11F_B10F"
+	};
+	struct buffers *b = malloc(sizeof(*b));
+	bool pass[3] = { true, true, true };
+	enum piglit_result result = PIGLIT_PASS;
+	uint64_t first, count;
+	uint32_t stride;
+	int i;
+
+	exhaustive = piglit_strip_arg(&argc, argv, "-exhaustive");
+	benchmark = piglit_strip_arg(&argc, argv, "-benchmark");
+
+	count = exhaustive ? (UINT64_C(1) << 32) : SAMPLES;
+	stride = exhaustive ? 1 : SAMPLE_STRIDE;
+
+	printf("F16C %s\n", piglit_cpu_has_f16c() ? "used" : "not available");
+
+	pass[0] = check_half_decoding();
+
+	for (first = 0; first < count; first += CHUNK) {
+		fill_chunk(b, first, stride);
+		if (!check_chunk(b, pass))
+			break;
+	}
+
+	for (i = 0; i < 3; i++) {
+		piglit_report_subtest_result(pass[i] ? PIGLIT_PASS :
+					     PIGLIT_FAIL, "%s", names[i]);
+		piglit_merge_result(&result, pass[i] ? PIGLIT_PASS :
+				    PIGLIT_FAIL);
+	}
+
+	if (benchmark)
+		run_benchmark(b);
+
+	free(b);
+	piglit_report_result(result);
+}
@@ -0,0 +1,283 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file probe-gpu.c
+ *
+ * Checks piglit's GPU comparison of probed regions (see
+ * piglit_set_gpu_probe()) against what the glReadPixels readback would
+ * decide: matching and mismatching colors and images, read state that
+ * glReadPixels applies but a blit doesn't, an error left pending by the
+ * test, and a multisample framebuffer, which only the readback may
+ * handle.  Each check also counts which probes were compared on the GPU,
+ * so that one quietly always falling back to the readback fails.  This
+ * tests piglit itself rather than the GL implementation.
+ */
+
+#include "piglit-util-gl.h"
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 43;
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGBA | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* Large enough for the GPU comparison to be used. */
+#define W 128
+#define H 128
+
+static const float red[4] = { 1, 0, 0, 1 };
+static const float green[4] = { 0, 1, 0, 1 };
+
+/* Whether n probes since the count was \a before compared on the GPU. */
+static bool
+check_gpu_probes(unsigned before, unsigned n)
+{
+	unsigned taken = piglit_get_gpu_probe_count() - before;
+
+	if (taken != n) {
+		printf("%u probes compared on the GPU, expected %u\n",
+		       taken, n);
+		return false;
+	}
+	return true;
+}
+
+static GLuint
+make_fbo(GLsizei samples)
+{
+	GLuint fb, rb;
+
+	glGenRenderbuffers(1, &rb);
+	glBindRenderbuffer(GL_RENDERBUFFER, rb);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8,
+					 W, H);
+	glGenFramebuffers(1, &fb);
+	glBindFramebuffer(GL_FRAMEBUFFER, fb);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+				  GL_RENDERBUFFER, rb);
+	return fb;
+}
+
+/* Green, with a red square at (40, 50). */
+static void
+draw_pattern(void)
+{
+	glClearColor(0, 1, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(40, 50, 8, 8);
+	glClearColor(1, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+}
+
+static bool
+check_colors(void)
+{
+	unsigned before = piglit_get_gpu_probe_count();
+	bool pass = true;
+
+	pass = piglit_probe_rect_rgba(0, 64, W, H - 64, green) && pass;
+	pass = piglit_probe_rect_rgb(0, 64, W, H - 64, green) && pass;
+	pass = piglit_probe_rect_rgba_each(0, 64, W, H - 64, green) && pass;
+
+	printf("Expecting a mismatch:\n");
+	pass = !piglit_probe_rect_rgba(0, 0, W, H, green) && pass;
+	printf("Expecting a mismatch:\n");
+	pass = !piglit_probe_rect_rgb(0, 0, W, H, green) && pass;
+
+	pass = check_gpu_probes(before, 5) && pass;
+	return piglit_check_gl_error(GL_NO_ERROR) && pass;
+}
+
+static bool
+check_images(void)
+{
+	unsigned before = piglit_get_gpu_probe_count();
+	float *image = malloc(W * H * 4 * sizeof(float));
+	bool pass = true;
+	int x, y;
+
+	for (y = 0; y < H; y++) {
+		for (x = 0; x < W; x++) {
+			bool in_square = x >= 40 && x < 48 &&
+					 y >= 50 && y < 58;
+
+			memcpy(&image[(y * W + x) * 4],
+			       in_square ? red : green, sizeof(green));
+		}
+	}
+	pass = piglit_probe_image_rgba(0, 0, W, H, image) && pass;
+
+	image[(57 * W + 47) * 4 + 1] = 0.5;
+	printf("Expecting a mismatch:\n");
+	pass = !piglit_probe_image_rgba(0, 0, W, H, image) && pass;
+
+	free(image);
+	pass = check_gpu_probes(before, 2) && pass;
+	return piglit_check_gl_error(GL_NO_ERROR) && pass;
+}
+
+/* glReadPixels scales the colors it reads, so the probe must as well. */
+static bool
+check_read_state(void)
+{
+	static const float half[4] = { 0.5, 0, 0, 1 };
+	unsigned before = piglit_get_gpu_probe_count();
+	bool pass;
+
+	glClearColor(0.25, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glPixelTransferf(GL_RED_SCALE, 2.0);
+	pass = piglit_probe_rect_rgba(0, 0, W, H, half);
+	glPixelTransferf(GL_RED_SCALE, 1.0);
+	pass = check_gpu_probes(before, 0) && pass;
+
+	return piglit_check_gl_error(GL_NO_ERROR) && pass;
+}
+
+/* The probe mustn't swallow an error the test hasn't checked yet. */
+static bool
+check_pending_error(void)
+{
+	unsigned before = piglit_get_gpu_probe_count();
+	bool pass;
+
+	glEnable(GL_TEXTURE_BINDING_2D);
+	pass = piglit_probe_rect_rgba(0, 64, W, H - 64, green);
+	pass = check_gpu_probes(before, 0) && pass;
+
+	return piglit_check_gl_error(GL_INVALID_ENUM) && pass;
+}
+
+/* A multisample framebuffer can't be blitted to a texture, so the probe
+ * falls back to glReadPixels, which refuses to read it.
+ */
+static bool
+check_multisample(void)
+{
+	unsigned before = piglit_get_gpu_probe_count();
+	GLuint fb = make_fbo(4);
+	bool pass;
+
+	glClearColor(0, 1, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+	piglit_probe_rect_rgb_silent(0, 0, W, H, green);
+	glDeleteFramebuffers(1, &fb);
+	pass = check_gpu_probes(before, 0);
+
+	return piglit_check_gl_error(GL_INVALID_OPERATION) && pass;
+}
+
+/* The imaging subset only keeps the probe off the GPU while one of its
+ * operations is set up: here a color matrix that doubles red.
+ */
+static enum piglit_result
+check_imaging(void)
+{
+	static const float quarter[4] = { 0.25, 0, 0, 1 };
+	static const float half[4] = { 0.5, 0, 0, 1 };
+	unsigned before;
+	bool pass = true;
+
+	if (!piglit_is_extension_supported("GL_ARB_imaging"))
+		return PIGLIT_SKIP;
+
+	glClearColor(0.25, 0, 0, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	before = piglit_get_gpu_probe_count();
+	glMatrixMode(GL_COLOR);
+	glScalef(2.0, 1.0, 1.0);
+	pass = piglit_probe_rect_rgba(0, 0, W, H, half) && pass;
+	pass = check_gpu_probes(before, 0) && pass;
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+
+	before = piglit_get_gpu_probe_count();
+	pass = piglit_probe_rect_rgba(0, 0, W, H, quarter) && pass;
+	pass = check_gpu_probes(before, 1) && pass;
+
+	pass = piglit_check_gl_error(GL_NO_ERROR) && pass;
+	return pass ? PIGLIT_PASS : PIGLIT_FAIL;
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	/* UNREACHED */
+	return PIGLIT_FAIL;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	enum piglit_result result = PIGLIT_PASS;
+	enum piglit_result subtest;
+	const char *env = getenv("PIGLIT_GPU_PROBE");
+	bool pass;
+
+	if (env && !streq(env, "") && atoi(env) == 0) {
+		printf("PIGLIT_GPU_PROBE=%s turns the GPU comparison off\n",
+		       env);
+		piglit_report_result(PIGLIT_SKIP);
+	}
+
+	piglit_set_gpu_probe(true);
+
+	make_fbo(0);
+	draw_pattern();
+
+	pass = check_colors();
+	piglit_report_subtest_result(pass ? PIGLIT_PASS : PIGLIT_FAIL,
+				     "color");
+	piglit_merge_result(&result, pass ? PIGLIT_PASS : PIGLIT_FAIL);
+
+	pass = check_images();
+	piglit_report_subtest_result(pass ? PIGLIT_PASS : PIGLIT_FAIL,
+				     "image");
+	piglit_merge_result(&result, pass ? PIGLIT_PASS : PIGLIT_FAIL);
+
+	pass = check_pending_error();
+	piglit_report_subtest_result(pass ? PIGLIT_PASS : PIGLIT_FAIL,
+				     "pending error");
+	piglit_merge_result(&result, pass ? PIGLIT_PASS : PIGLIT_FAIL);
+
+	pass = check_read_state();
+	piglit_report_subtest_result(pass ? PIGLIT_PASS : PIGLIT_FAIL,
+				     "pixel transfer");
+	piglit_merge_result(&result, pass ? PIGLIT_PASS : PIGLIT_FAIL);
+
+	pass = check_multisample();
+	piglit_report_subtest_result(pass ? PIGLIT_PASS : PIGLIT_FAIL,
+				     "multisample");
+	piglit_merge_result(&result, pass ? PIGLIT_PASS : PIGLIT_FAIL);
+
+	subtest = check_imaging();
+	piglit_report_subtest_result(subtest, "imaging");
+	piglit_merge_result(&result, subtest);
+
+	piglit_report_result(result);
+}
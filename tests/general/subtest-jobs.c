@@ -0,0 +1,189 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file subtest-jobs.c
+ *
+ * Checks piglit_run_selected_subtests() with PIGLIT_SUBTEST_JOBS set:
+ * the test runs itself that way, with a short PIGLIT_SUBTEST_TIMEOUT,
+ * and checks the subtest results and output it reports.  One subtest
+ * writes to stderr, one crashes and one closes its output and then
+ * hangs, which must be killed once the timeout runs out.  This tests
+ * piglit itself rather than the GL implementation.
+ */
+
+#include "piglit-util-gl.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#define TIMEOUT 2
+#define STDERR_MESSAGE "subtest-jobs: written to stderr"
+
+static struct piglit_gl_test_config *piglit_config;
+
+static enum piglit_result
+subtest_pass(void *data)
+{
+	return PIGLIT_PASS;
+}
+
+static enum piglit_result
+subtest_fail(void *data)
+{
+	return PIGLIT_FAIL;
+}
+
+static enum piglit_result
+subtest_stderr(void *data)
+{
+	fprintf(stderr, "%s\n", STDERR_MESSAGE);
+	return PIGLIT_PASS;
+}
+
+static enum piglit_result
+subtest_crash(void *data)
+{
+	abort();
+	return PIGLIT_PASS;
+}
+
+static enum piglit_result
+subtest_hang(void *data)
+{
+#ifdef __linux__
+	close(STDOUT_FILENO);
+	close(STDERR_FILENO);
+	sleep(10 * TIMEOUT);
+#endif
+	return PIGLIT_PASS;
+}
+
+static const struct piglit_subtest subtests[] = {
+	{ "pass", "pass", subtest_pass, NULL },
+	{ "fail", "fail", subtest_fail, NULL },
+	{ "stderr", "stderr", subtest_stderr, NULL },
+	{ "crash", "crash", subtest_crash, NULL },
+	{ "hang", "hang", subtest_hang, NULL },
+	{ NULL, NULL, NULL, NULL }
+};
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	piglit_config = &config;
+	config.subtests = subtests;
+	config.supports_gl_compat_version = 10;
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGB | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+static const char *const expected[] = {
+	"PIGLIT: {\"subtest\": {\"pass\" : \"pass\"}}",
+	"PIGLIT: {\"subtest\": {\"fail\" : \"fail\"}}",
+	"PIGLIT: {\"subtest\": {\"stderr\" : \"pass\"}}",
+	"PIGLIT: {\"subtest\": {\"crash\" : \"fail\"}}",
+	"PIGLIT: {\"subtest\": {\"hang\" : \"fail\"}}",
+	STDERR_MESSAGE,
+};
+
+/* Run this test again with PIGLIT_SUBTEST_JOBS set, and check what it
+ * reports.
+ */
+static enum piglit_result
+check_runner(const char *program)
+{
+	enum piglit_result result = PIGLIT_PASS;
+	char command[4096], line[4096];
+	char *output = NULL;
+	size_t output_size = 0;
+	int64_t start;
+	FILE *p;
+	unsigned i;
+
+	snprintf(command, sizeof(command),
+		 "PIGLIT_SUBTEST_JOBS=3 PIGLIT_SUBTEST_TIMEOUT=%d "
+		 "'%s' -auto -runner 2>/dev/null", TIMEOUT, program);
+
+	start = piglit_get_microseconds();
+	p = popen(command, "r");
+	if (p == NULL) {
+		printf("Failed to run %s\n", program);
+		return PIGLIT_FAIL;
+	}
+	/* Indent the output, so that its results aren't taken for this
+	 * test's own.
+	 */
+	printf("Output of %s:\n", command);
+	while (fgets(line, sizeof(line), p)) {
+		printf("\t%s", line);
+		output = realloc(output, output_size + strlen(line) + 1);
+		strcpy(output + output_size, line);
+		output_size += strlen(line);
+	}
+	pclose(p);
+
+	for (i = 0; i < ARRAY_SIZE(expected); i++) {
+		if (output == NULL || strstr(output, expected[i]) == NULL) {
+			printf("Missing from the output: %s\n", expected[i]);
+			result = PIGLIT_FAIL;
+		}
+	}
+
+	/* The hanging subtest must be killed at the timeout, not waited
+	 * for.
+	 */
+	if (piglit_get_microseconds() - start >
+	    5 * TIMEOUT * INT64_C(1000000)) {
+		printf("The subtests took too long\n");
+		result = PIGLIT_FAIL;
+	}
+
+	free(output);
+	return result;
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	/* UNREACHED */
+	return PIGLIT_FAIL;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+#ifdef __linux__
+	if (piglit_strip_arg(&argc, argv, "-runner") ||
+	    piglit_config->num_selected_subtests) {
+		piglit_report_result(piglit_run_selected_subtests(
+			subtests, piglit_config->selected_subtests,
+			piglit_config->num_selected_subtests, PIGLIT_PASS));
+	}
+
+	piglit_report_result(check_runner(argv[0]));
+#else
+	/* Subtests only run in child processes on Linux. */
+	piglit_report_result(PIGLIT_SKIP);
+#endif
+}
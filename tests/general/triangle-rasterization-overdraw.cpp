@@ -39,9 +39,14 @@
  *
  *   2. Clip:    Picks a random point in the window and adds vertices to the triangle fan
  *               around a circle that contains the entire window, thus going off screen.
+ *
+ * The fan is also rasterised with the reference rasteriser, counting how many
+ * triangles cover each pixel, and every pixel of the probed area is checked
+ * against the colour that count should produce.
  */
 
 #include "piglit-util-gl.h"
+#include "piglit-rasterizer.h"
 #include "mersenne.hpp"
 
 #include <time.h>
@@ -69,6 +74,7 @@ bool rect = false;
 bool clips = false;
 bool break_on_fail = false;
 int random_test_count = 10;
+int subpixel_bits;
 
 /* Piglit variables */
 
@@ -116,6 +122,7 @@ struct TestCase
 	} probe_rect;
 
 	void generate(void);
+	void rasterise(std::vector<uint32_t>& counts) const;
 	bool run(void) const;
 };
 
@@ -198,6 +205,36 @@ void TestCase::generate(void)
 	++test_id;
 }
 
+/* Counts how many triangles of the fan cover each pixel of the window,
+ * according to the reference rasteriser
+ */
+void TestCase::rasterise(std::vector<uint32_t>& counts) const
+{
+	struct piglit_rasterizer r;
+
+	counts.assign(piglit_width * piglit_height, 0);
+
+	/* Pixels away from the fan's vertices are covered the same number
+	 * of times under any consistent filling convention.
+	 */
+	r.subpixel_bits = subpixel_bits;
+	r.convention = PIGLIT_FILL_BOTTOM_LEFT;
+	r.buffer = &counts.front();
+	r.width = piglit_width;
+	r.height = piglit_height;
+	r.stride = piglit_width;
+
+	for (size_t i = 1; i + 1 < triangle_fan.size(); ++i) {
+		const float v[3][2] = {
+			{ triangle_fan[0].x, triangle_fan[0].y },
+			{ triangle_fan[i].x, triangle_fan[i].y },
+			{ triangle_fan[i + 1].x, triangle_fan[i + 1].y },
+		};
+
+		piglit_rasterize_triangle(&r, v, PIGLIT_RASTER_ADD, 1);
+	}
+}
+
 /* Tests a triangle fan */
 bool TestCase::run(void) const
 {
@@ -237,9 +274,52 @@ bool TestCase::run(void) const
 	/* Reset draw state */
 	glDisable(GL_BLEND);
 
-	if (!piglit_probe_rect_rgb(probe_rect.x, probe_rect.y, probe_rect.w, probe_rect.y, colour)) {
-		printf("%d. Triangle Fan with %d triangles around (%f, %f)\n",
-		       test_id, (int)triangle_fan.size(), mid.x, mid.y);
+	/* Read back the probed area once and compare every pixel with the
+	 * colour its reference coverage count produces: once for the
+	 * additive blend, an odd number of times for the inversion.
+	 */
+	std::vector<uint32_t> counts;
+	std::vector<float> pixels(probe_rect.w * probe_rect.h * 3);
+	int bad_pixels = 0;
+
+	rasterise(counts);
+	glReadPixels(probe_rect.x, probe_rect.y, probe_rect.w, probe_rect.h,
+		     GL_RGB, GL_FLOAT, &pixels.front());
+
+	for (int y = 0; y < probe_rect.h; ++y) {
+		for (int x = 0; x < probe_rect.w; ++x) {
+			const float *pixel = &pixels[(y * probe_rect.w + x) * 3];
+			uint32_t count = counts[(probe_rect.y + y) * piglit_width + probe_rect.x + x];
+			float expected;
+			bool match = true;
+
+			if (rect)
+				expected = std::min(count * 127, 255u) / 255.0f;
+			else
+				expected = (count & 1) ? 1.0f : 0.0f;
+
+			for (int c = 0; c < 3; ++c) {
+				if (fabs(pixel[c] - expected) > piglit_tolerance[c])
+					match = false;
+			}
+
+			if (match)
+				continue;
+
+			if (bad_pixels++ == 0) {
+				printf("Probe at (%d, %d)\n",
+				       probe_rect.x + x, probe_rect.y + y);
+				printf("  Expected: %f %f %f (covered %u times)\n",
+				       expected, expected, expected, count);
+				printf("  Observed: %f %f %f\n",
+				       pixel[0], pixel[1], pixel[2]);
+			}
+		}
+	}
+
+	if (bad_pixels) {
+		printf("%d. Triangle Fan with %d triangles around (%f, %f): %d bad pixels\n",
+		       test_id, (int)triangle_fan.size(), mid.x, mid.y, bad_pixels);
 
 		fflush(stdout);
 		return false;
@@ -291,6 +371,8 @@ piglit_init(int argc, char **argv)
 {
 	uint32_t seed = 0xfacebeef ^ time(NULL);
 
+	glGetIntegerv(GL_SUBPIXEL_BITS, &subpixel_bits);
+
 	for (int i = 1; i < argc; ++i) {
 		if (strcmp(argv[i], "-break_on_fail") == 0){
 			break_on_fail = true;
@@ -33,9 +33,14 @@
  * There are 2 components to the test;
  *   1. Predefined sanity tests ensuring bounding box calculations are correct
  *   2. Randomised triangle drawing to attempt to test all possible triangles
+ *
+ * With -batch N, up to N triangles are drawn per frame, each in its own cell
+ * of the framebuffer, and checked with a single readback.  The triangles then
+ * have to fit in a cell, so the largest random triangles are not generated.
  */
 
 #include "piglit-util-gl.h"
+#include "piglit-rasterizer.h"
 #include "mersenne.hpp"
 
 #include <time.h>
@@ -89,18 +94,10 @@ bool use_fbo = false;
 bool break_on_fail = false;
 bool print_triangle = false;
 int random_test_count = 100;
+int batch_size = 1;
 
 /* filling convention */
-static enum filling_convention_t {
-	bottom_left = 0,
-	left_bottom,
-	right_bottom,
-	bottom_right,
-	top_right,
-	right_top,
-	left_top,
-	top_left,
-} filling_convention;
+static enum piglit_fill_convention filling_convention;
 
 /* Fixed point format */
 static int FIXED_SHIFT;
@@ -110,6 +107,12 @@ static int FIXED_ONE;
 int fbo_width = 256;
 int fbo_height = 256;
 
+/* Layout of the cells triangles are drawn in, when batching */
+int grid_size = 1;
+int cell_width, cell_height;
+int cell_margin = 0;
+int max_triangle_size;
+
 /* Piglit variables */
 
 PIGLIT_GL_TEST_CONFIG_BEGIN
@@ -128,31 +131,6 @@ Mersenne mersenne;
 std::vector<Triangle> fixed_tests;
 
 
-/* std::algorithm min/max with 3 arguments! :D */
-namespace std {
-	template<typename T>
-	T min(T& a, T& b, T& c)
-	{
-		return (a < b) ? std::min(a, c) : std::min(b, c);
-	}
-
-	template<typename T>
-	T max(T& a, T& b, T& c)
-	{
-		return (a > b) ? std::max(a, c) : std::max(b, c);
-	}
-}
-
-/* Proper rounding of float to integer */
-int64_t iround(float v)
-{
-	if (v > 0.0f)
-		v += 0.5f;
-	if (v < 0.0f)
-		v -= 0.5f;
-	return (int64_t)v;
-}
-
 /* Calculate log2 for integers */
 int log2i(int x)
 {
@@ -163,146 +141,38 @@ int log2i(int x)
 }
 
 
-/* Based on http://devmaster.net/forums/topic/1145-advanced-rasterization */
-void rast_triangle(uint8_t* buffer, uint32_t stride, const Triangle& tri)
+/* Rasterise tri into buffer with the reference rasteriser */
+void rast_triangle(uint32_t* buffer, const Triangle& tri)
 {
-	float center_offset = -0.5f;
-
-	/* fixed point coordinates */
-	int64_t x1 = iround(FIXED_ONE * (tri[0].x + center_offset));
-	int64_t x2 = iround(FIXED_ONE * (tri[1].x + center_offset));
-	int64_t x3 = iround(FIXED_ONE * (tri[2].x + center_offset));
-
-	int64_t y1 = iround(FIXED_ONE * (tri[0].y + center_offset));
-	int64_t y2 = iround(FIXED_ONE * (tri[1].y + center_offset));
-	int64_t y3 = iround(FIXED_ONE * (tri[2].y + center_offset));
-
-	/* Force correct vertex order */
-	const int64_t cross = (x2 - x1) * (y3 - y2) - (y2 - y1) * (x3 - x2);
-	if (cross > 0) {
-		std::swap(x1, x3);
-		std::swap(y1, y3);
-	}
-
-	/* Deltas */
-	const int64_t dx12 = x1 - x2;
-	const int64_t dx23 = x2 - x3;
-	const int64_t dx31 = x3 - x1;
-
-	const int64_t dy12 = y1 - y2;
-	const int64_t dy23 = y2 - y3;
-	const int64_t dy31 = y3 - y1;
-
-	/* Fixed-point deltas */
-	const int64_t fdx12 = dx12 << FIXED_SHIFT;
-	const int64_t fdx23 = dx23 << FIXED_SHIFT;
-	const int64_t fdx31 = dx31 << FIXED_SHIFT;
-
-	const int64_t fdy12 = dy12 << FIXED_SHIFT;
-	const int64_t fdy23 = dy23 << FIXED_SHIFT;
-	const int64_t fdy31 = dy31 << FIXED_SHIFT;
-
-	/* Bounding rectangle */
-	int64_t minx = std::min(x1, x2, x3) >> FIXED_SHIFT;
-	int64_t maxx = (std::max(x1, x2, x3)) >> FIXED_SHIFT;
-
-	int64_t miny = (std::min(y1, y2, y3)) >> FIXED_SHIFT;
-	int64_t maxy = std::max(y1, y2, y3) >> FIXED_SHIFT;
-
-	minx = std::max(minx, (int64_t)0);
-	maxx = std::min(maxx, (int64_t)fbo_width - 1);
-
-	miny = std::max(miny, (int64_t)0);
-	maxy = std::min(maxy, (int64_t)fbo_height - 1);
-
-	/* Half-edge constants */
-	int64_t c1 = dy12 * x1 - dx12 * y1;
-	int64_t c2 = dy23 * x2 - dx23 * y2;
-	int64_t c3 = dy31 * x3 - dx31 * y3;
-
-	/* Correct for filling convention */
-	switch (filling_convention) {
-		case bottom_right:
-			if (dy12 > 0 || (dy12 == 0 && dx12 > 0)) c1++;
-			if (dy23 > 0 || (dy23 == 0 && dx23 > 0)) c2++;
-			if (dy31 > 0 || (dy31 == 0 && dx31 > 0)) c3++;
-			break;
-		case right_bottom:
-			if (dx12 < 0 || (dx12 == 0 && dy12 < 0)) c1++;
-			if (dx23 < 0 || (dx23 == 0 && dy23 < 0)) c2++;
-			if (dx31 < 0 || (dx31 == 0 && dy31 < 0)) c3++;
-			break;
-		case left_bottom:
-			if (dx12 < 0 || (dx12 == 0 && dy12 > 0)) c1++;
-			if (dx23 < 0 || (dx23 == 0 && dy23 > 0)) c2++;
-			if (dx31 < 0 || (dx31 == 0 && dy31 > 0)) c3++;
-			break;
-		case bottom_left:
-			if (dy12 < 0 || (dy12 == 0 && dx12 > 0)) c1++;
-			if (dy23 < 0 || (dy23 == 0 && dx23 > 0)) c2++;
-			if (dy31 < 0 || (dy31 == 0 && dx31 > 0)) c3++;
-			break;
-		case top_left:
-			if (dy12 < 0 || (dy12 == 0 && dx12 < 0)) c1++;
-			if (dy23 < 0 || (dy23 == 0 && dx23 < 0)) c2++;
-			if (dy31 < 0 || (dy31 == 0 && dx31 < 0)) c3++;
-			break;
-		case left_top:
-			if (dx12 > 0 || (dx12 == 0 && dy12 > 0)) c1++;
-			if (dx23 > 0 || (dx23 == 0 && dy23 > 0)) c2++;
-			if (dx31 > 0 || (dx31 == 0 && dy31 > 0)) c3++;
-			break;
-		case right_top:
-			if (dx12 > 0 || (dx12 == 0 && dy12 < 0)) c1++;
-			if (dx23 > 0 || (dx23 == 0 && dy23 < 0)) c2++;
-			if (dx31 > 0 || (dx31 == 0 && dy31 < 0)) c3++;
-			break;
-		case top_right:
-			if (dy12 > 0 || (dy12 == 0 && dx12 < 0)) c1++;
-			if (dy23 > 0 || (dy23 == 0 && dx23 < 0)) c2++;
-			if (dy31 > 0 || (dy31 == 0 && dx31 < 0)) c3++;
-			break;
-	}
-
-	int64_t cy1 = c1 + dx12 * (miny << FIXED_SHIFT) - dy12 * (minx << FIXED_SHIFT);
-	int64_t cy2 = c2 + dx23 * (miny << FIXED_SHIFT) - dy23 * (minx << FIXED_SHIFT);
-	int64_t cy3 = c3 + dx31 * (miny << FIXED_SHIFT) - dy31 * (minx << FIXED_SHIFT);
-
-	/* Perform rasterization */
-	buffer += miny * stride;
-	for (int64_t y = miny; y <= maxy; y++) {
-		int64_t cx1 = cy1;
-		int64_t cx2 = cy2;
-		int64_t cx3 = cy3;
-
-		for (int64_t x = minx; x <= maxx; x++) {
-			if (cx1 > 0 && cx2 > 0 && cx3 > 0) {
-				((uint32_t*)buffer)[x] = 0x00FF00FF;
-			}
-
-			cx1 -= fdy12;
-			cx2 -= fdy23;
-			cx3 -= fdy31;
-		}
+	struct piglit_rasterizer r;
+	float v[3][2];
 
-		cy1 += fdx12;
-		cy2 += fdx23;
-		cy3 += fdx31;
+	r.subpixel_bits = FIXED_SHIFT;
+	r.convention = filling_convention;
+	r.buffer = buffer;
+	r.width = fbo_width;
+	r.height = fbo_height;
+	r.stride = fbo_width;
 
-		buffer += stride;
+	for (int i = 0; i < 3; ++i) {
+		v[i][0] = tri[i].x;
+		v[i][1] = tri[i].y;
 	}
+
+	piglit_rasterize_triangle(&r, v, PIGLIT_RASTER_REPLACE, 0x00FF00FF);
 }
 
 
-/* Prints an ascii representation of the triangle */
-void triangle_art(uint32_t* buffer)
+/* Prints an ascii representation of the triangle in the given cell */
+void triangle_art(uint32_t* buffer, int cell_x, int cell_y)
 {
-	int minx = fbo_width - 1, miny = fbo_height - 1;
-	int maxx = 0, maxy = 0;
+	const int x0 = cell_x * cell_width, y0 = cell_y * cell_height;
+	int minx = x0 + cell_width - 1, miny = y0 + cell_height - 1;
+	int maxx = x0, maxy = y0;
 
 	/* Find bounds so we dont have to print whole screen */
-	for (int y = 0; y < fbo_height; ++y) {
-		for (int x = 0; x < fbo_width; ++x) {
+	for (int y = y0; y < y0 + cell_height; ++y) {
+		for (int x = x0; x < x0 + cell_width; ++x) {
 			if (buffer[y*fbo_width + x] & 0xFFFFFF00) {
 				if (x < minx) minx = x;
 				if (y < miny) miny = y;
@@ -316,8 +186,10 @@ void triangle_art(uint32_t* buffer)
 	if (minx > maxx || miny > maxy)
 		return;
 
-	--minx; --miny;
-	++maxx; ++maxy;
+	minx = std::max(minx - 1, 0);
+	miny = std::max(miny - 1, 0);
+	maxx = std::min(maxx + 1, fbo_width - 1);
+	maxy = std::min(maxy + 1, fbo_height - 1);
 
 	/* Print an ascii representation of triangle */
 	for (int y = maxy; y >= miny; --y) {
@@ -344,71 +216,110 @@ void triangle_art(uint32_t* buffer)
 }
 
 
-/* Reads buffer from OpenGL and checks for any colour other than black or yellow
- * (black = background, yellow = both opengl AND software rast drew to that pixel)
+/* Reads buffer from OpenGL and flags each cell containing any colour other
+ * than black or yellow (black = background, yellow = both opengl AND
+ * software rast drew to that pixel)
  */
-uint32_t* check_triangle()
+uint32_t* check_triangles(std::vector<bool>& failed)
 {
 	static uint32_t* buffer = 0;
 	if (!buffer) buffer = new uint32_t[fbo_width * fbo_height];
 
 	glReadPixels(0, 0, fbo_width, fbo_height, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, buffer);
 
-	for (int y = 0; y < fbo_height; ++y) {
-		for (int x = 0; x < fbo_width; ++x) {
+	failed.assign(grid_size * grid_size, false);
+
+	for (int y = 0; y < grid_size * cell_height; ++y) {
+		for (int x = 0; x < grid_size * cell_width; ++x) {
 			uint32_t val = buffer[y*fbo_width + x] & 0xFFFFFF00;
 
 			if (val != 0 && val != 0xFFFF0000) {
-				return buffer;
+				int cell = (y / cell_height) * grid_size + x / cell_width;
+				failed[cell] = true;
+
+				/* Skip to the next cell along */
+				x = (x / cell_width + 1) * cell_width - 1;
 			}
 		}
 	}
 
-	return NULL;
+	return buffer;
 }
 
 
-/* Performs test using tri */
-GLboolean test_triangle(const Triangle& tri)
+/* Performs test using tris, each drawn in its own cell.  Returns the number
+ * of triangles that failed.
+ */
+int test_triangles(const std::vector<Triangle>& tris, int first_id)
 {
 	static uint32_t* buffer = 0;
 	if (!buffer) buffer = new uint32_t[fbo_width * fbo_height];
 
+	std::vector<Triangle> placed(tris.size());
+	std::vector<bool> failed;
+	int fail_count = 0;
+
+	assert((int)tris.size() <= grid_size * grid_size);
+
 	/* Clear OpenGL and software buffer */
 	glClear(GL_COLOR_BUFFER_BIT);
 	memset(buffer, 0, sizeof(uint32_t) * fbo_width * fbo_height);
 
-	/* Software rasterise triangle and blit it to OpenGL */
-	rast_triangle((uint8_t*)buffer, fbo_width * 4, tri);
+	/* Move each triangle into its cell.  Rasterization is invariant
+	 * under translation by whole pixels, so this doesn't change the
+	 * fragments it produces.
+	 */
+	for (size_t i = 0; i < tris.size(); ++i) {
+		float dx = (i % grid_size) * cell_width + cell_margin;
+		float dy = (i / grid_size) * cell_height + cell_margin;
+
+		for (int j = 0; j < 3; ++j) {
+			placed[i][j].x = tris[i][j].x + dx;
+			placed[i][j].y = tris[i][j].y + dy;
+		}
+
+		/* Software rasterise triangle */
+		rast_triangle(buffer, placed[i]);
+	}
+
+	/* Blit the software triangles to OpenGL */
 	glDrawPixels(fbo_width, fbo_height, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, buffer);
 
-	/* Draw OpenGL triangle */
+	/* Draw OpenGL triangles */
 	glEnableClientState(GL_VERTEX_ARRAY);
-	glVertexPointer(2, GL_FLOAT, 0, tri.v);
-	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glVertexPointer(2, GL_FLOAT, 0, placed[0].v);
+	glDrawArrays(GL_TRIANGLES, 0, 3 * placed.size());
 	glDisableClientState(GL_VERTEX_ARRAY);
 
 	/* Check the result and print relevant error messages */
-	if (uint32_t* result = check_triangle()) {
-		printf("FAIL: %d. (%f, %f), (%f, %f), (%f, %f)\n", test_id,
+	uint32_t* result = check_triangles(failed);
+
+	for (size_t i = 0; i < tris.size(); ++i) {
+		const Triangle& tri = tris[i];
+
+		if (!failed[i])
+			continue;
+
+		printf("FAIL: %d. (%f, %f), (%f, %f), (%f, %f)\n",
+		       first_id + (int)i,
 		       tri[0].x, tri[0].y, tri[1].x, tri[1].y, tri[2].x, tri[2].y);
 
 		if (print_triangle) {
-			triangle_art(result);
+			triangle_art(result, i % grid_size, i / grid_size);
 		}
 
 		fflush(stdout);
-		return GL_FALSE;
+		++fail_count;
 	}
 
-	return GL_TRUE;
+	return fail_count;
 }
 
 
 /* Generate a random triangle */
 void random_triangle(Triangle& tri)
 {
-	int size = 1 << (mersenne.value() % (log2i(fbo_width) + 1));
+	int size = 1 << (mersenne.value() % (log2i(max_triangle_size) + 1));
 
 	for (int i = 0; i < 3; ++i) {
 		tri[i].x = (mersenne.value() % (size * FIXED_ONE)) * (1.0f / FIXED_ONE);
@@ -503,7 +414,7 @@ void get_filling_convention(void)
 	int produced_fragment_count = 0;
 	for (int i = 0; i < 8; ++i) {
 		if ((buffer[i] & 0xFFFFFF00) == 0xFFFFFF00) {
-			filling_convention = (filling_convention_t)i;
+			filling_convention = (piglit_fill_convention)i;
 			produced_fragment_count++;
 		}
 	}
@@ -564,20 +475,26 @@ piglit_display(void)
 	GLboolean pass = GL_TRUE;
 	if (piglit_automatic) {
 		int fail_count = 0;
+		std::vector<Triangle> tris;
 
 		printf("Running %d fixed tests\n", (int)fixed_tests.size());
-		for (std::vector<Triangle>::iterator itr = fixed_tests.begin(); itr != fixed_tests.end() && !(fail_count && break_on_fail); ++itr) {
-			if (!test_triangle(*itr))
-				++fail_count;
+		for (int i = 0; i < (int)fixed_tests.size() && !(fail_count && break_on_fail); i += batch_size) {
+			int n = std::min(batch_size, (int)fixed_tests.size() - i);
+
+			tris.assign(fixed_tests.begin() + i, fixed_tests.begin() + i + n);
+			fail_count += test_triangles(tris, i);
 		}
 
 		printf("Running %d random tests\n", random_test_count);
-		for (int i = 0; i < random_test_count && !(fail_count && break_on_fail); ++i) {
-			Triangle tri;
-			random_triangle(tri);
+		for (int i = 0; i < random_test_count && !(fail_count && break_on_fail); i += batch_size) {
+			int n = std::min(batch_size, random_test_count - i);
+			int first_id = test_id + 1;
 
-			if (!test_triangle(tri))
-				++fail_count;
+			tris.resize(n);
+			for (int j = 0; j < n; ++j)
+				random_triangle(tris[j]);
+
+			fail_count += test_triangles(tris, first_id);
 		}
 
 		printf("Failed %d tests\n", fail_count);
@@ -586,9 +503,9 @@ piglit_display(void)
 		if (fail_count)
 			pass = GL_FALSE;
 	} else {
-		Triangle tri;
-		random_triangle(tri);
-		pass &= test_triangle(tri);
+		std::vector<Triangle> tris(1);
+		random_triangle(tris[0]);
+		pass &= test_triangles(tris, test_id) == 0;
 
 		glDisable(GL_BLEND);
 
@@ -710,10 +627,33 @@ piglit_init(int argc, char **argv)
 				seed = strtoul(argv[++i], NULL, 0);
 			} else if (strcmp(argv[i], "-subpixel_bits") == 0) {
 				in_subpixel_bits = strtoul(argv[++i], NULL, 0);
+			} else if (strcmp(argv[i], "-batch") == 0) {
+				batch_size = std::max(1, atoi(argv[++i]));
 			}
 		}
 	}
 
+	/* Split the framebuffer into a grid of cells with room for a
+	 * triangle each, leaving a pixel between cells so that triangles
+	 * with vertices on a cell's edge can't touch their neighbours.
+	 */
+	while (grid_size * grid_size < batch_size)
+		++grid_size;
+	cell_width = fbo_width / grid_size;
+	cell_height = fbo_height / grid_size;
+	if (batch_size > 1) {
+		cell_margin = 1;
+		max_triangle_size = std::min(cell_width, cell_height) - 2 * cell_margin;
+		if (max_triangle_size < 1) {
+			printf("Batch of %d triangles does not fit in %dx%d\n",
+			       batch_size, fbo_width, fbo_height);
+			piglit_report_result(PIGLIT_FAIL);
+		}
+		printf("Testing up to %d triangles per frame\n", batch_size);
+	} else {
+		max_triangle_size = fbo_width;
+	}
+
 	FIXED_SHIFT = in_subpixel_bits;
 	FIXED_ONE = 1 << FIXED_SHIFT;
 
@@ -57,6 +57,7 @@ class Image {
 	GLsizei _alignment;
 	GLsizei _rowSizeInBytes;
 	GLsizei _pixelSizeInBytes;
+	bool _simd;
 
 	enum {				// validation bits, for lazy validation
 		vbRowSizeInBytes = 1,
@@ -198,6 +199,13 @@ class Image {
 			_pixelSizeInBytes: validatePixelSizeInBytes();
 	}
 
+	inline bool simd() const	// Whether pack() and unpack() may
+		{ return _simd; }	// use SIMD converters.  They are
+	inline void simd(bool s) {	// checked against the scalar ones
+		_simd = s;		// by clearing this.
+		invalidate(vbPacker | vbUnpacker);
+	}
+
 	// XXX Utilities to determine component size in bits/bytes?
 	// XXX Component range (min neg, max neg, min pos, max pos, eps?)
 
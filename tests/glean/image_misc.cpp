@@ -48,6 +48,7 @@ Image::Image() {
 	_alignment = 4;
 	_packer = 0;
 	_unpacker = 0;
+	_simd = true;
 	_invalid = vbAll;
 } // Image::Image
 
@@ -61,6 +62,7 @@ Image::Image(int aWidth, int aHeight, GLenum aFormat, GLenum aType) {
 	_alignment = 4;
 	_packer = 0;
 	_unpacker = 0;
+	_simd = true;
 	_invalid = vbAll;
 	reserve();
 } // Image::Image(aWidth, aHeight, aFormat, aType)
@@ -76,6 +78,7 @@ Image::Image(int aWidth, int aHeight, GLenum aFormat, GLenum aType,
 	_alignment = 4;
 	_packer = 0;
 	_unpacker = 0;
+	_simd = true;
 	_invalid = vbAll;
 	reserve();
 	int i;		// VC++ 6 doesn't handle the definition of variables in a 
@@ -106,6 +109,7 @@ Image::Image(Image& i) {
 	_pixels = 0;
 	_packer = 0;
 	_unpacker = 0;
+	_simd = i.simd();
 	_invalid = vbAll;
 	reserve();
 	memcpy(pixels(), i.pixels(), height() * rowSizeInBytes());
@@ -120,6 +124,7 @@ Image::operator= (Image& i) {
 	format(i.format());
 	type(i.type());
 	alignment(i.alignment());
+	simd(i.simd());
 	_invalid = vbAll;
 	reserve();
 	memcpy(pixels(), i.pixels(), height() * rowSizeInBytes());
@@ -32,6 +32,7 @@
 // main.cpp:  main program for Glean
 
 #include <cassert>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <string>
@@ -82,6 +83,13 @@ main(int argc, char* argv[]) {
 			o.overwrite = true;
 		} else if (!strcmp(argv[i], "--quick")) {
 			o.quick = true;
+		} else if (!strcmp(argv[i], "-j")
+		    || !strcmp(argv[i], "--jobs")) {
+			++i;
+			int jobs = atoi(mandatoryArg(argc, argv, i));
+			if (jobs < 1)
+				usage(argv[0]);
+			o.jobs = jobs;
 		} else if (!strcmp(argv[i], "--visuals")) {
 			visFilter = true;
 			++i;
@@ -271,6 +279,8 @@ usage(char* command) {
 "                                  # pixel formats) to test\n"
 "       (-t|--tests) {(+|-)test}   # choose tests to include (+) or exclude (-)\n"
 "       --quick                    # run fewer tests to reduce test time\n"
+"       (-j|--jobs) N              # test up to N visuals concurrently,\n"
+"                                  # each in its own process\n"
 "       --listtests                # list test names and exit\n"
 "       --help                     # display usage information\n"
 #if defined(__X11__)
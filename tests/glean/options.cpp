@@ -47,6 +47,7 @@ Options::Options() {
 	selectedTests.resize(0);
 	overwrite = false;
 	quick = false;
+	jobs = 1;
 #   if defined(__X11__)
 	{
 	char* display = getenv("DISPLAY");
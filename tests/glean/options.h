@@ -75,6 +75,10 @@ class Options {
 
 	bool quick;		// run fewer/quicker tests when possible
 
+	unsigned int jobs;	// Max number of drawing surface configs
+				// to test concurrently, each in its own
+				// worker process.
+
 #if defined(__X11__)
 	string dpyName;		// Name of the X11 display providing the
 				// OpenGL implementation to be tested.
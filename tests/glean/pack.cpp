@@ -34,6 +34,10 @@
 
 #include "image.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace {
 
 #define SCALE (static_cast<double>(num) / static_cast<double>(denom))
@@ -123,6 +127,52 @@ public :
 #undef SCALE
 #undef BIAS
 
+#if defined(__SSE2__)
+
+// SSE2 versions of the packers for GL_RGBA with GL_UNSIGNED_BYTE or
+// GL_FLOAT.  As with the unpackers in unpack.cpp, they do the same
+// arithmetic as the Pack specializations and give identical results;
+// double-to-integer conversion truncates and keeps the low-order bits,
+// just as the scalar static_cast does on x86.
+
+void
+pack_rgba_ubyte_sse2(GLsizei n, char* dst, double* rgba)
+{
+	const __m128d scale = _mm_set1_pd(255.0);
+	const __m128i mask = _mm_set1_epi32(0xff);
+	GLsizei i = 0;
+
+	// Two pixels (8 components) per iteration.
+	for (; i + 2 <= n; i += 2, dst += 8, rgba += 8) {
+		__m128i p0 = _mm_unpacklo_epi64(
+			_mm_cvttpd_epi32(_mm_mul_pd(_mm_loadu_pd(rgba + 0), scale)),
+			_mm_cvttpd_epi32(_mm_mul_pd(_mm_loadu_pd(rgba + 2), scale)));
+		__m128i p1 = _mm_unpacklo_epi64(
+			_mm_cvttpd_epi32(_mm_mul_pd(_mm_loadu_pd(rgba + 4), scale)),
+			_mm_cvttpd_epi32(_mm_mul_pd(_mm_loadu_pd(rgba + 6), scale)));
+		__m128i w = _mm_packs_epi32(_mm_and_si128(p0, mask),
+					    _mm_and_si128(p1, mask));
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst),
+				 _mm_packus_epi16(w, w));
+	}
+
+	Pack<GLubyte, 255, 1, 0>::pack_rgba(n - i, dst, rgba);
+}
+
+void
+pack_rgba_float_sse2(GLsizei n, char* dst, double* rgba)
+{
+	float* out = reinterpret_cast<float*>(dst);
+	double* end = rgba + 4 * n;
+	for (; rgba != end; rgba += 4, out += 4) {
+		__m128 rg = _mm_cvtpd_ps(_mm_loadu_pd(rgba + 0));
+		__m128 ba = _mm_cvtpd_ps(_mm_loadu_pd(rgba + 2));
+		_mm_storeu_ps(out, _mm_movelh_ps(rg, ba));
+	}
+}
+
+#endif // __SSE2__
+
 }; // anonymous namespace
 
 
@@ -231,6 +281,10 @@ Image::validatePacker() {
 			break;
 		case GL_UNSIGNED_BYTE:
 			_packer = Pack<GLubyte, 255, 1, 0>::pack_rgba;
+#if defined(__SSE2__)
+			if (_simd)
+				_packer = pack_rgba_ubyte_sse2;
+#endif
 			break;
 		case GL_SHORT:
 			_packer = Pack<GLshort, 65535, 2, 1>::pack_rgba;
@@ -246,6 +300,10 @@ Image::validatePacker() {
 			break;
 		case GL_FLOAT:
 			_packer = Pack<GLfloat, 1, 1, 0>::pack_rgba;
+#if defined(__SSE2__)
+			if (_simd)
+				_packer = pack_rgba_float_sse2;
+#endif
 			break;
 		default:
 			throw BadType(type());
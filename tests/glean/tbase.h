@@ -115,8 +115,10 @@ and tbasic.cpp.
 #define usleep(__usec) Sleep(((__usec) + 999)/1000)
 #endif
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include "dsconfig.h"
 #include "dsfilt.h"
 #include "dsurf.h"
@@ -125,6 +127,7 @@ and tbasic.cpp.
 #include "rc.h"
 #include "glutils.h"
 #include "misc.h"
+#include "workers.h"
 
 #include "test.h"
 
@@ -274,6 +277,129 @@ public:
 		return true;
 	}
 
+	// Run the test on a single drawing surface configuration, which
+	// must belong to environment.winSys.  Returns null if the config
+	// was skipped.
+	virtual ResultType* runConfig(Environment& environment,
+				      DrawingSurfaceConfig& config) {
+		WindowSystem& ws = environment.winSys;
+
+		Window w(ws, config, fWidth, fHeight);
+		RenderingContext rc(ws, config);
+		if (!ws.makeCurrent(rc, w)) {
+			// XXX need to throw exception here
+		}
+
+		// Make sure glew is initialized so we can call
+		// GL functions safely.
+		piglit_dispatch_default_init(PIGLIT_DISPATCH_GL);
+
+		// Check if test is applicable to this context
+		if (!isApplicable())
+			return 0;
+
+		// Check for all prerequisite extensions.  Note
+		// that this must be done after the rendering
+		// context has been created and made current!
+		if (!GLUtils::haveExtensions(extensions))
+			return 0;
+
+		// Create a result object and run the test:
+		ResultType* r = new ResultType();
+		r->config = &config;
+		runOne(*r, w);
+		logOne(*r);
+		return r;
+	}
+
+	// Runs runConfig() for each config in a worker process with its
+	// own window system connection.  Each worker returns its log
+	// output followed by its serialized result, and the results are
+	// rebuilt in the parent in config order.
+	class ConfigJobs: public WorkerJobs {
+	    public:
+		ConfigJobs(BaseTest* aTest,
+			   vector<DrawingSurfaceConfig*>& someConfigs):
+			test(aTest), configs(someConfigs) { }
+
+		BaseTest* test;
+		vector<DrawingSurfaceConfig*>& configs;
+
+		virtual string run(int index) {
+			Environment* parentEnv = test->env;
+			vector<DrawingSurfaceConfig*>& parentConfigs =
+				parentEnv->winSys.surfConfigs;
+			int configIndex = find(parentConfigs.begin(),
+					       parentConfigs.end(),
+					       configs[index])
+				- parentConfigs.begin();
+
+			ostringstream log;
+			streambuf* oldBuf = cout.rdbuf(log.rdbuf());
+			string result;
+			try {
+				Environment workerEnv(parentEnv->options);
+				test->env = &workerEnv;
+
+				// The worker's window system enumerates
+				// the same configs in the same order.
+				DrawingSurfaceConfig* config =
+					workerEnv.winSys.surfConfigs[configIndex];
+				ResultType* r = test->runConfig(workerEnv,
+								*config);
+				if (r) {
+					ostringstream rs;
+					r->put(rs);
+					result = rs.str();
+					delete r;
+				}
+			}
+			catch (RenderingContext::Error) {
+				cout << "Could not create a rendering context\n";
+			}
+			catch (WindowSystem::Error) {
+				cout << "Could not open the window system\n";
+			}
+			cout.rdbuf(oldBuf);
+			test->env = parentEnv;
+
+			ostringstream output;
+			output << log.str().size() << '\n'
+			       << log.str()
+			       << result;
+			return output.str();
+		}
+
+		virtual void collect(int index, bool ok,
+				     const string& output) {
+			istringstream s(output);
+			size_t logSize = 0;
+			if (!ok || !(s >> logSize) || s.get() != '\n') {
+				test->env->log << test->name << ":  FAIL "
+					<< configs[index]->conciseDescription()
+					<< '\n'
+					<< "\tworker process exited abnormally\n";
+				return;
+			}
+
+			string log(logSize, '\0');
+			s.read(&log[0], logSize);
+			test->env->log << log;
+
+			if (s.peek() == EOF)
+				return;	// config was skipped
+
+			ResultType* r = new ResultType();
+			if (!r->get(s)) {
+				delete r;
+				return;
+			}
+			delete r->config;
+			r->config = configs[index];
+			test->results.push_back(r);
+		}
+	};
+
 	virtual void run(Environment& environment) {
 		if (hasRun)
 			return; // no multiple invocations
@@ -294,49 +420,45 @@ public:
 			if (env->options.quick)
 				testOne = true;
 
-			// Test each config
+			// Many tests do not adjust their expectations
+			// for multisampling and hence incorrectly
+			// fail.
+			vector<DrawingSurfaceConfig*> testable;
 			for (vector<DrawingSurfaceConfig*>::const_iterator
 				     p = configs.begin();
 			     p < configs.end();
-			     ++p) {
-				// Many tests do not adjust their expectations
-				// for multisampling and hence incorrectly
-				// fail.
-				if ((*p)->samples > 0)
-					continue;
-
-				Window w(ws, **p, fWidth, fHeight);
-				RenderingContext rc(ws, **p);
-				if (!ws.makeCurrent(rc, w)) {
-					// XXX need to throw exception here
+			     ++p)
+				if ((*p)->samples == 0)
+					testable.push_back(*p);
+
+			// When testing only one config, which one is
+			// tested depends on the earlier ones being
+			// skipped, so the configs can't be tested
+			// concurrently.
+			if (!testOne && env->options.jobs > 1
+			    && testable.size() > 1 && HaveWorkers()) {
+				cout.flush();
+				ConfigJobs jobs(this, testable);
+				RunWorkerJobs(jobs, testable.size(),
+					      env->options.jobs);
+			} else {
+				// Test each config
+				for (vector<DrawingSurfaceConfig*>::const_iterator
+					     p = testable.begin();
+				     p < testable.end();
+				     ++p) {
+					ResultType* r = runConfig(environment,
+								  **p);
+					if (!r)
+						continue;
+
+					// Save the result
+					results.push_back(r);
+
+					// if testOne, skip remaining surface configs
+					if (testOne)
+						break;
 				}
-
-				// Make sure glew is initialized so we can call
-				// GL functions safely.
-				piglit_dispatch_default_init(PIGLIT_DISPATCH_GL);
-
-				// Check if test is applicable to this context
-				if (!isApplicable())
-					continue;
-
-				// Check for all prerequisite extensions.  Note
-				// that this must be done after the rendering
-				// context has been created and made current!
-				if (!GLUtils::haveExtensions(extensions))
-					continue;
-
-				// Create a result object and run the test:
-				ResultType* r = new ResultType();
-				r->config = *p;
-				runOne(*r, w);
-				logOne(*r);
-
-				// Save the result
-				results.push_back(r);
-
-				// if testOne, skip remaining surface configs
-				if (testOne)
-					break;
 			}
 		}
 		catch (DrawingSurfaceFilter::Syntax e) {
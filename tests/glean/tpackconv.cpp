@@ -0,0 +1,230 @@
+// BEGIN_COPYRIGHT -*- glean -*-
+// 
+// Copyright (C) 1999  Allen Akin   All Rights Reserved.
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the
+// Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL ALLEN AKIN BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+// AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+// OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// 
+// END_COPYRIGHT
+
+// tpackconv.cpp:  Check Image's SIMD pixel converters against the scalar ones
+
+// Image::pack() and Image::unpack() use SIMD converters for some formats
+// where the compiler targets SSE2 (see pack.cpp and unpack.cpp).  They must
+// give the same bits as the Pack and Unpack templates for every input,
+// including the out-of-range, negative and non-finite values that
+// glReadPixels never returns.  This test converts every 32-bit pattern
+// (every 4093rd with --quick) with both and compares the results, and
+// logs the throughput of each.  It needs no drawing, so it runs on one
+// drawing surface configuration.
+
+#include <cstring>
+#include <vector>
+#include "tpackconv.h"
+#include "image.h"
+#include "piglit-util.h"
+
+namespace {
+
+const GLsizei chunk = 65536;
+const uint32_t quickStride = 4093;
+
+uint32_t
+rotl(uint32_t x, int n)
+{
+	return n ? (x << n) | (x >> (32 - n)) : x;
+}
+
+float
+floatFromBits(uint32_t bits)
+{
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+// The color component j of the pixel made from a pattern.  Every float
+// value is seen in every component; the alpha of packed pixels also has
+// low-order bits set that no float has, which exercise the rounding.
+double
+component(uint32_t pattern, int j, bool packing)
+{
+	double d = floatFromBits(rotl(pattern, 8 * j));
+
+	if (packing && j == 3) {
+		uint64_t bits;
+		memcpy(&bits, &d, sizeof(d));
+		bits |= (pattern * 0x9e3779b9u) & 0x1fffffff;
+		memcpy(&d, &bits, sizeof(d));
+	}
+	return d;
+}
+
+struct Outcome {
+	bool pass;
+	uint32_t badPattern;	// The first pattern converted differently
+	uint64_t pixels;
+	int64_t simdTime;	// Microseconds
+	int64_t scalarTime;
+};
+
+Outcome
+compare(bool packing, GLenum type, uint32_t stride)
+{
+	using GLEAN::Image;
+
+	const uint64_t count = ((UINT64_C(1) << 32) + stride - 1) / stride;
+	Image simd(chunk, 1, GL_RGBA, type);
+	Image scalar(chunk, 1, GL_RGBA, type);
+	std::vector<double> rgba(4 * chunk), scalarRgba(4 * chunk);
+	const GLsizei size = simd.pixelSizeInBytes();
+	Outcome o = { true, 0, 0, 0, 0 };
+
+	scalar.simd(false);
+
+	GLsizei n;
+	for (uint64_t first = 0, round = 0; first < count;
+	     first += n, ++round) {
+		// Vary the length, so that the pixels the SIMD loops leave
+		// to the scalar code are seen too.
+		n = chunk - round % 4;
+		if (static_cast<uint64_t>(n) > count - first)
+			n = count - first;
+
+		for (GLsizei i = 0; i < n; ++i) {
+			uint32_t pattern = (first + i) * stride;
+			char* pixel = simd.pixels() + i * size;
+
+			if (packing) {
+				for (int j = 0; j < 4; ++j)
+					rgba[4 * i + j] =
+						component(pattern, j, true);
+			} else if (type == GL_UNSIGNED_BYTE) {
+				memcpy(pixel, &pattern, 4);
+			} else {
+				for (int j = 0; j < 4; ++j) {
+					float f = component(pattern, j,
+							    false);
+					memcpy(pixel + 4 * j, &f, 4);
+				}
+			}
+		}
+
+		int64_t start = piglit_get_microseconds();
+		if (packing)
+			simd.pack(n, simd.pixels(), &rgba[0]);
+		else
+			simd.unpack(n, &rgba[0], simd.pixels());
+		int64_t middle = piglit_get_microseconds();
+		if (packing)
+			scalar.pack(n, scalar.pixels(), &rgba[0]);
+		else
+			scalar.unpack(n, &scalarRgba[0], simd.pixels());
+		int64_t end = piglit_get_microseconds();
+
+		o.simdTime += middle - start;
+		o.scalarTime += end - middle;
+		o.pixels += n;
+
+		for (GLsizei i = 0; i < n; ++i) {
+			bool same = packing ?
+				!memcmp(simd.pixels() + i * size,
+					scalar.pixels() + i * size, size) :
+				!memcmp(&rgba[4 * i], &scalarRgba[4 * i],
+					4 * sizeof(double));
+			if (!same) {
+				o.pass = false;
+				o.badPattern = (first + i) * stride;
+				return o;
+			}
+		}
+	}
+
+	return o;
+}
+
+} // anonymous namespace
+
+namespace GLEAN {
+
+void
+PackConvTest::reportPassFail(MultiTestResult &r,
+			     bool pass, const char *msg) const
+{
+	if (pass) {
+		if (env->options.verbosity)
+			env->log << name << " PASS: " << msg << " test\n";
+		r.numPassed++;
+	}
+	else {
+		if (env->options.verbosity)
+			env->log << name << " FAILURE: " << msg << " test\n";
+		r.numFailed++;
+	}
+}
+
+void
+PackConvTest::runOne(MultiTestResult &r, Window &)
+{
+	static const struct {
+		bool packing;
+		GLenum type;
+		const char* name;
+	} conversions[] = {
+		{ false, GL_UNSIGNED_BYTE, "unpack GL_RGBA/GL_UNSIGNED_BYTE" },
+		{ false, GL_FLOAT, "unpack GL_RGBA/GL_FLOAT" },
+		{ true, GL_UNSIGNED_BYTE, "pack GL_RGBA/GL_UNSIGNED_BYTE" },
+		{ true, GL_FLOAT, "pack GL_RGBA/GL_FLOAT" },
+	};
+	const uint32_t stride = env->options.quick ? quickStride : 1;
+
+	for (unsigned i = 0; i < sizeof(conversions) / sizeof(conversions[0]);
+	     ++i) {
+		Outcome o = compare(conversions[i].packing,
+				    conversions[i].type, stride);
+
+		if (!o.pass) {
+			env->log << "\t" << conversions[i].name
+				 << ": pattern 0x" << std::hex
+				 << o.badPattern << std::dec
+				 << " is converted differently\n";
+		} else if (env->options.verbosity) {
+			env->log << "\t" << conversions[i].name << ": "
+				 << o.pixels << " pixels, SIMD "
+				 << o.pixels / (o.simdTime + 1.0)
+				 << " Mpixels/s, scalar "
+				 << o.pixels / (o.scalarTime + 1.0)
+				 << " Mpixels/s\n";
+		}
+		reportPassFail(r, o.pass, conversions[i].name);
+	}
+
+	r.pass = (r.numFailed == 0);
+}
+
+// The test object itself:
+PackConvTest packConvTest("packConv", "window",
+	"Check that the SIMD pixel packing and unpacking functions\n"
+	"used by glean's Image class convert every input exactly as\n"
+	"the scalar ones do, and log the throughput of each.\n");
+
+} // namespace GLEAN
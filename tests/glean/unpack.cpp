@@ -39,6 +39,10 @@
 
 #include "image.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace {
 
 #define SCALE (static_cast<double>(num) / static_cast<double>(denom))
@@ -132,6 +136,60 @@ public :
 #undef SCALE
 #undef BIAS
 
+#if defined(__SSE2__)
+
+// SSE2 versions of the unpackers for the formats that are read back
+// most often (GL_RGBA with GL_UNSIGNED_BYTE or GL_FLOAT).  They do
+// exactly the same double-precision arithmetic as the corresponding
+// Unpack specializations, two components at a time, so the results are
+// bit-for-bit identical.  The Unpack templates remain the reference
+// implementation and handle the remaining formats and the leftover
+// pixels at the end of a row.
+
+void
+unpack_rgba_ubyte_sse2(GLsizei n, double* rgba, char* src)
+{
+	const __m128d scale = _mm_set1_pd(1.0 / 255.0);
+	const __m128i zero = _mm_setzero_si128();
+	GLsizei i = 0;
+
+	// Four pixels (16 components) per iteration.
+	for (; i + 4 <= n; i += 4, src += 16, rgba += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<__m128i*>(src));
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		__m128i px[4] = {
+			_mm_unpacklo_epi16(lo, zero),
+			_mm_unpackhi_epi16(lo, zero),
+			_mm_unpacklo_epi16(hi, zero),
+			_mm_unpackhi_epi16(hi, zero)
+		};
+		for (int j = 0; j < 4; ++j) {
+			__m128d rg = _mm_cvtepi32_pd(px[j]);
+			__m128d ba = _mm_cvtepi32_pd(
+				_mm_shuffle_epi32(px[j], _MM_SHUFFLE(3, 2, 3, 2)));
+			_mm_storeu_pd(rgba + 4 * j + 0, _mm_mul_pd(rg, scale));
+			_mm_storeu_pd(rgba + 4 * j + 2, _mm_mul_pd(ba, scale));
+		}
+	}
+
+	Unpack<GLubyte, 1, 255, 0>::unpack_rgba(n - i, rgba, src);
+}
+
+void
+unpack_rgba_float_sse2(GLsizei n, double* rgba, char* src)
+{
+	float* in = reinterpret_cast<float*>(src);
+	double* end = rgba + 4 * n;
+	for (; rgba != end; rgba += 4, in += 4) {
+		__m128 v = _mm_loadu_ps(in);
+		_mm_storeu_pd(rgba + 0, _mm_cvtps_pd(v));
+		_mm_storeu_pd(rgba + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+	}
+}
+
+#endif // __SSE2__
+
 }; // anonymous namespace
 
 
@@ -240,6 +298,10 @@ Image::validateUnpacker() {
 			break;
 		case GL_UNSIGNED_BYTE:
 			_unpacker = Unpack<GLubyte, 1, 255, 0>::unpack_rgba;
+#if defined(__SSE2__)
+			if (_simd)
+				_unpacker = unpack_rgba_ubyte_sse2;
+#endif
 			break;
 		case GL_SHORT:
 			_unpacker = Unpack<GLshort, 2, 65535, 1>::unpack_rgba;
@@ -255,6 +317,10 @@ Image::validateUnpacker() {
 			break;
 		case GL_FLOAT:
 			_unpacker = Unpack<GLfloat, 1, 1, 0>::unpack_rgba;
+#if defined(__SSE2__)
+			if (_simd)
+				_unpacker = unpack_rgba_float_sse2;
+#endif
 			break;
 		default:
 			throw BadType(type());
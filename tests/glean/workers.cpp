@@ -0,0 +1,186 @@
+// BEGIN_COPYRIGHT -*- glean -*-
+// 
+// Copyright (C) 1999  Allen Akin   All Rights Reserved.
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the
+// Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL ALLEN AKIN BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+// AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+// OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// 
+// END_COPYRIGHT
+
+
+
+
+// workers.cpp:  run independent jobs in forked worker processes
+
+#include "workers.h"
+
+#include <deque>
+#include <iostream>
+
+#if defined(__UNIX__)
+#include <cerrno>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+namespace GLEAN {
+
+#if defined(__UNIX__)
+
+namespace {
+
+struct Worker {
+	int index;		// Job number.
+	pid_t pid;		// Child process, or -1 if fork failed.
+	int fd;			// Read end of the child's output pipe.
+};
+
+bool
+writeAll(int fd, const char* p, size_t n) {
+	while (n > 0) {
+		ssize_t written = write(fd, p, n);
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		p += written;
+		n -= written;
+	}
+	return true;
+} // writeAll
+
+string
+readAll(int fd) {
+	string s;
+	char buf[4096];
+	for (;;) {
+		ssize_t n = read(fd, buf, sizeof(buf));
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		if (n == 0)
+			break;
+		s.append(buf, n);
+	}
+	return s;
+} // readAll
+
+Worker
+startWorker(WorkerJobs& jobs, int index) {
+	Worker w;
+	w.index = index;
+	w.pid = -1;
+	w.fd = -1;
+
+	int fds[2];
+	if (pipe(fds) != 0)
+		return w;
+
+	// Don't let buffered output be written twice.
+	cout.flush();
+	cerr.flush();
+
+	w.pid = fork();
+	if (w.pid == 0) {
+		close(fds[0]);
+		string output = jobs.run(index);
+		bool ok = writeAll(fds[1], output.data(), output.size());
+		close(fds[1]);
+		// Skip static destructors and atexit handlers; they belong
+		// to the parent.
+		_exit(ok ? 0 : 1);
+	}
+
+	close(fds[1]);
+	if (w.pid < 0)
+		close(fds[0]);
+	else
+		w.fd = fds[0];
+	return w;
+} // startWorker
+
+void
+finishWorker(WorkerJobs& jobs, Worker& w) {
+	if (w.pid < 0) {
+		// Couldn't fork; run the job here instead.
+		jobs.collect(w.index, true, jobs.run(w.index));
+		return;
+	}
+
+	string output = readAll(w.fd);
+	close(w.fd);
+
+	int status = 0;
+	while (waitpid(w.pid, &status, 0) < 0 && errno == EINTR)
+		;
+	bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	jobs.collect(w.index, ok, output);
+} // finishWorker
+
+} // anonymous namespace
+
+bool
+HaveWorkers() {
+	return true;
+} // HaveWorkers
+
+void
+RunWorkerJobs(WorkerJobs& jobs, int count, unsigned int maxWorkers) {
+	if (maxWorkers < 1)
+		maxWorkers = 1;
+
+	// Workers are collected in the order they were started, which is
+	// job order.  A worker that finishes early simply waits, blocked
+	// on its pipe or as a zombie, until its turn comes.
+	deque<Worker> running;
+	int next = 0;
+	while (next < count || !running.empty()) {
+		while (next < count && running.size() < maxWorkers)
+			running.push_back(startWorker(jobs, next++));
+
+		finishWorker(jobs, running.front());
+		running.pop_front();
+	}
+} // RunWorkerJobs
+
+#else // !__UNIX__
+
+bool
+HaveWorkers() {
+	return false;
+} // HaveWorkers
+
+void
+RunWorkerJobs(WorkerJobs& jobs, int count, unsigned int maxWorkers) {
+	(void) maxWorkers;
+	for (int i = 0; i < count; ++i)
+		jobs.collect(i, true, jobs.run(i));
+} // RunWorkerJobs
+
+#endif // __UNIX__
+
+} // namespace GLEAN
@@ -0,0 +1,75 @@
+// BEGIN_COPYRIGHT -*- glean -*-
+// 
+// Copyright (C) 1999  Allen Akin   All Rights Reserved.
+// 
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use,
+// copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the
+// Software is furnished to do so, subject to the following
+// conditions:
+// 
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the
+// Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY
+// KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+// WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL ALLEN AKIN BE
+// LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+// AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF
+// OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+// 
+// END_COPYRIGHT
+
+
+
+
+// workers.h:  run independent jobs in forked worker processes
+
+// Each job runs in its own child process, so it may open its own
+// window-system connection, windows and rendering contexts without
+// interfering with the parent or with other jobs.  A job's output is
+// returned to the parent as a string through a pipe.  Outputs are
+// delivered to the parent in job order, regardless of the order in
+// which the workers finish, so that logs and result vectors built from
+// them are deterministic.
+
+#ifndef __workers_h__
+#define __workers_h__
+
+#include <string>
+
+using namespace std;
+
+namespace GLEAN {
+
+class WorkerJobs {
+    public:
+	virtual ~WorkerJobs() { }
+
+	// Run job number `index' in a worker process and return its
+	// output.  Called in the child.
+	virtual string run(int index) = 0;
+
+	// Receive the output of job number `index'.  Called in the
+	// parent, in increasing order of `index'.  If the worker exited
+	// abnormally, `ok' is false and `output' holds whatever the worker
+	// managed to send (normally nothing).
+	virtual void collect(int index, bool ok, const string& output) = 0;
+};
+
+// Returns true if this platform supports worker processes.  If not,
+// RunWorkerJobs() runs every job in the calling process.
+bool HaveWorkers();
+
+// Run jobs [0, count) with at most `maxWorkers' running at once.
+void RunWorkerJobs(WorkerJobs& jobs, int count, unsigned int maxWorkers);
+
+} // namespace GLEAN
+
+#endif // __workers_h__
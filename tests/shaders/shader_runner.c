@@ -2218,6 +2218,14 @@ piglit_display(void)
 			if (!piglit_probe_rect_rgb(x, y, w, h, &c[4])) {
 				pass = false;
 			}
+		} else if (sscanf(line,
+				  "probe each rgba ( %d , %d , %d , %d ) "
+				  "( %f , %f , %f , %f )",
+				  &x, &y, &w, &h,
+				  c + 0, c + 1, c + 2, c + 3) == 8) {
+			if (!piglit_probe_rect_rgba_each(x, y, w, h, c)) {
+				pass = false;
+			}
 		} else if (string_match("probe all rgba", line)) {
 			get_floats(line + 14, c, 4);
 			pass = pass &&
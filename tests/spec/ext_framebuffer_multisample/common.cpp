@@ -106,12 +106,39 @@
  *   buffers).  On some implementations (e.g. the nVidia proprietary
  *   driver for Linux) this is necessary for framebuffer completeness.
  *   On others (e.g. i965), this is an important corner case to test.
+ *
+ * The reference image doesn't depend on the sample count, or on
+ * whether a draw or a resolve is tested, so it is only rendered once
+ * per pattern and size.  It is kept in memory for the rest of the
+ * process, and, if the PIGLIT_REFERENCE_CACHE environment variable
+ * names a directory, in a file there for later processes.  The key of
+ * a reference image includes the GL vendor, renderer and version
+ * strings, so a cache is never used with a different driver.
  */
 
 #include "common.h"
+#if defined(_WIN32)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
 using namespace piglit_util_fbo;
 using namespace piglit_util_test_pattern;
 
+static const char reference_cache_magic[] = "piglit-reference-1\n";
+
+/**
+ * The most recently used reference image, so that a process testing
+ * several sample counts only renders or loads it once.
+ */
+static struct {
+	char key[512];
+	int width;
+	int height;
+	float *data;
+} reference_memo;
+
 void
 DownsampleProg::compile(int supersample_factor)
 {
@@ -249,9 +276,219 @@ Stats::is_better_than(double rms_error_threshold)
 	return sqrt(sum_squared_error / count) < rms_error_threshold;
 }
 
+/**
+ * Per-lane sums of squared errors and counts for unlit, partially lit
+ * and totally lit color components.
+ */
+struct error_lanes {
+	enum { count = 8 };
+	double sum[3][count];
+	int n[3][count];
+};
+
+static inline void
+add_error(error_lanes *lanes, int lane, float ref, float test)
+{
+	float error = test - ref;
+	double squared = error * error;
+	int is_unlit = ref <= 0.0f;
+	int is_total = ref >= 1.0f;
+	int is_partial = !(is_unlit | is_total);
+
+	lanes->sum[0][lane] += squared * is_unlit;
+	lanes->sum[1][lane] += squared * is_partial;
+	lanes->sum[2][lane] += squared * is_total;
+	lanes->n[0][lane] += is_unlit;
+	lanes->n[1][lane] += is_partial;
+	lanes->n[2][lane] += is_total;
+}
+
+/**
+ * Sort the errors between \a test and \a ref, which hold \a n
+ * color components, by whether the reference is unlit, partially lit
+ * or totally lit.
+ *
+ * Each of a fixed number of lanes accumulates every count'th
+ * component on its own, so the inner loop has no dependency between
+ * iterations and the compiler can vectorise it without reassociating
+ * floating point additions.
+ */
+static void
+accumulate_errors(const float *ref, const float *test, int n,
+		  Stats *unlit, Stats *partially_lit, Stats *totally_lit)
+{
+	error_lanes lanes;
+	int i, j;
+
+	memset(&lanes, 0, sizeof(lanes));
+	for (i = 0; i + error_lanes::count <= n; i += error_lanes::count) {
+		for (j = 0; j < error_lanes::count; ++j)
+			add_error(&lanes, j, ref[i + j], test[i + j]);
+	}
+	for (j = 0; i < n; ++i, ++j)
+		add_error(&lanes, j, ref[i], test[i]);
+
+	for (j = 0; j < error_lanes::count; ++j) {
+		unlit->record_sum(lanes.n[0][j], lanes.sum[0][j]);
+		partially_lit->record_sum(lanes.n[1][j], lanes.sum[1][j]);
+		totally_lit->record_sum(lanes.n[2][j], lanes.sum[2][j]);
+	}
+}
+
+/**
+ * Fill \a key with what identifies the reference image of \a name
+ * rendered with the given parameters by the current driver.
+ */
+static void
+reference_cache_key(char *key, size_t size, const char *name,
+		    int pattern_width, int pattern_height,
+		    int supersample_factor, bool combine_depth_stencil)
+{
+	snprintf(key, size, "%s %dx%d supersample=%d depthstencil=%d "
+		 "vendor=%s renderer=%s version=%s",
+		 name, pattern_width, pattern_height, supersample_factor,
+		 combine_depth_stencil,
+		 (const char *) glGetString(GL_VENDOR),
+		 (const char *) glGetString(GL_RENDERER),
+		 (const char *) glGetString(GL_VERSION));
+}
+
+/**
+ * Fill \a path with the name of the cache file for \a key, or return
+ * false if there is no cache directory.
+ */
+static bool
+reference_cache_path(char *path, size_t size, const char *key)
+{
+	const char *dir = getenv("PIGLIT_REFERENCE_CACHE");
+	uint64_t hash = 14695981039346656037ull;
+	const char *c;
+
+	if (!dir || !*dir)
+		return false;
+
+	/* FNV-1a; the file repeats the key in case of a collision. */
+	for (c = key; *c; ++c)
+		hash = (hash ^ (unsigned char) *c) * 1099511628211ull;
+
+	snprintf(path, size, "%s/%016llx.ref", dir, (unsigned long long) hash);
+	return true;
+}
+
+/**
+ * Read a reference image for \a key of the given size from \a f
+ * into \a data.
+ */
+static bool
+read_reference_file(FILE *f, const char *key, int width, int height,
+		    float *data)
+{
+	char magic[sizeof(reference_cache_magic)];
+	char file_key[sizeof(reference_memo.key)];
+	int file_width, file_height;
+	const size_t size = width * height * 4;
+
+	if (fread(magic, 1, sizeof(magic) - 1, f) != sizeof(magic) - 1 ||
+	    memcmp(magic, reference_cache_magic, sizeof(magic) - 1) != 0)
+		return false;
+
+	if (!fgets(file_key, sizeof(file_key), f))
+		return false;
+	file_key[strcspn(file_key, "\n")] = '\0';
+	if (!streq(file_key, key))
+		return false;
+
+	if (fread(&file_width, sizeof(int), 1, f) != 1 ||
+	    fread(&file_height, sizeof(int), 1, f) != 1 ||
+	    file_width != width || file_height != height)
+		return false;
+
+	return fread(data, sizeof(float), size, f) == size;
+}
+
+/**
+ * Return the reference image for \a key from memory or from the cache
+ * directory, or NULL if it hasn't been rendered yet.
+ */
+static const float *
+lookup_reference(const char *key, int width, int height)
+{
+	char path[4096];
+	float *data;
+	bool ok;
+	FILE *f;
+
+	if (reference_memo.data && streq(reference_memo.key, key) &&
+	    reference_memo.width == width && reference_memo.height == height)
+		return reference_memo.data;
+
+	if (!reference_cache_path(path, sizeof(path), key))
+		return NULL;
+
+	f = fopen(path, "rb");
+	if (!f)
+		return NULL;
+
+	data = new float[width * height * 4];
+	ok = read_reference_file(f, key, width, height, data);
+	fclose(f);
+	if (!ok) {
+		delete [] data;
+		return NULL;
+	}
+
+	delete [] reference_memo.data;
+	snprintf(reference_memo.key, sizeof(reference_memo.key), "%s", key);
+	reference_memo.width = width;
+	reference_memo.height = height;
+	reference_memo.data = data;
+	return data;
+}
+
+/**
+ * Remember the reference image \a data for \a key, in memory and in
+ * the cache directory.  The file is written under a temporary name and
+ * renamed, so that concurrent tests never read a partial file.
+ */
+static void
+store_reference(const char *key, int width, int height, const float *data)
+{
+	char path[4096];
+	char tmp_path[4096 + 32];
+	bool ok;
+	FILE *f;
+
+	delete [] reference_memo.data;
+	snprintf(reference_memo.key, sizeof(reference_memo.key), "%s", key);
+	reference_memo.width = width;
+	reference_memo.height = height;
+	reference_memo.data = new float[width * height * 4];
+	memcpy(reference_memo.data, data, sizeof(float) * width * height * 4);
+
+	if (!reference_cache_path(path, sizeof(path), key))
+		return;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int) getpid());
+	f = fopen(tmp_path, "wb");
+	if (!f)
+		return;
+
+	ok = fputs(reference_cache_magic, f) >= 0 &&
+	     fprintf(f, "%s\n", key) > 0 &&
+	     fwrite(&width, sizeof(int), 1, f) == 1 &&
+	     fwrite(&height, sizeof(int), 1, f) == 1 &&
+	     fwrite(data, sizeof(float), width * height * 4, f) ==
+		(size_t) (width * height * 4);
+	ok = fclose(f) == 0 && ok;
+
+	if (!ok || rename(tmp_path, path) != 0)
+		remove(tmp_path);
+}
+
 Test::Test(TestPattern *pattern, ManifestProgram *manifest_program,
 	   bool test_resolve, GLbitfield blit_type, bool srgb)
-	: pattern(pattern),
+	: reference_name(NULL),
+	  pattern(pattern),
 	  manifest_program(manifest_program),
 	  test_resolve(test_resolve),
 	  blit_type(blit_type),
@@ -259,8 +496,10 @@ Test::Test(TestPattern *pattern, ManifestProgram *manifest_program,
 	  pattern_width(0),
 	  pattern_height(0),
 	  supersample_factor(0),
+	  combine_depth_stencil(false),
 	  srgb(srgb),
 	  downsample_prog(),
+	  cached_reference(NULL),
 	  filter_mode(GL_NONE)
 {
 }
@@ -274,6 +513,7 @@ Test::init(int num_samples, bool small, bool combine_depth_stencil,
 	this->pattern_width = pattern_width;
 	this->pattern_height = pattern_height;
 	this->supersample_factor = supersample_factor;
+	this->combine_depth_stencil = combine_depth_stencil;
 	this->filter_mode = filter_mode;
 
 	FboConfig test_fbo_config(0,
@@ -444,11 +684,34 @@ Test::draw_to_default_framebuffer()
 }
 
 /**
- * Draw the entire test image, rendering it a piece at a time.
+ * Draw the entire reference image, rendering it a piece at a time,
+ * unless it was cached.
  */
 void
 Test::draw_reference_image()
 {
+	char key[sizeof(reference_memo.key)];
+
+	cached_reference = NULL;
+	if (reference_name) {
+		reference_cache_key(key, sizeof(key), reference_name,
+				    pattern_width, pattern_height,
+				    supersample_factor, combine_depth_stencil);
+		cached_reference = lookup_reference(key, pattern_width,
+						    pattern_height);
+	}
+
+	if (cached_reference) {
+		/* Show it where it would have been rendered */
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, piglit_winsys_fbo);
+		glViewport(0, 0, piglit_width, piglit_height);
+		glUseProgram(0);
+		glWindowPos2i(pattern_width, 0);
+		glDrawPixels(pattern_width, pattern_height, GL_RGBA, GL_FLOAT,
+			     cached_reference);
+		return;
+	}
+
 	int downsampled_width =
 		supersample_fbo.config.width / supersample_factor;
 	int downsampled_height =
@@ -486,45 +749,66 @@ bool
 Test::measure_accuracy()
 {
 	bool pass = true;
+	const int size = pattern_width * pattern_height * 4;
 
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, piglit_winsys_fbo);
 			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, piglit_winsys_fbo);
 			glViewport(0, 0, piglit_width, piglit_height);
 
-	float *reference_data = new float[pattern_width * pattern_height * 4];
-	glReadPixels(pattern_width, 0, pattern_width, pattern_height, GL_RGBA,
-		     GL_FLOAT, reference_data);
+	float *reference_data = new float[size];
+	float *test_data = new float[size];
+	if (cached_reference) {
+		memcpy(reference_data, cached_reference, sizeof(float) * size);
+		glReadPixels(0, 0, pattern_width, pattern_height, GL_RGBA,
+			     GL_FLOAT, test_data);
+	} else {
+		/* Read the test image and the reference image next to
+		 * it at once, then split the rows.
+		 */
+		float *data = new float[2 * size];
+		glReadPixels(0, 0, 2 * pattern_width, pattern_height, GL_RGBA,
+			     GL_FLOAT, data);
+		for (int y = 0; y < pattern_height; ++y) {
+			const float *row = data + 8 * y * pattern_width;
+			memcpy(test_data + 4 * y * pattern_width, row,
+			       sizeof(float) * 4 * pattern_width);
+			memcpy(reference_data + 4 * y * pattern_width,
+			       row + 4 * pattern_width,
+			       sizeof(float) * 4 * pattern_width);
+		}
+		delete [] data;
+
+		if (reference_name) {
+			char key[sizeof(reference_memo.key)];
+			reference_cache_key(key, sizeof(key), reference_name,
+					    pattern_width, pattern_height,
+					    supersample_factor,
+					    combine_depth_stencil);
+			store_reference(key, pattern_width, pattern_height,
+					reference_data);
+		}
+	}
 
-	float *test_data = new float[pattern_width * pattern_height * 4];
-	glReadPixels(0, 0, pattern_width, pattern_height, GL_RGBA,
-		     GL_FLOAT, test_data);
+	/* When testing sRGB, compare pixels linearly so that the
+	 * measured error is comparable to the non-sRGB case.
+	 */
+	if (srgb) {
+		for (int i = 0; i < size; ++i) {
+			if (i % 4 == 3)
+				continue;
+			reference_data[i] =
+				piglit_srgb_to_linear(reference_data[i]);
+			test_data[i] = piglit_srgb_to_linear(test_data[i]);
+		}
+	}
 
 	Stats unlit_stats;
 	Stats partially_lit_stats;
 	Stats totally_lit_stats;
-	for (int y = 0; y < pattern_height; ++y) {
-		for (int x = 0; x < pattern_width; ++x) {
-			for (int c = 0; c < 4; ++c) {
-				int pixel_pos = 4*(y*pattern_width + x) + c;
-				float ref = reference_data[pixel_pos];
-				float test = test_data[pixel_pos];
-				/* When testing sRGB, compare pixels
-				 * linearly so that the measured error
-				 * is comparable to the non-sRGB case.
-				 */
-				if (srgb && c < 3) {
-					ref = piglit_srgb_to_linear(ref);
-					test = piglit_srgb_to_linear(test);
-				}
-				if (ref <= 0.0)
-					unlit_stats.record(test - ref);
-				else if (ref >= 1.0)
-					totally_lit_stats.record(test - ref);
-				else
-					partially_lit_stats.record(test - ref);
-			}
-		}
-	}
+	accumulate_errors(reference_data, test_data, size, &unlit_stats,
+			  &partially_lit_stats, &totally_lit_stats);
+	delete [] reference_data;
+	delete [] test_data;
 
 	printf("Pixels that should be unlit\n");
 	unlit_stats.summarize();
@@ -612,5 +896,25 @@ create_test(test_type_enum test_type, int n_samples, bool small,
 
 	test->init(n_samples, small, combine_depth_stencil, pattern_width,
 		   pattern_height, supersample_factor, filter_mode);
+
+	/* Tests drawing the same pattern through the same manifest
+	 * program share their reference image.
+	 */
+	switch (test_type) {
+	case TEST_TYPE_COLOR:
+		test->reference_name = "triangles";
+		break;
+	case TEST_TYPE_SRGB:
+		test->reference_name = "triangles-srgb";
+		break;
+	case TEST_TYPE_STENCIL_DRAW:
+	case TEST_TYPE_STENCIL_RESOLVE:
+		test->reference_name = "stencil-sunburst";
+		break;
+	case TEST_TYPE_DEPTH_DRAW:
+	case TEST_TYPE_DEPTH_RESOLVE:
+		test->reference_name = "depth-sunburst";
+		break;
+	}
 	return test;
 }
@@ -78,6 +78,12 @@ public:
 		sum_squared_error += error * error;
 	}
 
+	void record_sum(int count, double sum_squared_error)
+	{
+		this->count += count;
+		this->sum_squared_error += sum_squared_error;
+	}
+
 	void summarize();
 
 	bool is_perfect();
@@ -113,6 +119,12 @@ public:
 	 */
 	piglit_util_fbo::Fbo test_fbo;
 
+	/**
+	 * Name of the pattern and manifest program, used to cache the
+	 * reference image, or NULL to always render it.
+	 */
+	const char *reference_name;
+
 private:
 	void resolve(piglit_util_fbo::Fbo *fbo, GLbitfield which_buffers);
 	void downsample_color(int downsampled_width, int downsampled_height);
@@ -171,9 +183,16 @@ private:
 	int pattern_width;
 	int pattern_height;
 	int supersample_factor;
+	bool combine_depth_stencil;
 	bool srgb;
 	DownsampleProg downsample_prog;
 
+	/**
+	 * The reference image shown by draw_reference_image() if it
+	 * came from the cache, NULL if it was rendered.
+	 */
+	const float *cached_reference;
+
 	/**
 	 * Filter mode to use when downsampling the image
 	 */
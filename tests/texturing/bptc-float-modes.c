@@ -33,6 +33,7 @@
  */
 
 #include "piglit-util-gl.h"
+#include "piglit-texcompress.h"
 
 PIGLIT_GL_TEST_CONFIG_BEGIN
 
@@ -43,181 +44,7 @@ PIGLIT_GL_TEST_CONFIG_BEGIN
 PIGLIT_GL_TEST_CONFIG_END
 
 #define BLOCK_SIZE 4
-#define BLOCK_BYTES 16
-#define N_PARTITIONS 32
-
-struct bptc_float_bitfield {
-   int8_t endpoint;
-   uint8_t component;
-   uint8_t offset;
-   uint8_t n_bits;
-   bool reverse;
-};
-
-struct bptc_float_mode {
-   int n_partition_bits;
-   int n_index_bits;
-   struct bptc_float_bitfield bitfields[24];
-};
-
-static const struct bptc_float_mode
-bptc_float_modes[] = {
-   /* 00 */
-   { 5, 3,
-     { { 2, 1, 4, 1, false }, { 2, 2, 4, 1, false }, { 3, 2, 4, 1, false },
-       { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
-       { 1, 0, 0, 5, false }, { 3, 1, 4, 1, false }, { 2, 1, 0, 4, false },
-       { 1, 1, 0, 5, false }, { 3, 2, 0, 1, false }, { 3, 1, 0, 4, false },
-       { 1, 2, 0, 5, false }, { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false },
-       { 2, 0, 0, 5, false }, { 3, 2, 2, 1, false }, { 3, 0, 0, 5, false },
-       { 3, 2, 3, 1, false },
-       { -1 } }
-   },
-   /* 01 */
-   { 5, 3,
-     { { 2, 1, 5, 1, false }, { 3, 1, 4, 1, false }, { 3, 1, 5, 1, false },
-       { 0, 0, 0, 7, false }, { 3, 2, 0, 1, false }, { 3, 2, 1, 1, false },
-       { 2, 2, 4, 1, false }, { 0, 1, 0, 7, false }, { 2, 2, 5, 1, false },
-       { 3, 2, 2, 1, false }, { 2, 1, 4, 1, false }, { 0, 2, 0, 7, false },
-       { 3, 2, 3, 1, false }, { 3, 2, 5, 1, false }, { 3, 2, 4, 1, false },
-       { 1, 0, 0, 6, false }, { 2, 1, 0, 4, false }, { 1, 1, 0, 6, false },
-       { 3, 1, 0, 4, false }, { 1, 2, 0, 6, false }, { 2, 2, 0, 4, false },
-       { 2, 0, 0, 6, false },
-       { 3, 0, 0, 6, false },
-       { -1 } }
-   },
-   /* 00010 */
-   { 5, 3,
-     { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
-       { 1, 0, 0, 5, false }, { 0, 0, 10, 1, false }, { 2, 1, 0, 4, false },
-       { 1, 1, 0, 4, false }, { 0, 1, 10, 1, false }, { 3, 2, 0, 1, false },
-       { 3, 1, 0, 4, false }, { 1, 2, 0, 4, false }, { 0, 2, 10, 1, false },
-       { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 5, false },
-       { 3, 2, 2, 1, false }, { 3, 0, 0, 5, false }, { 3, 2, 3, 1, false },
-       { -1 } }
-   },
-   /* 00011 */
-   { 0, 4,
-     { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
-       { 1, 0, 0, 10, false }, { 1, 1, 0, 10, false }, { 1, 2, 0, 10, false },
-       { -1 } }
-   },
-   /* 00110 */
-   { 5, 3,
-     { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
-       { 1, 0, 0, 4, false }, { 0, 0, 10, 1, false }, { 3, 1, 4, 1, false },
-       { 2, 1, 0, 4, false }, { 1, 1, 0, 5, false }, { 0, 1, 10, 1, false },
-       { 3, 1, 0, 4, false }, { 1, 2, 0, 4, false }, { 0, 2, 10, 1, false },
-       { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 4, false },
-       { 3, 2, 0, 1, false }, { 3, 2, 2, 1, false }, { 3, 0, 0, 4, false },
-       { 2, 1, 4, 1, false }, { 3, 2, 3, 1, false },
-       { -1 } }
-   },
-   /* 00111 */
-   { 0, 4,
-     { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
-       { 1, 0, 0, 9, false }, { 0, 0, 10, 1, false }, { 1, 1, 0, 9, false },
-       { 0, 1, 10, 1, false }, { 1, 2, 0, 9, false }, { 0, 2, 10, 1, false },
-       { -1 } }
-   },
-   /* 01010 */
-   { 5, 3,
-     { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
-       { 1, 0, 0, 4, false }, { 0, 0, 10, 1, false }, { 2, 2, 4, 1, false },
-       { 2, 1, 0, 4, false }, { 1, 1, 0, 4, false }, { 0, 1, 10, 1, false },
-       { 3, 2, 0, 1, false }, { 3, 1, 0, 4, false }, { 1, 2, 0, 5, false },
-       { 0, 2, 10, 1, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 4, false },
-       { 3, 2, 1, 1, false }, { 3, 2, 2, 1, false }, { 3, 0, 0, 4, false },
-       { 3, 2, 4, 1, false }, { 3, 2, 3, 1, false },
-       { -1 } }
-   },
-   /* 01011 */
-   { 0, 4,
-     { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
-       { 1, 0, 0, 8, false }, { 0, 0, 10, 2, true }, { 1, 1, 0, 8, false },
-       { 0, 1, 10, 2, true }, { 1, 2, 0, 8, false }, { 0, 2, 10, 2, true },
-       { -1 } }
-   },
-   /* 01110 */
-   { 5, 3,
-     { { 0, 0, 0, 9, false }, { 2, 2, 4, 1, false }, { 0, 1, 0, 9, false },
-       { 2, 1, 4, 1, false }, { 0, 2, 0, 9, false }, { 3, 2, 4, 1, false },
-       { 1, 0, 0, 5, false }, { 3, 1, 4, 1, false }, { 2, 1, 0, 4, false },
-       { 1, 1, 0, 5, false }, { 3, 2, 0, 1, false }, { 3, 1, 0, 4, false },
-       { 1, 2, 0, 5, false }, { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false },
-       { 2, 0, 0, 5, false }, { 3, 2, 2, 1, false }, { 3, 0, 0, 5, false },
-       { 3, 2, 3, 1, false },
-       { -1 } }
-   },
-   /* 01111 */
-   { 0, 4,
-     { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
-       { 1, 0, 0, 4, false }, { 0, 0, 10, 6, true }, { 1, 1, 0, 4, false },
-       { 0, 1, 10, 6, true }, { 1, 2, 0, 4, false }, { 0, 2, 10, 6, true },
-       { -1 } }
-   },
-   /* 10010 */
-   { 5, 3,
-     { { 0, 0, 0, 8, false }, { 3, 1, 4, 1, false }, { 2, 2, 4, 1, false },
-       { 0, 1, 0, 8, false }, { 3, 2, 2, 1, false }, { 2, 1, 4, 1, false },
-       { 0, 2, 0, 8, false }, { 3, 2, 3, 1, false }, { 3, 2, 4, 1, false },
-       { 1, 0, 0, 6, false }, { 2, 1, 0, 4, false }, { 1, 1, 0, 5, false },
-       { 3, 2, 0, 1, false }, { 3, 1, 0, 4, false }, { 1, 2, 0, 5, false },
-       { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 6, false },
-       { 3, 0, 0, 6, false },
-       { -1 } }
-   },
-   /* 10011 */
-   { /* reserved */ },
-   /* 10110 */
-   { 5, 3,
-     { { 0, 0, 0, 8, false }, { 3, 2, 0, 1, false }, { 2, 2, 4, 1, false },
-       { 0, 1, 0, 8, false }, { 2, 1, 5, 1, false }, { 2, 1, 4, 1, false },
-       { 0, 2, 0, 8, false }, { 3, 1, 5, 1, false }, { 3, 2, 4, 1, false },
-       { 1, 0, 0, 5, false }, { 3, 1, 4, 1, false }, { 2, 1, 0, 4, false },
-       { 1, 1, 0, 6, false }, { 3, 1, 0, 4, false }, { 1, 2, 0, 5, false },
-       { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 5, false },
-       { 3, 2, 2, 1, false }, { 3, 0, 0, 5, false }, { 3, 2, 3, 1, false },
-       { -1 } }
-   },
-   /* 10111 */
-   { /* reserved */ },
-   /* 11010 */
-   { 5, 3,
-     { { 0, 0, 0, 8, false }, { 3, 2, 1, 1, false }, { 2, 2, 4, 1, false },
-       { 0, 1, 0, 8, false }, { 2, 2, 5, 1, false }, { 2, 1, 4, 1, false },
-       { 0, 2, 0, 8, false }, { 3, 2, 5, 1, false }, { 3, 2, 4, 1, false },
-       { 1, 0, 0, 5, false }, { 3, 1, 4, 1, false }, { 2, 1, 0, 4, false },
-       { 1, 1, 0, 5, false }, { 3, 2, 0, 1, false }, { 3, 1, 0, 4, false },
-       { 1, 2, 0, 6, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 5, false },
-       { 3, 2, 2, 1, false }, { 3, 0, 0, 5, false }, { 3, 2, 3, 1, false },
-       { -1 } }
-   },
-   /* 11011 */
-   { /* reserved */ },
-   /* 11110 */
-   { 5, 3,
-     { { 0, 0, 0, 6, false }, { 3, 1, 4, 1, false }, { 3, 2, 0, 1, false },
-       { 3, 2, 1, 1, false }, { 2, 2, 4, 1, false }, { 0, 1, 0, 6, false },
-       { 2, 1, 5, 1, false }, { 2, 2, 5, 1, false }, { 3, 2, 2, 1, false },
-       { 2, 1, 4, 1, false }, { 0, 2, 0, 6, false }, { 3, 1, 5, 1, false },
-       { 3, 2, 3, 1, false }, { 3, 2, 5, 1, false }, { 3, 2, 4, 1, false },
-       { 1, 0, 0, 6, false }, { 2, 1, 0, 4, false }, { 1, 1, 0, 6, false },
-       { 3, 1, 0, 4, false }, { 1, 2, 0, 6, false }, { 2, 2, 0, 4, false },
-       { 2, 0, 0, 6, false }, { 3, 0, 0, 6, false },
-       { -1 } }
-   },
-   /* 11111 */
-   { /* reserved */ },
-};
-
-static const uint8_t
-anchor_indices[N_PARTITIONS] = {
-	/* Anchor index values for the second subset of two-subset
-	 * partitioning */
-	0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,
-	0xf,0x2,0x8,0x2,0x2,0x8,0x8,0xf,0x2,0x8,0x2,0x2,0x8,0x8,0x2,0x2
-};
+#define BLOCK_BYTES PIGLIT_BPTC_BLOCK_BYTES
 
 struct bptc_block {
 	int mode;
@@ -730,109 +557,18 @@ bptc_blocks[] = {
 
 #define N_BLOCKS ARRAY_SIZE(bptc_blocks)
 
-static void
-write_bits(uint8_t *out,
-	   int *offset,
-	   int value,
-	   int n_bits)
-{
-	int bit_index = *offset % 8;
-	int byte_index = *offset / 8;
-	int n_bits_in_byte = MIN2(n_bits, 8 - bit_index);
-
-	*offset += n_bits;
-
-	while (n_bits > 0) {
-		out[byte_index] |= ((value & ((1 << n_bits_in_byte) - 1)) <<
-				    bit_index);
-
-		n_bits -= n_bits_in_byte;
-		value >>= n_bits_in_byte;
-		byte_index++;
-		bit_index = 0;
-		n_bits_in_byte = MIN2(n_bits, 8);
-	}
-}
-
-static bool
-is_anchor(const struct bptc_float_mode *mode,
-	  int partition_num,
-	  int texel)
-{
-	if (texel == 0)
-		return true;
-
-	return (mode->n_partition_bits > 0 &&
-		anchor_indices[partition_num] == texel);
-}
-
-static uint16_t
-extract_bitfield(const struct bptc_block *block,
-		 const struct bptc_float_bitfield *bitfield)
-{
-	uint16_t value, tmp;
-	int i;
-
-	value = ((block->endpoints[bitfield->endpoint][bitfield->component] >>
-		  bitfield->offset) &
-		 ((1 << bitfield->n_bits) - 1));
-
-	if (bitfield->reverse) {
-		tmp = 0;
-		for (i = 0; i < bitfield->n_bits; i++) {
-			tmp <<= 1;
-			if (value & 1)
-				tmp |= 1;
-			value >>= 1;
-		}
-		return tmp;
-	} else {
-		return value;
-	}
-}
-
 static void
 make_block(const struct bptc_block *block,
 	   uint8_t *out)
 {
-	const struct bptc_float_mode *mode;
-	const struct bptc_float_bitfield *bitfield;
-	int offset = 0;
-	int n_bits;
-	uint16_t value;
-	int i;
+	struct piglit_bptc_float_block fields;
 
-	if (block->mode >= 2) {
-		mode = (bptc_float_modes +
-			(((block->mode >> 1) & 0xe) | (block->mode & 1))) + 2;
-	} else {
-		mode = bptc_float_modes + (block->mode & 1);
-	}
-
-	memset(out, 0, BLOCK_SIZE * BLOCK_SIZE);
-
-	if (block->mode < 2)
-		write_bits(out, &offset, block->mode, 2);
-	else
-		write_bits(out, &offset, block->mode, 5);
-
-	for (bitfield = mode->bitfields; bitfield->endpoint != -1; bitfield++) {
-		value = extract_bitfield(block, bitfield);
-		write_bits(out, &offset, value, bitfield->n_bits);
-	}
-
-	write_bits(out, &offset, block->partition, mode->n_partition_bits);
-
-	for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
-		n_bits = mode->n_index_bits;
-
-		if (is_anchor(mode, block->partition, i))
-			n_bits--;
-
-		write_bits(out, &offset, block->indices[i], n_bits);
-	}
+	fields.mode = block->mode;
+	fields.partition = block->partition;
+	memcpy(fields.endpoints, block->endpoints, sizeof(fields.endpoints));
+	memcpy(fields.indices, block->indices, sizeof(fields.indices));
 
-	assert(offset == BLOCK_BYTES * 8);
+	piglit_bptc_float_write_block(&fields, out);
 }
 
 static GLuint
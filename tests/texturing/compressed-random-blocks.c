@@ -0,0 +1,225 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file compressed-random-blocks.c
+ *
+ * Uploads a texture made of random compressed blocks and checks that
+ * glGetTexImage() returns what the reference decoder in
+ * piglit-texcompress.c makes of the same data.
+ *
+ * Where the other compressed texture tests exercise a few hand-picked
+ * blocks, this covers arbitrary combinations of modes, partitions and
+ * endpoints.  The image size is not a multiple of the block size so
+ * that partial blocks are covered too.
+ *
+ * GL_ETC1_RGB8_OES is uploaded as GL_COMPRESSED_RGB8_ETC2, which
+ * decodes ETC1 blocks identically.
+ */
+
+#include "piglit-util-gl.h"
+#include "piglit-texcompress.h"
+
+#define WIDTH 62
+#define HEIGHT 38
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 10;
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGB | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+struct format {
+	const char *name;
+	GLenum token;
+	/** Format passed to glCompressedTexImage2D(). */
+	GLenum upload_token;
+	const char **extension;
+	/** Allowed difference from the reference decoding. */
+	float tolerance;
+};
+
+static const char *S3TC[] = {
+	"GL_EXT_texture_compression_s3tc",
+	NULL
+};
+
+static const char *RGTC[] = {
+	"GL_ARB_texture_compression_rgtc",
+	NULL
+};
+
+static const char *RGTC_signed[] = {
+	"GL_ARB_texture_compression_rgtc",
+	"GL_EXT_texture_snorm",
+	NULL
+};
+
+static const char *BPTC[] = {
+	"GL_ARB_texture_compression_bptc",
+	NULL
+};
+
+static const char *ETC[] = {
+	"GL_ARB_ES3_compatibility",
+	NULL
+};
+
+/* S3TC and RGTC leave the precision of the interpolated values to the
+ * implementation.
+ */
+#define INTERP_TOLERANCE (2.0f / 255.0f)
+#define EXACT_TOLERANCE (0.5f / 255.0f)
+
+#define FORMAT(t, ext, tol) { #t, t, t, ext, tol }
+static const struct format formats[] = {
+	FORMAT(GL_COMPRESSED_RGB_S3TC_DXT1_EXT, S3TC, INTERP_TOLERANCE),
+	FORMAT(GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, S3TC, INTERP_TOLERANCE),
+	FORMAT(GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, S3TC, INTERP_TOLERANCE),
+	FORMAT(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, S3TC, INTERP_TOLERANCE),
+
+	FORMAT(GL_COMPRESSED_RED_RGTC1, RGTC, INTERP_TOLERANCE),
+	FORMAT(GL_COMPRESSED_SIGNED_RED_RGTC1, RGTC_signed,
+	       2.0f * INTERP_TOLERANCE),
+	FORMAT(GL_COMPRESSED_RG_RGTC2, RGTC, INTERP_TOLERANCE),
+	FORMAT(GL_COMPRESSED_SIGNED_RG_RGTC2, RGTC_signed,
+	       2.0f * INTERP_TOLERANCE),
+
+	FORMAT(GL_COMPRESSED_RGBA_BPTC_UNORM, BPTC, EXACT_TOLERANCE),
+	FORMAT(GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT, BPTC, 0.0f),
+	FORMAT(GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, BPTC, 0.0f),
+
+	{ "GL_ETC1_RGB8_OES", GL_ETC1_RGB8_OES, GL_COMPRESSED_RGB8_ETC2,
+	  ETC, EXACT_TOLERANCE },
+};
+
+static const struct format *format;
+
+enum piglit_result
+piglit_display(void)
+{
+	/* UNREACHED */
+	return PIGLIT_FAIL;
+}
+
+static bool
+check_image(const float *observed, const float *expected)
+{
+	int x, y, c;
+
+	for (y = 0; y < HEIGHT; y++) {
+		for (x = 0; x < WIDTH; x++) {
+			const float *o = &observed[(y * WIDTH + x) * 4];
+			const float *e = &expected[(y * WIDTH + x) * 4];
+
+			for (c = 0; c < 4; c++) {
+				if (fabsf(o[c] - e[c]) > format->tolerance)
+					break;
+			}
+			if (c == 4)
+				continue;
+
+			printf("Texel (%d, %d) in block %d of row %d\n"
+			       "  Expected: %f %f %f %f\n"
+			       "  Observed: %f %f %f %f\n",
+			       x, y, x / 4, y / 4,
+			       e[0], e[1], e[2], e[3],
+			       o[0], o[1], o[2], o[3]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void
+usage(const char *name)
+{
+	int i;
+
+	fprintf(stderr, "Usage: %s <format>\n", name);
+	fprintf(stderr, "format is one of:\n");
+	for (i = 0; i < ARRAY_SIZE(formats); i++)
+		fprintf(stderr, "  %s\n", formats[i].name);
+	exit(1);
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	const int n_blocks = ((WIDTH + 3) / 4) * ((HEIGHT + 3) / 4);
+	unsigned size;
+	void *data;
+	float *expected, *observed;
+	GLuint tex;
+	bool pass;
+	int i;
+
+	if (argc != 2)
+		usage(argv[0]);
+
+	format = NULL;
+	for (i = 0; i < ARRAY_SIZE(formats); i++) {
+		if (strcmp(formats[i].name, argv[1]) == 0) {
+			format = &formats[i];
+			break;
+		}
+	}
+	if (!format)
+		usage(argv[0]);
+
+	for (i = 0; format->extension[i]; i++)
+		piglit_require_extension(format->extension[i]);
+
+	size = piglit_compressed_image_size(format->token, WIDTH, HEIGHT);
+	data = malloc(size);
+	expected = malloc(WIDTH * HEIGHT * 4 * sizeof(float));
+	observed = malloc(WIDTH * HEIGHT * 4 * sizeof(float));
+
+	srand(0);
+	piglit_texcompress_random_blocks(format->token, n_blocks, data);
+	piglit_texcompress_decode_image(format->token, WIDTH, HEIGHT, data,
+					expected);
+
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glCompressedTexImage2D(GL_TEXTURE_2D, 0, format->upload_token,
+			       WIDTH, HEIGHT, 0, size, data);
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, observed);
+	if (!piglit_check_gl_error(GL_NO_ERROR))
+		piglit_report_result(PIGLIT_FAIL);
+
+	pass = check_image(observed, expected);
+
+	glDeleteTextures(1, &tex);
+	free(observed);
+	free(expected);
+	free(data);
+
+	piglit_report_result(pass ? PIGLIT_PASS : PIGLIT_FAIL);
+}
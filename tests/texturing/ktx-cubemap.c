@@ -0,0 +1,236 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file ktx-cubemap.c
+ *
+ * Loads a 1x1 RGB cube map from a KTX file with piglit_ktx, directly and
+ * through a pixel unpack buffer, and checks each face.  Each face's three
+ * bytes are padded to four in the file.  The file is then cut short at
+ * every length inside the image data, including those where a face's
+ * padding lies beyond the end, and every face must be refused.  This tests
+ * piglit itself rather than the GL implementation.
+ */
+
+#include "piglit-util-gl.h"
+#include "piglit_ktx.h"
+
+PIGLIT_GL_TEST_CONFIG_BEGIN
+
+	config.supports_gl_compat_version = 13;
+
+	config.window_visual = PIGLIT_GL_VISUAL_RGB | PIGLIT_GL_VISUAL_DOUBLE;
+
+PIGLIT_GL_TEST_CONFIG_END
+
+/* The header, imageSize, and six padded faces. */
+#define FILE_SIZE (64 + 4 + 6 * 4)
+
+static const GLubyte face_colors[6][3] = {
+	{ 255, 0, 0 },
+	{ 0, 255, 0 },
+	{ 0, 0, 255 },
+	{ 255, 255, 0 },
+	{ 0, 255, 255 },
+	{ 255, 0, 255 },
+};
+
+static void
+get_path(char *path, size_t size, const char *filename)
+{
+	piglit_join_paths(path, size, 4, piglit_source_dir(), "tests",
+			  "texturing", filename);
+}
+
+static bool
+check_info(const struct piglit_ktx_info *info, size_t size)
+{
+	if (info->target != GL_TEXTURE_CUBE_MAP || info->num_images != 6 ||
+	    info->pixel_width != 1 || info->pixel_height != 1 ||
+	    info->size != size) {
+		printf("Unexpected KTX info: target 0x%x, %u images, %ux%u, "
+		       "%zu bytes\n", info->target, info->num_images,
+		       info->pixel_width, info->pixel_height, info->size);
+		return false;
+	}
+	return true;
+}
+
+static bool
+check_faces(GLuint tex)
+{
+	GLubyte texel[4];
+	bool pass = true;
+	int face;
+
+	glBindTexture(GL_TEXTURE_CUBE_MAP, tex);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	for (face = 0; face < 6; face++) {
+		glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0,
+			      GL_RGB, GL_UNSIGNED_BYTE, texel);
+		if (memcmp(texel, face_colors[face], 3) != 0) {
+			printf("Face %d: expected %u %u %u, got %u %u %u\n",
+			       face, face_colors[face][0],
+			       face_colors[face][1], face_colors[face][2],
+			       texel[0], texel[1], texel[2]);
+			pass = false;
+		}
+	}
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	return pass;
+}
+
+static bool
+load_file(const char *path, bool streaming)
+{
+	struct piglit_ktx_info info;
+	struct piglit_ktx *ktx;
+	GLuint tex = 0;
+	bool pass = true;
+
+	if (!piglit_ktx_read_file_info(path, &info) ||
+	    !check_info(&info, FILE_SIZE))
+		return false;
+
+	ktx = piglit_ktx_read_file(path);
+	if (ktx == NULL)
+		return false;
+
+	if (streaming)
+		pass = piglit_ktx_load_texture_streaming(ktx, &tex, NULL);
+	else
+		pass = piglit_ktx_load_texture(ktx, &tex, NULL);
+	pass = pass && check_info(piglit_ktx_get_info(ktx), FILE_SIZE);
+	pass = pass && check_faces(tex);
+
+	glDeleteTextures(1, &tex);
+	piglit_ktx_destroy(ktx);
+	return pass;
+}
+
+/* Cut the data short at every length inside the image data. */
+static bool
+check_truncated_bytes(const char *path)
+{
+	struct piglit_ktx *ktx;
+	GLubyte data[FILE_SIZE];
+	bool pass = true;
+	FILE *file;
+	size_t size;
+	int face;
+
+	file = fopen(path, "rb");
+	if (file == NULL || fread(data, 1, FILE_SIZE, file) != FILE_SIZE) {
+		printf("Failed to read %s\n", path);
+		if (file != NULL)
+			fclose(file);
+		return false;
+	}
+	fclose(file);
+
+	for (size = 64; size < FILE_SIZE; size++) {
+		ktx = piglit_ktx_read_bytes(data, size);
+		if (ktx == NULL) {
+			printf("Header of %zu bytes refused\n", size);
+			pass = false;
+			continue;
+		}
+
+		/* The faces of a miplevel are parsed together. */
+		for (face = 0; face < 6; face++) {
+			if (piglit_ktx_get_image(ktx, 0, face) != NULL) {
+				printf("Face %d of %zu bytes accepted\n",
+				       face, size);
+				pass = false;
+			}
+		}
+		piglit_ktx_destroy(ktx);
+	}
+	return pass;
+}
+
+static bool
+check_truncated_file(const char *path)
+{
+	struct piglit_ktx_info info;
+	struct piglit_ktx *ktx;
+	GLuint tex = 0;
+	bool pass;
+
+	/* Only the header is read, which is intact. */
+	if (!piglit_ktx_read_file_info(path, &info) ||
+	    !check_info(&info, 64 + 4 + 3))
+		return false;
+
+	ktx = piglit_ktx_read_file(path);
+	if (ktx == NULL)
+		return false;
+
+	pass = !piglit_ktx_load_texture_streaming(ktx, &tex, NULL) &&
+	       tex == 0;
+	piglit_ktx_destroy(ktx);
+	return pass;
+}
+
+enum piglit_result
+piglit_display(void)
+{
+	/* UNREACHED */
+	return PIGLIT_FAIL;
+}
+
+void
+piglit_init(int argc, char **argv)
+{
+	enum piglit_result result = PIGLIT_PASS;
+	char path[4096], truncated_path[4096];
+	bool pass;
+
+	get_path(path, sizeof(path), "ktx-cubemap-rgb-1x1.ktx");
+	get_path(truncated_path, sizeof(truncated_path),
+		 "ktx-cubemap-rgb-1x1-truncated.ktx");
+
+	pass = load_file(path, false);
+	piglit_report_subtest_result(pass ? PIGLIT_PASS : PIGLIT_FAIL,
+				     "load");
+	piglit_merge_result(&result, pass ? PIGLIT_PASS : PIGLIT_FAIL);
+
+	pass = load_file(path, true);
+	piglit_report_subtest_result(pass ? PIGLIT_PASS : PIGLIT_FAIL,
+				     "load streaming");
+	piglit_merge_result(&result, pass ? PIGLIT_PASS : PIGLIT_FAIL);
+
+	pass = check_truncated_bytes(path);
+	piglit_report_subtest_result(pass ? PIGLIT_PASS : PIGLIT_FAIL,
+				     "truncated data");
+	piglit_merge_result(&result, pass ? PIGLIT_PASS : PIGLIT_FAIL);
+
+	pass = check_truncated_file(truncated_path);
+	piglit_report_subtest_result(pass ? PIGLIT_PASS : PIGLIT_FAIL,
+				     "truncated file");
+	piglit_merge_result(&result, pass ? PIGLIT_PASS : PIGLIT_FAIL);
+
+	pass = piglit_check_gl_error(GL_NO_ERROR);
+	piglit_merge_result(&result, pass ? PIGLIT_PASS : PIGLIT_FAIL);
+
+	piglit_report_result(result);
+}
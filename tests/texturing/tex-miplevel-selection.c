@@ -55,6 +55,7 @@
  */
 
 #include "piglit-util-gl.h"
+#include "piglit-sampler.h"
 
 PIGLIT_GL_TEST_CONFIG_BEGIN
 
@@ -1361,23 +1362,28 @@ static int
 calc_expected_level(int fetch_level, int baselevel, int maxlevel, int minlod,
 		    int maxlod, int bias, int mipfilter)
 {
-	int expected_level;
-
-	if (mipfilter) {
-		if (no_lod_clamp) {
-			expected_level = CLAMP(fetch_level + bias,
-					       baselevel,
-					       maxlevel);
-		} else {
-			expected_level = CLAMP(fetch_level + bias,
-					       MIN2(baselevel + minlod, maxlevel),
-					       MIN2(baselevel + maxlod, maxlevel));
-		}
-	} else {
-		expected_level = baselevel;
+	struct piglit_sampler sampler;
+	struct piglit_sampler_levels levels;
+	float lod;
+
+	/* The quad is scaled so that the texture coordinates would select
+	 * fetch_level with no bias, base level or LOD clamping. */
+	piglit_sampler_init(&sampler, 2);
+	sampler.min_filter = mipfilter ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST;
+	sampler.mag_filter = GL_NEAREST;
+	sampler.base_level = baselevel;
+	sampler.max_level = maxlevel;
+	if (!no_lod_clamp) {
+		sampler.min_lod = minlod;
+		sampler.max_lod = maxlod;
 	}
-	assert(expected_level >= 0 && expected_level <= last_level);
-	return expected_level;
+
+	lod = piglit_sampler_lod(&sampler,
+				 ldexpf(1.0f, fetch_level - baselevel), bias);
+	piglit_sampler_select_levels(&sampler, last_level, lod, &levels);
+
+	assert(levels.level[0] >= 0 && levels.level[0] <= last_level);
+	return levels.level[0];
 }
 
 enum piglit_result
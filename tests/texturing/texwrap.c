@@ -63,6 +63,7 @@
  */
 
 #include "piglit-util-gl.h"
+#include "piglit-sampler.h"
 #include <limits.h>
 
 /* Only *_ARB versions of these exist. I am lazy to add the suffix. */
@@ -599,169 +600,103 @@ static int get_int_format_bits(const struct format_desc *format)
 	       maxbits >= 10 ? 10 : 8;
 }
 
-static void sample_nearest(int x, int y, int z,
-			   GLenum wrap_mode, GLenum filter,
-			   unsigned char pixel[4],
-			   const struct format_desc *format,
-			   GLboolean npot, GLboolean texswizzle,
-			   int bits)
+/** Number of texels along each side of a tile. */
+#define TILE_TEXELS(npot)   (TEXTURE_SIZE(npot) + BIAS_INT(npot)*2)
+#define TILE_TEXELS_MAX     (SIZEMAX + (SIZEMAX+2)*2)
+
+/**
+ * Compute the expected colour of every texel-sized square of a tile
+ * drawn with the given wrap mode and filter.  The squares are sampled
+ * at their centres, in texel coordinates.
+ */
+static void compute_expected_tile(GLenum wrap_mode, GLenum filter,
+				  unsigned char *expected,
+				  const struct format_desc *format,
+				  GLboolean npot, GLboolean texswizzle,
+				  int bits)
 {
-	unsigned sample_border = 0;
-	float border_factor = 0;
-	int coords[3] = {x, y, z};
-	unsigned i;
-	float result[4];
-	int *iresult = (int*)result;
-	unsigned *uiresult = (unsigned*)result;
+	static float coords[TILE_TEXELS_MAX * TILE_TEXELS_MAX * 3];
+	static float results[TILE_TEXELS_MAX * TILE_TEXELS_MAX * 4];
+	const GLenum iden[4] = {GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA};
+	const int n = TILE_TEXELS(npot);
+	struct piglit_sampler sampler;
+	struct piglit_sampler_image level;
+	int a, b, i, dims;
 
-	/* Zero coords according to the texture target. */
 	switch (texture_target) {
 	case GL_TEXTURE_1D:
-		coords[1] = 0;
-		/* Fall through. */
-
-	case GL_TEXTURE_2D:
-	case GL_TEXTURE_RECTANGLE:
-		coords[2] = 0;
-	}
-
-	/* Handle clamp mirroring. */
-	switch (wrap_mode) {
-	case GL_MIRROR_CLAMP_EXT:
-	case GL_MIRROR_CLAMP_TO_EDGE_EXT:
-	case GL_MIRROR_CLAMP_TO_BORDER_EXT:
-		for (i = 0; i < 3; i++) {
-			if (coords[i] < 0) {
-				coords[i] = -coords[i] - 1;
-			}
-		}
-	}
-
-	/* Handle border sampling. */
-	switch (wrap_mode) {
-	case GL_CLAMP:
-	case GL_MIRROR_CLAMP_EXT:
-		if (filter != GL_LINEAR) {
-			break;
-		}
-
-	case GL_CLAMP_TO_BORDER:
-	case GL_MIRROR_CLAMP_TO_BORDER_EXT:
-		sample_border = 0;
-		for (i = 0; i < 3; i++) {
-			if (coords[i] >= TEXTURE_SIZE(npot) || coords[i] < 0) {
-				sample_border++;
-			}
-		}
-	}
-
-	/* Figure out what the border factor is. */
-	switch (wrap_mode) {
-	case GL_CLAMP:
-	case GL_MIRROR_CLAMP_EXT:
-		if (filter == GL_LINEAR) {
-			const double factor[] = {0, 0.5, 0.75, 0.875};
-			border_factor = factor[sample_border];
-		}
+		dims = 1;
 		break;
-	case GL_CLAMP_TO_BORDER:
-	case GL_MIRROR_CLAMP_TO_BORDER_EXT:
-		if (sample_border) {
-			border_factor = 1;
-		}
-		break;
-	}
-
-	/* Handle wrapping. */
-	switch (wrap_mode) {
-	case GL_REPEAT:
-		for (i = 0; i < 3; i++) {
-			coords[i] = (coords[i] + TEXTURE_SIZE(npot)*10) % TEXTURE_SIZE(npot);
-		}
-		break;
-
-	case GL_CLAMP:
-	case GL_MIRROR_CLAMP_EXT:
-	case GL_CLAMP_TO_BORDER:
-	case GL_MIRROR_CLAMP_TO_BORDER_EXT:
-	case GL_CLAMP_TO_EDGE:
-	case GL_MIRROR_CLAMP_TO_EDGE_EXT:
-		for (i = 0; i < 3; i++) {
-			coords[i] = coords[i] >= TEXTURE_SIZE(npot) ? TEXTURE_SIZE(npot)-1 :
-								coords[i] < 0 ? 0 : coords[i];
-		}
+	case GL_TEXTURE_3D:
+		dims = 3;
 		break;
-
-	case GL_MIRRORED_REPEAT:
-		for (i = 0; i < 3; i++) {
-			coords[i] = (coords[i] + TEXTURE_SIZE(npot)*10) % (TEXTURE_SIZE(npot) * 2);
-			if (coords[i] >= TEXTURE_SIZE(npot))
-				coords[i] = 2*TEXTURE_SIZE(npot) - coords[i] - 1;
-		}
+	default:
+		dims = 2;
 		break;
 	}
 
-	/* Sample the pixel. */
-	if (format->depth) {
-		result[0] = result[1] = result[2] =
-				image[(coords[2]*size_y*size_x +
-				       coords[1]*size_x + coords[0])];
-		result[3] = 1;
-	} else {
-		memcpy(result,
-		       &image[(coords[2]*size_y*size_x +
-			       coords[1]*size_x + coords[0])*4],
-		       sizeof(result));
-	}
-
-	if (format->srgb) {
-		for (i = 0; i < 3; i++) {
-			result[i] = piglit_srgb_to_linear(result[i]);
-		}
-	}
-
-	/* Sample the border.
-	 * This is actually the only place we care about linear filtering,
-	 * for CLAMP. Pixels are expected to be sampled at their center,
-	 * so we don't have to take 4 samples. */
-	if (border_factor == 1) {
-		memcpy(result, border_real, 16);
-	} else if (border_factor) {
+	piglit_sampler_init(&sampler, dims);
+	sampler.type = format->type == INT_TYPE ? PIGLIT_SAMPLER_INT :
+		       format->type == UINT_TYPE ? PIGLIT_SAMPLER_UINT :
+		       PIGLIT_SAMPLER_FLOAT;
+	sampler.srgb = format->srgb;
+	sampler.unnormalized = GL_TRUE;
+	for (i = 0; i < 3; i++)
+		sampler.wrap[i] = wrap_mode;
+	sampler.min_filter = filter;
+	sampler.mag_filter = filter;
+	memcpy(sampler.border_color, border_real, sizeof(border_real));
+	if (texswizzle) {
 		for (i = 0; i < 4; i++)
-			result[i] = border_real[i] * border_factor +
-				    result[i] * (1 - border_factor);
+			sampler.swizzle[i] = iden[swizzle[i]];
 	}
 
-	/* Texture swizzle. */
-	if (texswizzle) {
-		float orig[4];
-		memcpy(orig, result, 16);
-
-		for (i = 0; i < 4; i++) {
-			result[i] = orig[swizzle[i]];
+	level.width = size_x;
+	level.height = size_y;
+	level.depth = size_z;
+	level.components = format->depth ? 1 : 4;
+	level.texels = image;
+
+	/* The slices of 3D textures are the same, so sample the first. */
+	for (b = 0; b < n; b++) {
+		for (a = 0; a < n; a++) {
+			float *coord = &coords[(b * n + a) * 3];
+			coord[0] = a - BIAS_INT(npot) + 0.5;
+			coord[1] = b - BIAS_INT(npot) + 0.5;
+			coord[2] = 0.5;
 		}
 	}
 
+	piglit_sampler_sample(&sampler, &level, 1, n * n, coords, NULL,
+			      results);
+
 	/* Final conversion. */
-	switch (format->type) {
-	case FLOAT_TYPE:
-		for (i = 0; i < 4; i++) {
-			pixel[i] = result[i] * 255.1;
-		}
-		break;
-	case INT_TYPE:
-		for (i = 0; i < 4; i++) {
-			pixel[i] = iresult[i] * (255.1 / ((1ull << (bits-1))-1));
-		}
-		break;
-	case UINT_TYPE:
-		for (i = 0; i < 4; i++) {
-			pixel[i] = uiresult[i] * (255.1 / ((1ull << bits)-1));
-		}
-		if (bits == 10) {
-			pixel[3] = uiresult[3] * (255.1 / 3);
+	for (a = 0; a < n * n; a++) {
+		const float *result = &results[a * 4];
+		const int *iresult = (const int*)result;
+		const unsigned *uiresult = (const unsigned*)result;
+		unsigned char *pixel = &expected[a * 4];
+
+		switch (format->type) {
+		case FLOAT_TYPE:
+			for (i = 0; i < 4; i++) {
+				pixel[i] = result[i] * 255.1;
+			}
+			break;
+		case INT_TYPE:
+			for (i = 0; i < 4; i++) {
+				pixel[i] = iresult[i] * (255.1 / ((1ull << (bits-1))-1));
+			}
+			break;
+		case UINT_TYPE:
+			for (i = 0; i < 4; i++) {
+				pixel[i] = uiresult[i] * (255.1 / ((1ull << bits)-1));
+			}
+			if (bits == 10) {
+				pixel[3] = uiresult[3] * (255.1 / 3);
+			}
+			break;
 		}
-		break;
 	}
 }
 
@@ -1022,7 +957,7 @@ static GLboolean probe_pixels(const struct format_desc *format, GLboolean npot,
 
 		/* Loop over all wrap modes. */
 		for (j = 0; wrap_modes[j].mode != 0; j++) {
-			unsigned char expected[4];
+			unsigned char expected[TILE_TEXELS_MAX * TILE_TEXELS_MAX * 4];
 			int x0, y0;
 			int a, b;
 
@@ -1034,18 +969,18 @@ static GLboolean probe_pixels(const struct format_desc *format, GLboolean npot,
 			if (skip_test(wrap_modes[j].mode, filter))
 				continue;
 
-			for (b = 0; b < (TEXTURE_SIZE(npot) + BIAS_INT(npot)*2); b++) {
-				for (a = 0; a < (TEXTURE_SIZE(npot) + BIAS_INT(npot)*2); a++) {
+			compute_expected_tile(wrap_modes[j].mode, filter, expected,
+					      format, npot, texswizzle, bits);
+
+			for (b = 0; b < TILE_TEXELS(npot); b++) {
+				for (a = 0; a < TILE_TEXELS(npot); a++) {
 					double x = x0 + TEXEL_SIZE*(a+0.5);
 					double y = y0 + TEXEL_SIZE*(b+0.5);
 
-					sample_nearest(a - BIAS_INT(npot), b - BIAS_INT(npot),
-						       0, /* the slices are the same */
-						       wrap_modes[j].mode, filter, expected,
-						       format, npot, texswizzle, bits);
-
 					if (!probe_pixel_rgba(pixels, piglit_width, deltamax_swizzled,
-							      x, y, expected, a, b,
+							      x, y,
+							      &expected[(b * TILE_TEXELS(npot) + a) * 4],
+							      a, b,
 							      sfilter, wrap_modes[j].name)) {
 						pass = GL_FALSE;
 						goto tile_done;
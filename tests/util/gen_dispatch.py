@@ -89,11 +89,96 @@ class DispatchCode(object):
     @classmethod
     def emit(cls, out_dir, gl_registry):
         assert(isinstance(gl_registry, registry.gl.Registry))
-        context_vars = dict(dispatch=cls, gl_registry=gl_registry)
+        function_hash = PerfectHash(
+            [command.name for command in gl_registry.commands],
+            string_hash)
+        context_vars = dict(dispatch=cls, gl_registry=gl_registry,
+                            function_hash=function_hash)
         render_template(cls.H_TEMPLATE, out_dir, **context_vars)
         render_template(cls.C_TEMPLATE, out_dir, **context_vars)
 
 
+def _fmix32(h):
+    """The finalizer of MurmurHash3, which spreads every input bit over
+    the whole result.
+    """
+    h ^= h >> 16
+    h = (h * 0x85ebca6b) & 0xffffffff
+    h ^= h >> 13
+    h = (h * 0xc2b2ae35) & 0xffffffff
+    h ^= h >> 16
+    return h
+
+
+def string_hash(string, seed):
+    """FNV-1a of the string, starting from the offset basis xor the seed.
+
+    Must match string_hash() in piglit-dispatch-gen.c.mako.
+    """
+    h = 2166136261 ^ seed
+    for c in bytearray(string.encode('ascii')):
+        h ^= c
+        h = (h * 16777619) & 0xffffffff
+    return _fmix32(h)
+
+
+def int_hash(value, seed):
+    """Must match int_hash() in piglit-util-gl-enum-gen.c.mako."""
+    return _fmix32((value + seed * 0x9e3779b9) & 0xffffffff)
+
+
+class PerfectHash(object):
+    """A minimal perfect hash over a list of distinct keys, built by hash
+    and displace.
+
+    Every key falls, by hash_func(key, 0), into one of len(keys) buckets.
+    The keys of each bucket holding more than one key are placed,
+    largest buckets first, with the smallest seed d > 0 that sends all
+    of them to free slots by hash_func(key, d); the bucket's
+    displacement is d.  The remaining slots go to the buckets holding a
+    single key, whose displacement is -(slot + 1).  A lookup is then
+
+        d = displacements[hash_func(key, 0) % n]
+        slot = -d - 1 if d < 0 else hash_func(key, d) % n
+
+    followed by a comparison with keys[slot] to reject unknown keys.
+    """
+
+    def __init__(self, keys, hash_func):
+        n = len(keys)
+        assert(len(set(keys)) == n)
+
+        buckets = [[] for i in range(n)]
+        for key in keys:
+            buckets[hash_func(key, 0) % n].append(key)
+
+        self.displacements = [0] * n
+        self.keys = [None] * n
+
+        order = sorted(range(n), key=lambda b: (-len(buckets[b]), b))
+        for b in order:
+            bucket = buckets[b]
+            if len(bucket) < 2:
+                break
+            d = 1
+            while True:
+                slots = [hash_func(key, d) % n for key in bucket]
+                if (len(set(slots)) == len(slots) and
+                        all(self.keys[slot] is None for slot in slots)):
+                    break
+                d += 1
+            for key, slot in zip(bucket, slots):
+                self.keys[slot] = key
+            self.displacements[b] = d
+
+        free_slots = (slot for slot in range(n) if self.keys[slot] is None)
+        for b in order:
+            if len(buckets[b]) == 1:
+                slot = next(free_slots)
+                self.keys[slot] = buckets[b][0]
+                self.displacements[b] = -(slot + 1)
+
+
 def render_template(filename, out_dir, **context_vars):
     assert(filename.endswith('.mako'))
     template_filepath = os.path.join(os.path.dirname(__file__), filename)
@@ -135,11 +220,15 @@ class EnumCode(object):
     def emit(cls, out_dir, gl_registry):
         assert(isinstance(gl_registry, registry.gl.Registry))
         enums = cls.get_unique_enums_in_default_namespace(gl_registry)
+        assert(all(0 <= enum.num_value <= 0xffffffff for enum in enums))
+        enum_by_value = dict((enum.num_value, enum) for enum in enums)
+        enum_hash = PerfectHash([enum.num_value for enum in enums], int_hash)
         render_template(
             cls.C_TEMPLATE,
             out_dir,
             gl_registry=gl_registry,
-            sorted_unique_enums_in_default_namespace=enums)
+            enum_hash=enum_hash,
+            enum_by_value=enum_by_value)
 
 
     @classmethod
@@ -93,16 +93,74 @@ static void reset_dispatch_pointers(void)
 % endfor
 }
 
-static const char * function_names[] = {
-% for command in gl_registry.commands:
->-------"${command.name}",
-% endfor
-};
+/**
+ * Resolve, in one pass, every dispatch pointer that the implementation
+ * supports.  Pointers to unsupported functions keep their stubs.
+ */
+static void resolve_all_dispatch_pointers(void)
+{
+>-------void *p;
 
-static void* (*const function_resolvers[])(void) = {
 % for alias_set in gl_registry.command_alias_map:
 <% f0 = alias_set.primary_command %>\
->-------resolve_${f0.name},
+>-------p = resolve_${f0.name}();
+>-------if (p)
+>------->-------piglit_dispatch_${f0.name} = p;
+% endfor
+}
+
+/**
+ * FNV-1a with a seed, followed by the MurmurHash3 finalizer.  This must
+ * match string_hash() in gen_dispatch.py.
+ */
+static uint32_t
+string_hash(const char *string, uint32_t seed)
+{
+>-------uint32_t h = 2166136261u ^ seed;
+
+>-------for (; *string; string++) {
+>------->-------h ^= (unsigned char) *string;
+>------->-------h *= 16777619u;
+>-------}
+
+>-------h ^= h >> 16;
+>-------h *= 0x85ebca6bu;
+>-------h ^= h >> 13;
+>-------h *= 0xc2b2ae35u;
+>-------h ^= h >> 16;
+>-------return h;
+}
+
+/* Minimal perfect hash of all function names; see PerfectHash in
+ * gen_dispatch.py.
+ */
+static const int32_t function_hash_displacements[] = {
+% for d in function_hash.displacements:
+>-------${d},
+% endfor
+};
+
+static const struct {
+>-------const char *name;
+>-------void *(*resolver)(void);
+} function_table[] = {
+% for name in function_hash.keys:
+<% f0 = gl_registry.command_alias_map[name].primary_command %>\
+>-------{ "${name}", resolve_${f0.name} },
 % endfor
 };
+
+/**
+ * Return the index of \a name in function_table, or -1 if it isn't a
+ * GL function.
+ */
+static int
+find_function(const char *name)
+{
+>-------const uint32_t n = ARRAY_SIZE(function_table);
+>-------const int32_t d = function_hash_displacements[string_hash(name, 0) % n];
+>-------const uint32_t slot = d < 0 ? -d - 1 : string_hash(name, d) % n;
+
+>-------return strcmp(function_table[slot].name, name) == 0 ? (int) slot : -1;
+}
 </%block>\
@@ -171,6 +171,29 @@ check_extension(const char *name)
 
 #include "piglit-dispatch-gen.c"
 
+static void
+ignore_error(const char *name)
+{
+}
+
+/**
+ * Resolve all dispatch pointers now rather than on their first use.
+ * Functions that are unsupported, or whose address can't be found, keep
+ * their stubs, which report the problem if the test calls them.
+ */
+static void
+resolve_eagerly(void)
+{
+	piglit_error_function_ptr saved_unsupported = unsupported;
+	piglit_error_function_ptr saved_failure = get_proc_address_failure;
+
+	unsupported = ignore_error;
+	get_proc_address_failure = ignore_error;
+	resolve_all_dispatch_pointers();
+	unsupported = saved_unsupported;
+	get_proc_address_failure = saved_failure;
+}
+
 /**
  * Initialize the dispatch mechanism.
  *
@@ -201,6 +224,9 @@ check_extension(const char *name)
  * get_core_proc() or get_ext_proc() unexpectedly returned NULL.  It
  * is passed the name of the function that was passed to
  * get_core_proc() or get_ext_proc().
+ *
+ * If the PIGLIT_DISPATCH_EAGER environment variable is set, every
+ * function is resolved here in a single pass instead of lazily.
  */
 void
 piglit_dispatch_init(piglit_dispatch_api api,
@@ -250,16 +276,9 @@ piglit_dispatch_init(piglit_dispatch_api api,
 	 * check_extension().
 	 */
 	gl_version = piglit_get_gl_version();
-}
 
-/**
- * Compare two strings in the function_names table.
- */
-static int compare_function_names(const void *x, const void *y)
-{
-	const char *x_str = *(const char * const *) x;
-	const char *y_str = *(const char * const *) y;
-	return strcmp(x_str, y_str);
+	if (getenv("PIGLIT_DISPATCH_EAGER"))
+		resolve_eagerly();
 }
 
 /**
@@ -284,17 +303,12 @@ static int compare_function_names(const void *x, const void *y)
 piglit_dispatch_function_ptr
 piglit_dispatch_resolve_function(const char *name)
 {
-	size_t item_size = sizeof(function_names[0]);
-	size_t num_items = ARRAY_SIZE(function_names);
-	const char * const *item = (const char * const *)
-		bsearch(&name, function_names, num_items, item_size,
-			compare_function_names);
+	int index = find_function(name);
 	check_initialized();
-	if (!item) {
+	if (index < 0) {
 		unsupported(name);
 		return NULL;
 	} else {
-		size_t item_index = item - function_names;
-		return function_resolvers[item_index]();
+		return function_table[index].resolver();
 	}
 }
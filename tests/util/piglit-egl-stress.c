@@ -0,0 +1,609 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-egl-stress.c
+ *
+ * See piglit-egl-stress.h.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "piglit-egl-stress.h"
+
+static EGLDisplay dpy = EGL_NO_DISPLAY;
+static EGLConfig egl_config;
+static bool surfaceless;
+
+/**
+ * Context that the contexts of share_group runs share objects with.  It is
+ * never current while threads run.
+ */
+static EGLContext share_root = EGL_NO_CONTEXT;
+
+static const EGLint pbuffer_attribs[] = {
+	EGL_WIDTH, 64,
+	EGL_HEIGHT, 64,
+	EGL_NONE
+};
+
+/**
+ * Make a context current on this thread, without a surface if possible.
+ * \c *surf is set to the pbuffer made for it, or EGL_NO_SURFACE.
+ */
+static bool
+make_current(EGLContext ctx, EGLSurface *surf)
+{
+	*surf = EGL_NO_SURFACE;
+	if (!surfaceless) {
+		*surf = eglCreatePbufferSurface(dpy, egl_config,
+						 pbuffer_attribs);
+		if (*surf == EGL_NO_SURFACE) {
+			fprintf(stderr, "eglCreatePbufferSurface() failed\n");
+			return false;
+		}
+	}
+
+	if (!eglMakeCurrent(dpy, *surf, *surf, ctx)) {
+		fprintf(stderr, "eglMakeCurrent() failed\n");
+		return false;
+	}
+	return true;
+}
+
+void
+piglit_egl_stress_init(void)
+{
+	EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLint major, minor, count;
+	EGLSurface surf;
+
+	dpy = piglit_egl_get_default_display(EGL_NONE);
+	if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, &major, &minor)) {
+		printf("No EGL display\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+
+	if (!piglit_egl_bind_api(EGL_OPENGL_API))
+		piglit_report_result(PIGLIT_SKIP);
+
+	/* Without a surface, the config needn't support any surface type */
+	surfaceless = piglit_is_egl_extension_supported(dpy,
+				"EGL_KHR_surfaceless_context");
+	if (surfaceless)
+		config_attribs[1] = 0;
+
+	if (!eglChooseConfig(dpy, config_attribs, &egl_config, 1, &count) ||
+	    count == 0) {
+		printf("No EGL config for desktop GL\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+
+	share_root = eglCreateContext(dpy, egl_config, EGL_NO_CONTEXT, NULL);
+	if (share_root == EGL_NO_CONTEXT) {
+		printf("eglCreateContext() failed\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+
+	if (!make_current(share_root, &surf))
+		piglit_report_result(PIGLIT_FAIL);
+
+	/* Resolve what the threads would otherwise race to resolve: the
+	 * dispatch table and the cached GL version and extension list.
+	 */
+	piglit_dispatch_default_init(PIGLIT_DISPATCH_GL);
+	piglit_get_gl_version();
+	piglit_is_extension_supported("GL_ARB_framebuffer_object");
+
+	eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (surf != EGL_NO_SURFACE)
+		eglDestroySurface(dpy, surf);
+}
+
+struct worker {
+	const struct piglit_egl_stress_config *config;
+	pthread_barrier_t *barrier;
+	struct piglit_egl_stress_thread_stats *stats;
+};
+
+static double
+thread_cpu_seconds(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec t;
+
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) == 0)
+		return t.tv_sec + t.tv_nsec / 1e9;
+#endif
+	return -1;
+}
+
+static int64_t
+thread_voluntary_switches(void)
+{
+#ifdef RUSAGE_THREAD
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_THREAD, &usage) == 0)
+		return usage.ru_nvcsw;
+#endif
+	return -1;
+}
+
+static void
+iterate(const struct piglit_egl_stress_config *config, void *data,
+	struct piglit_egl_stress_thread_stats *stats)
+{
+	const int64_t start = piglit_get_microseconds();
+	const int64_t end = start + (int64_t) (config->seconds * 1000000);
+	const double cpu_start = thread_cpu_seconds();
+	const int64_t switches_start = thread_voluntary_switches();
+	int64_t now = start;
+
+	while (now < end) {
+		const int64_t before = now;
+
+		if (!config->workload->iterate(data) ||
+		    !piglit_check_gl_error(GL_NO_ERROR)) {
+			stats->result = PIGLIT_FAIL;
+			break;
+		}
+		stats->iterations++;
+
+		now = piglit_get_microseconds();
+		if ((now - before) / 1e6 > stats->max_iteration)
+			stats->max_iteration = (now - before) / 1e6;
+	}
+	glFinish();
+
+	stats->seconds = (piglit_get_microseconds() - start) / 1e6;
+	if (cpu_start >= 0)
+		stats->cpu_seconds = thread_cpu_seconds() - cpu_start;
+	if (switches_start >= 0)
+		stats->voluntary_switches =
+			thread_voluntary_switches() - switches_start;
+}
+
+static void *
+worker_main(void *arg)
+{
+	struct worker *worker = arg;
+	const struct piglit_egl_stress_config *config = worker->config;
+	struct piglit_egl_stress_thread_stats *stats = worker->stats;
+	EGLContext ctx;
+	EGLSurface surf = EGL_NO_SURFACE;
+	void *data = NULL;
+
+	stats->result = PIGLIT_FAIL;
+	stats->cpu_seconds = -1;
+	stats->voluntary_switches = -1;
+
+	/* The bound API is per thread, and defaults to GLES */
+	eglBindAPI(EGL_OPENGL_API);
+	ctx = eglCreateContext(dpy, egl_config,
+			       config->share_group ? share_root
+						   : EGL_NO_CONTEXT,
+			       NULL);
+	if (ctx == EGL_NO_CONTEXT)
+		fprintf(stderr, "eglCreateContext() failed\n");
+	else if (make_current(ctx, &surf))
+		stats->result = config->workload->init(&data);
+
+	/* Every thread waits here, ready or not, or the others would wait
+	 * forever.
+	 */
+	pthread_barrier_wait(worker->barrier);
+
+	if (stats->result == PIGLIT_PASS)
+		iterate(config, data, stats);
+
+	if (data != NULL)
+		config->workload->fini(data);
+	eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (surf != EGL_NO_SURFACE)
+		eglDestroySurface(dpy, surf);
+	if (ctx != EGL_NO_CONTEXT)
+		eglDestroyContext(dpy, ctx);
+	eglReleaseThread();
+
+	return NULL;
+}
+
+void
+piglit_egl_stress_run(const struct piglit_egl_stress_config *config,
+		      struct piglit_egl_stress_stats *stats)
+{
+	pthread_t threads[PIGLIT_EGL_STRESS_MAX_THREADS];
+	struct worker workers[PIGLIT_EGL_STRESS_MAX_THREADS];
+	pthread_barrier_t barrier;
+	unsigned i, started;
+	uint64_t iterations = 0;
+	double seconds = 0;
+
+	assert(dpy != EGL_NO_DISPLAY);
+	assert(config->num_threads > 0 &&
+	       config->num_threads <= PIGLIT_EGL_STRESS_MAX_THREADS);
+
+	memset(stats, 0, sizeof(*stats));
+	stats->num_threads = config->num_threads;
+	pthread_barrier_init(&barrier, NULL, config->num_threads);
+
+	for (started = 0; started < config->num_threads; started++) {
+		workers[started].config = config;
+		workers[started].barrier = &barrier;
+		workers[started].stats = &stats->threads[started];
+		if (pthread_create(&threads[started], NULL, worker_main,
+				   &workers[started]) != 0) {
+			/* The started threads would wait for it forever */
+			fprintf(stderr, "pthread_create() failed\n");
+			piglit_report_result(PIGLIT_FAIL);
+		}
+	}
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+	pthread_barrier_destroy(&barrier);
+
+	stats->result = PIGLIT_SKIP;
+	for (i = 0; i < config->num_threads; i++) {
+		const struct piglit_egl_stress_thread_stats *t =
+			&stats->threads[i];
+
+		piglit_merge_result(&stats->result, t->result);
+		iterations += t->iterations;
+		if (t->seconds > seconds)
+			seconds = t->seconds;
+	}
+	if (seconds > 0)
+		stats->throughput = iterations / seconds;
+}
+
+void
+piglit_egl_stress_print_stats(const struct piglit_egl_stress_config *config,
+			      const struct piglit_egl_stress_stats *stats)
+{
+	unsigned i;
+
+	printf("%s, %u thread(s)%s: %.1f iterations/s\n",
+	       config->workload->name, stats->num_threads,
+	       config->share_group ? ", shared" : "",
+	       stats->throughput);
+
+	for (i = 0; i < stats->num_threads; i++) {
+		const struct piglit_egl_stress_thread_stats *t =
+			&stats->threads[i];
+
+		printf("  thread %u: %s, %" PRIu64 " iterations, %.1f/s",
+		       i, piglit_result_to_string(t->result), t->iterations,
+		       t->seconds > 0 ? t->iterations / t->seconds : 0.0);
+		/* A thread that is busy in the driver uses all of its time;
+		 * one that waits for a lock doesn't, and blocks often.
+		 */
+		if (t->cpu_seconds >= 0 && t->seconds > 0)
+			printf(", %.0f%% on CPU",
+			       100 * t->cpu_seconds / t->seconds);
+		if (t->voluntary_switches >= 0)
+			printf(", blocked %" PRId64 " times",
+			       t->voluntary_switches);
+		printf(", longest iteration %.3f ms\n",
+		       t->max_iteration * 1000);
+	}
+}
+
+const struct piglit_egl_stress_workload *
+piglit_egl_stress_find_workload(const char *name)
+{
+	unsigned i;
+
+	for (i = 0; piglit_egl_stress_workloads[i] != NULL; i++) {
+		if (streq(piglit_egl_stress_workloads[i]->name, name))
+			return piglit_egl_stress_workloads[i];
+	}
+	return NULL;
+}
+
+/* Workloads */
+
+/**
+ * Number of programs compiled by compile_iterate() so far, in all threads.
+ * It starts from the time, so that a shader cache on disk can't help either.
+ */
+static unsigned compile_count;
+
+static enum piglit_result
+compile_init(void **data)
+{
+	if (piglit_get_gl_version() < 20)
+		return PIGLIT_SKIP;
+
+	__sync_bool_compare_and_swap(&compile_count, 0,
+				     (unsigned) piglit_get_microseconds());
+	return PIGLIT_PASS;
+}
+
+static bool
+compile_iterate(void *data)
+{
+	const unsigned count = __sync_fetch_and_add(&compile_count, 1);
+	char vs_text[256], fs_text[256];
+	GLuint vs, fs;
+	GLint prog;
+
+	/* Make every program different, so that a shader cache can't
+	 * answer for the compiler.
+	 */
+	snprintf(vs_text, sizeof(vs_text),
+		 "void main() {\n"
+		 "	gl_Position = gl_Vertex * %u.0;\n"
+		 "}\n", count);
+	snprintf(fs_text, sizeof(fs_text),
+		 "void main() {\n"
+		 "	gl_FragColor = vec4(%u.0 / 65536.0);\n"
+		 "}\n", count % 65536);
+
+	vs = piglit_compile_shader_text(GL_VERTEX_SHADER, vs_text);
+	fs = piglit_compile_shader_text(GL_FRAGMENT_SHADER, fs_text);
+	prog = piglit_link_simple_program(vs, fs);
+
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+	glDeleteProgram(prog);
+	return prog != 0;
+}
+
+static void
+compile_fini(void *data)
+{
+}
+
+const struct piglit_egl_stress_workload piglit_egl_stress_compile = {
+	"compile", compile_init, compile_iterate, compile_fini
+};
+
+#define UPLOAD_SIZE 256
+
+struct texture_upload_data {
+	GLuint tex;
+	GLubyte texels[UPLOAD_SIZE * UPLOAD_SIZE * 4];
+};
+
+static enum piglit_result
+texture_upload_init(void **data)
+{
+	struct texture_upload_data *d = malloc(sizeof(*d));
+
+	memset(d->texels, 0x80, sizeof(d->texels));
+	glGenTextures(1, &d->tex);
+	glBindTexture(GL_TEXTURE_2D, d->tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, UPLOAD_SIZE, UPLOAD_SIZE, 0,
+		     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	*data = d;
+	return PIGLIT_PASS;
+}
+
+static bool
+texture_upload_iterate(void *data)
+{
+	struct texture_upload_data *d = data;
+
+	d->texels[0]++;
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, UPLOAD_SIZE, UPLOAD_SIZE,
+			GL_RGBA, GL_UNSIGNED_BYTE, d->texels);
+	return true;
+}
+
+static void
+texture_upload_fini(void *data)
+{
+	struct texture_upload_data *d = data;
+
+	glDeleteTextures(1, &d->tex);
+	free(d);
+}
+
+const struct piglit_egl_stress_workload piglit_egl_stress_texture_upload = {
+	"texture-upload", texture_upload_init, texture_upload_iterate,
+	texture_upload_fini
+};
+
+#define MAP_SIZE (1024 * 1024)
+
+struct buffer_map_data {
+	GLuint bo;
+	bool map_range;
+	GLubyte value;
+};
+
+static enum piglit_result
+buffer_map_init(void **data)
+{
+	struct buffer_map_data *d;
+
+	if (piglit_get_gl_version() < 15)
+		return PIGLIT_SKIP;
+
+	d = calloc(1, sizeof(*d));
+	d->map_range = piglit_get_gl_version() >= 30 ||
+		       piglit_is_extension_supported("GL_ARB_map_buffer_range");
+	glGenBuffers(1, &d->bo);
+	glBindBuffer(GL_ARRAY_BUFFER, d->bo);
+	glBufferData(GL_ARRAY_BUFFER, MAP_SIZE, NULL, GL_STREAM_DRAW);
+
+	*data = d;
+	return PIGLIT_PASS;
+}
+
+static bool
+buffer_map_iterate(void *data)
+{
+	struct buffer_map_data *d = data;
+	void *map;
+
+	if (d->map_range) {
+		map = glMapBufferRange(GL_ARRAY_BUFFER, 0, MAP_SIZE,
+				       GL_MAP_WRITE_BIT |
+				       GL_MAP_INVALIDATE_BUFFER_BIT);
+	} else {
+		map = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+	}
+	if (map == NULL)
+		return false;
+
+	memset(map, d->value++, MAP_SIZE);
+	return glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+static void
+buffer_map_fini(void *data)
+{
+	struct buffer_map_data *d = data;
+
+	glDeleteBuffers(1, &d->bo);
+	free(d);
+}
+
+const struct piglit_egl_stress_workload piglit_egl_stress_buffer_map = {
+	"buffer-map", buffer_map_init, buffer_map_iterate, buffer_map_fini
+};
+
+#define DRAW_SIZE 64
+#define DRAW_TRIANGLES 1024
+
+struct draw_data {
+	GLuint fbo;
+	GLuint rb;
+	GLuint bo;
+	GLint prog;
+};
+
+static enum piglit_result
+draw_init(void **data)
+{
+	static const char vs_text[] =
+		"void main() {\n"
+		"	gl_Position = gl_Vertex;\n"
+		"}\n";
+	static const char fs_text[] =
+		"void main() {\n"
+		"	gl_FragColor = vec4(0.0, 1.0, 0.0, 1.0);\n"
+		"}\n";
+	struct draw_data *d;
+	float verts[DRAW_TRIANGLES * 3][2];
+	unsigned i;
+
+	if (piglit_get_gl_version() < 20)
+		return PIGLIT_SKIP;
+	/* Without a surface there is nothing to draw to but an FBO */
+	if (surfaceless &&
+	    piglit_get_gl_version() < 30 &&
+	    !piglit_is_extension_supported("GL_ARB_framebuffer_object"))
+		return PIGLIT_SKIP;
+
+	d = calloc(1, sizeof(*d));
+	if (surfaceless) {
+		glGenFramebuffers(1, &d->fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, d->fbo);
+		glGenRenderbuffers(1, &d->rb);
+		glBindRenderbuffer(GL_RENDERBUFFER, d->rb);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8,
+				      DRAW_SIZE, DRAW_SIZE);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+					  GL_RENDERBUFFER, d->rb);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) !=
+		    GL_FRAMEBUFFER_COMPLETE) {
+			*data = d;
+			return PIGLIT_FAIL;
+		}
+	}
+	glViewport(0, 0, DRAW_SIZE, DRAW_SIZE);
+
+	/* A fan of thin triangles around the middle of the viewport */
+	for (i = 0; i < DRAW_TRIANGLES; i++) {
+		const float a0 = 2 * M_PI * i / DRAW_TRIANGLES;
+		const float a1 = 2 * M_PI * (i + 1) / DRAW_TRIANGLES;
+
+		verts[i * 3][0] = 0;
+		verts[i * 3][1] = 0;
+		verts[i * 3 + 1][0] = cos(a0);
+		verts[i * 3 + 1][1] = sin(a0);
+		verts[i * 3 + 2][0] = cos(a1);
+		verts[i * 3 + 2][1] = sin(a1);
+	}
+	glGenBuffers(1, &d->bo);
+	glBindBuffer(GL_ARRAY_BUFFER, d->bo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+	glVertexPointer(2, GL_FLOAT, 0, NULL);
+	glEnableClientState(GL_VERTEX_ARRAY);
+
+	d->prog = piglit_build_simple_program(vs_text, fs_text);
+	glUseProgram(d->prog);
+
+	*data = d;
+	return PIGLIT_PASS;
+}
+
+static bool
+draw_iterate(void *data)
+{
+	glClear(GL_COLOR_BUFFER_BIT);
+	glDrawArrays(GL_TRIANGLES, 0, DRAW_TRIANGLES * 3);
+	return true;
+}
+
+static void
+draw_fini(void *data)
+{
+	struct draw_data *d = data;
+
+	glDeleteProgram(d->prog);
+	glDeleteBuffers(1, &d->bo);
+	if (d->fbo) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &d->fbo);
+		glDeleteRenderbuffers(1, &d->rb);
+	}
+	free(d);
+}
+
+const struct piglit_egl_stress_workload piglit_egl_stress_draw = {
+	"draw", draw_init, draw_iterate, draw_fini
+};
+
+const struct piglit_egl_stress_workload *const piglit_egl_stress_workloads[] = {
+	&piglit_egl_stress_compile,
+	&piglit_egl_stress_texture_upload,
+	&piglit_egl_stress_buffer_map,
+	&piglit_egl_stress_draw,
+	NULL
+};
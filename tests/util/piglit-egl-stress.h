@@ -0,0 +1,153 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file
+ *
+ * A harness that runs the same GL workload on N threads at once, each in its
+ * own EGL context, and measures how well the driver lets them run in
+ * parallel.
+ *
+ * The contexts have no window system surface: they are made current without
+ * one if EGL_KHR_surfaceless_context is supported, and with a small pbuffer
+ * otherwise.  So the harness needs no display server, and runs on llvmpipe.
+ *
+ * Besides each thread's throughput, it records hints of contention inside
+ * the driver: how much of its time a thread spent on the CPU, how often it
+ * blocked, and its longest iteration.  Running it for increasing N gives a
+ * scaling curve; a driver that serialises the threads on a lock has a flat
+ * one.
+ */
+
+#pragma once
+
+#include "piglit-util-gl.h"
+#include "piglit-util-egl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIGLIT_EGL_STRESS_MAX_THREADS 64
+
+/**
+ * GL work that each thread of the harness does over and over in its own
+ * context.  All hooks are called with that context current.
+ */
+struct piglit_egl_stress_workload {
+	const char *name;
+
+	/**
+	 * Set up what the iterations need, and store it in \c *data.  Return
+	 * PIGLIT_SKIP if the context lacks a feature the workload needs.
+	 */
+	enum piglit_result (*init)(void **data);
+
+	/** Do one iteration of work.  Return false on failure. */
+	bool (*iterate)(void *data);
+
+	/** Free what init() set up.  Not called if it left \c *data NULL. */
+	void (*fini)(void *data);
+};
+
+/** Compiles and links a small program whose source differs every time. */
+extern const struct piglit_egl_stress_workload piglit_egl_stress_compile;
+
+/** Replaces the contents of a 256x256 RGBA texture. */
+extern const struct piglit_egl_stress_workload piglit_egl_stress_texture_upload;
+
+/** Maps a 1 MiB buffer object, writes it and unmaps it. */
+extern const struct piglit_egl_stress_workload piglit_egl_stress_buffer_map;
+
+/** Clears a 64x64 framebuffer and draws 1024 triangles to it. */
+extern const struct piglit_egl_stress_workload piglit_egl_stress_draw;
+
+/** The workloads above, followed by NULL. */
+extern const struct piglit_egl_stress_workload *const piglit_egl_stress_workloads[];
+
+/**
+ * Look up a workload of piglit_egl_stress_workloads by name.  Return NULL if
+ * there is none.
+ */
+const struct piglit_egl_stress_workload *
+piglit_egl_stress_find_workload(const char *name);
+
+struct piglit_egl_stress_config {
+	const struct piglit_egl_stress_workload *workload;
+	unsigned num_threads;
+	/** How long each thread does iterations for, in seconds. */
+	double seconds;
+	/** If true, all contexts are in one share group. */
+	bool share_group;
+};
+
+struct piglit_egl_stress_thread_stats {
+	enum piglit_result result;
+	uint64_t iterations;
+	/** Seconds the thread spent iterating, including a final glFinish(). */
+	double seconds;
+	/** CPU seconds the thread used meanwhile, or -1 if unknown. */
+	double cpu_seconds;
+	/** Times the thread blocked meanwhile, or -1 if unknown. */
+	int64_t voluntary_switches;
+	/** Seconds the longest iteration took. */
+	double max_iteration;
+};
+
+struct piglit_egl_stress_stats {
+	/** The worst result of any thread, or PIGLIT_SKIP if all skipped. */
+	enum piglit_result result;
+	unsigned num_threads;
+	struct piglit_egl_stress_thread_stats threads[PIGLIT_EGL_STRESS_MAX_THREADS];
+	/** Iterations per second of all threads together. */
+	double throughput;
+};
+
+/**
+ * Initialize EGL and pick a config for desktop GL contexts.  Reports SKIP if
+ * there is no EGL display or it doesn't support desktop GL.
+ */
+void
+piglit_egl_stress_init(void);
+
+/**
+ * Run config->workload on config->num_threads threads at once and return how
+ * they fared in \c stats.
+ *
+ * Each thread creates its context, sets the workload up and then waits for
+ * the others, so that the iterations of all threads overlap.
+ */
+void
+piglit_egl_stress_run(const struct piglit_egl_stress_config *config,
+		      struct piglit_egl_stress_stats *stats);
+
+/**
+ * Print the per-thread throughput and contention hints of a run.
+ */
+void
+piglit_egl_stress_print_stats(const struct piglit_egl_stress_config *config,
+			      const struct piglit_egl_stress_stats *stats);
+
+#ifdef __cplusplus
+} /* end extern "C" */
+#endif
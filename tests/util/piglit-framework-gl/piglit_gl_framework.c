@@ -30,6 +30,7 @@
 
 #ifdef PIGLIT_USE_WAFFLE
 #	include "piglit_fbo_framework.h"
+#	include "piglit_wfl_framework.h"
 #	include "piglit_winsys_framework.h"
 #else
 #	include "piglit_glut_framework.h"
@@ -44,6 +45,17 @@ piglit_gl_framework_factory(const struct piglit_gl_test_config *test_config)
 #ifdef PIGLIT_USE_WAFFLE
 	struct piglit_gl_framework *gl_fw = NULL;
 
+#ifdef PIGLIT_HAS_SURFACELESS_EGL
+	/* There is no window system to render to, so render to an FBO
+	 * unless the test can't.  Tests that need a multisample window
+	 * get a pbuffer instead.
+	 */
+	if (piglit_wfl_framework_choose_platform(test_config) ==
+	    WAFFLE_PLATFORM_SURFACELESS_EGL &&
+	    test_config->window_samples <= 1)
+		piglit_use_fbo = true;
+#endif
+
 	if (piglit_use_fbo) {
 		gl_fw = piglit_fbo_framework_create(test_config);
 	}
@@ -34,6 +34,13 @@ enum context_flavor {
 	CONTEXT_GL_ES,
 };
 
+/**
+ * Whether the last make_context_current_singlepass() got as far as
+ * choosing a config, so that its failure, if it failed, was the
+ * context's and not the visual's.
+ */
+static bool config_was_chosen;
+
 static bool
 make_context_current_singlepass(struct piglit_wfl_framework *wfl_fw,
                                 const struct piglit_gl_test_config *test_config,
@@ -109,6 +116,16 @@ piglit_wfl_framework_choose_platform(const struct piglit_gl_test_config *test_co
 #endif
 	}
 
+	else if (streq(env, "surfaceless_egl")) {
+#ifdef PIGLIT_HAS_SURFACELESS_EGL
+		return WAFFLE_PLATFORM_SURFACELESS_EGL;
+#else
+		fprintf(stderr, "environment var PIGLIT_PLATFORM=surfaceless_egl, "
+		        "but piglit was built without surfaceless EGL support\n");
+		piglit_report_result(PIGLIT_FAIL);
+#endif
+	}
+
 	else {
 		fprintf(stderr, "environment var PIGLIT_PLATFORM has bad "
 			"value \"%s\"\n", env);
@@ -232,6 +249,28 @@ make_context_description(char buf[], size_t bufsize, const int32_t attrib_list[]
 		profile_str, debug_str);
 }
 
+/**
+ * Return the WAFFLE_CONTEXT_API for the ES version the test requires.
+ */
+static int32_t
+es_context_api(const struct piglit_gl_test_config *test_config)
+{
+	if (test_config->supports_gl_es_version < 40 &&
+	    test_config->supports_gl_es_version >= 30) {
+		return WAFFLE_CONTEXT_OPENGL_ES3;
+	} else if (test_config->supports_gl_es_version >= 20) {
+		return WAFFLE_CONTEXT_OPENGL_ES2;
+	} else if (test_config->supports_gl_es_version >= 10) {
+		return WAFFLE_CONTEXT_OPENGL_ES1;
+	}
+
+	printf("piglit: error: config attribute "
+	       "'supports_gl_es_version' has "
+	       "bad value %d\n",
+	       test_config->supports_gl_es_version);
+	piglit_report_result(PIGLIT_FAIL);
+}
+
 /**
  * \brief Return a attribute list suitable for waffle_config_choose().
  *
@@ -291,34 +330,17 @@ make_config_attrib_list(const struct piglit_gl_test_config *test_config,
 			head_attrib_list[i++] = test_config->supports_gl_compat_version % 10;
 			break;
 
-		case CONTEXT_GL_ES: {
-			int32_t waffle_context_api;
+		case CONTEXT_GL_ES:
 			assert(test_config->supports_gl_es_version);
 
-			if (test_config->supports_gl_es_version < 40 &&
-			    test_config->supports_gl_es_version >= 30) {
-				waffle_context_api = WAFFLE_CONTEXT_OPENGL_ES3;
-			} else if (test_config->supports_gl_es_version >= 20) {
-				waffle_context_api = WAFFLE_CONTEXT_OPENGL_ES2;
-			} else if (test_config->supports_gl_es_version >= 10) {
-				waffle_context_api = WAFFLE_CONTEXT_OPENGL_ES1;
-			} else {
-				printf("piglit: error: config attribute "
-				       "'supports_gl_es_version' has "
-				       "bad value %d\n",
-				       test_config->supports_gl_es_version);
-				piglit_report_result(PIGLIT_FAIL);
-			}
-
 			i = 0;
 			head_attrib_list[i++] = WAFFLE_CONTEXT_API;
-			head_attrib_list[i++] = waffle_context_api;
+			head_attrib_list[i++] = es_context_api(test_config);
 			head_attrib_list[i++] = WAFFLE_CONTEXT_MAJOR_VERSION;
 			head_attrib_list[i++] = test_config->supports_gl_es_version / 10;
 			head_attrib_list[i++] = WAFFLE_CONTEXT_MINOR_VERSION;
 			head_attrib_list[i++] = test_config->supports_gl_es_version % 10;
 			break;
-			}
 
 		default:
 			assert(0);
@@ -489,6 +511,7 @@ make_context_current_singlepass(struct piglit_wfl_framework *wfl_fw,
 	assert(attrib_list);
 	make_context_description(ctx_desc, sizeof(ctx_desc),
 				 attrib_list, flavor);
+	config_was_chosen = false;
 	wfl_fw->config = waffle_config_choose(wfl_fw->display, attrib_list);
 	free(attrib_list);
 	if (!wfl_fw->config) {
@@ -497,6 +520,7 @@ make_context_current_singlepass(struct piglit_wfl_framework *wfl_fw,
 			"waffle_config for %s\n", ctx_desc);
 		goto fail;
 	}
+	config_was_chosen = true;
 
 	wfl_fw->context = waffle_context_create(wfl_fw->config, NULL);
 	if (!wfl_fw->context) {
@@ -549,6 +573,146 @@ fail:
 	return false;
 }
 
+#if defined(PIGLIT_USE_OPENGL)
+
+/** Names of the flavors in the context cache, indexed by flavor. */
+static const char *const flavor_names[] = {
+	"core",
+	"compat",
+};
+
+/** Size of the context cache's keys, and of its lines. */
+#define CONTEXT_CACHE_KEY_SIZE 2048
+
+/**
+ * Environment variables that select the GL driver, or change what it
+ * supports, so that the cache doesn't carry one driver's answer over
+ * to another.
+ */
+static const char *const driver_env_vars[] = {
+	"LD_LIBRARY_PATH",
+	"LIBGL_ALWAYS_SOFTWARE",
+	"LIBGL_DRIVERS_PATH",
+	"MESA_LOADER_DRIVER_OVERRIDE",
+	"GALLIUM_DRIVER",
+	"DRI_PRIME",
+	"MESA_GL_VERSION_OVERRIDE",
+	"__GLX_VENDOR_LIBRARY_NAME",
+	"__EGL_VENDOR_LIBRARY_FILENAMES",
+	"__EGL_VENDOR_LIBRARY_DIRS",
+};
+
+/**
+ * Describe the display, the driver, and the kind of context and visual
+ * \a test_config and \a partial_config_attrib_list ask for, as the key
+ * of a line in the context cache.
+ *
+ * Return false if the key doesn't fit in \a bufsize bytes.
+ */
+static bool
+make_context_cache_key(char buf[], size_t bufsize, int32_t platform,
+		       const struct piglit_gl_test_config *test_config,
+		       const int32_t partial_config_attrib_list[])
+{
+	const char *display = getenv(platform == WAFFLE_PLATFORM_WAYLAND ?
+				     "WAYLAND_DISPLAY" : "DISPLAY");
+	size_t len;
+	int i;
+
+	len = snprintf(buf, bufsize,
+		       "platform=%d display=%s core=%d compat=%d fwd=%d "
+		       "debug=%d config=",
+		       platform, display ? display : "",
+		       test_config->supports_gl_core_version,
+		       test_config->supports_gl_compat_version,
+		       test_config->require_forward_compatible_context,
+		       test_config->require_debug_context);
+
+	for (i = 0; partial_config_attrib_list[i] != 0 && len < bufsize;
+	     i += 2) {
+		len += snprintf(buf + len, bufsize - len, "%s%#x:%d",
+				i ? "," : "",
+				(unsigned) partial_config_attrib_list[i],
+				partial_config_attrib_list[i + 1]);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(driver_env_vars) && len < bufsize; i++) {
+		const char *value = getenv(driver_env_vars[i]);
+
+		if (value)
+			len += snprintf(buf + len, bufsize - len, " %s=%s",
+					driver_env_vars[i], value);
+	}
+
+	/* A line of the cache holds the key, and can't hold newlines. */
+	return len + 16 < bufsize && strchr(buf, '\n') == NULL;
+}
+
+/**
+ * Look up the flavor that last succeeded for \a key in the context cache
+ * named by PIGLIT_CONTEXT_CACHE.
+ *
+ * Each line of the cache is a flavor name followed by a key.  Test
+ * processes only ever append to it, so the last matching line wins.
+ */
+static bool
+lookup_cached_flavor(const char *key, enum context_flavor *flavor)
+{
+	const char *path = getenv("PIGLIT_CONTEXT_CACHE");
+	char line[CONTEXT_CACHE_KEY_SIZE];
+	bool found = false;
+	FILE *f;
+	int i;
+
+	if (!path || !*path)
+		return false;
+
+	f = fopen(path, "r");
+	if (!f)
+		return false;
+
+	while (fgets(line, sizeof(line), f)) {
+		line[strcspn(line, "\n")] = '\0';
+
+		for (i = 0; i < ARRAY_SIZE(flavor_names); i++) {
+			const size_t len = strlen(flavor_names[i]);
+
+			if (strncmp(line, flavor_names[i], len) == 0 &&
+			    line[len] == ' ' && streq(line + len + 1, key)) {
+				*flavor = i;
+				found = true;
+			}
+		}
+	}
+
+	fclose(f);
+	return found;
+}
+
+/**
+ * Append \a flavor for \a key to the context cache.  The line is
+ * written with a single append, so concurrent test processes don't
+ * interleave their lines.
+ */
+static void
+record_flavor(const char *key, enum context_flavor flavor)
+{
+	const char *path = getenv("PIGLIT_CONTEXT_CACHE");
+	FILE *f;
+
+	if (!path || !*path)
+		return;
+
+	f = fopen(path, "a");
+	if (!f)
+		return;
+
+	fprintf(f, "%s %s\n", flavor_names[flavor], key);
+	fclose(f);
+}
+
+#endif
+
 static void
 make_context_current(struct piglit_wfl_framework *wfl_fw,
                      const struct piglit_gl_test_config *test_config,
@@ -557,37 +721,87 @@ make_context_current(struct piglit_wfl_framework *wfl_fw,
 	bool ok = false;
 
 #if defined(PIGLIT_USE_OPENGL)
+	enum context_flavor flavors[2];
+	enum context_flavor cached_flavor;
+	bool have_cached_flavor = false;
+	bool use_cache;
+	bool core_config_failed = false;
+	char key[CONTEXT_CACHE_KEY_SIZE];
+	int num_flavors = 0;
+	int i;
+
+	if (!waffle_display_supports_context_api(wfl_fw->display,
+						 WAFFLE_CONTEXT_OPENGL)) {
+		printf("piglit: info: The display does not support "
+		       "OpenGL\n");
+		piglit_report_result(PIGLIT_SKIP);
+	}
+
+	if (test_config->supports_gl_core_version)
+		flavors[num_flavors++] = CONTEXT_GL_CORE;
+	if (test_config->supports_gl_compat_version)
+		flavors[num_flavors++] = CONTEXT_GL_COMPAT;
+
+	/* Try first the flavor that an earlier test process, making the
+	 * same request of the same display and driver, ended up with.
+	 * This skips the failing core attempt for every test on drivers
+	 * without core profile support.
+	 */
+	use_cache = make_context_cache_key(key, sizeof(key), wfl_fw->platform,
+					   test_config,
+					   partial_config_attrib_list);
+	if (use_cache)
+		have_cached_flavor = lookup_cached_flavor(key, &cached_flavor);
+	if (have_cached_flavor && num_flavors == 2 &&
+	    flavors[1] == cached_flavor) {
+		flavors[1] = flavors[0];
+		flavors[0] = cached_flavor;
+	}
+
+	for (i = 0; i < num_flavors; i++) {
+		if (i > 0 && flavors[i] == CONTEXT_GL_COMPAT) {
+			/* The above attempt to create a core context
+			 * failed.
+			 */
+			printf("piglit: info: Falling back to GL %d.%d "
+			       "compatibility context\n",
+			       test_config->supports_gl_compat_version / 10,
+			       test_config->supports_gl_compat_version % 10);
+		}
 
-	if (test_config->supports_gl_core_version) {
 		ok = make_context_current_singlepass(wfl_fw, test_config,
-		                                     CONTEXT_GL_CORE,
+		                                     flavors[i],
 		                                     partial_config_attrib_list);
 		if (ok) {
-			piglit_is_core_profile = true;
+			if (flavors[i] == CONTEXT_GL_CORE)
+				piglit_is_core_profile = true;
+
+			/* Core profile support is only ruled out if core
+			 * context creation failed, and not because no
+			 * config matched the visual.
+			 */
+			if (use_cache && !core_config_failed &&
+			    (!have_cached_flavor ||
+			     cached_flavor != flavors[i]))
+				record_flavor(key, flavors[i]);
 			return;
 		}
-	}
-
-	if (test_config->supports_gl_core_version &&
-	    test_config->supports_gl_compat_version) {
-		/* The above attempt to create a core context failed. */
-		printf("piglit: info: Falling back to GL %d.%d "
-		       "compatibility context\n",
-		       test_config->supports_gl_compat_version / 10,
-		       test_config->supports_gl_compat_version % 10);
-        }
 
-	if (test_config->supports_gl_compat_version) {
-		ok = make_context_current_singlepass(wfl_fw, test_config,
-		                                     CONTEXT_GL_COMPAT,
-		                                     partial_config_attrib_list);
-		if (ok)
-		   return;
+		if (flavors[i] == CONTEXT_GL_CORE && !config_was_chosen)
+			core_config_failed = true;
 	}
 
 #elif defined(PIGLIT_USE_OPENGL_ES1) || \
       defined(PIGLIT_USE_OPENGL_ES2) || \
       defined(PIGLIT_USE_OPENGL_ES3)
+	if (!waffle_display_supports_context_api(wfl_fw->display,
+						 es_context_api(test_config))) {
+		printf("piglit: info: The display does not support "
+		       "OpenGL ES %d.x\n",
+		       test_config->supports_gl_es_version / 10);
+		piglit_report_result(PIGLIT_SKIP);
+	}
+
 	ok = make_context_current_singlepass(wfl_fw, test_config,
 	                                     CONTEXT_GL_ES,
 	                                     partial_config_attrib_list);
@@ -613,6 +827,7 @@ piglit_wfl_framework_init(struct piglit_wfl_framework *wfl_fw,
 	static int32_t initialized_platform = 0;
 
 	bool ok = true;
+	int64_t start;
 
 	if (is_waffle_initialized) {
 		assert(platform == initialized_platform);
@@ -631,10 +846,17 @@ piglit_wfl_framework_init(struct piglit_wfl_framework *wfl_fw,
 	if (!ok)
 		goto fail;
 
+	start = piglit_get_microseconds();
+
 	wfl_fw->platform = platform;
 	wfl_fw->display = wfl_checked_display_connect(NULL);
 	make_context_current(wfl_fw, test_config, partial_config_attrib_list);
 
+	/* Goes into the test's result, like the result line itself. */
+	printf("PIGLIT: {\"context_creation_time\": %.6f}\n",
+	       (piglit_get_microseconds() - start) / 1000000.0);
+	fflush(stdout);
+
 	return true;
 
 fail:
@@ -31,6 +31,7 @@
 
 #include "piglit_gbm_framework.h"
 #include "piglit_gl_framework.h"
+#include "piglit_sl_framework.h"
 #include "piglit_winsys_framework.h"
 #include "piglit_wl_framework.h"
 #include "piglit_x11_framework.h"
@@ -172,6 +173,11 @@ piglit_winsys_framework_factory(const struct piglit_gl_test_config *test_config)
 		return piglit_gbm_framework_create(test_config);
 #endif
 
+#ifdef PIGLIT_HAS_SURFACELESS_EGL
+	case WAFFLE_PLATFORM_SURFACELESS_EGL:
+		return piglit_sl_framework_create(test_config);
+#endif
+
 #ifdef PIGLIT_HAS_WAYLAND
 	case WAFFLE_PLATFORM_WAYLAND:
 		return piglit_wl_framework_create(test_config);
@@ -0,0 +1,282 @@
+/**************************************************************************
+ *
+ * Copyright 2012 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * \file piglit-rasterizer.c
+ *
+ * Half-edge triangle rasterizer, originally from
+ * tests/general/triangle-rasterization.cpp and based on
+ * http://devmaster.net/forums/topic/1145-advanced-rasterization
+ *
+ * For an edge from vertex a to vertex b the edge function at pixel (x, y)
+ * is
+ *
+ *     E(x, y) = c + (dx << subpixel_bits) * y - (dy << subpixel_bits) * x
+ *
+ * with dx = xa - xb, dy = ya - yb and c chosen so that E is zero along the
+ * edge.  A pixel is covered when all three edge functions are positive.
+ * Because E is linear, its extremes over a rectangular block of pixels are
+ * found at the block's corners, which is what allows whole blocks to be
+ * accepted or rejected at once.
+ */
+
+#include "piglit-rasterizer.h"
+
+#include <stdbool.h>
+
+/** Width and height of the blocks the bounding box is walked in. */
+#define BLOCK_SIZE 8
+
+struct edge {
+	/** Value of the edge function at the current pixel. */
+	int64_t value;
+	/** Change in value for a step of one pixel in x and in y. */
+	int64_t step_x;
+	int64_t step_y;
+};
+
+/* Proper rounding of float to integer */
+static int64_t
+iround(float v)
+{
+	if (v > 0.0f)
+		v += 0.5f;
+	if (v < 0.0f)
+		v -= 0.5f;
+	return (int64_t)v;
+}
+
+static int64_t
+min3(int64_t a, int64_t b, int64_t c)
+{
+	int64_t m = a < b ? a : b;
+	return m < c ? m : c;
+}
+
+static int64_t
+max3(int64_t a, int64_t b, int64_t c)
+{
+	int64_t m = a > b ? a : b;
+	return m > c ? m : c;
+}
+
+/**
+ * Return true if pixel centers lying exactly on the edge with deltas
+ * (dx, dy) belong to the triangle under the given filling convention.
+ */
+static bool
+edge_is_inclusive(enum piglit_fill_convention convention,
+		  int64_t dx, int64_t dy)
+{
+	switch (convention) {
+	case PIGLIT_FILL_BOTTOM_RIGHT:
+		return dy > 0 || (dy == 0 && dx > 0);
+	case PIGLIT_FILL_RIGHT_BOTTOM:
+		return dx < 0 || (dx == 0 && dy < 0);
+	case PIGLIT_FILL_LEFT_BOTTOM:
+		return dx < 0 || (dx == 0 && dy > 0);
+	case PIGLIT_FILL_BOTTOM_LEFT:
+		return dy < 0 || (dy == 0 && dx > 0);
+	case PIGLIT_FILL_TOP_LEFT:
+		return dy < 0 || (dy == 0 && dx < 0);
+	case PIGLIT_FILL_LEFT_TOP:
+		return dx > 0 || (dx == 0 && dy > 0);
+	case PIGLIT_FILL_RIGHT_TOP:
+		return dx > 0 || (dx == 0 && dy < 0);
+	case PIGLIT_FILL_TOP_RIGHT:
+		return dy > 0 || (dy == 0 && dx < 0);
+	}
+	return false;
+}
+
+static void
+write_span(uint32_t *dst, int count, enum piglit_raster_op op, uint32_t value)
+{
+	int i;
+
+	if (op == PIGLIT_RASTER_ADD) {
+		for (i = 0; i < count; i++)
+			dst[i] += value;
+	} else {
+		for (i = 0; i < count; i++)
+			dst[i] = value;
+	}
+}
+
+/**
+ * Rasterize the pixels of a row of a partially covered block,
+ * PIGLIT_RASTER_LANES at a time.  e[] holds the edge functions at the
+ * first pixel of the row.
+ */
+static void
+rasterize_row(uint32_t *dst, int count, const struct edge e[3],
+	      enum piglit_raster_op op, uint32_t value)
+{
+	int64_t e0[PIGLIT_RASTER_LANES];
+	int64_t e1[PIGLIT_RASTER_LANES];
+	int64_t e2[PIGLIT_RASTER_LANES];
+	int x, i;
+
+	for (i = 0; i < PIGLIT_RASTER_LANES; i++) {
+		e0[i] = e[0].value + i * e[0].step_x;
+		e1[i] = e[1].value + i * e[1].step_x;
+		e2[i] = e[2].value + i * e[2].step_x;
+	}
+
+	for (x = 0; x < count; x += PIGLIT_RASTER_LANES) {
+		bool covered[PIGLIT_RASTER_LANES];
+		int lanes = count - x < PIGLIT_RASTER_LANES ?
+			count - x : PIGLIT_RASTER_LANES;
+
+		for (i = 0; i < PIGLIT_RASTER_LANES; i++) {
+			covered[i] = (e0[i] > 0) & (e1[i] > 0) & (e2[i] > 0);
+			e0[i] += PIGLIT_RASTER_LANES * e[0].step_x;
+			e1[i] += PIGLIT_RASTER_LANES * e[1].step_x;
+			e2[i] += PIGLIT_RASTER_LANES * e[2].step_x;
+		}
+
+		for (i = 0; i < lanes; i++) {
+			if (!covered[i])
+				continue;
+			if (op == PIGLIT_RASTER_ADD)
+				dst[x + i] += value;
+			else
+				dst[x + i] = value;
+		}
+	}
+}
+
+void
+piglit_rasterize_triangle(const struct piglit_rasterizer *r,
+			  const float v[3][2],
+			  enum piglit_raster_op op,
+			  uint32_t value)
+{
+	const int shift = r->subpixel_bits;
+	const float one = (float)(1 << shift);
+	const float center_offset = -0.5f;
+	int64_t x[3], y[3];
+	int64_t minx, maxx, miny, maxy;
+	int64_t bx, by;
+	struct edge edges[3];
+	int i;
+
+	/* fixed point coordinates */
+	for (i = 0; i < 3; i++) {
+		x[i] = iround(one * (v[i][0] + center_offset));
+		y[i] = iround(one * (v[i][1] + center_offset));
+	}
+
+	/* Force correct vertex order */
+	if ((x[1] - x[0]) * (y[2] - y[1]) - (y[1] - y[0]) * (x[2] - x[1]) > 0) {
+		int64_t t;
+		t = x[0]; x[0] = x[2]; x[2] = t;
+		t = y[0]; y[0] = y[2]; y[2] = t;
+	}
+
+	/* Bounding rectangle, clipped to the buffer */
+	minx = min3(x[0], x[1], x[2]) >> shift;
+	maxx = max3(x[0], x[1], x[2]) >> shift;
+	miny = min3(y[0], y[1], y[2]) >> shift;
+	maxy = max3(y[0], y[1], y[2]) >> shift;
+
+	if (minx < 0)
+		minx = 0;
+	if (maxx > r->width - 1)
+		maxx = r->width - 1;
+	if (miny < 0)
+		miny = 0;
+	if (maxy > r->height - 1)
+		maxy = r->height - 1;
+	if (minx > maxx || miny > maxy)
+		return;
+
+	/* Half-edge functions, evaluated at (minx, miny) */
+	for (i = 0; i < 3; i++) {
+		const int j = (i + 1) % 3;
+		const int64_t dx = x[i] - x[j];
+		const int64_t dy = y[i] - y[j];
+		int64_t c = dy * x[i] - dx * y[i];
+
+		/* Correct for filling convention */
+		if (edge_is_inclusive(r->convention, dx, dy))
+			c++;
+
+		edges[i].step_x = -(dy << shift);
+		edges[i].step_y = dx << shift;
+		edges[i].value = c + dx * (miny << shift) - dy * (minx << shift);
+	}
+
+	/* Walk the bounding rectangle in blocks */
+	for (by = miny; by <= maxy; by += BLOCK_SIZE) {
+		const int h = (int)(maxy - by + 1 < BLOCK_SIZE ?
+				    maxy - by + 1 : BLOCK_SIZE);
+
+		for (bx = minx; bx <= maxx; bx += BLOCK_SIZE) {
+			const int w = (int)(maxx - bx + 1 < BLOCK_SIZE ?
+					    maxx - bx + 1 : BLOCK_SIZE);
+			uint32_t *dst = r->buffer + by * r->stride + bx;
+			struct edge e[3];
+			bool inside = true;
+			bool outside = false;
+			int row;
+
+			for (i = 0; i < 3; i++) {
+				const int64_t across = (w - 1) * edges[i].step_x;
+				const int64_t up = (h - 1) * edges[i].step_y;
+				int64_t lo, hi;
+
+				e[i] = edges[i];
+				e[i].value += (bx - minx) * edges[i].step_x +
+					      (by - miny) * edges[i].step_y;
+
+				lo = e[i].value + (across < 0 ? across : 0) +
+					(up < 0 ? up : 0);
+				hi = e[i].value + (across > 0 ? across : 0) +
+					(up > 0 ? up : 0);
+				if (hi <= 0)
+					outside = true;
+				if (lo <= 0)
+					inside = false;
+			}
+
+			if (outside)
+				continue;
+
+			for (row = 0; row < h; row++) {
+				if (inside)
+					write_span(dst, w, op, value);
+				else
+					rasterize_row(dst, w, e, op, value);
+
+				dst += r->stride;
+				for (i = 0; i < 3; i++)
+					e[i].value += e[i].step_y;
+			}
+		}
+	}
+}
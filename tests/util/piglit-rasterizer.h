@@ -0,0 +1,113 @@
+/**************************************************************************
+ *
+ * Copyright 2012 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * \file piglit-rasterizer.h
+ *
+ * Fixed-point reference triangle rasterizer.
+ *
+ * Triangles are snapped to a grid of 2^subpixel_bits positions per pixel
+ * and rasterized with half-edge functions.  Pixels whose center lies
+ * exactly on an edge are resolved with one of the eight filling
+ * conventions described in triangle-rasterization.cpp, so the result can
+ * be compared pixel for pixel with a GL implementation once its
+ * convention is known.
+ *
+ * The framebuffer is walked in blocks of pixels.  Blocks that lie wholly
+ * outside an edge are skipped and blocks wholly inside all three edges
+ * are filled without testing each pixel; the remaining blocks are
+ * evaluated PIGLIT_RASTER_LANES pixels at a time.
+ */
+
+#ifndef PIGLIT_RASTERIZER_H
+#define PIGLIT_RASTERIZER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of pixels evaluated together along a row. */
+#define PIGLIT_RASTER_LANES 4
+
+/**
+ * Filling conventions, named after the horizontal and vertical edges
+ * that belong to a triangle.  The order matches the triangles used by
+ * triangle-rasterization.cpp to detect the implementation's convention.
+ */
+enum piglit_fill_convention {
+	PIGLIT_FILL_BOTTOM_LEFT = 0,
+	PIGLIT_FILL_LEFT_BOTTOM,
+	PIGLIT_FILL_RIGHT_BOTTOM,
+	PIGLIT_FILL_BOTTOM_RIGHT,
+	PIGLIT_FILL_TOP_RIGHT,
+	PIGLIT_FILL_RIGHT_TOP,
+	PIGLIT_FILL_LEFT_TOP,
+	PIGLIT_FILL_TOP_LEFT,
+};
+
+/** How a covered pixel is combined with the destination. */
+enum piglit_raster_op {
+	/** Replace the pixel with the value. */
+	PIGLIT_RASTER_REPLACE,
+	/** Add the value to the pixel, e.g. to count overdraw. */
+	PIGLIT_RASTER_ADD,
+};
+
+struct piglit_rasterizer {
+	/** Number of bits of subpixel precision. */
+	int subpixel_bits;
+	enum piglit_fill_convention convention;
+
+	/**
+	 * Destination buffer of width x height 32-bit pixels, with
+	 * stride pixels between the starts of rows.  Row 0 is the bottom
+	 * row, as in GL.  Triangles are clipped to it.
+	 */
+	uint32_t *buffer;
+	int width;
+	int height;
+	int stride;
+};
+
+/**
+ * Rasterize the triangle with window-space vertices v[0..2] (x, y) into
+ * r->buffer, combining \a value with each covered pixel according to
+ * \a op.
+ */
+void
+piglit_rasterize_triangle(const struct piglit_rasterizer *r,
+			  const float v[3][2],
+			  enum piglit_raster_op op,
+			  uint32_t value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIGLIT_RASTERIZER_H */
@@ -0,0 +1,368 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-sampler.c
+ *
+ * Software texture sampler; see piglit-sampler.h.
+ *
+ * Coordinates are converted to texel space (u = s * width) and wrapped
+ * per texel index, following the formulation of the wrap modes in
+ * section 8.14.2 of the GL 4.4 specification.  Indices of -1 and size
+ * after wrapping denote the border.
+ */
+
+#include "piglit-sampler.h"
+
+#include <math.h>
+
+void
+piglit_sampler_init(struct piglit_sampler *s, int dimensions)
+{
+	int i;
+
+	memset(s, 0, sizeof(*s));
+	s->dimensions = dimensions;
+	s->type = PIGLIT_SAMPLER_FLOAT;
+	for (i = 0; i < 3; i++)
+		s->wrap[i] = GL_REPEAT;
+	s->min_filter = GL_NEAREST_MIPMAP_LINEAR;
+	s->mag_filter = GL_LINEAR;
+	s->min_lod = -1000.0f;
+	s->max_lod = 1000.0f;
+	s->base_level = 0;
+	s->max_level = 1000;
+	s->swizzle[0] = GL_RED;
+	s->swizzle[1] = GL_GREEN;
+	s->swizzle[2] = GL_BLUE;
+	s->swizzle[3] = GL_ALPHA;
+}
+
+float
+piglit_sampler_lod(const struct piglit_sampler *s, float rho, float bias)
+{
+	float lod = log2f(rho) + s->lod_bias + bias;
+
+	if (!(lod > s->min_lod))
+		lod = s->min_lod;
+	if (lod > s->max_lod)
+		lod = s->max_lod;
+	return lod;
+}
+
+static bool
+is_mipmap_filter(GLenum filter)
+{
+	return filter != GL_NEAREST && filter != GL_LINEAR;
+}
+
+void
+piglit_sampler_select_levels(const struct piglit_sampler *s, int last_level,
+			     float lod, struct piglit_sampler_levels *levels)
+{
+	const int base = s->base_level;
+	const int q = MIN2(last_level, s->max_level);
+	float c = 0.0f;
+
+	/* Section 8.14.4 (Coordinate Wrapping and Texel Selection) */
+	if (s->mag_filter == GL_LINEAR &&
+	    (s->min_filter == GL_NEAREST_MIPMAP_NEAREST ||
+	     s->min_filter == GL_NEAREST_MIPMAP_LINEAR))
+		c = 0.5f;
+
+	levels->magnify = lod <= c;
+	levels->level[0] = levels->level[1] = base;
+	levels->weight = 0.0f;
+
+	if (levels->magnify || !is_mipmap_filter(s->min_filter))
+		return;
+
+	/* Section 8.14.3 (Mipmapping) */
+	if (s->min_filter == GL_NEAREST_MIPMAP_NEAREST ||
+	    s->min_filter == GL_LINEAR_MIPMAP_NEAREST) {
+		if (lod <= 0.5f)
+			levels->level[0] = base;
+		else if (base + lod <= q + 0.5f)
+			levels->level[0] = (int)ceilf(base + lod + 0.5f) - 1;
+		else
+			levels->level[0] = q;
+		levels->level[1] = levels->level[0];
+	} else if (lod >= q - base) {
+		levels->level[0] = levels->level[1] = q;
+	} else {
+		levels->level[0] = base + (int)floorf(lod);
+		levels->level[1] = levels->level[0] + 1;
+		levels->weight = lod - floorf(lod);
+	}
+}
+
+static int
+mirror(int i)
+{
+	return i >= 0 ? i : -(1 + i);
+}
+
+/**
+ * Wrap texel index \a i of a level \a size texels across.  The result
+ * is -1 or size for the border.
+ */
+static int
+wrap_index(GLenum mode, int i, int size)
+{
+	switch (mode) {
+	case GL_REPEAT:
+		return ((i % size) + size) % size;
+	case GL_MIRRORED_REPEAT:
+		return (size - 1) - mirror((((i % (2 * size)) + 2 * size) %
+					    (2 * size)) - size);
+	case GL_CLAMP_TO_EDGE:
+		return CLAMP(i, 0, size - 1);
+	case GL_MIRROR_CLAMP_TO_EDGE_EXT:
+		return CLAMP(mirror(i), 0, size - 1);
+	case GL_MIRROR_CLAMP_TO_BORDER_EXT:
+		return MIN2(mirror(i), size);
+	case GL_CLAMP:
+	case GL_MIRROR_CLAMP_EXT:
+	case GL_CLAMP_TO_BORDER:
+	default:
+		return CLAMP(i, -1, size);
+	}
+}
+
+/**
+ * GL_CLAMP and GL_MIRROR_CLAMP_EXT clamp the coordinate itself, after
+ * which linear filtering can reach the border but nearest can't.
+ */
+static bool
+clamps_coordinate(GLenum mode, float *u, int size)
+{
+	switch (mode) {
+	case GL_MIRROR_CLAMP_EXT:
+		*u = fabsf(*u);
+		/* Fall through. */
+	case GL_CLAMP:
+		*u = CLAMP(*u, 0.0f, (float)size);
+		return true;
+	default:
+		return false;
+	}
+}
+
+static int
+wrap_nearest(GLenum mode, float u, int size)
+{
+	if (clamps_coordinate(mode, &u, size))
+		return MIN2((int)floorf(u), size - 1);
+	return wrap_index(mode, (int)floorf(u), size);
+}
+
+static void
+wrap_linear(GLenum mode, float u, int size, int i[2], float *alpha)
+{
+	if (clamps_coordinate(mode, &u, size))
+		mode = GL_CLAMP_TO_BORDER;
+
+	u -= 0.5f;
+	*alpha = u - floorf(u);
+	i[0] = wrap_index(mode, (int)floorf(u), size);
+	i[1] = wrap_index(mode, (int)floorf(u) + 1, size);
+}
+
+static void
+fetch_texel(const struct piglit_sampler *s,
+	    const struct piglit_sampler_image *img,
+	    int x, int y, int z, float texel[4])
+{
+	const float *src;
+	int i;
+
+	if (x < 0 || x >= img->width ||
+	    y < 0 || y >= img->height ||
+	    z < 0 || z >= img->depth) {
+		memcpy(texel, s->border_color, 4 * sizeof(float));
+		return;
+	}
+
+	src = &img->texels[((z * img->height + y) * img->width + x) *
+			   img->components];
+	if (img->components == 1) {
+		texel[0] = texel[1] = texel[2] = src[0];
+		texel[3] = 1.0f;
+	} else {
+		memcpy(texel, src, 4 * sizeof(float));
+	}
+
+	if (s->srgb) {
+		for (i = 0; i < 3; i++)
+			texel[i] = piglit_srgb_to_linear(texel[i]);
+	}
+}
+
+/** Texel-space coordinate along axis \a axis of \a img. */
+static float
+texel_coord(const struct piglit_sampler *s,
+	    const struct piglit_sampler_image *img,
+	    const float *coord, int axis)
+{
+	const int size = axis == 0 ? img->width :
+			 axis == 1 ? img->height : img->depth;
+
+	return s->unnormalized ? coord[axis] : coord[axis] * size;
+}
+
+static void
+sample_level(const struct piglit_sampler *s,
+	     const struct piglit_sampler_image *img,
+	     GLenum filter, const float *coord, float result[4])
+{
+	const int sizes[3] = { img->width, img->height, img->depth };
+	int index[3][2] = { { 0, 0 }, { 0, 0 }, { 0, 0 } };
+	float alpha[3] = { 0.0f, 0.0f, 0.0f };
+	int axis, corner, c;
+
+	if (s->type != PIGLIT_SAMPLER_FLOAT)
+		filter = GL_NEAREST;
+
+	if (filter == GL_NEAREST) {
+		for (axis = 0; axis < s->dimensions; axis++) {
+			index[axis][0] = wrap_nearest(s->wrap[axis],
+						      texel_coord(s, img, coord, axis),
+						      sizes[axis]);
+		}
+		fetch_texel(s, img, index[0][0], index[1][0], index[2][0],
+			    result);
+		return;
+	}
+
+	for (axis = 0; axis < s->dimensions; axis++) {
+		wrap_linear(s->wrap[axis], texel_coord(s, img, coord, axis),
+			    sizes[axis], index[axis], &alpha[axis]);
+	}
+
+	/* Weighted sum over the 2, 4 or 8 texels around the coordinate. */
+	memset(result, 0, 4 * sizeof(float));
+	for (corner = 0; corner < (1 << s->dimensions); corner++) {
+		float texel[4];
+		float weight = 1.0f;
+
+		for (axis = 0; axis < s->dimensions; axis++) {
+			const int hi = (corner >> axis) & 1;
+			weight *= hi ? alpha[axis] : 1.0f - alpha[axis];
+		}
+		if (weight == 0.0f)
+			continue;
+
+		fetch_texel(s, img,
+			    index[0][(corner >> 0) & 1],
+			    index[1][(corner >> 1) & 1],
+			    index[2][(corner >> 2) & 1], texel);
+		for (c = 0; c < 4; c++)
+			result[c] += weight * texel[c];
+	}
+}
+
+static void
+apply_swizzle(const struct piglit_sampler *s, float value[4])
+{
+	float orig[4];
+	int i;
+
+	memcpy(orig, value, sizeof(orig));
+	for (i = 0; i < 4; i++) {
+		switch (s->swizzle[i]) {
+		case GL_RED:
+			value[i] = orig[0];
+			break;
+		case GL_GREEN:
+			value[i] = orig[1];
+			break;
+		case GL_BLUE:
+			value[i] = orig[2];
+			break;
+		case GL_ALPHA:
+			value[i] = orig[3];
+			break;
+		case GL_ZERO:
+			value[i] = 0.0f;
+			break;
+		case GL_ONE:
+			if (s->type == PIGLIT_SAMPLER_FLOAT) {
+				value[i] = 1.0f;
+			} else {
+				const int32_t one = 1;
+				memcpy(&value[i], &one, sizeof(one));
+			}
+			break;
+		}
+	}
+}
+
+void
+piglit_sampler_sample(const struct piglit_sampler *s,
+		      const struct piglit_sampler_image *levels,
+		      int num_levels, int count, const float *coords,
+		      const float *lods, float *out)
+{
+	int i, c;
+
+	for (i = 0; i < count; i++) {
+		const float *coord = &coords[i * 3];
+		float *result = &out[i * 4];
+		struct piglit_sampler_levels sel;
+		GLenum filter;
+
+		piglit_sampler_select_levels(s, num_levels - 1,
+					     lods ? lods[i] : 0.0f, &sel);
+
+		if (sel.magnify) {
+			filter = s->mag_filter;
+		} else {
+			switch (s->min_filter) {
+			case GL_NEAREST:
+			case GL_NEAREST_MIPMAP_NEAREST:
+			case GL_NEAREST_MIPMAP_LINEAR:
+				filter = GL_NEAREST;
+				break;
+			default:
+				filter = GL_LINEAR;
+				break;
+			}
+		}
+
+		sample_level(s, &levels[sel.level[0]], filter, coord, result);
+
+		if (sel.level[1] != sel.level[0] && sel.weight != 0.0f &&
+		    s->type == PIGLIT_SAMPLER_FLOAT) {
+			float second[4];
+
+			sample_level(s, &levels[sel.level[1]], filter, coord,
+				     second);
+			for (c = 0; c < 4; c++) {
+				result[c] = (1.0f - sel.weight) * result[c] +
+					    sel.weight * second[c];
+			}
+		}
+
+		apply_swizzle(s, result);
+	}
+}
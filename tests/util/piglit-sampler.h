@@ -0,0 +1,161 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-sampler.h
+ *
+ * Software model of GL texture sampling, for computing the expected
+ * result of texture lookups on the CPU.
+ *
+ * The model follows the texture minification and magnification rules
+ * of the GL 4.4 specification (section 8.14): wrap modes including the
+ * mirror-clamp extensions and GL_CLAMP, border colours, nearest and
+ * linear filtering, level-of-detail selection with bias and LOD clamps,
+ * mipmapped filtering, texture swizzles, sRGB decoding and integer
+ * textures.  Cube maps, depth comparison and anisotropic filtering are
+ * not modelled.
+ *
+ * Lookups are done in batches: piglit_sampler_sample() computes the
+ * result for a whole array of texture coordinates at once, so a test
+ * can build the expected image for a probe grid and compare it with a
+ * single readback.
+ */
+
+#ifndef PIGLIT_SAMPLER_H
+#define PIGLIT_SAMPLER_H
+
+#include "piglit-util-gl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Interpretation of texel data and results. */
+enum piglit_sampler_type {
+	/** 32-bit floats, filtered as usual. */
+	PIGLIT_SAMPLER_FLOAT,
+	/**
+	 * 32-bit signed or unsigned integers.  The values are carried
+	 * through the float arrays of this interface as bit patterns and
+	 * are never filtered: integer textures are sampled with NEAREST
+	 * filtering, from a single mipmap level.
+	 */
+	PIGLIT_SAMPLER_INT,
+	PIGLIT_SAMPLER_UINT,
+};
+
+/** One mipmap level of a texture. */
+struct piglit_sampler_image {
+	int width, height, depth;
+
+	/**
+	 * 4 for RGBA texels, or 1 for single-channel texels which are
+	 * returned as (x, x, x, 1), as for a depth texture with
+	 * GL_DEPTH_TEXTURE_MODE of GL_LUMINANCE.
+	 */
+	int components;
+
+	/** width * height * depth * components values, x fastest. */
+	const float *texels;
+};
+
+/** Sampler and texture object state that affects sampling. */
+struct piglit_sampler {
+	/** 1, 2 or 3; only the first \a dimensions coordinates are used. */
+	int dimensions;
+	enum piglit_sampler_type type;
+
+	/** Decode the RGB channels of texels from sRGB before filtering. */
+	bool srgb;
+
+	/**
+	 * Coordinates are in texels rather than normalized, as for
+	 * rectangle textures.
+	 */
+	bool unnormalized;
+
+	GLenum wrap[3];
+	GLenum min_filter;
+	GLenum mag_filter;
+	float border_color[4];
+
+	float lod_bias;
+	float min_lod;
+	float max_lod;
+	int base_level;
+	int max_level;
+
+	/** GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA, GL_ZERO or GL_ONE. */
+	GLenum swizzle[4];
+};
+
+/** Mipmap levels chosen for a level of detail. */
+struct piglit_sampler_levels {
+	/** True if the magnification filter applies. */
+	bool magnify;
+	/** Levels to sample, and the weight of the second. */
+	int level[2];
+	float weight;
+};
+
+/**
+ * Initialize \a s to GL's default sampler state for a texture with the
+ * given number of dimensions.
+ */
+void
+piglit_sampler_init(struct piglit_sampler *s, int dimensions);
+
+/**
+ * Return the level of detail for scale factor \a rho (GL's ρ) and a
+ * shader-supplied \a bias, after the sampler's bias and LOD clamps.
+ */
+float
+piglit_sampler_lod(const struct piglit_sampler *s, float rho, float bias);
+
+/**
+ * Choose the mipmap levels sampled at level of detail \a lod for a
+ * texture whose mipmap array ends at \a last_level.
+ */
+void
+piglit_sampler_select_levels(const struct piglit_sampler *s, int last_level,
+			     float lod, struct piglit_sampler_levels *levels);
+
+/**
+ * Sample the texture whose mipmap levels are levels[0..num_levels-1]
+ * at \a count texture coordinates.
+ *
+ * \param coords  count (s, t, r) triples
+ * \param lods    level of detail for each coordinate, or NULL for 0
+ * \param out     receives count RGBA results
+ */
+void
+piglit_sampler_sample(const struct piglit_sampler *s,
+		      const struct piglit_sampler_image *levels,
+		      int num_levels, int count, const float *coords,
+		      const float *lods, float *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIGLIT_SAMPLER_H */
@@ -0,0 +1,1256 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-texcompress.c
+ *
+ * Block-compressed texture codecs; see piglit-texcompress.h.
+ *
+ * The BPTC mode and anchor tables were moved here from bptc-modes.c and
+ * bptc-float-modes.c.  The partition tables are those of the
+ * ARB_texture_compression_bptc specification.
+ */
+
+#include "piglit-texcompress.h"
+
+#include <assert.h>
+
+#define BLOCK_SIZE 4
+#define N_PARTITIONS 64
+
+/* ------------------------------------------------------------------ */
+/* Bit streams                                                         */
+/* ------------------------------------------------------------------ */
+
+static void
+write_bits(uint8_t *out,
+	   int *offset,
+	   int value,
+	   int n_bits)
+{
+	int bit_index = *offset % 8;
+	int byte_index = *offset / 8;
+	int n_bits_in_byte = MIN2(n_bits, 8 - bit_index);
+
+	*offset += n_bits;
+
+	while (n_bits > 0) {
+		out[byte_index] |= ((value & ((1 << n_bits_in_byte) - 1)) <<
+				    bit_index);
+
+		n_bits -= n_bits_in_byte;
+		value >>= n_bits_in_byte;
+		byte_index++;
+		bit_index = 0;
+		n_bits_in_byte = MIN2(n_bits, 8);
+	}
+}
+
+static int
+read_bits(const uint8_t *in,
+	  int *offset,
+	  int n_bits)
+{
+	int value = 0;
+	int bit;
+
+	for (bit = 0; bit < n_bits; bit++) {
+		const int pos = *offset + bit;
+		value |= ((in[pos / 8] >> (pos % 8)) & 1) << bit;
+	}
+
+	*offset += n_bits;
+
+	return value;
+}
+
+/* ------------------------------------------------------------------ */
+/* BPTC tables                                                         */
+/* ------------------------------------------------------------------ */
+
+struct bptc_mode {
+	int n_subsets;
+	int n_partition_bits;
+	bool has_rotation_bits;
+	bool has_index_selection_bit;
+	int n_color_bits;
+	int n_alpha_bits;
+	bool has_endpoint_pbits;
+	bool has_shared_pbits;
+	int n_index_bits;
+	int n_secondary_index_bits;
+};
+
+static const struct bptc_mode
+bptc_modes[] = {
+	/* 0 */ { 3, 4, false, false, 4, 0, true,  false, 3, 0 },
+	/* 1 */ { 2, 6, false, false, 6, 0, false, true,  3, 0 },
+	/* 2 */ { 3, 6, false, false, 5, 0, false, false, 2, 0 },
+	/* 3 */ { 2, 6, false, false, 7, 0, true,  false, 2, 0 },
+	/* 4 */ { 1, 0, true,  true,  5, 6, false, false, 2, 3 },
+	/* 5 */ { 1, 0, true,  false, 7, 8, false, false, 2, 2 },
+	/* 6 */ { 1, 0, false, false, 7, 7, true,  false, 4, 0 },
+	/* 7 */ { 2, 6, false, false, 5, 5, true,  false, 2, 0 }
+};
+
+static const uint8_t
+anchor_indices[][N_PARTITIONS] = {
+	/* Anchor index values for the second subset of two-subset
+	 * partitioning */
+	{
+		0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,
+		0xf,0x2,0x8,0x2,0x2,0x8,0x8,0xf,0x2,0x8,0x2,0x2,0x8,0x8,0x2,0x2,
+		0xf,0xf,0x6,0x8,0x2,0x8,0xf,0xf,0x2,0x8,0x2,0x2,0x2,0xf,0xf,0x6,
+		0x6,0x2,0x6,0x8,0xf,0xf,0x2,0x2,0xf,0xf,0xf,0xf,0xf,0x2,0x2,0xf
+	},
+
+	/* Anchor index values for the second subset of three-subset
+	 * partitioning */
+	{
+		0x3,0x3,0xf,0xf,0x8,0x3,0xf,0xf,0x8,0x8,0x6,0x6,0x6,0x5,0x3,0x3,
+		0x3,0x3,0x8,0xf,0x3,0x3,0x6,0xa,0x5,0x8,0x8,0x6,0x8,0x5,0xf,0xf,
+		0x8,0xf,0x3,0x5,0x6,0xa,0x8,0xf,0xf,0x3,0xf,0x5,0xf,0xf,0xf,0xf,
+		0x3,0xf,0x5,0x5,0x5,0x8,0x5,0xa,0x5,0xa,0x8,0xd,0xf,0xc,0x3,0x3
+	},
+
+	/* Anchor index values for the third subset of three-subset
+	 * partitioning
+	 */
+	{
+		0xf,0x8,0x8,0x3,0xf,0xf,0x3,0x8,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0x8,
+		0xf,0x8,0xf,0x3,0xf,0x8,0xf,0x8,0x3,0xf,0x6,0xa,0xf,0xf,0xa,0x8,
+		0xf,0x3,0xf,0xa,0xa,0x8,0x9,0xa,0x6,0xf,0x8,0xf,0x3,0x6,0x6,0x8,
+		0xf,0x3,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0xf,0x3,0xf,0xf,0x8
+	}
+};
+
+/**
+ * Two-subset partitions.  Bit n is set if texel n (in row-major order)
+ * belongs to the second subset.
+ */
+static const uint16_t
+partition_table2[N_PARTITIONS] = {
+	0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+	0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+	0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+	0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+	0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+	0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+	0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+	0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+};
+
+/** Three-subset partitions, giving the subset of each texel. */
+static const uint8_t
+partition_table3[N_PARTITIONS][BLOCK_SIZE * BLOCK_SIZE] = {
+	{ 0,0,1,1, 0,0,1,1, 0,2,2,1, 2,2,2,2 },
+	{ 0,0,0,1, 0,0,1,1, 2,2,1,1, 2,2,2,1 },
+	{ 0,0,0,0, 2,0,0,1, 2,2,1,1, 2,2,1,1 },
+	{ 0,2,2,2, 0,0,2,2, 0,0,1,1, 0,1,1,1 },
+	{ 0,0,0,0, 0,0,0,0, 1,1,2,2, 1,1,2,2 },
+	{ 0,0,1,1, 0,0,1,1, 0,0,2,2, 0,0,2,2 },
+	{ 0,0,2,2, 0,0,2,2, 1,1,1,1, 1,1,1,1 },
+	{ 0,0,1,1, 0,0,1,1, 2,2,1,1, 2,2,1,1 },
+	{ 0,0,0,0, 0,0,0,0, 1,1,1,1, 2,2,2,2 },
+	{ 0,0,0,0, 1,1,1,1, 1,1,1,1, 2,2,2,2 },
+	{ 0,0,0,0, 1,1,1,1, 2,2,2,2, 2,2,2,2 },
+	{ 0,0,1,2, 0,0,1,2, 0,0,1,2, 0,0,1,2 },
+	{ 0,1,1,2, 0,1,1,2, 0,1,1,2, 0,1,1,2 },
+	{ 0,1,2,2, 0,1,2,2, 0,1,2,2, 0,1,2,2 },
+	{ 0,0,1,1, 0,1,1,2, 1,1,2,2, 1,2,2,2 },
+	{ 0,0,1,1, 2,0,0,1, 2,2,0,0, 2,2,2,0 },
+	{ 0,0,0,1, 0,0,1,1, 0,1,1,2, 1,1,2,2 },
+	{ 0,1,1,1, 0,0,1,1, 2,0,0,1, 2,2,0,0 },
+	{ 0,0,0,0, 1,1,2,2, 1,1,2,2, 1,1,2,2 },
+	{ 0,0,2,2, 0,0,2,2, 0,0,2,2, 1,1,1,1 },
+	{ 0,1,1,1, 0,1,1,1, 0,2,2,2, 0,2,2,2 },
+	{ 0,0,0,1, 0,0,0,1, 2,2,2,1, 2,2,2,1 },
+	{ 0,0,0,0, 0,0,1,1, 0,1,2,2, 0,1,2,2 },
+	{ 0,0,0,0, 1,1,0,0, 2,2,1,0, 2,2,1,0 },
+	{ 0,1,2,2, 0,1,2,2, 0,0,1,1, 0,0,0,0 },
+	{ 0,0,1,2, 0,0,1,2, 1,1,2,2, 2,2,2,2 },
+	{ 0,1,1,0, 1,2,2,1, 1,2,2,1, 0,1,1,0 },
+	{ 0,0,0,0, 0,1,1,0, 1,2,2,1, 1,2,2,1 },
+	{ 0,0,2,2, 1,1,0,2, 1,1,0,2, 0,0,2,2 },
+	{ 0,1,1,0, 0,1,1,0, 2,0,0,2, 2,2,2,2 },
+	{ 0,0,1,1, 0,1,2,2, 0,1,2,2, 0,0,1,1 },
+	{ 0,0,0,0, 2,0,0,0, 2,2,1,1, 2,2,2,1 },
+	{ 0,0,0,0, 0,0,0,2, 1,1,2,2, 1,2,2,2 },
+	{ 0,2,2,2, 0,0,2,2, 0,0,1,2, 0,0,1,1 },
+	{ 0,0,1,1, 0,0,1,2, 0,0,2,2, 0,2,2,2 },
+	{ 0,1,2,0, 0,1,2,0, 0,1,2,0, 0,1,2,0 },
+	{ 0,0,0,0, 1,1,1,1, 2,2,2,2, 0,0,0,0 },
+	{ 0,1,2,0, 1,2,0,1, 2,0,1,2, 0,1,2,0 },
+	{ 0,1,2,0, 2,0,1,2, 1,2,0,1, 0,1,2,0 },
+	{ 0,0,1,1, 2,2,0,0, 1,1,2,2, 0,0,1,1 },
+	{ 0,0,1,1, 1,1,2,2, 2,2,0,0, 0,0,1,1 },
+	{ 0,1,0,1, 0,1,0,1, 2,2,2,2, 2,2,2,2 },
+	{ 0,0,0,0, 0,0,0,0, 2,1,2,1, 2,1,2,1 },
+	{ 0,0,2,2, 1,1,2,2, 0,0,2,2, 1,1,2,2 },
+	{ 0,0,2,2, 0,0,1,1, 0,0,2,2, 0,0,1,1 },
+	{ 0,2,2,0, 1,2,2,1, 0,2,2,0, 1,2,2,1 },
+	{ 0,1,0,1, 2,2,2,2, 2,2,2,2, 0,1,0,1 },
+	{ 0,0,0,0, 2,1,2,1, 2,1,2,1, 2,1,2,1 },
+	{ 0,1,0,1, 0,1,0,1, 0,1,0,1, 2,2,2,2 },
+	{ 0,2,2,2, 0,1,1,1, 0,2,2,2, 0,1,1,1 },
+	{ 0,0,0,2, 1,1,1,2, 0,0,0,2, 1,1,1,2 },
+	{ 0,0,0,0, 2,1,1,2, 2,1,1,2, 2,1,1,2 },
+	{ 0,2,2,2, 0,1,1,1, 0,1,1,1, 0,2,2,2 },
+	{ 0,0,0,2, 1,1,1,2, 1,1,1,2, 0,0,0,2 },
+	{ 0,1,1,0, 0,1,1,0, 0,1,1,0, 2,2,2,2 },
+	{ 0,0,0,0, 0,0,0,0, 2,1,1,2, 2,1,1,2 },
+	{ 0,1,1,0, 0,1,1,0, 2,2,2,2, 2,2,2,2 },
+	{ 0,0,2,2, 0,0,1,1, 0,0,1,1, 0,0,2,2 },
+	{ 0,0,2,2, 1,1,2,2, 1,1,2,2, 0,0,2,2 },
+	{ 0,0,0,0, 0,0,0,0, 0,0,0,0, 2,1,1,2 },
+	{ 0,0,0,2, 0,0,0,1, 0,0,0,2, 0,0,0,1 },
+	{ 0,2,2,2, 1,2,2,2, 0,2,2,2, 1,2,2,2 },
+	{ 0,1,0,1, 2,2,2,2, 2,2,2,2, 2,2,2,2 },
+	{ 0,1,1,1, 2,0,1,1, 2,2,0,1, 2,2,2,0 },
+};
+
+static const uint8_t weights2[] = { 0, 21, 43, 64 };
+static const uint8_t weights3[] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const uint8_t weights4[] = {
+	0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+};
+
+static const uint8_t *
+bptc_weights(int n_bits)
+{
+	switch (n_bits) {
+	case 2:
+		return weights2;
+	case 3:
+		return weights3;
+	default:
+		return weights4;
+	}
+}
+
+static int
+bptc_subset(int n_subsets, int partition, int texel)
+{
+	switch (n_subsets) {
+	case 2:
+		return (partition_table2[partition] >> texel) & 1;
+	case 3:
+		return partition_table3[partition][texel];
+	default:
+		return 0;
+	}
+}
+
+static bool
+bptc_is_anchor(int n_subsets, int partition, int texel)
+{
+	if (texel == 0)
+		return true;
+
+	switch (n_subsets) {
+	case 1:
+		return false;
+	case 2:
+		return anchor_indices[0][partition] == texel;
+	case 3:
+		return (anchor_indices[1][partition] == texel ||
+			anchor_indices[2][partition] == texel);
+	default:
+		assert(false);
+		return false;
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* BPTC UNORM                                                          */
+/* ------------------------------------------------------------------ */
+
+void
+piglit_bptc_unorm_write_block(const struct piglit_bptc_unorm_block *block,
+			      uint8_t *out)
+{
+	const struct bptc_mode *mode = bptc_modes + block->mode;
+	int offset = 0;
+	int component;
+	int subset;
+	int endpoint;
+	int n_bits;
+	int i;
+
+	memset(out, 0, PIGLIT_BPTC_BLOCK_BYTES);
+
+	write_bits(out, &offset, 1 << block->mode, block->mode + 1);
+
+	write_bits(out, &offset, block->partition, mode->n_partition_bits);
+
+	write_bits(out, &offset, block->rotation,
+		   mode->has_rotation_bits ? 2 : 0);
+
+	write_bits(out, &offset, block->index_selection,
+		   mode->has_index_selection_bit);
+
+	for (component = 0; component < 3; component++) {
+		for (subset = 0; subset < mode->n_subsets; subset++) {
+			for (endpoint = 0; endpoint < 2; endpoint++) {
+				write_bits(out, &offset,
+					   block->endpoints[subset * 2 +
+							    endpoint][component],
+					   mode->n_color_bits);
+			}
+		}
+	}
+
+	for (subset = 0; subset < mode->n_subsets; subset++) {
+		for (endpoint = 0; endpoint < 2; endpoint++) {
+			write_bits(out, &offset,
+				   block->endpoints[subset * 2 + endpoint][3],
+				   mode->n_alpha_bits);
+		}
+	}
+
+	for (subset = 0; subset < mode->n_subsets; subset++) {
+		for (endpoint = 0; endpoint < 2; endpoint++) {
+			write_bits(out, &offset,
+				   block->pbits[subset * 2 + endpoint],
+				   mode->has_endpoint_pbits);
+		}
+	}
+
+	for (subset = 0; subset < mode->n_subsets; subset++) {
+		write_bits(out, &offset,
+			   block->pbits[subset],
+			   mode->has_shared_pbits);
+	}
+
+	for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+		n_bits = mode->n_index_bits;
+
+		if (bptc_is_anchor(mode->n_subsets, block->partition, i))
+			n_bits--;
+
+		write_bits(out, &offset, block->primary_indices[i], n_bits);
+	}
+
+	if (mode->n_secondary_index_bits) {
+		for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+			n_bits = mode->n_secondary_index_bits;
+
+			if (bptc_is_anchor(mode->n_subsets,
+					   block->partition, i))
+				n_bits--;
+
+			write_bits(out, &offset,
+				   block->secondary_indices[i], n_bits);
+		}
+	}
+
+	assert(offset == PIGLIT_BPTC_BLOCK_BYTES * 8);
+}
+
+/** Expand an \a n_bits endpoint component to 8 bits. */
+static uint8_t
+expand_unorm(int value, int n_bits)
+{
+	value <<= 8 - n_bits;
+	return value | (value >> n_bits);
+}
+
+void
+piglit_bptc_unorm_decode_block(const uint8_t *in, uint8_t out[16 * 4])
+{
+	const struct bptc_mode *mode;
+	struct piglit_bptc_unorm_block block;
+	uint8_t endpoints[2 * 3][4];
+	int mode_num, offset;
+	int component, subset, endpoint;
+	int color_bits, alpha_bits;
+	const uint8_t *color_indices, *alpha_indices;
+	int i, n_bits;
+
+	for (mode_num = 0; mode_num < 8; mode_num++) {
+		if (in[0] & (1 << mode_num))
+			break;
+	}
+	if (mode_num == 8) {
+		/* Reserved mode: every texel is zero. */
+		memset(out, 0, 16 * 4);
+		return;
+	}
+
+	mode = bptc_modes + mode_num;
+	memset(&block, 0, sizeof(block));
+	offset = mode_num + 1;
+
+	block.partition = read_bits(in, &offset, mode->n_partition_bits);
+	block.rotation = read_bits(in, &offset,
+				   mode->has_rotation_bits ? 2 : 0);
+	block.index_selection = read_bits(in, &offset,
+					  mode->has_index_selection_bit);
+
+	for (component = 0; component < 3; component++) {
+		for (subset = 0; subset < mode->n_subsets; subset++) {
+			for (endpoint = 0; endpoint < 2; endpoint++) {
+				block.endpoints[subset * 2 + endpoint][component] =
+					read_bits(in, &offset,
+						  mode->n_color_bits);
+			}
+		}
+	}
+
+	for (i = 0; i < mode->n_subsets * 2; i++)
+		block.endpoints[i][3] = read_bits(in, &offset,
+						  mode->n_alpha_bits);
+
+	if (mode->has_endpoint_pbits) {
+		for (i = 0; i < mode->n_subsets * 2; i++)
+			block.pbits[i] = read_bits(in, &offset, 1);
+	}
+	if (mode->has_shared_pbits) {
+		for (subset = 0; subset < mode->n_subsets; subset++) {
+			block.pbits[subset * 2] = block.pbits[subset * 2 + 1] =
+				read_bits(in, &offset, 1);
+		}
+	}
+
+	for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+		n_bits = mode->n_index_bits;
+		if (bptc_is_anchor(mode->n_subsets, block.partition, i))
+			n_bits--;
+		block.primary_indices[i] = read_bits(in, &offset, n_bits);
+	}
+
+	for (i = 0; mode->n_secondary_index_bits &&
+		    i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+		n_bits = mode->n_secondary_index_bits;
+		if (i == 0)
+			n_bits--;
+		block.secondary_indices[i] = read_bits(in, &offset, n_bits);
+	}
+
+	/* Unquantize the endpoints. */
+	for (i = 0; i < mode->n_subsets * 2; i++) {
+		const bool pbit = (mode->has_endpoint_pbits ||
+				   mode->has_shared_pbits);
+
+		for (component = 0; component < 4; component++) {
+			int value = block.endpoints[i][component];
+
+			n_bits = (component == 3 ?
+				  mode->n_alpha_bits : mode->n_color_bits);
+			if (n_bits == 0) {
+				endpoints[i][component] = 255;
+				continue;
+			}
+			if (pbit) {
+				value = (value << 1) | block.pbits[i];
+				n_bits++;
+			}
+			endpoints[i][component] = expand_unorm(value, n_bits);
+		}
+	}
+
+	if (block.index_selection) {
+		color_indices = block.secondary_indices;
+		alpha_indices = block.primary_indices;
+		color_bits = mode->n_secondary_index_bits;
+		alpha_bits = mode->n_index_bits;
+	} else {
+		color_indices = block.primary_indices;
+		color_bits = mode->n_index_bits;
+		if (mode->n_secondary_index_bits) {
+			alpha_indices = block.secondary_indices;
+			alpha_bits = mode->n_secondary_index_bits;
+		} else {
+			alpha_indices = block.primary_indices;
+			alpha_bits = mode->n_index_bits;
+		}
+	}
+
+	for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+		const uint8_t *e;
+		uint8_t *texel = out + i * 4;
+		int weight, tmp;
+
+		subset = bptc_subset(mode->n_subsets, block.partition, i);
+		e = endpoints[subset * 2];
+
+		weight = bptc_weights(color_bits)[color_indices[i]];
+		for (component = 0; component < 3; component++) {
+			texel[component] = ((64 - weight) * e[component] +
+					    weight * e[4 + component] +
+					    32) >> 6;
+		}
+
+		weight = bptc_weights(alpha_bits)[alpha_indices[i]];
+		texel[3] = ((64 - weight) * e[3] + weight * e[7] + 32) >> 6;
+
+		if (block.rotation) {
+			tmp = texel[3];
+			texel[3] = texel[block.rotation - 1];
+			texel[block.rotation - 1] = tmp;
+		}
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* BPTC float                                                          */
+/* ------------------------------------------------------------------ */
+
+struct bptc_float_bitfield {
+	int8_t endpoint;
+	uint8_t component;
+	uint8_t offset;
+	uint8_t n_bits;
+	bool reverse;
+};
+
+struct bptc_float_mode {
+	int n_partition_bits;
+	int n_index_bits;
+	struct bptc_float_bitfield bitfields[24];
+};
+
+/**
+ * Layout of the endpoint bits of each mode, in the order they appear
+ * in the block.  Reserved modes have no index bits.
+ */
+static const struct bptc_float_mode
+bptc_float_modes[] = {
+	/* 00 */
+	{ 5, 3,
+	  { { 2, 1, 4, 1, false }, { 2, 2, 4, 1, false }, { 3, 2, 4, 1, false },
+	    { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
+	    { 1, 0, 0, 5, false }, { 3, 1, 4, 1, false }, { 2, 1, 0, 4, false },
+	    { 1, 1, 0, 5, false }, { 3, 2, 0, 1, false }, { 3, 1, 0, 4, false },
+	    { 1, 2, 0, 5, false }, { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false },
+	    { 2, 0, 0, 5, false }, { 3, 2, 2, 1, false }, { 3, 0, 0, 5, false },
+	    { 3, 2, 3, 1, false },
+	    { -1 } }
+	},
+	/* 01 */
+	{ 5, 3,
+	  { { 2, 1, 5, 1, false }, { 3, 1, 4, 1, false }, { 3, 1, 5, 1, false },
+	    { 0, 0, 0, 7, false }, { 3, 2, 0, 1, false }, { 3, 2, 1, 1, false },
+	    { 2, 2, 4, 1, false }, { 0, 1, 0, 7, false }, { 2, 2, 5, 1, false },
+	    { 3, 2, 2, 1, false }, { 2, 1, 4, 1, false }, { 0, 2, 0, 7, false },
+	    { 3, 2, 3, 1, false }, { 3, 2, 5, 1, false }, { 3, 2, 4, 1, false },
+	    { 1, 0, 0, 6, false }, { 2, 1, 0, 4, false }, { 1, 1, 0, 6, false },
+	    { 3, 1, 0, 4, false }, { 1, 2, 0, 6, false }, { 2, 2, 0, 4, false },
+	    { 2, 0, 0, 6, false },
+	    { 3, 0, 0, 6, false },
+	    { -1 } }
+	},
+	/* 00010 */
+	{ 5, 3,
+	  { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
+	    { 1, 0, 0, 5, false }, { 0, 0, 10, 1, false }, { 2, 1, 0, 4, false },
+	    { 1, 1, 0, 4, false }, { 0, 1, 10, 1, false }, { 3, 2, 0, 1, false },
+	    { 3, 1, 0, 4, false }, { 1, 2, 0, 4, false }, { 0, 2, 10, 1, false },
+	    { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 5, false },
+	    { 3, 2, 2, 1, false }, { 3, 0, 0, 5, false }, { 3, 2, 3, 1, false },
+	    { -1 } }
+	},
+	/* 00011 */
+	{ 0, 4,
+	  { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
+	    { 1, 0, 0, 10, false }, { 1, 1, 0, 10, false }, { 1, 2, 0, 10, false },
+	    { -1 } }
+	},
+	/* 00110 */
+	{ 5, 3,
+	  { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
+	    { 1, 0, 0, 4, false }, { 0, 0, 10, 1, false }, { 3, 1, 4, 1, false },
+	    { 2, 1, 0, 4, false }, { 1, 1, 0, 5, false }, { 0, 1, 10, 1, false },
+	    { 3, 1, 0, 4, false }, { 1, 2, 0, 4, false }, { 0, 2, 10, 1, false },
+	    { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 4, false },
+	    { 3, 2, 0, 1, false }, { 3, 2, 2, 1, false }, { 3, 0, 0, 4, false },
+	    { 2, 1, 4, 1, false }, { 3, 2, 3, 1, false },
+	    { -1 } }
+	},
+	/* 00111 */
+	{ 0, 4,
+	  { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
+	    { 1, 0, 0, 9, false }, { 0, 0, 10, 1, false }, { 1, 1, 0, 9, false },
+	    { 0, 1, 10, 1, false }, { 1, 2, 0, 9, false }, { 0, 2, 10, 1, false },
+	    { -1 } }
+	},
+	/* 01010 */
+	{ 5, 3,
+	  { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
+	    { 1, 0, 0, 4, false }, { 0, 0, 10, 1, false }, { 2, 2, 4, 1, false },
+	    { 2, 1, 0, 4, false }, { 1, 1, 0, 4, false }, { 0, 1, 10, 1, false },
+	    { 3, 2, 0, 1, false }, { 3, 1, 0, 4, false }, { 1, 2, 0, 5, false },
+	    { 0, 2, 10, 1, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 4, false },
+	    { 3, 2, 1, 1, false }, { 3, 2, 2, 1, false }, { 3, 0, 0, 4, false },
+	    { 3, 2, 4, 1, false }, { 3, 2, 3, 1, false },
+	    { -1 } }
+	},
+	/* 01011 */
+	{ 0, 4,
+	  { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
+	    { 1, 0, 0, 8, false }, { 0, 0, 10, 2, true }, { 1, 1, 0, 8, false },
+	    { 0, 1, 10, 2, true }, { 1, 2, 0, 8, false }, { 0, 2, 10, 2, true },
+	    { -1 } }
+	},
+	/* 01110 */
+	{ 5, 3,
+	  { { 0, 0, 0, 9, false }, { 2, 2, 4, 1, false }, { 0, 1, 0, 9, false },
+	    { 2, 1, 4, 1, false }, { 0, 2, 0, 9, false }, { 3, 2, 4, 1, false },
+	    { 1, 0, 0, 5, false }, { 3, 1, 4, 1, false }, { 2, 1, 0, 4, false },
+	    { 1, 1, 0, 5, false }, { 3, 2, 0, 1, false }, { 3, 1, 0, 4, false },
+	    { 1, 2, 0, 5, false }, { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false },
+	    { 2, 0, 0, 5, false }, { 3, 2, 2, 1, false }, { 3, 0, 0, 5, false },
+	    { 3, 2, 3, 1, false },
+	    { -1 } }
+	},
+	/* 01111 */
+	{ 0, 4,
+	  { { 0, 0, 0, 10, false }, { 0, 1, 0, 10, false }, { 0, 2, 0, 10, false },
+	    { 1, 0, 0, 4, false }, { 0, 0, 10, 6, true }, { 1, 1, 0, 4, false },
+	    { 0, 1, 10, 6, true }, { 1, 2, 0, 4, false }, { 0, 2, 10, 6, true },
+	    { -1 } }
+	},
+	/* 10010 */
+	{ 5, 3,
+	  { { 0, 0, 0, 8, false }, { 3, 1, 4, 1, false }, { 2, 2, 4, 1, false },
+	    { 0, 1, 0, 8, false }, { 3, 2, 2, 1, false }, { 2, 1, 4, 1, false },
+	    { 0, 2, 0, 8, false }, { 3, 2, 3, 1, false }, { 3, 2, 4, 1, false },
+	    { 1, 0, 0, 6, false }, { 2, 1, 0, 4, false }, { 1, 1, 0, 5, false },
+	    { 3, 2, 0, 1, false }, { 3, 1, 0, 4, false }, { 1, 2, 0, 5, false },
+	    { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 6, false },
+	    { 3, 0, 0, 6, false },
+	    { -1 } }
+	},
+	/* 10011 */
+	{ /* reserved */ },
+	/* 10110 */
+	{ 5, 3,
+	  { { 0, 0, 0, 8, false }, { 3, 2, 0, 1, false }, { 2, 2, 4, 1, false },
+	    { 0, 1, 0, 8, false }, { 2, 1, 5, 1, false }, { 2, 1, 4, 1, false },
+	    { 0, 2, 0, 8, false }, { 3, 1, 5, 1, false }, { 3, 2, 4, 1, false },
+	    { 1, 0, 0, 5, false }, { 3, 1, 4, 1, false }, { 2, 1, 0, 4, false },
+	    { 1, 1, 0, 6, false }, { 3, 1, 0, 4, false }, { 1, 2, 0, 5, false },
+	    { 3, 2, 1, 1, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 5, false },
+	    { 3, 2, 2, 1, false }, { 3, 0, 0, 5, false }, { 3, 2, 3, 1, false },
+	    { -1 } }
+	},
+	/* 10111 */
+	{ /* reserved */ },
+	/* 11010 */
+	{ 5, 3,
+	  { { 0, 0, 0, 8, false }, { 3, 2, 1, 1, false }, { 2, 2, 4, 1, false },
+	    { 0, 1, 0, 8, false }, { 2, 2, 5, 1, false }, { 2, 1, 4, 1, false },
+	    { 0, 2, 0, 8, false }, { 3, 2, 5, 1, false }, { 3, 2, 4, 1, false },
+	    { 1, 0, 0, 5, false }, { 3, 1, 4, 1, false }, { 2, 1, 0, 4, false },
+	    { 1, 1, 0, 5, false }, { 3, 2, 0, 1, false }, { 3, 1, 0, 4, false },
+	    { 1, 2, 0, 6, false }, { 2, 2, 0, 4, false }, { 2, 0, 0, 5, false },
+	    { 3, 2, 2, 1, false }, { 3, 0, 0, 5, false }, { 3, 2, 3, 1, false },
+	    { -1 } }
+	},
+	/* 11011 */
+	{ /* reserved */ },
+	/* 11110 */
+	{ 5, 3,
+	  { { 0, 0, 0, 6, false }, { 3, 1, 4, 1, false }, { 3, 2, 0, 1, false },
+	    { 3, 2, 1, 1, false }, { 2, 2, 4, 1, false }, { 0, 1, 0, 6, false },
+	    { 2, 1, 5, 1, false }, { 2, 2, 5, 1, false }, { 3, 2, 2, 1, false },
+	    { 2, 1, 4, 1, false }, { 0, 2, 0, 6, false }, { 3, 1, 5, 1, false },
+	    { 3, 2, 3, 1, false }, { 3, 2, 5, 1, false }, { 3, 2, 4, 1, false },
+	    { 1, 0, 0, 6, false }, { 2, 1, 0, 4, false }, { 1, 1, 0, 6, false },
+	    { 3, 1, 0, 4, false }, { 1, 2, 0, 6, false }, { 2, 2, 0, 4, false },
+	    { 2, 0, 0, 6, false }, { 3, 0, 0, 6, false },
+	    { -1 } }
+	},
+	/* 11111 */
+	{ /* reserved */ },
+};
+
+static const struct bptc_float_mode *
+bptc_float_mode(int mode)
+{
+	if (mode >= 2)
+		return (bptc_float_modes +
+			(((mode >> 1) & 0xe) | (mode & 1))) + 2;
+	else
+		return bptc_float_modes + (mode & 1);
+}
+
+static uint16_t
+reverse_bits(uint16_t value, int n_bits)
+{
+	uint16_t tmp = 0;
+	int i;
+
+	for (i = 0; i < n_bits; i++) {
+		tmp <<= 1;
+		if (value & 1)
+			tmp |= 1;
+		value >>= 1;
+	}
+
+	return tmp;
+}
+
+static uint16_t
+extract_bitfield(const struct piglit_bptc_float_block *block,
+		 const struct bptc_float_bitfield *bitfield)
+{
+	uint16_t value;
+
+	value = ((block->endpoints[bitfield->endpoint][bitfield->component] >>
+		  bitfield->offset) &
+		 ((1 << bitfield->n_bits) - 1));
+
+	if (bitfield->reverse)
+		return reverse_bits(value, bitfield->n_bits);
+	else
+		return value;
+}
+
+void
+piglit_bptc_float_write_block(const struct piglit_bptc_float_block *block,
+			      uint8_t *out)
+{
+	const struct bptc_float_mode *mode = bptc_float_mode(block->mode);
+	const struct bptc_float_bitfield *bitfield;
+	int n_subsets = mode->n_partition_bits ? 2 : 1;
+	int offset = 0;
+	int n_bits;
+	uint16_t value;
+	int i;
+
+	memset(out, 0, PIGLIT_BPTC_BLOCK_BYTES);
+
+	if (block->mode < 2)
+		write_bits(out, &offset, block->mode, 2);
+	else
+		write_bits(out, &offset, block->mode, 5);
+
+	for (bitfield = mode->bitfields; bitfield->endpoint != -1; bitfield++) {
+		value = extract_bitfield(block, bitfield);
+		write_bits(out, &offset, value, bitfield->n_bits);
+	}
+
+	write_bits(out, &offset, block->partition, mode->n_partition_bits);
+
+	for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+		n_bits = mode->n_index_bits;
+
+		if (bptc_is_anchor(n_subsets, block->partition, i))
+			n_bits--;
+
+		write_bits(out, &offset, block->indices[i], n_bits);
+	}
+
+	assert(offset == PIGLIT_BPTC_BLOCK_BYTES * 8);
+}
+
+static int32_t
+sign_extend(int32_t value, int n_bits)
+{
+	if (value & (1 << (n_bits - 1)))
+		value |= -(1 << n_bits);
+	return value;
+}
+
+static int32_t
+unquantize_float(int32_t value, int n_bits, bool is_signed)
+{
+	bool sign = false;
+
+	if (is_signed) {
+		if (n_bits >= 16 || value == 0)
+			return value;
+
+		if (value < 0) {
+			sign = true;
+			value = -value;
+		}
+
+		if (value >= (1 << (n_bits - 1)) - 1)
+			value = 0x7fff;
+		else
+			value = ((value << 15) + 0x4000) >> (n_bits - 1);
+
+		return sign ? -value : value;
+	} else {
+		if (n_bits >= 15 || value == 0)
+			return value;
+		if (value == (1 << n_bits) - 1)
+			return 0xffff;
+		return ((value << 15) + 0x4000) >> (n_bits - 1);
+	}
+}
+
+static uint16_t
+finish_unquantize(int32_t value, bool is_signed)
+{
+	if (!is_signed)
+		return (value * 31) >> 6;
+
+	if (value < 0)
+		return 0x8000 | (((-value) * 31) >> 5);
+	else
+		return (value * 31) >> 5;
+}
+
+void
+piglit_bptc_float_decode_block(const uint8_t *in, bool is_signed,
+			       uint16_t out[16 * 3])
+{
+	const struct bptc_float_mode *mode;
+	const struct bptc_float_bitfield *bitfield;
+	struct piglit_bptc_float_block block;
+	int32_t endpoints[2 * 2][3];
+	int n_bits[2 * 2][3];
+	int n_subsets, offset, i, e, c;
+	bool transformed;
+
+	memset(&block, 0, sizeof(block));
+	offset = 0;
+	if ((in[0] & 3) < 2)
+		block.mode = read_bits(in, &offset, 2);
+	else
+		block.mode = read_bits(in, &offset, 5);
+
+	mode = bptc_float_mode(block.mode);
+	if (mode->n_index_bits == 0) {
+		/* Reserved mode: every texel is zero. */
+		memset(out, 0, 16 * 3 * sizeof(uint16_t));
+		return;
+	}
+	n_subsets = mode->n_partition_bits ? 2 : 1;
+
+	/* The precision of each endpoint is the highest bit any of the
+	 * mode's bitfields reach. */
+	memset(n_bits, 0, sizeof(n_bits));
+	for (bitfield = mode->bitfields; bitfield->endpoint != -1; bitfield++) {
+		int value = read_bits(in, &offset, bitfield->n_bits);
+		int *bits = &n_bits[bitfield->endpoint][bitfield->component];
+
+		if (bitfield->reverse)
+			value = reverse_bits(value, bitfield->n_bits);
+		block.endpoints[bitfield->endpoint][bitfield->component] |=
+			value << bitfield->offset;
+		*bits = MAX2(*bits, bitfield->offset + bitfield->n_bits);
+	}
+
+	block.partition = read_bits(in, &offset, mode->n_partition_bits);
+
+	for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+		int bits = mode->n_index_bits;
+		if (bptc_is_anchor(n_subsets, block.partition, i))
+			bits--;
+		block.indices[i] = read_bits(in, &offset, bits);
+	}
+
+	/* Endpoints with fewer bits than the base endpoint are deltas. */
+	transformed = n_bits[1][0] < n_bits[0][0];
+
+	for (e = 0; e < n_subsets * 2; e++) {
+		for (c = 0; c < 3; c++) {
+			const int base_bits = n_bits[0][c];
+			int32_t value = block.endpoints[e][c];
+
+			if (e > 0 && transformed) {
+				value = sign_extend(value, n_bits[e][c]);
+				value = (block.endpoints[0][c] + value) &
+					((1 << base_bits) - 1);
+			}
+			if (is_signed)
+				value = sign_extend(value, base_bits);
+
+			endpoints[e][c] = unquantize_float(value, base_bits,
+							   is_signed);
+		}
+	}
+
+	for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+		const int subset = bptc_subset(n_subsets, block.partition, i);
+		const int weight =
+			bptc_weights(mode->n_index_bits)[block.indices[i]];
+		const int32_t *e0 = endpoints[subset * 2];
+		const int32_t *e1 = endpoints[subset * 2 + 1];
+
+		for (c = 0; c < 3; c++) {
+			int32_t value = ((64 - weight) * e0[c] +
+					 weight * e1[c] + 32) >> 6;
+			out[i * 3 + c] = finish_unquantize(value, is_signed);
+		}
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* S3TC and RGTC                                                       */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Decode the colour half of an S3TC block.  Texels in the
+ * three-colour mode's black are given \a black_alpha.
+ */
+static void
+decode_s3tc_color(const uint8_t *in, bool allow_three_color,
+		  float black_alpha, float *out, int stride)
+{
+	const int c0 = in[0] | (in[1] << 8);
+	const int c1 = in[2] | (in[3] << 8);
+	const uint32_t bits = (in[4] | (in[5] << 8) | (in[6] << 16) |
+			       ((uint32_t) in[7] << 24));
+	float colors[4][4];
+	int c, i;
+
+	for (i = 0; i < 2; i++) {
+		const int v = i ? c1 : c0;
+		colors[i][0] = ((v >> 11) << 3 | (v >> 13)) / 255.0f;
+		colors[i][1] = (((v >> 5) & 0x3f) << 2 |
+				((v >> 9) & 0x3)) / 255.0f;
+		colors[i][2] = ((v & 0x1f) << 3 | ((v >> 2) & 0x7)) / 255.0f;
+		colors[i][3] = 1.0f;
+	}
+
+	for (c = 0; c < 3; c++) {
+		if (c0 > c1 || !allow_three_color) {
+			colors[2][c] = (2 * colors[0][c] + colors[1][c]) / 3;
+			colors[3][c] = (colors[0][c] + 2 * colors[1][c]) / 3;
+		} else {
+			colors[2][c] = (colors[0][c] + colors[1][c]) / 2;
+			colors[3][c] = 0.0f;
+		}
+	}
+	colors[2][3] = 1.0f;
+	colors[3][3] = (c0 > c1 || !allow_three_color) ? 1.0f : black_alpha;
+
+	for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+		float *texel = out + (i / 4) * stride + (i % 4) * 4;
+		memcpy(texel, colors[(bits >> (i * 2)) & 3], 4 * sizeof(float));
+	}
+}
+
+/**
+ * Decode an RGTC channel (also the alpha of DXT5) into component
+ * \a component of each texel.
+ */
+static void
+decode_rgtc_channel(const uint8_t *in, bool is_signed,
+		    float *out, int stride, int component)
+{
+	uint64_t bits = 0;
+	float values[8];
+	int a0, a1, i;
+	float lo, hi;
+
+	if (is_signed) {
+		/* -128 decodes to -1.0 like -127, but the mode is chosen
+		 * by comparing the raw values. */
+		a0 = (int8_t) in[0];
+		a1 = (int8_t) in[1];
+		lo = -1.0f;
+		hi = 1.0f;
+		values[0] = MAX2(a0, -127) / 127.0f;
+		values[1] = MAX2(a1, -127) / 127.0f;
+	} else {
+		a0 = in[0];
+		a1 = in[1];
+		lo = 0.0f;
+		hi = 1.0f;
+		values[0] = a0 / 255.0f;
+		values[1] = a1 / 255.0f;
+	}
+
+	if (a0 > a1) {
+		for (i = 2; i < 8; i++)
+			values[i] = ((8 - i) * values[0] +
+				     (i - 1) * values[1]) / 7;
+	} else {
+		for (i = 2; i < 6; i++)
+			values[i] = ((6 - i) * values[0] +
+				     (i - 1) * values[1]) / 5;
+		values[6] = lo;
+		values[7] = hi;
+	}
+
+	for (i = 0; i < 6; i++)
+		bits |= (uint64_t) in[2 + i] << (i * 8);
+
+	for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+		float *texel = out + (i / 4) * stride + (i % 4) * 4;
+		texel[component] = values[(bits >> (i * 3)) & 7];
+	}
+}
+
+static void
+fill_channel(float *out, int stride, int component, float value)
+{
+	int i;
+
+	for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++)
+		out[(i / 4) * stride + (i % 4) * 4 + component] = value;
+}
+
+/* ------------------------------------------------------------------ */
+/* ETC1                                                                */
+/* ------------------------------------------------------------------ */
+
+static const int etc1_modifiers[8][2] = {
+	{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 },
+	{ 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+static void
+decode_etc1(const uint8_t *in, float *out, int stride)
+{
+	const uint32_t high = ((uint32_t) in[0] << 24 | in[1] << 16 |
+			       in[2] << 8 | in[3]);
+	const uint32_t low = ((uint32_t) in[4] << 24 | in[5] << 16 |
+			      in[6] << 8 | in[7]);
+	const bool diff = (high >> 1) & 1;
+	const bool flip = high & 1;
+	int base[2][3];
+	int x, y, c, i;
+
+	for (c = 0; c < 3; c++) {
+		const int shift = 24 - c * 8;
+
+		if (diff) {
+			int v = (high >> (shift + 3)) & 0x1f;
+			int d = sign_extend((high >> shift) & 0x7, 3);
+
+			base[0][c] = (v << 3) | (v >> 2);
+			v += d;
+			base[1][c] = (v << 3) | (v >> 2);
+		} else {
+			base[0][c] = ((high >> (shift + 4)) & 0xf) * 17;
+			base[1][c] = ((high >> shift) & 0xf) * 17;
+		}
+	}
+
+	for (y = 0; y < BLOCK_SIZE; y++) {
+		for (x = 0; x < BLOCK_SIZE; x++) {
+			const int bit = x * 4 + y;
+			const int subblock = flip ? y >= 2 : x >= 2;
+			const int table = (high >> (subblock ? 2 : 5)) & 7;
+			const int index = (((low >> (bit + 16)) & 1) << 1 |
+					   ((low >> bit) & 1));
+			int modifier = etc1_modifiers[table][index & 1];
+			float *texel = out + y * stride + x * 4;
+
+			if (index & 2)
+				modifier = -modifier;
+
+			for (c = 0; c < 3; c++) {
+				i = CLAMP(base[subblock][c] + modifier, 0, 255);
+				texel[c] = i / 255.0f;
+			}
+			texel[3] = 1.0f;
+		}
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* Images                                                              */
+/* ------------------------------------------------------------------ */
+
+/** Decode one block of \a format into RGBA floats. */
+static void
+decode_block(GLenum format, const uint8_t *in, float *out, int stride)
+{
+	int i, c;
+
+	switch (format) {
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		decode_s3tc_color(in, true, 1.0f, out, stride);
+		break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+		decode_s3tc_color(in, true, 0.0f, out, stride);
+		break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+		decode_s3tc_color(in + 8, false, 1.0f, out, stride);
+		for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+			const int alpha = (in[i / 2] >> ((i & 1) * 4)) & 0xf;
+			out[(i / 4) * stride + (i % 4) * 4 + 3] = alpha / 15.0f;
+		}
+		break;
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+		decode_s3tc_color(in + 8, false, 1.0f, out, stride);
+		decode_rgtc_channel(in, false, out, stride, 3);
+		break;
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+		decode_rgtc_channel(in,
+				    format == GL_COMPRESSED_SIGNED_RED_RGTC1,
+				    out, stride, 0);
+		fill_channel(out, stride, 1, 0.0f);
+		fill_channel(out, stride, 2, 0.0f);
+		fill_channel(out, stride, 3, 1.0f);
+		break;
+	case GL_COMPRESSED_RG_RGTC2:
+	case GL_COMPRESSED_SIGNED_RG_RGTC2:
+		decode_rgtc_channel(in,
+				    format == GL_COMPRESSED_SIGNED_RG_RGTC2,
+				    out, stride, 0);
+		decode_rgtc_channel(in + 8,
+				    format == GL_COMPRESSED_SIGNED_RG_RGTC2,
+				    out, stride, 1);
+		fill_channel(out, stride, 2, 0.0f);
+		fill_channel(out, stride, 3, 1.0f);
+		break;
+	case GL_ETC1_RGB8_OES:
+		decode_etc1(in, out, stride);
+		break;
+	case GL_COMPRESSED_RGBA_BPTC_UNORM: {
+		uint8_t texels[16 * 4];
+
+		piglit_bptc_unorm_decode_block(in, texels);
+		for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+			for (c = 0; c < 4; c++) {
+				out[(i / 4) * stride + (i % 4) * 4 + c] =
+					texels[i * 4 + c] / 255.0f;
+			}
+		}
+		break;
+	}
+	case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+	case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT: {
+		uint16_t texels[16 * 3];
+
+		piglit_bptc_float_decode_block(
+			in, format == GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT,
+			texels);
+		for (i = 0; i < BLOCK_SIZE * BLOCK_SIZE; i++) {
+			float *texel = out + (i / 4) * stride + (i % 4) * 4;
+			for (c = 0; c < 3; c++)
+				texel[c] = piglit_float_from_half(texels[i * 3 + c]);
+			texel[3] = 1.0f;
+		}
+		break;
+	}
+	default:
+		assert(!"unsupported compressed format");
+	}
+}
+
+bool
+piglit_texcompress_is_supported(GLenum format)
+{
+	switch (format) {
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+	case GL_COMPRESSED_RG_RGTC2:
+	case GL_COMPRESSED_SIGNED_RG_RGTC2:
+	case GL_ETC1_RGB8_OES:
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+	case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static unsigned
+block_bytes(GLenum format)
+{
+	unsigned bw, bh, bytes;
+
+	piglit_get_compressed_block_size(format, &bw, &bh, &bytes);
+	assert(bw == BLOCK_SIZE && bh == BLOCK_SIZE);
+
+	return bytes;
+}
+
+void
+piglit_texcompress_decode_image(GLenum format, int width, int height,
+				const void *data, float *out)
+{
+	const uint8_t *in = data;
+	const unsigned bytes = block_bytes(format);
+	float tile[BLOCK_SIZE * BLOCK_SIZE * 4];
+	int bx, by, y;
+
+	for (by = 0; by < height; by += BLOCK_SIZE) {
+		for (bx = 0; bx < width; bx += BLOCK_SIZE) {
+			const int w = MIN2(width - bx, BLOCK_SIZE);
+			const int h = MIN2(height - by, BLOCK_SIZE);
+
+			if (w == BLOCK_SIZE && h == BLOCK_SIZE) {
+				/* Whole blocks go straight to the image. */
+				decode_block(format, in,
+					     out + (by * width + bx) * 4,
+					     width * 4);
+			} else {
+				decode_block(format, in, tile, BLOCK_SIZE * 4);
+				for (y = 0; y < h; y++) {
+					memcpy(out + ((by + y) * width + bx) * 4,
+					       tile + y * BLOCK_SIZE * 4,
+					       w * 4 * sizeof(float));
+				}
+			}
+
+			in += bytes;
+		}
+	}
+}
+
+void
+piglit_texcompress_random_blocks(GLenum format, int n_blocks, void *out)
+{
+	const unsigned bytes = block_bytes(format);
+	uint8_t *block = out;
+	int i, c;
+
+	for (; n_blocks > 0; n_blocks--, block += bytes) {
+		for (i = 0; i < bytes; i++)
+			block[i] = rand() & 0xff;
+
+		switch (format) {
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+			/* Byte 0 selects mode 8, which is reserved. */
+			if (block[0] == 0)
+				block[0] = 1 << (rand() % 8);
+			break;
+		case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+		case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+			/* The reserved five-bit modes are 10011, 10111,
+			 * 11011 and 11111. */
+			if ((block[0] & 0x13) == 0x13)
+				block[0] &= ~0x10;
+			break;
+		case GL_ETC1_RGB8_OES:
+			/* ETC2 gives differential blocks whose second base
+			 * colour overflows a meaning of their own. */
+			if (block[3] & 2) {
+				for (c = 0; c < 3; c++) {
+					int v = block[c] >> 3;
+					int d = sign_extend(block[c] & 7, 3);
+					if (v + d < 0 || v + d > 31)
+						block[3] &= ~2;
+				}
+			}
+			break;
+		}
+	}
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file piglit-texcompress.h
+ *
+ * Reference encoders and decoders for block-compressed texture formats:
+ * S3TC (DXT1, DXT3, DXT5), RGTC, ETC1 and BPTC (both the UNORM and the
+ * float variants).
+ *
+ * The decoders follow the decoding rules in the extension
+ * specifications.  Where those leave the precision of interpolation to
+ * the implementation (S3TC and RGTC) the result is computed exactly, so
+ * a test comparing against a driver needs a tolerance of a couple of
+ * units in the last place of the 8-bit endpoints.  BPTC and ETC1
+ * decoding is exact.
+ *
+ * The BPTC block writers take the fields of a block (mode, partition,
+ * quantized endpoints, indices) and pack them, driven by the same mode
+ * tables the decoders use.
+ */
+
+#ifndef PIGLIT_TEXCOMPRESS_H
+#define PIGLIT_TEXCOMPRESS_H
+
+#include "piglit-util-gl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIGLIT_BPTC_BLOCK_BYTES 16
+
+/** Fields of a GL_COMPRESSED_RGBA_BPTC_UNORM block. */
+struct piglit_bptc_unorm_block {
+	int mode;
+	int partition;
+	int rotation;
+	int index_selection;
+	/** Quantized endpoints, two per subset, without p-bits. */
+	uint8_t endpoints[2 * 3][4];
+	/**
+	 * Per-endpoint p-bits, or one per subset for the modes with
+	 * shared p-bits.
+	 */
+	uint8_t pbits[3 * 2];
+	uint8_t primary_indices[16];
+	uint8_t secondary_indices[16];
+};
+
+/** Fields of a GL_COMPRESSED_RGB_BPTC_*_FLOAT block. */
+struct piglit_bptc_float_block {
+	/** 0 or 1 for the two-bit modes, otherwise the five-bit mode. */
+	int mode;
+	int partition;
+	/**
+	 * Quantized endpoints in the order the specification calls
+	 * w, x, y and z.  For the transformed modes x, y and z hold the
+	 * raw deltas.
+	 */
+	uint16_t endpoints[2 * 2][3];
+	uint8_t indices[16];
+};
+
+/**
+ * Pack \a block into \a out, which must have room for
+ * PIGLIT_BPTC_BLOCK_BYTES bytes.
+ */
+void
+piglit_bptc_unorm_write_block(const struct piglit_bptc_unorm_block *block,
+			      uint8_t *out);
+
+void
+piglit_bptc_float_write_block(const struct piglit_bptc_float_block *block,
+			      uint8_t *out);
+
+/**
+ * Decode a GL_COMPRESSED_RGBA_BPTC_UNORM block into 16 RGBA texels.
+ */
+void
+piglit_bptc_unorm_decode_block(const uint8_t *in, uint8_t out[16 * 4]);
+
+/**
+ * Decode a GL_COMPRESSED_RGB_BPTC_{SIGNED,UNSIGNED}_FLOAT block into 16
+ * RGB texels of half floats.
+ */
+void
+piglit_bptc_float_decode_block(const uint8_t *in, bool is_signed,
+			       uint16_t out[16 * 3]);
+
+/**
+ * Return true if \a format is handled by the functions below: the S3TC,
+ * RGTC and BPTC formats (without their sRGB variants) and
+ * GL_ETC1_RGB8_OES.  piglit_compressed_image_size() gives the size of
+ * an image.
+ */
+bool
+piglit_texcompress_is_supported(GLenum format);
+
+/**
+ * Decode a \a width x \a height image of \a format into RGBA floats,
+ * as glGetTexImage would return them with GL_RGBA and GL_FLOAT.  No
+ * sRGB decoding is done.
+ */
+void
+piglit_texcompress_decode_image(GLenum format, int width, int height,
+				const void *data, float *out);
+
+/**
+ * Fill \a out with \a n_blocks random blocks of \a format, using rand().
+ *
+ * Every block has a well-defined decoding: reserved BPTC modes are
+ * avoided, and ETC1 blocks are never in differential mode with a base
+ * colour that overflows, so they also decode identically as ETC2.
+ */
+void
+piglit_texcompress_random_blocks(GLenum format, int n_blocks, void *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PIGLIT_TEXCOMPRESS_H */
@@ -26,28 +26,60 @@
 <%block filter='fake_whitespace'>\
 #include "piglit-util-gl.h"
 
+/**
+ * The MurmurHash3 finalizer of a seeded value.  This must match
+ * int_hash() in gen_dispatch.py.
+ */
+static uint32_t
+int_hash(uint32_t value, uint32_t seed)
+{
+>-------uint32_t h = value + seed * 0x9e3779b9u;
+
+>-------h ^= h >> 16;
+>-------h *= 0x85ebca6bu;
+>-------h ^= h >> 13;
+>-------h *= 0xc2b2ae35u;
+>-------h ^= h >> 16;
+>-------return h;
+}
+
+/* Minimal perfect hash of the enum values; see PerfectHash in
+ * gen_dispatch.py.
+ */
+static const int32_t enum_hash_displacements[] = {
+% for d in enum_hash.displacements:
+>-------${d},
+% endfor
+};
+
+static const struct {
+>-------GLenum value;
+>-------const char *name;
+} enum_table[] = {
+% for value in enum_hash.keys:
+<% enum = enum_by_value[value] %>\
+>-------{ ${enum.c_num_literal}, "${enum.name}" },
+% endfor
+};
+
 const char*
 piglit_get_gl_enum_name(GLenum param)
 {
->-------switch (param) {
-% for enum in sorted_unique_enums_in_default_namespace:
->-------case ${enum.c_num_literal}: return "${enum.name}";
-% endfor
->-------default: return "(unrecognized enum)";
->-------}
+>-------const uint32_t n = ARRAY_SIZE(enum_table);
+>-------const int32_t d = enum_hash_displacements[int_hash(param, 0) % n];
+>-------const uint32_t slot = d < 0 ? -d - 1 : int_hash(param, d) % n;
+
+>-------if (enum_table[slot].value != param)
+>------->-------return "(unrecognized enum)";
+>-------return enum_table[slot].name;
 }
 
 const char*
 piglit_get_prim_name(GLenum prim)
 {
 <% gl_patches = gl_registry.enums['GL_PATCHES'] %>\
->-------switch (prim) {
-% for enum in sorted_unique_enums_in_default_namespace:
-% if enum.num_value <= gl_patches.num_value:
->-------case ${enum.c_num_literal}: return "${enum.name}";
-% endif
-% endfor
->-------default: return "(unrecognized enum)";
->-------}
+>-------if (prim > ${gl_patches.c_num_literal})
+>------->-------return "(unrecognized enum)";
+>-------return piglit_get_gl_enum_name(prim);
 }
 </%block>\
@@ -24,6 +24,15 @@
 #include "piglit-util-gl.h"
 #include <ctype.h>
 
+#ifdef PIGLIT_HAS_X86_TARGET_ATTRIBUTE
+#include <immintrin.h>
+#endif
+
+#ifdef PIGLIT_HAS_PTHREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
 /**
@@ -173,12 +182,23 @@ const char* piglit_get_gl_error_name(GLenum error)
 #undef CASE
 }
 
+/**
+ * An error that was pending when the GPU probe needed glGetError to
+ * itself, kept for the next piglit_check_gl_error().
+ */
+static GLenum deferred_gl_error = GL_NO_ERROR;
+
 GLboolean
 piglit_check_gl_error_(GLenum expected_error, const char *file, unsigned line)
 {
 	GLenum actual_error;
 
-	actual_error = glGetError();
+	if (deferred_gl_error != GL_NO_ERROR) {
+		actual_error = deferred_gl_error;
+		deferred_gl_error = GL_NO_ERROR;
+	} else {
+		actual_error = glGetError();
+	}
 	if (actual_error == expected_error) {
 		return GL_TRUE;
 	}
@@ -204,6 +224,7 @@ piglit_check_gl_error_(GLenum expected_error, const char *file, unsigned line)
 
 void piglit_reset_gl_error(void)
 {
+	deferred_gl_error = GL_NO_ERROR;
 	while (glGetError() != GL_NO_ERROR) {
 		/* empty */
 	}
@@ -386,6 +407,131 @@ piglit_half_from_float(float val)
 	return result;
 }
 
+/**
+ * Convert a 2-byte half float to a 4-byte float.  NaNs keep their
+ * payload and become quiet NaNs, as with the F16C instructions.
+ */
+float
+piglit_float_from_half(unsigned short val)
+{
+	const int s = (val >> 15) & 0x1;
+	const int e = (val >> 10) & 0x1f;
+	const int m = val & 0x3ff;
+	fi_type fi;
+
+	if (e == 0) {
+		/* zero or denorm */
+		fi.f = ldexpf((float) m, -24);
+	} else if (e == 31 && m == 0) {
+		fi.f = INFINITY;
+	} else if (e == 31) {
+		fi.i = 0x7fc00000 | (m << 13);
+	} else {
+		fi.f = ldexpf((float) (0x400 | m), e - 25);
+	}
+
+	return s ? -fi.f : fi.f;
+}
+
+#ifdef PIGLIT_HAS_X86_TARGET_ATTRIBUTE
+/**
+ * F16C version of piglit_half_from_float_array() for the first
+ * multiple of four values.
+ *
+ * Converting with truncation gives the same result as
+ * piglit_half_from_float() except for NaNs, which that function maps
+ * to 0x7c01 with the input's sign, and magnitudes of 65536 or more,
+ * which it maps to infinity rather than to the largest finite half.
+ */
+__attribute__((target("f16c,sse4.1")))
+static unsigned
+half_from_float_f16c(const float *in, unsigned count, unsigned short *out)
+{
+	const __m128i abs_mask = _mm_set1_epi32(0x7fffffff);
+	const __m128i sign_mask = _mm_set1_epi32(0x8000);
+	const __m128i f32_inf = _mm_set1_epi32(0x7f800000);
+	const __m128i f32_below_65536 = _mm_set1_epi32(0x477fffff);
+	const __m128i half_inf = _mm_set1_epi32(0x7c00);
+	const __m128i half_nan = _mm_set1_epi32(0x7c01);
+	unsigned i;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		const __m128 f = _mm_loadu_ps(in + i);
+		const __m128i bits = _mm_castps_si128(f);
+		const __m128i abs = _mm_and_si128(bits, abs_mask);
+		const __m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16),
+						   sign_mask);
+		const __m128i is_large = _mm_cmpgt_epi32(abs, f32_below_65536);
+		const __m128i is_nan = _mm_cmpgt_epi32(abs, f32_inf);
+		__m128i h;
+
+		h = _mm_cvtepu16_epi32(_mm_cvtps_ph(f, _MM_FROUND_TO_ZERO));
+		h = _mm_blendv_epi8(h, _mm_or_si128(sign, half_inf), is_large);
+		h = _mm_blendv_epi8(h, _mm_or_si128(sign, half_nan), is_nan);
+		_mm_storel_epi64((__m128i *) (out + i), _mm_packus_epi32(h, h));
+	}
+
+	return i;
+}
+
+/**
+ * F16C version of piglit_float_from_half_array() for the first
+ * multiple of four values.
+ */
+__attribute__((target("f16c")))
+static unsigned
+float_from_half_f16c(const unsigned short *in, unsigned count, float *out)
+{
+	unsigned i;
+
+	for (i = 0; i + 4 <= count; i += 4) {
+		const __m128i h = _mm_loadl_epi64((const __m128i *) (in + i));
+		_mm_storeu_ps(out + i, _mm_cvtph_ps(h));
+	}
+
+	return i;
+}
+#endif /* PIGLIT_HAS_X86_TARGET_ATTRIBUTE */
+
+/**
+ * Convert \a count floats to half floats.  The results are the same as
+ * from piglit_half_from_float(), which is used when the CPU has no
+ * faster way.
+ */
+void
+piglit_half_from_float_array(const float *in, unsigned count,
+			     unsigned short *out)
+{
+	unsigned i = 0;
+
+#ifdef PIGLIT_HAS_X86_TARGET_ATTRIBUTE
+	if (piglit_cpu_has_f16c())
+		i = half_from_float_f16c(in, count, out);
+#endif
+
+	for (; i < count; i++)
+		out[i] = piglit_half_from_float(in[i]);
+}
+
+/**
+ * Convert \a count half floats to floats.  The results are the same as
+ * from piglit_float_from_half().
+ */
+void
+piglit_float_from_half_array(const unsigned short *in, unsigned count,
+			     float *out)
+{
+	unsigned i = 0;
+
+#ifdef PIGLIT_HAS_X86_TARGET_ATTRIBUTE
+	if (piglit_cpu_has_f16c())
+		i = float_from_half_f16c(in, count, out);
+#endif
+
+	for (; i < count; i++)
+		out[i] = piglit_float_from_half(in[i]);
+}
+
 int
 piglit_probe_rect_halves_equal_rgba(int x, int y, int w, int h)
 {
@@ -449,6 +595,7 @@ piglit_get_compressed_block_size(GLenum format,
 	case GL_COMPRESSED_SIGNED_RED_RGTC1:
 	case GL_COMPRESSED_LUMINANCE_LATC1_EXT:
 	case GL_COMPRESSED_SIGNED_LUMINANCE_LATC1_EXT:
+	case GL_ETC1_RGB8_OES:
 		*bw = *bh = 4;
 		*bytes = 8;
 		return true;
@@ -1021,6 +1168,509 @@ piglit_read_pixels_float(GLint x, GLint y, GLsizei width, GLsizei height,
 	return pixels;
 }
 
+/**
+ * -1 until piglit_set_gpu_probe() is called.
+ */
+static int gpu_probe = -1;
+
+/** Number of probes the GPU comparison has decided. */
+static unsigned gpu_probe_count;
+
+/**
+ * Make the rectangle and image probes compare on the GPU, and read back
+ * only the outcome, if the GL implementation can.  PIGLIT_GPU_PROBE=0 or 1
+ * in the environment overrides this.
+ *
+ * Only when the comparison finds a mismatch are the pixels read back, to
+ * compare them again on the CPU and report the first one that differs.
+ */
+void
+piglit_set_gpu_probe(bool enable)
+{
+	gpu_probe = enable;
+}
+
+/**
+ * Return how many probes so far compared the pixels on the GPU, whether
+ * they matched or not, rather than only reading them back.
+ */
+unsigned
+piglit_get_gpu_probe_count(void)
+{
+	return gpu_probe_count;
+}
+
+#ifdef PIGLIT_USE_OPENGL
+
+/**
+ * Regions smaller than this many pixels are cheaper to read back than to
+ * compare on the GPU.
+ */
+#define GPU_PROBE_MIN_PIXELS (64 * 64)
+
+static const char gpu_probe_source[] =
+	"#version 430\n"
+	"layout(local_size_x = 8, local_size_y = 8) in;\n"
+	"\n"
+	"uniform sampler2D observed;\n"
+	"uniform ivec2 size;\n"
+	"uniform int components;\n"
+	"uniform bool per_pixel;\n"
+	"uniform vec4 expected_color;\n"
+	"uniform vec4 tolerance;\n"
+	"\n"
+	"layout(std430, binding = 0) buffer outcome {\n"
+	"	uint matches;\n"
+	"	uint mismatches;\n"
+	"	uint first;\n"
+	"	uint max_error;\n"
+	"};\n"
+	"layout(std430, binding = 1) buffer expected_image {\n"
+	"	float expected[];\n"
+	"};\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	ivec2 p = ivec2(gl_GlobalInvocationID.xy);\n"
+	"	int i = (p.y * size.x + p.x) * components;\n"
+	"	vec4 e = expected_color;\n"
+	"	vec4 diff;\n"
+	"	bvec4 bad;\n"
+	"\n"
+	"	if (any(greaterThanEqual(p, size)))\n"
+	"		return;\n"
+	"\n"
+	"	if (per_pixel) {\n"
+	"		e = vec4(expected[i], expected[i + 1], expected[i + 2],\n"
+	"			 components == 4 ? expected[i + 3] : 0.0);\n"
+	"	}\n"
+	"	diff = abs(texelFetch(observed, p, 0) - e);\n"
+	"	if (components == 3)\n"
+	"		diff.w = 0.0;\n"
+	"\n"
+	"	bad = greaterThanEqual(diff, tolerance);\n"
+	"	if (components == 3)\n"
+	"		bad.w = false;\n"
+	"	if (any(bad)) {\n"
+	"		atomicAdd(mismatches, 1u);\n"
+	"		atomicMin(first, uint(p.y * size.x + p.x));\n"
+	"	} else {\n"
+	"		atomicAdd(matches, 1u);\n"
+	"	}\n"
+	"	atomicMax(max_error, floatBitsToUint(max(max(diff.x, diff.y),\n"
+	"						 max(diff.z, diff.w))));\n"
+	"}\n";
+
+static bool
+use_gpu_probe(int w, int h)
+{
+	static bool once = true;
+	static int env_value = -1;
+
+	if (once) {
+		const char *env = getenv("PIGLIT_GPU_PROBE");
+
+		once = false;
+		if (env && !streq(env, ""))
+			env_value = atoi(env) != 0;
+	}
+
+	if ((env_value >= 0 ? env_value : gpu_probe) <= 0)
+		return false;
+
+	return w * h >= GPU_PROBE_MIN_PIXELS &&
+	       piglit_get_gl_version() >= 43;
+}
+
+/**
+ * Whether \a prog names the comparison program in the current context.
+ * The name may have been cached in another context, where the current
+ * one has a different program, or none, under it.
+ */
+static bool
+is_gpu_probe_program(GLuint prog)
+{
+	GLint ok, size[3];
+
+	if (prog == 0 || !glIsProgram(prog))
+		return false;
+
+	glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+	if (!ok ||
+	    glGetProgramResourceIndex(prog, GL_SHADER_STORAGE_BLOCK,
+				      "outcome") == GL_INVALID_INDEX ||
+	    glGetProgramResourceIndex(prog, GL_SHADER_STORAGE_BLOCK,
+				      "expected_image") == GL_INVALID_INDEX)
+		return false;
+
+	/* This is an error for a program without a compute shader. */
+	glGetProgramiv(prog, GL_COMPUTE_WORK_GROUP_SIZE, size);
+	if (glGetError() != GL_NO_ERROR)
+		return false;
+	return size[0] == 8 && size[1] == 8 && size[2] == 1;
+}
+
+/**
+ * Return the comparison program, or 0 if it doesn't build.  It's built
+ * once, and built again if the current context doesn't have it.
+ */
+static GLuint
+gpu_probe_program(void)
+{
+	static GLuint prog = 0;
+	const char *source = gpu_probe_source;
+	GLuint shader;
+	GLint ok;
+
+	if (is_gpu_probe_program(prog))
+		return prog;
+
+	shader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok) {
+		glDeleteShader(shader);
+		return prog = 0;
+	}
+
+	prog = glCreateProgram();
+	glAttachShader(prog, shader);
+	glLinkProgram(prog);
+	glDeleteShader(shader);
+	glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+	if (!ok) {
+		glDeleteProgram(prog);
+		return prog = 0;
+	}
+	return prog;
+}
+
+/**
+ * Whether the color buffer glReadPixels would read can be blitted to a
+ * floating-point texture: it must exist, be single-sampled and not hold
+ * integers.
+ */
+static bool
+can_blit_read_buffer(void)
+{
+	GLint read_fb, draw_fb, read_buffer, type, samples;
+
+	glGetIntegerv(GL_READ_BUFFER, &read_buffer);
+	if (read_buffer == GL_NONE ||
+	    glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) !=
+	    GL_FRAMEBUFFER_COMPLETE)
+		return false;
+
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &read_fb);
+	if (read_fb != 0) {
+		glGetFramebufferAttachmentParameteriv(
+			GL_READ_FRAMEBUFFER, read_buffer,
+			GL_FRAMEBUFFER_ATTACHMENT_COMPONENT_TYPE, &type);
+		if (type == GL_INT || type == GL_UNSIGNED_INT)
+			return false;
+	}
+
+	/* GL_SAMPLES describes the draw framebuffer. */
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &draw_fb);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, read_fb);
+	glGetIntegerv(GL_SAMPLES, &samples);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw_fb);
+
+	return samples == 0;
+}
+
+/**
+ * Whether the scales and biases \a scales and \a biases, four of each,
+ * leave colors unchanged.
+ */
+static bool
+scale_bias_is_identity(const GLenum *scales, const GLenum *biases)
+{
+	GLfloat value;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		glGetFloatv(scales[i], &value);
+		if (value != 1.0)
+			return false;
+		glGetFloatv(biases[i], &value);
+		if (value != 0.0)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Whether none of the imaging subset's pixel operations is set up to
+ * change what glReadPixels returns.
+ */
+static bool
+imaging_is_idle(void)
+{
+	static const GLenum enables[] = {
+		GL_COLOR_TABLE, GL_CONVOLUTION_1D, GL_CONVOLUTION_2D,
+		GL_SEPARABLE_2D, GL_POST_CONVOLUTION_COLOR_TABLE,
+		GL_POST_COLOR_MATRIX_COLOR_TABLE, GL_HISTOGRAM, GL_MINMAX
+	};
+	static const GLenum convolution_scales[] = {
+		GL_POST_CONVOLUTION_RED_SCALE, GL_POST_CONVOLUTION_GREEN_SCALE,
+		GL_POST_CONVOLUTION_BLUE_SCALE, GL_POST_CONVOLUTION_ALPHA_SCALE
+	};
+	static const GLenum convolution_biases[] = {
+		GL_POST_CONVOLUTION_RED_BIAS, GL_POST_CONVOLUTION_GREEN_BIAS,
+		GL_POST_CONVOLUTION_BLUE_BIAS, GL_POST_CONVOLUTION_ALPHA_BIAS
+	};
+	static const GLenum color_matrix_scales[] = {
+		GL_POST_COLOR_MATRIX_RED_SCALE,
+		GL_POST_COLOR_MATRIX_GREEN_SCALE,
+		GL_POST_COLOR_MATRIX_BLUE_SCALE,
+		GL_POST_COLOR_MATRIX_ALPHA_SCALE
+	};
+	static const GLenum color_matrix_biases[] = {
+		GL_POST_COLOR_MATRIX_RED_BIAS,
+		GL_POST_COLOR_MATRIX_GREEN_BIAS,
+		GL_POST_COLOR_MATRIX_BLUE_BIAS,
+		GL_POST_COLOR_MATRIX_ALPHA_BIAS
+	};
+	GLfloat matrix[16];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(enables); i++) {
+		if (glIsEnabled(enables[i]))
+			return false;
+	}
+
+	glGetFloatv(GL_COLOR_MATRIX, matrix);
+	for (i = 0; i < 16; i++) {
+		if (matrix[i] != (i % 5 == 0 ? 1.0 : 0.0))
+			return false;
+	}
+
+	return scale_bias_is_identity(convolution_scales,
+				      convolution_biases) &&
+	       scale_bias_is_identity(color_matrix_scales,
+				      color_matrix_biases);
+}
+
+/**
+ * Whether glReadPixels would return the color buffer's values unchanged,
+ * as the blit copies them: no clamping beyond that of fixed-point
+ * buffers, and in compatibility profiles no scale, bias, color maps or
+ * enabled imaging subset operations.
+ */
+static bool
+read_pixels_is_plain(void)
+{
+	static const GLenum scales[] = {
+		GL_RED_SCALE, GL_GREEN_SCALE, GL_BLUE_SCALE, GL_ALPHA_SCALE
+	};
+	static const GLenum biases[] = {
+		GL_RED_BIAS, GL_GREEN_BIAS, GL_BLUE_BIAS, GL_ALPHA_BIAS
+	};
+	GLint clamp;
+	GLboolean map_color;
+
+	glGetIntegerv(GL_CLAMP_READ_COLOR, &clamp);
+	if (clamp != GL_FIXED_ONLY)
+		return false;
+
+	if (piglit_is_core_profile)
+		return true;
+
+	glGetBooleanv(GL_MAP_COLOR, &map_color);
+	if (map_color || !scale_bias_is_identity(scales, biases))
+		return false;
+
+	return !piglit_is_extension_supported("GL_ARB_imaging") ||
+	       imaging_is_idle();
+}
+
+/**
+ * Compare the w x h pixels at (x, y) of the read framebuffer on the GPU,
+ * with either the color \a expected, or the image \a expected_image of
+ * \a components floats per pixel.
+ *
+ * Return true only if the comparison ran and every pixel matched.  All GL
+ * state it touches is restored.
+ */
+static bool
+gpu_probe_rect(int x, int y, int w, int h, int components,
+	       const float *tolerance, const float *expected,
+	       const float *expected_image)
+{
+	static const GLuint initial_outcome[4] = { 0, 0, ~0u, 0 };
+	GLint prev_prog, prev_draw_fb, prev_active_texture, prev_texture;
+	GLint prev_sampler, prev_ssbo, prev_ssbo_index[2];
+	GLint64 prev_ssbo_start[2], prev_ssbo_size[2];
+	GLboolean prev_scissor, prev_srgb;
+	GLuint prog, fb, tex, buffers[2];
+	GLuint outcome[4];
+	GLenum error;
+	float max_error;
+	float color[4] = { 0, 0, 0, 0 };
+	float tol[4] = { 0, 0, 0, 0 };
+	int64_t start;
+	int i;
+
+	if (!use_gpu_probe(w, h) || deferred_gl_error != GL_NO_ERROR)
+		return false;
+
+	/* Any error raised from here on is the probe's, so one the test
+	 * hasn't checked yet is kept for it.
+	 */
+	error = glGetError();
+	if (error != GL_NO_ERROR) {
+		deferred_gl_error = error;
+		return false;
+	}
+
+	if (glIsEnabled(GL_RASTERIZER_DISCARD) || !read_pixels_is_plain() ||
+	    !can_blit_read_buffer())
+		return false;
+
+	prog = gpu_probe_program();
+	if (prog == 0)
+		return false;
+
+	start = piglit_get_microseconds();
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &prev_prog);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &prev_draw_fb);
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &prev_active_texture);
+	glActiveTexture(GL_TEXTURE0);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &prev_texture);
+	glGetIntegerv(GL_SAMPLER_BINDING, &prev_sampler);
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &prev_ssbo);
+	for (i = 0; i < 2; i++) {
+		glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, i,
+				&prev_ssbo_index[i]);
+		glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_START, i,
+				  &prev_ssbo_start[i]);
+		glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_SIZE, i,
+				  &prev_ssbo_size[i]);
+	}
+	prev_scissor = glIsEnabled(GL_SCISSOR_TEST);
+	prev_srgb = glIsEnabled(GL_FRAMEBUFFER_SRGB);
+
+	/* Copy the pixels as glReadPixels would see them: the scissor
+	 * test and sRGB encoding don't apply to it.
+	 */
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glBindSampler(0, 0);
+	glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, w, h);
+	glGenFramebuffers(1, &fb);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			       GL_TEXTURE_2D, tex, 0);
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_FRAMEBUFFER_SRGB);
+	glBlitFramebuffer(x, y, x + w, y + h, 0, 0, w, h,
+			  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	glGenBuffers(2, buffers);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffers[0]);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(initial_outcome),
+		     initial_outcome, GL_STREAM_READ);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, buffers[1]);
+	if (expected_image) {
+		glBufferData(GL_SHADER_STORAGE_BUFFER,
+			     (size_t) w * h * components * sizeof(float),
+			     expected_image, GL_STREAM_DRAW);
+	} else {
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float), NULL,
+			     GL_STREAM_DRAW);
+		memcpy(color, expected, components * sizeof(float));
+	}
+	memcpy(tol, tolerance, components * sizeof(float));
+
+	glUseProgram(prog);
+	glUniform1i(glGetUniformLocation(prog, "observed"), 0);
+	glUniform2i(glGetUniformLocation(prog, "size"), w, h);
+	glUniform1i(glGetUniformLocation(prog, "components"), components);
+	glUniform1i(glGetUniformLocation(prog, "per_pixel"),
+		    expected_image != NULL);
+	glUniform4fv(glGetUniformLocation(prog, "expected_color"), 1, color);
+	glUniform4fv(glGetUniformLocation(prog, "tolerance"), 1, tol);
+	glDispatchCompute((w + 7) / 8, (h + 7) / 8, 1);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[0]);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(outcome),
+			   outcome);
+
+	glUseProgram(prev_prog);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, prev_draw_fb);
+	glDeleteFramebuffers(1, &fb);
+	glBindTexture(GL_TEXTURE_2D, prev_texture);
+	glBindSampler(0, prev_sampler);
+	glActiveTexture(prev_active_texture);
+	glDeleteTextures(1, &tex);
+	for (i = 0; i < 2; i++) {
+		if (prev_ssbo_size[i] == 0) {
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, i,
+					 prev_ssbo_index[i]);
+		} else {
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, i,
+					  prev_ssbo_index[i],
+					  prev_ssbo_start[i],
+					  prev_ssbo_size[i]);
+		}
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, prev_ssbo);
+	glDeleteBuffers(2, buffers);
+	if (prev_scissor)
+		glEnable(GL_SCISSOR_TEST);
+	if (prev_srgb)
+		glEnable(GL_FRAMEBUFFER_SRGB);
+
+	/* If anything failed the outcome can't be trusted, and the
+	 * readback path gets to decide.
+	 */
+	error = glGetError();
+	if (error != GL_NO_ERROR) {
+		piglit_logd("GPU probe of %dx%d at (%d,%d) failed with %s",
+			    w, h, x, y, piglit_get_gl_error_name(error));
+		piglit_reset_gl_error();
+		return false;
+	}
+
+	memcpy(&max_error, &outcome[3], sizeof(max_error));
+	if (outcome[1] == 0 && outcome[0] == (GLuint) w * h) {
+		gpu_probe_count++;
+		piglit_logd("GPU probe of %dx%d at (%d,%d): match, "
+			    "max error %f, %.3f ms", w, h, x, y, max_error,
+			    (piglit_get_microseconds() - start) / 1000.0);
+		return true;
+	}
+
+	if (outcome[1] == 0) {
+		piglit_logd("GPU probe of %dx%d at (%d,%d): only %u pixels "
+			    "compared", w, h, x, y, outcome[0]);
+		return false;
+	}
+
+	gpu_probe_count++;
+	piglit_logd("GPU probe of %dx%d at (%d,%d): %u pixels differ, "
+		    "the first at (%d,%d), max error %f", w, h, x, y,
+		    outcome[1], x + (int) (outcome[2] % w),
+		    y + (int) (outcome[2] / w), max_error);
+	return false;
+}
+
+#else
+
+static bool
+gpu_probe_rect(int x, int y, int w, int h, int components,
+	       const float *tolerance, const float *expected,
+	       const float *expected_image)
+{
+	return false;
+}
+
+#endif /* PIGLIT_USE_OPENGL */
+
 int
 piglit_probe_pixel_rgb_silent(int x, int y, const float* expected, float *out_probe)
 {
@@ -1126,6 +1776,9 @@ piglit_probe_rect_rgb_silent(int x, int y, int w, int h, const float *expected)
 	GLfloat *probe;
 	GLfloat *pixels;
 
+	if (gpu_probe_rect(x, y, w, h, 3, piglit_tolerance, expected, NULL))
+		return 1;
+
 	pixels = piglit_read_pixels_float(x, y, w, h, GL_RGB, NULL);
 
 	for (j = 0; j < h; j++) {
@@ -1152,6 +1805,9 @@ piglit_probe_rect_rgb(int x, int y, int w, int h, const float *expected)
 	GLfloat *probe;
 	GLfloat *pixels;
 
+	if (gpu_probe_rect(x, y, w, h, 3, piglit_tolerance, expected, NULL))
+		return 1;
+
 	pixels = piglit_read_pixels_float(x, y, w, h, GL_RGB, NULL);
 
 	for (j = 0; j < h; j++) {
@@ -1184,6 +1840,9 @@ piglit_probe_rect_rgba(int x, int y, int w, int h, const float *expected)
 	GLfloat *probe;
 	GLfloat *pixels;
 
+	if (gpu_probe_rect(x, y, w, h, 4, piglit_tolerance, expected, NULL))
+		return 1;
+
 	pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA, NULL);
 
 	for (j = 0; j < h; j++) {
@@ -1209,6 +1868,48 @@ piglit_probe_rect_rgba(int x, int y, int w, int h, const float *expected)
 	return 1;
 }
 
+/**
+ * Like piglit_probe_rect_rgba(), but check every pixel and report each
+ * one that differs, rather than stopping at the first.  Useful where
+ * each pixel holds the outcome of a separate test.
+ */
+int
+piglit_probe_rect_rgba_each(int x, int y, int w, int h, const float *expected)
+{
+	int i, j, p;
+	GLfloat *probe;
+	GLfloat *pixels;
+	int pass = 1;
+
+	if (gpu_probe_rect(x, y, w, h, 4, piglit_tolerance, expected, NULL))
+		return 1;
+
+	pixels = piglit_read_pixels_float(x, y, w, h, GL_RGBA, NULL);
+
+	for (j = 0; j < h; j++) {
+		for (i = 0; i < w; i++) {
+			probe = &pixels[(j*w+i)*4];
+
+			for (p = 0; p < 4; ++p) {
+				if (fabs(probe[p] - expected[p]) >= piglit_tolerance[p])
+					break;
+			}
+			if (p == 4)
+				continue;
+
+			printf("Probe color at (%i,%i)\n", x+i, y+j);
+			printf("  Expected: %f %f %f %f\n",
+			       expected[0], expected[1], expected[2], expected[3]);
+			printf("  Observed: %f %f %f %f\n",
+			       probe[0], probe[1], probe[2], probe[3]);
+			pass = 0;
+		}
+	}
+
+	free(pixels);
+	return pass;
+}
+
 int
 piglit_probe_rect_rgba_int(int x, int y, int w, int h, const int *expected)
 {
@@ -1372,6 +2073,10 @@ piglit_probe_image_color(int x, int y, int w, int h, GLenum format,
 		format = GL_LUMINANCE;
 	}
 
+	if ((format == GL_RGB || format == GL_RGBA) &&
+	    gpu_probe_rect(x, y, w, h, c, tolerance, NULL, image))
+		return 1;
+
 	pixels = piglit_read_pixels_float(x, y, w, h, format, NULL);
 
 	result = piglit_compare_images_color(x, y, w, h, c, tolerance, image,
@@ -1904,29 +2609,421 @@ piglit_draw_triangle_z(float z, float x1, float y1, float x2, float y2,
 	glDisableClientState(GL_VERTEX_ARRAY);
 }
 
+/*
+ * The texture generators below keep the images they fill, keyed by the
+ * generator and its parameters.  Format-matrix tests ask for the same
+ * images over and over, once per format and mipmap level, and only pay for
+ * filling each of them once this way.  Large images are filled by several
+ * threads.  With PIGLIT_DEBUG=1 every call logs the time it took.
+ */
+
+/** Bytes of images that aren't in use that are kept for reuse. */
+#define IMAGE_CACHE_BUDGET (64 * 1024 * 1024)
+
+/** Images are only filled by several threads if each gets this many bytes. */
+#define PARALLEL_FILL_MIN_BYTES (1024 * 1024)
+#define PARALLEL_FILL_MAX_THREADS 8
+
+#define IMAGE_KEY_MAX_PARAMS 20
+
+struct image_key {
+	/** Name of the image's generator, which gives params their meaning. */
+	const char *generator;
+	int width;
+	int height;
+	/** Size of a texel in bytes. */
+	int texel_size;
+	uint32_t params[IMAGE_KEY_MAX_PARAMS];
+};
+
 /**
- * Generate a checkerboard texture
- *
- * \param tex                Name of the texture to be used.  If \c tex is
- *                           zero, a new texture name will be generated.
- * \param level              Mipmap level the checkerboard should be written to
- * \param width              Width of the texture image
- * \param height             Height of the texture image
- * \param horiz_square_size  Size of each checkerboard tile along the X axis
- * \param vert_square_size   Size of each checkerboard tile along the Y axis
- * \param black              RGBA color to be used for "black" tiles
- * \param white              RGBA color to be used for "white" tiles
- *
- * A texture with alternating black and white squares in a checkerboard
- * pattern is generated.  The texture data is written to LOD \c level of
- * the texture \c tex.
- *
- * If \c tex is zero, a new texture created.  This texture will have several
- * texture parameters set to non-default values:
- *
- *  - Min and mag filter will be set to \c GL_NEAREST.
- *  - For GL:
- *    - S and T wrap modes will be set to \c GL_CLAMP_TO_BORDER.
+ * Fill rows [y0, y1) of the image described by key, which starts at data.
+ */
+typedef void (*image_fill_func)(void *data, const struct image_key *key,
+				int y0, int y1);
+
+struct image_entry {
+	struct image_entry *next;
+	struct image_key key;
+	size_t size;
+	/** Number of acquire_image() calls not yet matched by release_image() */
+	unsigned refs;
+	uint64_t last_use;
+	void *data;
+};
+
+static struct image_entry *image_cache;
+static size_t image_cache_size;
+static uint64_t image_cache_clock;
+
+#ifdef PIGLIT_HAS_PTHREADS
+static pthread_mutex_t image_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void
+image_cache_lock(void)
+{
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_lock(&image_cache_mutex);
+#endif
+}
+
+static void
+image_cache_unlock(void)
+{
+#ifdef PIGLIT_HAS_PTHREADS
+	pthread_mutex_unlock(&image_cache_mutex);
+#endif
+}
+
+static bool
+image_key_equal(const struct image_key *a, const struct image_key *b)
+{
+	return streq(a->generator, b->generator) &&
+	       a->width == b->width &&
+	       a->height == b->height &&
+	       a->texel_size == b->texel_size &&
+	       memcmp(a->params, b->params, sizeof(a->params)) == 0;
+}
+
+/**
+ * Free the least recently used images that aren't in use until the cache
+ * is within its budget.  Must be called with the cache locked.
+ */
+static void
+evict_idle_images(void)
+{
+	while (image_cache_size > IMAGE_CACHE_BUDGET) {
+		struct image_entry **lru = NULL;
+		struct image_entry **e;
+		struct image_entry *victim;
+
+		for (e = &image_cache; *e != NULL; e = &(*e)->next) {
+			if ((*e)->refs == 0 &&
+			    (lru == NULL || (*e)->last_use < (*lru)->last_use))
+				lru = e;
+		}
+		if (lru == NULL)
+			return;
+
+		victim = *lru;
+		*lru = victim->next;
+		image_cache_size -= victim->size;
+		free(victim->data);
+		free(victim);
+	}
+}
+
+#if defined(PIGLIT_HAS_PTHREADS) && defined(_SC_NPROCESSORS_ONLN)
+struct fill_job {
+	image_fill_func fill;
+	void *data;
+	const struct image_key *key;
+	int y0;
+	int y1;
+};
+
+static void *
+run_fill_job(void *arg)
+{
+	struct fill_job *job = arg;
+
+	job->fill(job->data, job->key, job->y0, job->y1);
+	return NULL;
+}
+#endif
+
+/**
+ * Fill the image, splitting its rows between threads if it is large enough.
+ *
+ * \return the number of threads that filled it
+ */
+static int
+fill_image(void *data, const struct image_key *key, size_t size,
+	   image_fill_func fill)
+{
+#if defined(PIGLIT_HAS_PTHREADS) && defined(_SC_NPROCESSORS_ONLN)
+	struct fill_job jobs[PARALLEL_FILL_MAX_THREADS];
+	pthread_t threads[PARALLEL_FILL_MAX_THREADS];
+	long num_threads = size / PARALLEL_FILL_MIN_BYTES;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int started, i;
+
+	if (num_threads > cpus)
+		num_threads = cpus;
+	if (num_threads > PARALLEL_FILL_MAX_THREADS)
+		num_threads = PARALLEL_FILL_MAX_THREADS;
+	if (num_threads > key->height)
+		num_threads = key->height;
+
+	if (num_threads > 1) {
+		for (i = 0; i < num_threads; i++) {
+			jobs[i].fill = fill;
+			jobs[i].data = data;
+			jobs[i].key = key;
+			jobs[i].y0 = (int64_t) key->height * i / num_threads;
+			jobs[i].y1 = (int64_t) key->height * (i + 1) /
+				     num_threads;
+		}
+
+		/* This thread takes the first band, and any that no thread
+		 * could be started for.
+		 */
+		for (started = 1; started < num_threads; started++) {
+			if (pthread_create(&threads[started], NULL,
+					   run_fill_job, &jobs[started]) != 0)
+				break;
+		}
+		run_fill_job(&jobs[0]);
+		for (i = started; i < num_threads; i++)
+			run_fill_job(&jobs[i]);
+		for (i = 1; i < started; i++)
+			pthread_join(threads[i], NULL);
+
+		return started;
+	}
+#endif
+
+	fill(data, key, 0, key->height);
+	return 1;
+}
+
+/**
+ * Return the image described by key, filling it with fill if it isn't
+ * cached yet.  The image must be handed back to release_image(), and
+ * mustn't be written to.
+ */
+static const void *
+acquire_image(const struct image_key *key, image_fill_func fill)
+{
+	const size_t size = (size_t) key->width * key->height * key->texel_size;
+	struct image_entry *entry;
+	int64_t start;
+	int num_threads;
+
+	image_cache_lock();
+	for (entry = image_cache; entry != NULL; entry = entry->next) {
+		if (image_key_equal(&entry->key, key)) {
+			entry->refs++;
+			entry->last_use = ++image_cache_clock;
+			image_cache_unlock();
+			return entry->data;
+		}
+	}
+	image_cache_unlock();
+
+	entry = calloc(1, sizeof(*entry));
+	entry->data = malloc(size ? size : 1);
+	if (entry->data == NULL) {
+		printf("Out of memory filling a %dx%d %s image\n",
+		       key->width, key->height, key->generator);
+		piglit_report_result(PIGLIT_FAIL);
+	}
+
+	start = piglit_get_microseconds();
+	num_threads = fill_image(entry->data, key, size, fill);
+	piglit_logd("%s: filled %dx%d image in %.3f ms on %d thread(s)",
+		    key->generator, key->width, key->height,
+		    (piglit_get_microseconds() - start) / 1000.0,
+		    num_threads);
+
+	/* Another thread may have filled the same image meanwhile; the
+	 * copies are identical and the spare one is evicted in time.
+	 */
+	image_cache_lock();
+	entry->key = *key;
+	entry->size = size;
+	entry->refs = 1;
+	entry->last_use = ++image_cache_clock;
+	entry->next = image_cache;
+	image_cache = entry;
+	image_cache_size += size;
+	evict_idle_images();
+	image_cache_unlock();
+
+	return entry->data;
+}
+
+static void
+release_image(const void *data)
+{
+	struct image_entry *entry;
+
+	image_cache_lock();
+	for (entry = image_cache; entry != NULL; entry = entry->next) {
+		if (entry->data == data) {
+			assert(entry->refs > 0);
+			entry->refs--;
+			break;
+		}
+	}
+	evict_idle_images();
+	image_cache_unlock();
+}
+
+static void
+log_generator_time(const char *name, int64_t start)
+{
+	piglit_logd("%s: %.3f ms", name,
+		    (piglit_get_microseconds() - start) / 1000.0);
+}
+
+/**
+ * -1 until piglit_set_texture_upload_pbo() is called.
+ */
+static int texture_upload_pbo = -1;
+
+/**
+ * Make the texture generators upload their images through a pixel unpack
+ * buffer, if the GL implementation has them.  PIGLIT_TEXTURE_UPLOAD_PBO=0
+ * or 1 in the environment overrides this.
+ */
+void
+piglit_set_texture_upload_pbo(bool enable)
+{
+	texture_upload_pbo = enable;
+}
+
+static bool
+use_upload_pbo(void)
+{
+	static bool once = true;
+	static int env_value = -1;
+
+	if (once) {
+		const char *env = getenv("PIGLIT_TEXTURE_UPLOAD_PBO");
+
+		once = false;
+		if (env && !streq(env, ""))
+			env_value = atoi(env) != 0;
+	}
+
+	if ((env_value >= 0 ? env_value : texture_upload_pbo) <= 0)
+		return false;
+
+	if (piglit_is_gles())
+		return piglit_get_gl_version() >= 30;
+	return piglit_get_gl_version() >= 21 ||
+	       piglit_is_extension_supported("GL_ARB_pixel_buffer_object");
+}
+
+struct texture_upload {
+	GLuint pbo;
+	GLint prev_binding;
+};
+
+/**
+ * Return what to pass as the pixels of the texture uploads of the size
+ * bytes at data: either data itself, or an offset into a pixel unpack
+ * buffer holding a copy of them.  finish_upload() must follow the uploads.
+ */
+static const void *
+start_upload(struct texture_upload *upload, const void *data, size_t size)
+{
+	upload->pbo = 0;
+	if (!use_upload_pbo())
+		return data;
+
+	glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &upload->prev_binding);
+	glGenBuffers(1, &upload->pbo);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload->pbo);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, data, GL_STREAM_DRAW);
+	return BUFFER_OFFSET(0);
+}
+
+static void
+finish_upload(struct texture_upload *upload)
+{
+	if (upload->pbo == 0)
+		return;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload->prev_binding);
+	glDeleteBuffers(1, &upload->pbo);
+}
+
+static void
+fill_checkerboard(void *data, const struct image_key *key, int y0, int y1)
+{
+	const unsigned horiz_square_size = key->params[0];
+	const unsigned vert_square_size = key->params[1];
+	const void *black = &key->params[2];
+	const void *white = &key->params[6];
+	const size_t row_size = (size_t) key->width * key->texel_size;
+	char *first_row[2] = { NULL, NULL };
+	int x, y;
+
+	for (y = y0; y < y1; y++) {
+		const unsigned row = y / vert_square_size;
+		char *texel = (char *) data + y * row_size;
+
+		/* Rows of the same parity are all alike */
+		if (first_row[row & 1] != NULL) {
+			memcpy(texel, first_row[row & 1], row_size);
+			continue;
+		}
+		first_row[row & 1] = texel;
+
+		for (x = 0; x < key->width; x++) {
+			const unsigned col = x / horiz_square_size;
+
+			memcpy(texel, ((row ^ col) & 1) ? white : black,
+			       key->texel_size);
+			texel += key->texel_size;
+		}
+	}
+}
+
+/**
+ * Fills an image of RGBA float texels, all of color_wheel[params[0]].
+ */
+static void
+fill_solid(void *data, const struct image_key *key, int y0, int y1)
+{
+	const float *color = color_wheel[key->params[0]];
+	GLfloat *texel = (GLfloat *) data + (size_t) y0 * key->width * 4;
+	size_t i;
+
+	for (i = 0; i < (size_t) (y1 - y0) * key->width; i++) {
+		memcpy(texel, color, 4 * sizeof(GLfloat));
+		texel += 4;
+	}
+}
+
+/**
+ * Look up a solid color_wheel image; see fill_solid().
+ */
+static const GLfloat *
+acquire_solid_image(int w, int h, unsigned color)
+{
+	struct image_key key = { "solid", w, h, 4 * sizeof(GLfloat) };
+
+	key.params[0] = color % ARRAY_SIZE(color_wheel);
+	return acquire_image(&key, fill_solid);
+}
+
+/**
+ * Generate a checkerboard texture
+ *
+ * \param tex                Name of the texture to be used.  If \c tex is
+ *                           zero, a new texture name will be generated.
+ * \param level              Mipmap level the checkerboard should be written to
+ * \param width              Width of the texture image
+ * \param height             Height of the texture image
+ * \param horiz_square_size  Size of each checkerboard tile along the X axis
+ * \param vert_square_size   Size of each checkerboard tile along the Y axis
+ * \param black              RGBA color to be used for "black" tiles
+ * \param white              RGBA color to be used for "white" tiles
+ *
+ * A texture with alternating black and white squares in a checkerboard
+ * pattern is generated.  The texture data is written to LOD \c level of
+ * the texture \c tex.
+ *
+ * If \c tex is zero, a new texture created.  This texture will have several
+ * texture parameters set to non-default values:
+ *
+ *  - Min and mag filter will be set to \c GL_NEAREST.
+ *  - For GL:
+ *    - S and T wrap modes will be set to \c GL_CLAMP_TO_BORDER.
  *    - Border color will be set to { 1.0, 0.0, 0.0, 1.0 }.
  *  - For GLES:
  *    - S and T wrap modes will be set to \c GL_CLAMP_TO_EDGE.
@@ -1943,44 +3040,30 @@ piglit_checkerboard_texture(GLuint tex, unsigned level,
 			    const float *black, const float *white)
 {
 	static const GLfloat border_color[4] = { 1.0, 0.0, 0.0, 1.0 };
+	const int64_t start = piglit_get_microseconds();
+	struct image_key key = { "checkerboard", width, height };
+	struct texture_upload upload;
+	const void *tex_data;
 	unsigned i;
-	unsigned j;
-	void *tex_data;
-	char *texel;
-	unsigned pixel_size;
-	GLubyte black_b[4], white_b[4];
-	const void *black_data, *white_data;
 
+	key.params[0] = horiz_square_size;
+	key.params[1] = vert_square_size;
 	if (piglit_is_gles()) {
-		pixel_size = 4 * sizeof(GLubyte);
+		GLubyte black_b[4], white_b[4];
+
+		key.texel_size = 4 * sizeof(GLubyte);
 		for (i = 0; i < 4; i++) {
 			black_b[i] = black[i] * 255;
 			white_b[i] = white[i] * 255;
 		}
-		black_data = black_b;
-		white_data = white_b;
+		memcpy(&key.params[2], black_b, sizeof(black_b));
+		memcpy(&key.params[6], white_b, sizeof(white_b));
 	} else {
-		pixel_size = 4 * sizeof(float);
-		black_data = black;
-		white_data = white;
-	}
-	texel = tex_data = malloc(width * height * pixel_size);
-
-	for (i = 0; i < height; i++) {
-		const unsigned row = i / vert_square_size;
-
-		for (j = 0; j < width; j++) {
-			const unsigned col = j / horiz_square_size;
-
-			if ((row ^ col) & 1) {
-				memcpy(texel, white_data, pixel_size);
-			} else {
-				memcpy(texel, black_data, pixel_size);
-			}
-
-			texel += pixel_size;
-		}
+		key.texel_size = 4 * sizeof(float);
+		memcpy(&key.params[2], black, 4 * sizeof(float));
+		memcpy(&key.params[6], white, 4 * sizeof(float));
 	}
+	tex_data = acquire_image(&key, fill_checkerboard);
 
 	if (tex == 0) {
 		glGenTextures(1, &tex);
@@ -2009,8 +3092,13 @@ piglit_checkerboard_texture(GLuint tex, unsigned level,
 	}
 
 	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA,
-		     piglit_is_gles() ? GL_UNSIGNED_BYTE : GL_FLOAT, tex_data);
+		     piglit_is_gles() ? GL_UNSIGNED_BYTE : GL_FLOAT,
+		     start_upload(&upload, tex_data,
+				  (size_t) width * height * key.texel_size));
+	finish_upload(&upload);
+	release_image(tex_data);
 
+	log_generator_time("piglit_checkerboard_texture", start);
 	return tex;
 }
 
@@ -2020,8 +3108,10 @@ piglit_checkerboard_texture(GLuint tex, unsigned level,
 GLuint
 piglit_miptree_texture()
 {
-	GLfloat *data;
-	int size, i, level;
+	const int64_t start = piglit_get_microseconds();
+	struct texture_upload upload;
+	const GLfloat *data;
+	int size, level;
 	GLuint tex;
 
 	glGenTextures(1, &tex);
@@ -2035,18 +3125,156 @@ piglit_miptree_texture()
 	for (level = 0; level < 4; ++level) {
 		size = 8 >> level;
 
-		data = malloc(size*size*4*sizeof(GLfloat));
-		for (i = 0; i < size * size; ++i) {
-			memcpy(data + 4 * i, color_wheel[level],
-			       4 * sizeof(GLfloat));
-		}
+		data = acquire_solid_image(size, size, level);
 		glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA,
-			     size, size, 0, GL_RGBA, GL_FLOAT, data);
-		free(data);
+			     size, size, 0, GL_RGBA, GL_FLOAT,
+			     start_upload(&upload, data,
+					  size * size * 4 * sizeof(GLfloat)));
+		finish_upload(&upload);
+		release_image(data);
 	}
+
+	log_generator_time("piglit_miptree_texture", start);
 	return tex;
 }
 
+/**
+ * Get the colors of the quadrants of piglit_rgbw_image(): red, green, blue
+ * and white, in that order.
+ */
+static void
+rgbw_colors(float colors[4][4], GLboolean alpha, GLenum basetype)
+{
+	static const float unorm[4][4] = {
+		{1.0, 0.0, 0.0, 0.0},
+		{0.0, 1.0, 0.0, 0.25},
+		{0.0, 0.0, 1.0, 0.5},
+		{1.0, 1.0, 1.0, 1.0},
+	};
+	int i, c;
+
+	for (i = 0; i < 4; i++) {
+		for (c = 0; c < 4; c++) {
+			float value = c == 3 && !alpha ? 1.0 : unorm[i][c];
+
+			switch (basetype) {
+			case GL_UNSIGNED_NORMALIZED:
+				break;
+			case GL_SIGNED_NORMALIZED:
+				value = value * 2 - 1;
+				break;
+			case GL_FLOAT:
+				value = value * 10 - 5;
+				break;
+			default:
+				assert(0);
+			}
+			colors[i][c] = value;
+		}
+	}
+}
+
+/**
+ * Whether piglit_rgbw_image() makes levels of the internal format one
+ * color instead of quadrants.
+ */
+static bool
+is_blocked_compressed_format(GLenum internalFormat)
+{
+	switch (internalFormat) {
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RGB_FXT1_3DFX:
+	case GL_COMPRESSED_RGBA_FXT1_3DFX:
+	case GL_COMPRESSED_RED_RGTC1:
+	case GL_COMPRESSED_SIGNED_RED_RGTC1:
+	case GL_COMPRESSED_RG_RGTC2:
+	case GL_COMPRESSED_SIGNED_RG_RGTC2:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+	case GL_COMPRESSED_RGBA_BPTC_UNORM:
+	case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+	case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+	case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Fills rows of an image of red, green, blue and white quadrants, whose
+ * texels are at the start of params in that order.  If params[16] isn't ~0
+ * the whole image is of the color it indexes instead.
+ */
+static void
+fill_quadrants(void *data, const struct image_key *key, int y0, int y1)
+{
+	const size_t texel_size = key->texel_size;
+	const char *colors = (const char *) key->params;
+	const int w = key->width;
+	int x, y;
+
+	for (y = y0; y < y1; y++) {
+		char *texel = (char *) data + y * w * texel_size;
+		const bool top = y < key->height / 2;
+
+		for (x = 0; x < w; x++) {
+			const bool left = x < w / 2;
+			unsigned color;
+
+			if (key->params[16] != ~0u)
+				color = key->params[16];
+			else if (left && top)
+				color = 0;
+			else if (top)
+				color = 1;
+			else if (left)
+				color = 2;
+			else
+				color = 3;
+
+			memcpy(texel, colors + color * texel_size, texel_size);
+			texel += texel_size;
+		}
+	}
+}
+
+/**
+ * Look up the float image of piglit_rgbw_image().
+ */
+static const GLfloat *
+acquire_rgbw_image(GLenum internalFormat, int w, int h,
+		   GLboolean alpha, GLenum basetype)
+{
+	struct image_key key = { "rgbw", w, h, 4 * sizeof(GLfloat) };
+	float colors[4][4];
+	const int size = w > h ? w : h;
+	unsigned solid = ~0u;
+
+	rgbw_colors(colors, alpha, basetype);
+	memcpy(key.params, colors, sizeof(colors));
+
+	/* For compressed teximages, where the blocking would be problematic,
+	 * the levels of size 4, 2 and 1 are red, green and blue.
+	 */
+	if (is_blocked_compressed_format(internalFormat)) {
+		if (size == 4)
+			solid = 0;
+		else if (size == 2)
+			solid = 1;
+		else if (size == 1)
+			solid = 2;
+	}
+	key.params[16] = solid;
+
+	return acquire_image(&key, fill_quadrants);
+}
+
 /**
  * Generates an image of the given size with quadrants of red, green,
  * blue and white.
@@ -2054,6 +3282,9 @@ piglit_miptree_texture()
  * problematic, we assign the whole layers at w == 4 to red, w == 2 to
  * green, and w == 1 to blue.
  *
+ * The image is copied out of the cache of generated images; use
+ * piglit_rgbw_image_fill() to have it written to a buffer of your own.
+ *
  * \param internalFormat  either GL_RGBA or a specific compressed format
  * \param w  the width in texels
  * \param h  the height in texels
@@ -2065,138 +3296,51 @@ GLfloat *
 piglit_rgbw_image(GLenum internalFormat, int w, int h,
 		  GLboolean alpha, GLenum basetype)
 {
-	float red[4]   = {1.0, 0.0, 0.0, 0.0};
-	float green[4] = {0.0, 1.0, 0.0, 0.25};
-	float blue[4]  = {0.0, 0.0, 1.0, 0.5};
-	float white[4] = {1.0, 1.0, 1.0, 1.0};
-	GLfloat *data;
-	int x, y;
-
-	if (!alpha) {
-		red[3] = 1.0;
-		green[3] = 1.0;
-		blue[3] = 1.0;
-		white[3] = 1.0;
-	}
-
-	switch (basetype) {
-	case GL_UNSIGNED_NORMALIZED:
-		break;
-
-	case GL_SIGNED_NORMALIZED:
-		for (x = 0; x < 4; x++) {
-			red[x] = red[x] * 2 - 1;
-			green[x] = green[x] * 2 - 1;
-			blue[x] = blue[x] * 2 - 1;
-			white[x] = white[x] * 2 - 1;
-		}
-		break;
-
-	case GL_FLOAT:
-		for (x = 0; x < 4; x++) {
-			red[x] = red[x] * 10 - 5;
-			green[x] = green[x] * 10 - 5;
-			blue[x] = blue[x] * 10 - 5;
-			white[x] = white[x] * 10 - 5;
-		}
-		break;
-
-	default:
-		assert(0);
-	}
-
-	data = malloc(w * h * 4 * sizeof(GLfloat));
-
-	for (y = 0; y < h; y++) {
-		for (x = 0; x < w; x++) {
-			const int size = w > h ? w : h;
-			const float *color;
-
-			if (x < w / 2 && y < h / 2)
-				color = red;
-			else if (y < h / 2)
-				color = green;
-			else if (x < w / 2)
-				color = blue;
-			else
-				color = white;
-
-			switch (internalFormat) {
-			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
-			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
-			case GL_COMPRESSED_RGB_FXT1_3DFX:
-			case GL_COMPRESSED_RGBA_FXT1_3DFX:
-			case GL_COMPRESSED_RED_RGTC1:
-			case GL_COMPRESSED_SIGNED_RED_RGTC1:
-			case GL_COMPRESSED_RG_RGTC2:
-			case GL_COMPRESSED_SIGNED_RG_RGTC2:
-			case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
-			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
-			case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
-			case GL_COMPRESSED_RGBA_BPTC_UNORM:
-			case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
-			case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
-			case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
-				if (size == 4)
-					color = red;
-				else if (size == 2)
-					color = green;
-				else if (size == 1)
-					color = blue;
-				break;
-			default:
-				break;
-			}
-
-			memcpy(data + (y * w + x) * 4, color,
-			       4 * sizeof(float));
-		}
-	}
+	GLfloat *data = malloc(w * h * 4 * sizeof(GLfloat));
 
+	piglit_rgbw_image_fill(data, internalFormat, w, h, alpha, basetype);
 	return data;
 }
 
-static GLubyte *
-piglit_rgbw_image_ubyte(int w, int h, GLboolean alpha)
+/**
+ * Like piglit_rgbw_image(), but writes the image to \c data, which must
+ * have room for w * h RGBA float texels.
+ */
+void
+piglit_rgbw_image_fill(GLfloat *data, GLenum internalFormat, int w, int h,
+		       GLboolean alpha, GLenum basetype)
 {
-	GLubyte red[4]   = {255, 0, 0, 0};
-	GLubyte green[4] = {0, 255, 0, 64};
-	GLubyte blue[4]  = {0, 0, 255, 128};
-	GLubyte white[4] = {255, 255, 255, 255};
-	GLubyte *data;
-	int x, y;
+	const int64_t start = piglit_get_microseconds();
+	const GLfloat *image = acquire_rgbw_image(internalFormat, w, h,
+						  alpha, basetype);
 
-	if (!alpha) {
-		red[3] = 255;
-		green[3] = 255;
-		blue[3] = 255;
-		white[3] = 255;
-	}
+	memcpy(data, image, w * h * 4 * sizeof(GLfloat));
+	release_image(image);
 
-	data = malloc(w * h * 4 * sizeof(GLubyte));
+	log_generator_time("piglit_rgbw_image", start);
+}
 
-	for (y = 0; y < h; y++) {
-		for (x = 0; x < w; x++) {
-			const GLubyte *color;
-
-			if (x < w / 2 && y < h / 2)
-				color = red;
-			else if (y < h / 2)
-				color = green;
-			else if (x < w / 2)
-				color = blue;
-			else
-				color = white;
+static const GLubyte *
+acquire_rgbw_image_ubyte(int w, int h, GLboolean alpha)
+{
+	static const GLubyte colors[4][4] = {
+		{255, 0, 0, 0},
+		{0, 255, 0, 64},
+		{0, 0, 255, 128},
+		{255, 255, 255, 255},
+	};
+	struct image_key key = { "rgbw_ubyte", w, h, 4 * sizeof(GLubyte) };
+	GLubyte *params = (GLubyte *) key.params;
+	int i;
 
-			memcpy(data + (y * w + x) * 4, color,
-			       4 * sizeof(GLubyte));
-		}
+	memcpy(params, colors, sizeof(colors));
+	if (!alpha) {
+		for (i = 0; i < 4; i++)
+			params[i * 4 + 3] = 255;
 	}
+	key.params[16] = ~0u;
 
-	return data;
+	return acquire_image(&key, fill_quadrants);
 }
 
 /**
@@ -2211,18 +3355,22 @@ GLuint
 piglit_rgbw_texture(GLenum internalFormat, int w, int h, GLboolean mip,
 		    GLboolean alpha, GLenum basetype)
 {
+	const int64_t start = piglit_get_microseconds();
 	int size, level;
 	GLuint tex;
 	GLenum teximage_type;
+	size_t texel_size;
 
 	switch (basetype) {
 	case GL_UNSIGNED_NORMALIZED:
 	case GL_SIGNED_NORMALIZED:
 	case GL_FLOAT:
 		teximage_type = GL_FLOAT;
+		texel_size = 4 * sizeof(GLfloat);
 		break;
 	case GL_UNSIGNED_BYTE:
 		teximage_type = GL_UNSIGNED_BYTE;
+		texel_size = 4 * sizeof(GLubyte);
 		break;
 	default:
 		assert(0);
@@ -2245,19 +3393,22 @@ piglit_rgbw_texture(GLenum internalFormat, int w, int h, GLboolean mip,
 	}
 
 	for (level = 0, size = w > h ? w : h; size > 0; level++, size >>= 1) {
-		void *data;
+		struct texture_upload upload;
+		const void *data;
 
 		if (teximage_type == GL_UNSIGNED_BYTE)
-			data = piglit_rgbw_image_ubyte(w, h, alpha);
+			data = acquire_rgbw_image_ubyte(w, h, alpha);
 		else
-			data = piglit_rgbw_image(internalFormat, w, h,
-			                         alpha, basetype);
+			data = acquire_rgbw_image(internalFormat, w, h,
+						  alpha, basetype);
 
 		glTexImage2D(GL_TEXTURE_2D, level,
 			     internalFormat,
 			     w, h, 0,
-			     GL_RGBA, teximage_type, data);
-		free(data);
+			     GL_RGBA, teximage_type,
+			     start_upload(&upload, data, w * h * texel_size));
+		finish_upload(&upload);
+		release_image(data);
 
 		if (!mip)
 			break;
@@ -2268,9 +3419,52 @@ piglit_rgbw_texture(GLenum internalFormat, int w, int h, GLboolean mip,
 			h >>= 1;
 	}
 
+	log_generator_time("piglit_rgbw_texture", start);
 	return tex;
 }
 
+enum depth_image_layout {
+	DEPTH_FLOAT,
+	/** GL_FLOAT_32_UNSIGNED_INT_24_8_REV, with stencil 0 */
+	DEPTH_FLOAT_STENCIL,
+	/** GL_UNSIGNED_INT_24_8_EXT, with stencil 0 */
+	DEPTH_UINT_24_8,
+};
+
+/**
+ * Fills rows of the depth gradient of piglit_depth_texture(), laid out as
+ * params[0], a depth_image_layout, says.
+ */
+static void
+fill_depth_gradient(void *data, const struct image_key *key, int y0, int y1)
+{
+	const int w = key->width;
+	const size_t row_size = (size_t) w * key->texel_size;
+	char *first_row = (char *) data + y0 * row_size;
+	int x, y;
+
+	/* Every row is the same gradient */
+	for (x = 0; x < w; x++) {
+		float val = (float)(x) / (w - 1);
+
+		switch (key->params[0]) {
+		case DEPTH_FLOAT:
+			((float *) first_row)[x] = val;
+			break;
+		case DEPTH_FLOAT_STENCIL:
+			((float *) first_row)[x * 2] = val;
+			((uint32_t *) first_row)[x * 2 + 1] = 0;
+			break;
+		case DEPTH_UINT_24_8:
+			((unsigned int *) first_row)[x] = 0xffffff00 * val;
+			break;
+		}
+	}
+
+	for (y = y0 + 1; y < y1; y++)
+		memcpy((char *) data + y * row_size, first_row, row_size);
+}
+
 /**
  * Create a depth texture.  The depth texture will be a gradient which varies
  * from 0.0 at the left side to 1.0 at the right side.  For a 2D array texture,
@@ -2287,10 +3481,9 @@ piglit_rgbw_texture(GLenum internalFormat, int w, int h, GLboolean mip,
 GLuint
 piglit_depth_texture(GLenum target, GLenum internalformat, int w, int h, int d, GLboolean mip)
 {
-	void *data;
-	float *f = NULL, *f2 = NULL;
-	unsigned int  *i = NULL;
-	int size, x, y, level, layer;
+	const int64_t start = piglit_get_microseconds();
+	struct image_key key = { "depth_gradient" };
+	int size, level, layer;
 	GLuint tex;
 	GLenum type, format;
 
@@ -2309,42 +3502,43 @@ piglit_depth_texture(GLenum target, GLenum internalformat, int w, int h, int d,
 		glTexParameteri(target, GL_TEXTURE_MIN_FILTER,
 				GL_NEAREST);
 	}
-	data = malloc(w * h * 4 * sizeof(GLfloat));
 
 	if (internalformat == GL_DEPTH_STENCIL_EXT ||
 	    internalformat == GL_DEPTH24_STENCIL8_EXT) {
 		format = GL_DEPTH_STENCIL_EXT;
 		type = GL_UNSIGNED_INT_24_8_EXT;
-		i = data;
+		key.params[0] = DEPTH_UINT_24_8;
+		key.texel_size = sizeof(GLuint);
 	} else if (internalformat == GL_DEPTH32F_STENCIL8) {
 		format = GL_DEPTH_STENCIL;
 		type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
-		f2 = data;
+		key.params[0] = DEPTH_FLOAT_STENCIL;
+		key.texel_size = 2 * sizeof(GLuint);
 	} else {
 		format = GL_DEPTH_COMPONENT;
 		type = GL_FLOAT;
-		f = data;
+		key.params[0] = DEPTH_FLOAT;
+		key.texel_size = sizeof(GLfloat);
 	}
 
 	for (level = 0, size = w > h ? w : h; size > 0; level++, size >>= 1) {
-		for (y = 0; y < h; y++) {
-			for (x = 0; x < w; x++) {
-				float val = (float)(x) / (w - 1);
-				if (f)
-					f[y * w + x] = val;
-				else if (f2)
-					f2[(y * w + x)*2] = val;
-				else
-					i[y * w + x] = 0xffffff00 * val;
-			}
-		}
+		struct texture_upload upload;
+		const void *data;
+		const void *pixels;
+
+		key.width = w;
+		key.height = h;
+		data = acquire_image(&key, fill_depth_gradient);
 
 		switch (target) {
 		case GL_TEXTURE_1D:
 			glTexImage1D(target, level,
 				     internalformat,
 				     w, 0,
-				     format, type, data);
+				     format, type,
+				     start_upload(&upload, data,
+						  w * key.texel_size));
+			finish_upload(&upload);
 			break;
 
 		case GL_TEXTURE_1D_ARRAY:
@@ -2353,7 +3547,10 @@ piglit_depth_texture(GLenum target, GLenum internalformat, int w, int h, int d,
 			glTexImage2D(target, level,
 				     internalformat,
 				     w, h, 0,
-				     format, type, data);
+				     format, type,
+				     start_upload(&upload, data,
+						  w * h * key.texel_size));
+			finish_upload(&upload);
 			break;
 
 		case GL_TEXTURE_2D_ARRAY:
@@ -2361,16 +3558,20 @@ piglit_depth_texture(GLenum target, GLenum internalformat, int w, int h, int d,
 				     internalformat,
 				     w, h, d, 0,
 				     format, type, NULL);
+			pixels = start_upload(&upload, data,
+					      w * h * key.texel_size);
 			for (layer = 0; layer < d; layer++) {
 				glTexSubImage3D(target, level,
 						0, 0, layer, w, h, 1,
-						format, type, data);
+						format, type, pixels);
 			}
+			finish_upload(&upload);
 			break;
 
 		default:
 			assert(0);
 		}
+		release_image(data);
 
 		if (!mip)
 			break;
@@ -2382,7 +3583,8 @@ piglit_depth_texture(GLenum target, GLenum internalformat, int w, int h, int d,
 		    h > 1)
 			h >>= 1;
 	}
-	free(data);
+
+	log_generator_time("piglit_depth_texture", start);
 	return tex;
 }
 
@@ -2394,8 +3596,8 @@ GLuint
 piglit_array_texture(GLenum target, GLenum internalformat,
 		     int w, int h, int d, GLboolean mip)
 {
-	float *data;
-	int size, i, level, layer;
+	const int64_t start = piglit_get_microseconds();
+	int size, level, layer;
 	GLuint tex;
 	GLenum type = GL_FLOAT, format = GL_RGBA;
 
@@ -2421,7 +3623,6 @@ piglit_array_texture(GLenum target, GLenum internalformat,
 		glTexParameteri(target, GL_TEXTURE_MIN_FILTER,
 				GL_NEAREST);
 	}
-	data = malloc(w * h * 4 * sizeof(GLfloat));
 
 	size = w > h ? w : h;
 
@@ -2439,23 +3640,24 @@ piglit_array_texture(GLenum target, GLenum internalformat,
 
 		for (layer = 0; layer < d; layer++) {
 			/* Set whole layer to one color */
-			for (i = 0; i < w * h; i++) {
-				memcpy(data + 4 * i,
-				       color_wheel[layer %
-						   ARRAY_SIZE(color_wheel)],
-				       sizeof(color_wheel[0]));
-			}
+			const GLfloat *data = acquire_solid_image(w, h, layer);
+			struct texture_upload upload;
+			const void *pixels =
+				start_upload(&upload, data,
+					     w * h * 4 * sizeof(GLfloat));
 
 			if (target == GL_TEXTURE_1D_ARRAY) {
 				glTexSubImage2D(target, level,
 						0, layer, w, 1,
-						format, type, data);
+						format, type, pixels);
 			}
 			else {
 				glTexSubImage3D(target, level,
 						0, 0, layer, w, h, 1,
-						format, type, data);
+						format, type, pixels);
 			}
+			finish_upload(&upload);
+			release_image(data);
 		}
 
 		if (!mip)
@@ -2466,7 +3668,8 @@ piglit_array_texture(GLenum target, GLenum internalformat,
 		if (h > 1)
 			h >>= 1;
 	}
-	free(data);
+
+	log_generator_time("piglit_array_texture", start);
 	return tex;
 }
 
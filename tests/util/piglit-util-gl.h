@@ -129,6 +129,7 @@ int piglit_probe_pixel_rgba(int x, int y, const float* expected);
 int piglit_probe_rect_rgb(int x, int y, int w, int h, const float* expected);
 int piglit_probe_rect_rgb_silent(int x, int y, int w, int h, const float *expected);
 int piglit_probe_rect_rgba(int x, int y, int w, int h, const float* expected);
+int piglit_probe_rect_rgba_each(int x, int y, int w, int h, const float *expected);
 int piglit_probe_rect_rgba_int(int x, int y, int w, int h, const int* expected);
 int piglit_probe_rect_rgba_uint(int x, int y, int w, int h, const unsigned int* expected);
 void piglit_compute_probe_tolerance(GLenum format, float *tolerance);
@@ -157,6 +158,8 @@ int piglit_probe_rect_depth(int x, int y, int w, int h, float expected);
 int piglit_probe_pixel_stencil(int x, int y, unsigned expected);
 int piglit_probe_rect_stencil(int x, int y, int w, int h, unsigned expected);
 int piglit_probe_rect_halves_equal_rgba(int x, int y, int w, int h);
+void piglit_set_gpu_probe(bool enable);
+unsigned piglit_get_gpu_probe_count(void);
 
 bool piglit_probe_buffer(GLuint buf, GLenum target, const char *label,
 			 unsigned n, unsigned num_components,
@@ -179,6 +182,11 @@ GLvoid piglit_draw_rect_back(float x, float y, float w, float h);
 void piglit_draw_rect_from_arrays(const void *verts, const void *tex);
 
 unsigned short piglit_half_from_float(float val);
+float piglit_float_from_half(unsigned short val);
+void piglit_half_from_float_array(const float *in, unsigned count,
+				  unsigned short *out);
+void piglit_float_from_half_array(const unsigned short *in, unsigned count,
+				  float *out);
 
 void piglit_escape_exit_key(unsigned char key, int x, int y);
 
@@ -200,10 +208,13 @@ GLuint piglit_checkerboard_texture(GLuint tex, unsigned level,
 GLuint piglit_miptree_texture(void);
 GLfloat *piglit_rgbw_image(GLenum internalFormat, int w, int h,
                            GLboolean alpha, GLenum basetype);
+void piglit_rgbw_image_fill(GLfloat *data, GLenum internalFormat, int w, int h,
+                            GLboolean alpha, GLenum basetype);
 GLuint piglit_rgbw_texture(GLenum internalFormat, int w, int h, GLboolean mip,
 		    GLboolean alpha, GLenum basetype);
 GLuint piglit_depth_texture(GLenum target, GLenum format, int w, int h, int d, GLboolean mip);
 GLuint piglit_array_texture(GLenum target, GLenum format, int w, int h, int d, GLboolean mip);
+void piglit_set_texture_upload_pbo(bool enable);
 extern float piglit_tolerance[4];
 void piglit_set_tolerance_for_bits(int rbits, int gbits, int bbits, int abits);
 extern void piglit_require_transform_feedback(void);
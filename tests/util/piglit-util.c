@@ -29,9 +29,13 @@
 #endif
 
 #ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/syscall.h>
+#include <sys/wait.h>
 #endif
 
 #include <assert.h>
@@ -64,6 +68,10 @@
 
 #include "piglit-util.h"
 
+#ifdef PIGLIT_HAS_X86_TARGET_ATTRIBUTE
+#include <cpuid.h>
+#endif
+
 
 #ifndef HAVE_ASPRINTF
 
@@ -718,6 +726,384 @@ piglit_find_subtest(const struct piglit_subtest *subtests, const char *name)
 	return NULL;
 }
 
+static enum piglit_result
+run_subtest(const struct piglit_subtest *subtest)
+{
+	const enum piglit_result result = subtest->subtest_func(subtest->data);
+
+	piglit_report_subtest_result(result, "%s", subtest->name);
+	return result;
+}
+
+#ifdef __linux__
+
+/** Default of PIGLIT_SUBTEST_TIMEOUT, in seconds. */
+#define DEFAULT_SUBTEST_TIMEOUT 300
+
+/**
+ * How often, in microseconds, a child that closed its output is checked
+ * for having exited.
+ */
+#define SUBTEST_REAP_INTERVAL 10000
+
+/** A subtest running in a child process. */
+struct subtest_child {
+	const struct piglit_subtest *subtest;
+	pid_t pid;
+	/** Read end of the pipe connected to the child's stdout and stderr. */
+	int fd;
+	/** Whether the child has closed its end of the pipe. */
+	bool eof;
+	/** The child's exit status, once it has been reaped. */
+	int status;
+	int64_t deadline;
+	bool timed_out;
+	char *output;
+	size_t output_size;
+};
+
+static unsigned
+env_unsigned(const char *name, unsigned default_value)
+{
+	const char *s = getenv(name);
+
+	return s && *s ? strtoul(s, NULL, 0) : default_value;
+}
+
+/**
+ * Read the command line of this process, without any -subtest
+ * options, into a NULL-terminated array with room for two more
+ * arguments.
+ */
+static char **
+read_command_line(int *argc)
+{
+	char *buf = NULL, *p;
+	size_t size = 0, cap = 0;
+	char **argv;
+	int fd, n = 0;
+	ssize_t r;
+
+	fd = open("/proc/self/cmdline", O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+
+	do {
+		if (size == cap) {
+			cap = MAX2(2 * cap, 4096);
+			buf = realloc(buf, cap + 1);
+		}
+		r = read(fd, buf + size, cap - size);
+		if (r > 0)
+			size += r;
+	} while (r > 0 || (r < 0 && errno == EINTR));
+	close(fd);
+
+	if (size == 0) {
+		free(buf);
+		return NULL;
+	}
+	buf[size] = '\0';
+
+	argv = malloc((size + 3) * sizeof(char *));
+	for (p = buf; p < buf + size; p += strlen(p) + 1) {
+		if (n > 0 && streq(p, "-subtest")) {
+			p += strlen(p) + 1;
+			continue;
+		}
+		argv[n++] = p;
+	}
+	argv[n] = NULL;
+
+	*argc = n;
+	return argv;
+}
+
+static bool
+spawn_subtest(struct subtest_child *child, char **argv, int argc,
+	      unsigned timeout)
+{
+	int fds[2];
+
+	if (pipe2(fds, O_CLOEXEC) != 0) {
+		piglit_loge("pipe failed: %s", strerror(errno));
+		return false;
+	}
+
+	argv[argc] = "-subtest";
+	argv[argc + 1] = (char *) child->subtest->option;
+	argv[argc + 2] = NULL;
+
+	fflush(stdout);
+	fflush(stderr);
+
+	child->pid = fork();
+	if (child->pid == 0) {
+		dup2(fds[1], STDOUT_FILENO);
+		dup2(fds[1], STDERR_FILENO);
+		unsetenv("PIGLIT_SUBTEST_JOBS");
+		execv("/proc/self/exe", argv);
+		fprintf(stderr, "exec of %s failed: %s\n", argv[0],
+			strerror(errno));
+		_exit(127);
+	}
+
+	close(fds[1]);
+	if (child->pid < 0) {
+		piglit_loge("fork failed: %s", strerror(errno));
+		close(fds[0]);
+		return false;
+	}
+
+	child->fd = fds[0];
+	child->eof = false;
+	child->status = 0;
+	child->deadline = timeout ?
+		piglit_get_microseconds() + timeout * INT64_C(1000000) : -1;
+	child->timed_out = false;
+	child->output = NULL;
+	child->output_size = 0;
+	return true;
+}
+
+/**
+ * Read what is available from the child's output.  Return false at the
+ * end of the output.
+ */
+static bool
+read_subtest_output(struct subtest_child *child)
+{
+	char buf[4096];
+	ssize_t r;
+
+	do {
+		r = read(child->fd, buf, sizeof(buf));
+	} while (r < 0 && errno == EINTR);
+
+	if (r <= 0)
+		return false;
+
+	child->output = realloc(child->output, child->output_size + r + 1);
+	memcpy(child->output + child->output_size, buf, r);
+	child->output_size += r;
+	child->output[child->output_size] = '\0';
+	return true;
+}
+
+static bool
+string_to_result(const char *s, enum piglit_result *result)
+{
+	static const enum piglit_result results[] = {
+		PIGLIT_PASS, PIGLIT_FAIL, PIGLIT_SKIP, PIGLIT_WARN
+	};
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(results); i++) {
+		const char *name = piglit_result_to_string(results[i]);
+
+		if (strncmp(s, name, strlen(name)) == 0 &&
+		    s[strlen(name)] == '"') {
+			*result = results[i];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Return whether the child has exited, reaping it if it has.
+ */
+static bool
+reap_subtest(struct subtest_child *child)
+{
+	pid_t r;
+
+	do {
+		r = waitpid(child->pid, &child->status, WNOHANG);
+	} while (r < 0 && errno == EINTR);
+
+	return r != 0;
+}
+
+/**
+ * Pass on the output of a reaped or timed-out child and report the
+ * result of its subtest.  A child that timed out is killed first.
+ *
+ * The child's own report of the subtest wins over its final result
+ * line.  A child that crashed, timed out or reported nothing fails.
+ */
+static enum piglit_result
+finish_subtest(struct subtest_child *child)
+{
+	const char *name = child->subtest->name;
+	const size_t name_len = strlen(name);
+	enum piglit_result result = PIGLIT_FAIL;
+	bool have_subtest_result = false, have_result = false;
+	char *line, *next;
+	int status;
+
+	if (child->timed_out) {
+		kill(child->pid, SIGKILL);
+		while (waitpid(child->pid, &child->status, 0) < 0 &&
+		       errno == EINTR)
+			;
+	}
+	status = child->status;
+	close(child->fd);
+
+	for (line = child->output; line && *line; line = next) {
+		static const char subtest_prefix[] = "PIGLIT: {\"subtest\": {\"";
+		static const char result_prefix[] = "PIGLIT: {\"result\": \"";
+		const char *s;
+
+		next = strchrnul(line, '\n');
+		if (*next)
+			*next++ = '\0';
+
+		s = line + strlen(subtest_prefix);
+		if (strncmp(line, subtest_prefix, strlen(subtest_prefix)) == 0 &&
+		    strncmp(s, name, name_len) == 0 &&
+		    strncmp(s + name_len, "\" : \"", 5) == 0) {
+			have_subtest_result =
+				string_to_result(s + name_len + 5, &result);
+		} else if (strncmp(line, result_prefix,
+				   strlen(result_prefix)) == 0) {
+			if (!have_subtest_result)
+				have_result = string_to_result(
+					line + strlen(result_prefix), &result);
+		} else {
+			printf("%s\n", line);
+		}
+	}
+	free(child->output);
+
+	if (child->timed_out) {
+		piglit_loge("Subtest \"%s\" timed out", name);
+		result = PIGLIT_FAIL;
+	} else if (WIFSIGNALED(status)) {
+		piglit_loge("Subtest \"%s\" was killed by signal %d",
+			    name, WTERMSIG(status));
+		result = PIGLIT_FAIL;
+	} else if (!have_subtest_result && !have_result) {
+		piglit_loge("Subtest \"%s\" exited without a result", name);
+		result = PIGLIT_FAIL;
+	}
+
+	piglit_report_subtest_result(result, "%s", name);
+	return result;
+}
+
+/**
+ * Run each subtest by executing this test again with just that
+ * subtest selected, at most \a jobs at a time.
+ */
+static bool
+run_subtests_forked(const struct piglit_subtest **subtests,
+		    unsigned num_subtests, unsigned jobs,
+		    enum piglit_result *result)
+{
+	const unsigned timeout = env_unsigned("PIGLIT_SUBTEST_TIMEOUT",
+					      DEFAULT_SUBTEST_TIMEOUT);
+	struct subtest_child *children;
+	struct pollfd *fds;
+	unsigned next = 0, running = 0, i;
+	char **argv;
+	int argc;
+
+	argv = read_command_line(&argc);
+	if (!argv)
+		return false;
+
+	jobs = MIN2(jobs, num_subtests);
+	children = calloc(jobs, sizeof(*children));
+	fds = calloc(jobs, sizeof(*fds));
+
+	while (next < num_subtests || running > 0) {
+		int64_t now, wait = -1;
+
+		while (running < jobs && next < num_subtests) {
+			struct subtest_child *child = &children[running];
+
+			child->subtest = subtests[next++];
+			if (spawn_subtest(child, argv, argc, timeout)) {
+				running++;
+			} else {
+				piglit_report_subtest_result(
+					PIGLIT_FAIL, "%s",
+					child->subtest->name);
+				piglit_merge_result(result, PIGLIT_FAIL);
+			}
+		}
+
+		now = piglit_get_microseconds();
+		for (i = 0; i < running; i++) {
+			/* A child that closed its output may keep running,
+			 * so it is checked on now and then instead.
+			 */
+			fds[i].fd = children[i].eof ? -1 : children[i].fd;
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+			if (children[i].eof &&
+			    (wait < 0 || wait > SUBTEST_REAP_INTERVAL))
+				wait = SUBTEST_REAP_INTERVAL;
+			if (children[i].deadline >= 0) {
+				const int64_t left =
+					MAX2(children[i].deadline - now, 0);
+
+				if (wait < 0 || left < wait)
+					wait = left;
+			}
+		}
+
+		if (running == 0)
+			continue;
+
+		if (poll(fds, running, wait < 0 ? -1 :
+			 (int) MIN2((wait + 999) / 1000, INT32_MAX)) < 0 &&
+		    errno != EINTR) {
+			piglit_loge("poll failed: %s", strerror(errno));
+			piglit_report_result(PIGLIT_FAIL);
+		}
+
+		now = piglit_get_microseconds();
+		for (i = 0; i < running; ) {
+			struct subtest_child *child = &children[i];
+			bool done = false;
+
+			if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+				child->eof = !read_subtest_output(child);
+			if (child->eof)
+				done = reap_subtest(child);
+			if (!done && child->deadline >= 0 &&
+			    now >= child->deadline)
+				child->timed_out = done = true;
+
+			if (!done) {
+				i++;
+				continue;
+			}
+
+			piglit_merge_result(result, finish_subtest(child));
+
+			/* Keep the running children, and their poll
+			 * results, at the front of the arrays.
+			 */
+			running--;
+			children[i] = children[running];
+			fds[i] = fds[running];
+		}
+	}
+
+	free(fds);
+	free(children);
+	free(argv[0]);
+	free(argv);
+	return true;
+}
+
+#endif /* __linux__ */
+
 enum piglit_result
 piglit_run_selected_subtests(const struct piglit_subtest *all_subtests,
 			     const char **selected_subtests,
@@ -725,12 +1111,14 @@ piglit_run_selected_subtests(const struct piglit_subtest *all_subtests,
 			     enum piglit_result previous_result)
 {
 	enum piglit_result result = previous_result;
+	const struct piglit_subtest **subtests;
+	unsigned num_subtests = 0;
+	unsigned i;
 
 	if (num_selected_subtests) {
-		unsigned i;
+		subtests = malloc(num_selected_subtests * sizeof(*subtests));
 
 		for (i = 0; i < num_selected_subtests; i++) {
-			enum piglit_result subtest_result;
 			const char *const name = selected_subtests[i];
 			const struct piglit_subtest *subtest =
 				piglit_find_subtest(all_subtests, name);
@@ -740,25 +1128,34 @@ piglit_run_selected_subtests(const struct piglit_subtest *all_subtests,
 				piglit_report_result(PIGLIT_FAIL);
 			}
 
-			subtest_result = subtest->subtest_func(subtest->data);
-			piglit_report_subtest_result(subtest_result, "%s",
-						     subtest->name);
-
-			piglit_merge_result(&result, subtest_result);
+			subtests[num_subtests++] = subtest;
 		}
 	} else {
-		unsigned i;
+		while (!PIGLIT_SUBTEST_END(&all_subtests[num_subtests]))
+			num_subtests++;
 
-		for (i = 0; !PIGLIT_SUBTEST_END(&all_subtests[i]); i++) {
-			const enum piglit_result subtest_result =
-				all_subtests[i].subtest_func(all_subtests[i].data);
-			piglit_report_subtest_result(subtest_result, "%s",
-						     all_subtests[i].name);
+		subtests = malloc(MAX2(num_subtests, 1) * sizeof(*subtests));
+		for (i = 0; i < num_subtests; i++)
+			subtests[i] = &all_subtests[i];
+	}
 
-			piglit_merge_result(&result, subtest_result);
+#ifdef __linux__
+	{
+		const unsigned jobs = env_unsigned("PIGLIT_SUBTEST_JOBS", 0);
+
+		if (jobs > 0 && num_subtests > 1 &&
+		    run_subtests_forked(subtests, num_subtests, jobs,
+					&result)) {
+			free(subtests);
+			return result;
 		}
 	}
+#endif
+
+	for (i = 0; i < num_subtests; i++)
+		piglit_merge_result(&result, run_subtest(subtests[i]));
 
+	free(subtests);
 	return result;
 }
 
@@ -771,3 +1168,32 @@ piglit_gettid(void)
 	return 0;
 #endif
 }
+
+bool
+piglit_cpu_has_f16c(void)
+{
+#ifdef PIGLIT_HAS_X86_TARGET_ATTRIBUTE
+	static int has_f16c = -1;
+
+	if (has_f16c < 0) {
+		unsigned eax, ebx, ecx, edx;
+		unsigned xcr0_lo, xcr0_hi;
+
+		has_f16c = 0;
+		if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+		    (ecx & bit_F16C) && (ecx & bit_OSXSAVE)) {
+			/* XGETBV, spelled out for old assemblers.  Bits 1
+			 * and 2 of XCR0 say the OS saves the SSE and AVX
+			 * state.
+			 */
+			__asm__ (".byte 0x0f, 0x01, 0xd0"
+				 : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+			has_f16c = (xcr0_lo & 0x6) == 0x6;
+		}
+	}
+
+	return has_f16c;
+#else
+	return false;
+#endif
+}
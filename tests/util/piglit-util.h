@@ -161,6 +161,18 @@ struct piglit_subtest {
 const struct piglit_subtest*
 piglit_find_subtest(const struct piglit_subtest *subtests, const char *name);
 
+/**
+ * Run the subtests named in \a selected_subtests, or all of them if
+ * there are none, report each result and return them merged with
+ * \a previous_result.
+ *
+ * If the environment variable PIGLIT_SUBTEST_JOBS is set to N > 0 (on
+ * Linux), each subtest is instead run by executing the test again with
+ * only that subtest selected, N at a time.  Every subtest then gets its
+ * own process and context, so a crash or hang only fails that subtest.
+ * A subtest still running after PIGLIT_SUBTEST_TIMEOUT seconds (default
+ * 300, 0 for none) is killed.
+ */
 enum piglit_result
 piglit_run_selected_subtests(const struct piglit_subtest *all_subtests,
 			     const char **selected_subtests,
@@ -281,6 +293,29 @@ piglit_parse_subtest_args(int *argc, char *argv[],
 uint64_t
 piglit_gettid(void);
 
+/**
+ * Defined when functions can be compiled for x86 instruction set
+ * extensions that the build as a whole doesn't target, by means of
+ * __attribute__((target)).  Such functions may only be called after
+ * checking that the CPU supports the extension.
+ */
+#if (defined(__i386__) || defined(__x86_64__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || \
+     (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define PIGLIT_HAS_X86_TARGET_ATTRIBUTE
+#endif
+
+/**
+ * \brief Return true if the CPU has the F16C half-float conversion
+ * instructions.
+ *
+ * This also checks that the OS saves the AVX register state, which the
+ * VEX-encoded F16C instructions need.  Always false when
+ * PIGLIT_HAS_X86_TARGET_ATTRIBUTE isn't defined.
+ */
+bool
+piglit_cpu_has_f16c(void);
+
 #ifdef __cplusplus
 } /* end extern "C" */
 #endif
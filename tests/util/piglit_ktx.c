@@ -26,6 +26,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "config.h"
+#if defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYS_STAT_H) && defined(HAVE_FCNTL_H) && defined(HAVE_UNISTD_H) && !defined(_WIN32)
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+# define USE_MMAP
+#endif
+
 #include "piglit_ktx.h"
 #include "piglit-util-gl.h"
 
@@ -68,12 +77,38 @@ struct piglit_ktx {
 	/** \brief The raw KTX data. */
 	void *data;
 
+	/**
+	 * \brief Length of the mapping if \c data was obtained with mmap().
+	 *
+	 * If 0, then \c data was obtained with malloc().
+	 */
+	size_t mapped_size;
+
 	/**
 	 * \brief Array of images.
 	 *
-	 * Array length is piglit_ktx_info::num_images.
+	 * Array length is piglit_ktx_info::num_images. The images are parsed
+	 * lazily, in order, as they are requested; only the first
+	 * \c num_parsed_images elements are valid.
 	 */
 	struct piglit_ktx_image *images;
+
+	/** \brief Number of valid elements in \c images. */
+	uint32_t num_parsed_images;
+
+	/**
+	 * \name State of the lazy image parser.
+	 * \{
+	 *
+	 * \c parse_offset is the byte offset in \c data of the next unparsed
+	 * miplevel's imageSize field. The parse_pixel_* fields are the size,
+	 * as passed to glTexImage(), of that miplevel.
+	 */
+	size_t parse_offset;
+	uint32_t parse_pixel_width;
+	uint32_t parse_pixel_height;
+	uint32_t parse_pixel_depth;
+	/** \} */
 };
 
 static void
@@ -99,6 +134,11 @@ piglit_ktx_destroy(struct piglit_ktx *self)
 	if (self->images != NULL)
 		free(self->images);
 
+#ifdef USE_MMAP
+	if (self->mapped_size != 0)
+		munmap(self->data, self->mapped_size);
+	else
+#endif
 	if (self->data)
 		free(self->data);
 
@@ -286,129 +326,174 @@ piglit_ktx_calc_base_image_size(struct piglit_ktx *self,
 	}
 }
 
+/**
+ * \brief Prepare the lazy image parser.
+ *
+ * No image data is accessed here. The images are parsed on demand by
+ * piglit_ktx_parse_images_until().
+ */
+static bool
+piglit_ktx_begin_parse_images(struct piglit_ktx *self)
+{
+	self->images = calloc(self->info.num_images, sizeof(*self->images));
+	if (self->images == NULL) {
+		piglit_ktx_error("%s", "out of memory");
+		return false;
+	}
+
+	self->num_parsed_images = 0;
+	self->parse_offset = piglit_ktx_header_length;
+
+	piglit_ktx_calc_base_image_size(self,
+					&self->parse_pixel_width,
+					&self->parse_pixel_height,
+					&self->parse_pixel_depth);
+	return true;
+}
+
+/**
+ * \brief Parse the image, or the six cube faces, of the next miplevel.
+ *
+ * On failure none of the miplevel's images count as parsed, so that asking
+ * for any of them again fails again.
+ */
 static bool
-piglit_ktx_parse_images(struct piglit_ktx *self)
+piglit_ktx_parse_next_miplevel(struct piglit_ktx *self)
 {
 	struct piglit_ktx_info *info = &self->info;
+	const uint8_t *data = self->data;
 
-	/* Current image being parsed. */
-	struct piglit_ktx_image *image;
+	const uint32_t first_image = self->num_parsed_images;
+	const size_t first_offset = self->parse_offset;
+	const uint32_t first_width = self->parse_pixel_width;
+	const uint32_t first_height = self->parse_pixel_height;
+	const uint32_t first_depth = self->parse_pixel_depth;
 
-	/*
-	 * Current byte being parsed. Used to traverse data with a step of
-	 * either 8 or 32 bits.
-	 */
-	union piglit_ktx_position {
-		uint8_t *u8;
-		uint32_t *u32;
-	} p;
-
-	/* Size of image, as passed to glTexImage(). */
-	uint32_t pixel_width;
-	uint32_t pixel_height;
-	uint32_t pixel_depth;
-
-	/* Loop counters */
-	int miplevel;
+	uint32_t miplevel;
+	uint32_t image_size;
+	int num_faces;
 	int face;
 
-	piglit_ktx_calc_base_image_size(self,
-					&pixel_width,
-					&pixel_height,
-					&pixel_depth);
+	if (info->target == GL_TEXTURE_CUBE_MAP) {
+		miplevel = self->num_parsed_images / 6;
+		num_faces = 6;
+	} else {
+		miplevel = self->num_parsed_images;
+		num_faces = 1;
+	}
 
-	self->images = calloc(info->num_images, sizeof(*self->images));
+	assert(miplevel < info->num_miplevels);
 
-	/* Skip header. */
-	p.u8 = self->data;
-	p.u8 += piglit_ktx_header_length;
+	if (info->size < self->parse_offset + 4) {
+		/*
+		 * Reading the image size below would access
+		 * out-of-bounds memory.
+		 */
+		piglit_ktx_error("size of data stream must be at "
+				 "least %zu", self->parse_offset + 4);
+		return false;
+	}
 
-	/* Begin parsing first image. */
-	image = &self->images[0];
+	memcpy(&image_size, data + self->parse_offset, 4);
+	self->parse_offset += 4;
 
-#define CUR_SIZE (p.u8 - (uint8_t *) self->data)
+	for (face = 0; face < num_faces; ++face) {
+		struct piglit_ktx_image *image =
+			&self->images[self->num_parsed_images];
 
-	for (miplevel = 0; miplevel < info->num_miplevels; ++miplevel) {
-		uint32_t image_size;
+		assert(self->num_parsed_images < info->num_images);
 
-		if (info->size < CUR_SIZE + 1) {
+		if (self->parse_offset > info->size ||
+		    info->size - self->parse_offset < image_size) {
 			/*
-			 * Reading the image size below would access
-			 * out-of-bounds memory.
+			 * The image's data lies, at least partially, in
+			 * out-of-bounds memory. The previous face's padding
+			 * may already lie there.
 			 */
 			piglit_ktx_error("size of data stream must be at "
-					 "least %u", CUR_SIZE + 1);
-			return false;
+					 "least %zu",
+					 self->parse_offset + image_size);
+			goto fail;
 		}
 
-		image_size = *p.u32;
-		++p.u32;
-
-		for (face = 0; face < 6; ++face) {
-			assert(image - self->images < info->num_images);
-
-			image->data = p.u8;
-			image->size = image_size;
-			image->miplevel = miplevel;
-			image->face = face;
-			image->pixel_width = pixel_width;
-			image->pixel_height = pixel_height;
-			image->pixel_depth = pixel_depth;
+		image->data = data + self->parse_offset;
+		image->size = image_size;
+		image->miplevel = miplevel;
+		image->face = face;
+		image->pixel_width = self->parse_pixel_width;
+		image->pixel_height = self->parse_pixel_height;
+		image->pixel_depth = self->parse_pixel_depth;
 
-			p.u8 += image_size;
-			++image;
+		self->parse_offset += image_size;
+		++self->num_parsed_images;
 
-			/* Padding */
-			while (CUR_SIZE % 4 != 0)
-				++p.u8;
+		/* Padding */
+		while (self->parse_offset % 4 != 0)
+			++self->parse_offset;
+	}
 
-			if (info->target != GL_TEXTURE_CUBE_MAP)
-				break;
-		}
+	switch (info->target) {
+		case GL_TEXTURE_3D:
+			minify(&self->parse_pixel_width);
+			minify(&self->parse_pixel_height);
+			minify(&self->parse_pixel_depth);
+			break;
+		case GL_TEXTURE_2D:
+		case GL_TEXTURE_2D_ARRAY:
+		case GL_TEXTURE_CUBE_MAP:
+		case GL_TEXTURE_CUBE_MAP_ARRAY:
+			minify(&self->parse_pixel_width);
+			minify(&self->parse_pixel_height);
+			break;
+		case GL_TEXTURE_1D:
+		case GL_TEXTURE_1D_ARRAY:
+			minify(&self->parse_pixel_width);
+			break;
+		default:
+			assert(0);
+			break;
+	}
 
-		switch (info->target) {
-			case GL_TEXTURE_3D:
-				minify(&pixel_width);
-				minify(&pixel_height);
-				minify(&pixel_depth);
-				break;
-			case GL_TEXTURE_2D:
-			case GL_TEXTURE_2D_ARRAY:
-			case GL_TEXTURE_CUBE_MAP:
-			case GL_TEXTURE_CUBE_MAP_ARRAY:
-				minify(&pixel_width);
-				minify(&pixel_height);
-				break;
-			case GL_TEXTURE_1D:
-			case GL_TEXTURE_1D_ARRAY:
-				minify(&pixel_width);
-				break;
-			default:
-				assert(0);
-				break;
+	if (self->num_parsed_images == info->num_images) {
+		if (info->size < self->parse_offset) {
+			/* The final padding lies in out-of-bounds memory. */
+			piglit_ktx_error("size of data stream must be at "
+					 "least %zu", self->parse_offset);
+			goto fail;
 		}
-	}
 
-	if (info->size < CUR_SIZE) {
 		/*
-		 * The last image's data lies, at least partially, in
-		 * out-of-bounds memory.
+		 * Up until now, info->size was an upper bound on the data
+		 * size. Now the actual data size is known.
 		 */
-		piglit_ktx_error("size of data stream must be at least %zd",
-				 CUR_SIZE);
-		return false;
+		info->size = self->parse_offset;
 	}
 
+	return true;
 
-	/*
-	 * Up until now, info->size was an upper bound on the data size. Now
-	 * the actual data size is known.
-	 */
-	info->size = CUR_SIZE;
+fail:
+	self->num_parsed_images = first_image;
+	self->parse_offset = first_offset;
+	self->parse_pixel_width = first_width;
+	self->parse_pixel_height = first_height;
+	self->parse_pixel_depth = first_depth;
+	return false;
+}
 
-	return true;
+/**
+ * \brief Ensure that the first \a num_images images have been parsed.
+ */
+static bool
+piglit_ktx_parse_images_until(struct piglit_ktx *self, uint32_t num_images)
+{
+	assert(num_images <= self->info.num_images);
+
+	while (self->num_parsed_images < num_images) {
+		if (!piglit_ktx_parse_next_miplevel(self))
+			return false;
+	}
 
-#undef CUR_SIZE
+	return true;
 }
 
 static bool
@@ -417,7 +502,7 @@ piglit_ktx_parse_data(struct piglit_ktx *self)
 	bool ok = true;
 
 	ok = ok && piglit_ktx_parse_header(self);
-	ok = ok && piglit_ktx_parse_images(self);
+	ok = ok && piglit_ktx_begin_parse_images(self);
 
 	return ok;
 }
@@ -427,16 +512,48 @@ piglit_ktx_read_file(const char *filename)
 {
 	struct piglit_ktx *self;
 
+#ifdef USE_MMAP
+	int fd = -1;
+	struct stat st;
+#else
 	FILE *file = NULL;
 	size_t size_read = 0;
+	int error = 0;
+#endif
 
 	bool ok = true;
-	int error = 0;
 
 	self = calloc(1, sizeof(*self));
 	if (self == NULL)
 		goto out_of_memory;
 
+#ifdef USE_MMAP
+	fd = open(filename, O_RDONLY);
+	if (fd == -1)
+		goto bad_open;
+
+	if (fstat(fd, &st) != 0)
+		goto bad_read;
+	self->info.size = st.st_size;
+
+	/*
+	 * Map the file rather than copy it. Pages are faulted in only when
+	 * an image is parsed or uploaded, so the cost of loading a texture is
+	 * proportional to the miplevels actually used.
+	 *
+	 * An empty file cannot be mapped. Leave self->data null and let
+	 * piglit_ktx_parse_header() report the short data.
+	 */
+	if (self->info.size > 0) {
+		self->data = mmap(NULL, self->info.size, PROT_READ,
+				  MAP_PRIVATE, fd, 0);
+		if (self->data == MAP_FAILED) {
+			self->data = NULL;
+			goto bad_read;
+		}
+		self->mapped_size = self->info.size;
+	}
+#else
 	file = fopen(filename, "rb");
 	if (file == NULL)
 		goto bad_open;
@@ -453,13 +570,10 @@ piglit_ktx_read_file(const char *filename)
 	if (self->data == NULL)
 		goto out_of_memory;
 
-	/*
-	 * On Unix, one should mmap() here rather than copy. But this code
-	 * needs to support Windows too.
-	 */
 	size_read = fread(self->data, 1, self->info.size, file);
 	if (size_read < self->info.size)
 		goto bad_read;
+#endif
 
 	ok = piglit_ktx_parse_data(self);
 	goto end;
@@ -480,8 +594,13 @@ bad_read:
 	goto end;
 
 end:
+#ifdef USE_MMAP
+	if (fd != -1)
+		close(fd);
+#else
 	if (file != NULL)
 		fclose(file);
+#endif
 
 	if (!ok) {
 		piglit_ktx_destroy(self);
@@ -491,8 +610,63 @@ end:
 	return self;
 }
 
+bool
+piglit_ktx_read_file_info(const char *filename, struct piglit_ktx_info *info)
+{
+	struct piglit_ktx tmp;
+	uint32_t header[16];
+
+	FILE *file = NULL;
+	long file_size;
+	size_t size_read = 0;
+
+	bool ok = true;
+
+	memset(&tmp, 0, sizeof(tmp));
+	tmp.data = header;
+
+	file = fopen(filename, "rb");
+	if (file == NULL)
+		goto bad_open;
+
+	if (fseek(file, 0, SEEK_END) != 0)
+		goto bad_read;
+	file_size = ftell(file);
+	if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0)
+		goto bad_read;
+
+	tmp.info.size = file_size;
+
+	if (tmp.info.size >= piglit_ktx_header_length) {
+		size_read = fread(header, 1, piglit_ktx_header_length, file);
+		if (size_read < piglit_ktx_header_length)
+			goto bad_read;
+	}
+
+	ok = piglit_ktx_parse_header(&tmp);
+	if (ok)
+		*info = tmp.info;
+	goto end;
+
+bad_open:
+	ok = false;
+	piglit_ktx_error("failed to open file: %s", filename);
+	goto end;
+
+bad_read:
+	ok = false;
+	piglit_ktx_error("errors in reading file: %s", filename);
+	goto end;
+
+end:
+	if (file != NULL)
+		fclose(file);
+
+	return ok;
+}
+
 struct piglit_ktx*
-ktx_file_read_bytes(const void *bytes , size_t size)
+piglit_ktx_read_bytes(const void *bytes, size_t size)
 {
 	struct piglit_ktx *self;
 	bool ok = true;
@@ -503,6 +677,13 @@ ktx_file_read_bytes(const void *bytes , size_t size)
 		return NULL;
 	}
 
+	self->data = malloc(size);
+	if (self->data == NULL && size > 0) {
+		piglit_ktx_error("%s", "out of memory");
+		piglit_ktx_destroy(self);
+		return NULL;
+	}
+
 	self->info.size = size;
 	memcpy(self->data, bytes, size);
 
@@ -522,11 +703,14 @@ piglit_ktx_write_file(struct piglit_ktx *self, const char *filename)
 	size_t size_written = 0;
 	bool ok = true;
 
+	if (!piglit_ktx_parse_images_until(self, self->info.num_images))
+		return false;
+
 	file = fopen(filename, "wb");
 	if (file == NULL)
 		goto bad_open;
 
-	size_written = fwrite(self->data, self->info.size, 1, file);
+	size_written = fwrite(self->data, 1, self->info.size, file);
 	if (size_written < self->info.size)
 		goto bad_write;
 
@@ -552,6 +736,9 @@ end:
 bool
 piglit_ktx_write_bytes(struct piglit_ktx *self, void *bytes)
 {
+	if (!piglit_ktx_parse_images_until(self, self->info.num_images))
+		return false;
+
 	memcpy(bytes, self->data, self->info.size);
 	return true;
 }
@@ -562,6 +749,7 @@ piglit_ktx_get_image(struct piglit_ktx *self,
 		     int cube_face)
 {
 	const struct piglit_ktx_info *info = &self->info;
+	int image;
 
 	if (miplevel < 0 || miplevel >= info->num_miplevels) {
 		piglit_ktx_error("bad miplevel %d", miplevel);
@@ -581,14 +769,20 @@ piglit_ktx_get_image(struct piglit_ktx *self,
 	}
 
 	if (info->target == GL_TEXTURE_CUBE_MAP)
-		return &self->images[6 * miplevel + cube_face];
+		image = 6 * miplevel + cube_face;
 	else
-		return &self->images[miplevel];
+		image = miplevel;
+
+	if (!piglit_ktx_parse_images_until(self, image + 1))
+		return NULL;
+
+	return &self->images[image];
 }
 
 static bool
 piglit_ktx_load_cubeface(struct piglit_ktx *self,
                          int image,
+                         const void *data,
                          GLenum *gl_error)
 {
 	const struct piglit_ktx_info *info = &self->info;
@@ -605,7 +799,7 @@ piglit_ktx_load_cubeface(struct piglit_ktx *self,
 				       img->pixel_height,
 				       0 /*border*/,
 				       img->size,
-				       img->data);
+				       data);
 	else
 		glTexImage2D(face,
 			     level,
@@ -615,7 +809,7 @@ piglit_ktx_load_cubeface(struct piglit_ktx *self,
 			     0 /*border*/,
 			     info->gl_format,
 			     info->gl_type,
-			     img->data);
+			     data);
 
 	*gl_error = glGetError();
 	return *gl_error == 0;
@@ -624,6 +818,7 @@ piglit_ktx_load_cubeface(struct piglit_ktx *self,
 static bool
 piglit_ktx_load_noncubeface(struct piglit_ktx *self,
                             int image,
+                            const void *data,
                             GLenum *gl_error)
 {
 	const struct piglit_ktx_info *info = &self->info;
@@ -641,7 +836,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 					       img->pixel_width,
 					       0 /*border*/,
 					       img->size,
-					       img->data);
+					       data);
 		else
 			glTexImage1D(info->target,
 				     level,
@@ -650,7 +845,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 				     0 /*border*/,
 				     info->gl_format,
 				     info->gl_type,
-				     img->data);
+				     data);
 		break;
 	case GL_TEXTURE_1D_ARRAY:
 	case GL_TEXTURE_2D:
@@ -663,7 +858,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 					       img->pixel_height,
 					       0 /*border*/,
 					       img->size,
-					       img->data);
+					       data);
 		else
 			glTexImage2D(info->target,
 				     level,
@@ -673,7 +868,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 				     0 /*border*/,
 				     info->gl_format,
 				     info->gl_type,
-				     img->data);
+				     data);
 		break;
 	case GL_TEXTURE_2D_ARRAY:
 	case GL_TEXTURE_3D:
@@ -689,7 +884,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 					       img->pixel_depth,
 					       0 /*border*/,
 					       img->size,
-					       img->data);
+					       data);
 		else
 			glTexImage3D(info->target,
 				     level,
@@ -700,7 +895,7 @@ piglit_ktx_load_noncubeface(struct piglit_ktx *self,
 				     0 /*border*/,
 				     info->gl_format,
 				     info->gl_type,
-				     img->data);
+				     data);
 		break;
 	default:
 		*gl_error = 0;
@@ -719,15 +914,53 @@ unsupported_on_gles:
 	return false;
 }
 
+/**
+ * \brief Upload one image with glTexImage().
+ *
+ * If \a pbo is non-zero, it is bound to GL_PIXEL_UNPACK_BUFFER and the image
+ * is streamed through it. Otherwise the image is uploaded directly from
+ * piglit_ktx_image::data, which may point into a mapping of the KTX file.
+ */
 static bool
 piglit_ktx_load_image(struct piglit_ktx *self,
                       int image,
+                      GLuint pbo,
                       GLenum *gl_error)
 {
+	const struct piglit_ktx_image *img = &self->images[image];
+	const void *data = img->data;
+
+	if (pbo != 0) {
+		/*
+		 * Respecify the buffer for each image, which orphans the
+		 * previous storage. The driver then need not wait for the
+		 * previous image's upload to complete before accepting this
+		 * one.
+		 */
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, img->size, img->data,
+			     GL_STREAM_DRAW);
+		*gl_error = glGetError();
+		if (*gl_error)
+			return false;
+
+		/* Offset 0 into the bound buffer. */
+		data = NULL;
+	}
+
 	if (self->info.target == GL_TEXTURE_CUBE_MAP)
-		return piglit_ktx_load_cubeface(self, image, gl_error);
+		return piglit_ktx_load_cubeface(self, image, data, gl_error);
+	else
+		return piglit_ktx_load_noncubeface(self, image, data, gl_error);
+}
+
+static bool
+piglit_ktx_has_pixel_unpack_buffer(void)
+{
+	if (piglit_is_gles())
+		return piglit_get_gl_version() >= 30;
 	else
-		return piglit_ktx_load_noncubeface(self, image, gl_error);
+		return piglit_get_gl_version() >= 21 ||
+		       piglit_is_extension_supported("GL_ARB_pixel_buffer_object");
 }
 
 static GLuint
@@ -757,10 +990,11 @@ target_to_texture_binding(GLuint target)
 	return 0;
 }
 
-bool
-piglit_ktx_load_texture(struct piglit_ktx *self,
-			GLuint *tex_name,
-			GLenum *gl_error)
+static bool
+piglit_ktx_load_texture_common(struct piglit_ktx *self,
+			       GLuint *tex_name,
+			       bool streaming,
+			       GLenum *gl_error)
 {
 	const struct piglit_ktx_info *info = &self->info;
 
@@ -783,6 +1017,14 @@ piglit_ktx_load_texture(struct piglit_ktx *self,
 	 */
 	GLint old_unpack_alignment;
 
+	/*
+	 * The pixel unpack buffer used for streaming, and the buffer bound
+	 * to GL_PIXEL_UNPACK_BUFFER before this function call. Both are 0
+	 * if not streaming.
+	 */
+	GLuint pbo = 0;
+	GLint old_pbo = 0;
+
 	bool made_texture = false;
 
 	bool ok = true;
@@ -790,9 +1032,14 @@ piglit_ktx_load_texture(struct piglit_ktx *self,
 
 	assert(tex_name != NULL);
 
+	if (streaming && !piglit_ktx_has_pixel_unpack_buffer())
+		streaming = false;
+
 	glGetIntegerv(target_to_texture_binding(info->target),
 	              &old_bound_tex);
 	glGetIntegerv(GL_UNPACK_ALIGNMENT, &old_unpack_alignment);
+	if (streaming)
+		glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &old_pbo);
 
 	/* Reset GL error state. */
 	while (glGetError())
@@ -812,8 +1059,28 @@ piglit_ktx_load_texture(struct piglit_ktx *self,
 	if (my_gl_error)
 		goto fail;
 
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (streaming) {
+		glGenBuffers(1, &pbo);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+		my_gl_error = glGetError();
+		if (my_gl_error)
+			goto fail;
+	}
+
 	for (i = 0; i < info->num_images; ++i) {
-		ok = piglit_ktx_load_image(self, i, &my_gl_error);
+		/*
+		 * Parse each image just before uploading it, so that with a
+		 * mapped file each page is touched only once.
+		 */
+		ok = piglit_ktx_parse_images_until(self, i + 1);
+		if (!ok) {
+			my_gl_error = GL_NO_ERROR;
+			goto fail;
+		}
+
+		ok = piglit_ktx_load_image(self, i, pbo, &my_gl_error);
 		if (!ok)
 			goto fail;
 	}
@@ -836,11 +1103,35 @@ cleanup:
 	while (glGetError())
 		;;
 
+	if (streaming) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, old_pbo);
+		if (pbo != 0)
+			glDeleteBuffers(1, &pbo);
+	}
+
 	glBindTexture(info->target, old_bound_tex);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, old_unpack_alignment);
 	return ok;
 }
 
+bool
+piglit_ktx_load_texture(struct piglit_ktx *self,
+			GLuint *tex_name,
+			GLenum *gl_error)
+{
+	return piglit_ktx_load_texture_common(self, tex_name, false,
+					      gl_error);
+}
+
+bool
+piglit_ktx_load_texture_streaming(struct piglit_ktx *self,
+				  GLuint *tex_name,
+				  GLenum *gl_error)
+{
+	return piglit_ktx_load_texture_common(self, tex_name, true,
+					      gl_error);
+}
+
 const struct piglit_ktx_info*
 piglit_ktx_get_info(struct piglit_ktx *self)
 {
@@ -46,7 +46,13 @@ extern "C" {
 struct piglit_ktx;
 
 struct piglit_ktx_info {
-	/** \brief Size in bytes of the raw KTX data. */
+	/**
+	 * \brief Size in bytes of the raw KTX data.
+	 *
+	 * Images are parsed lazily. Until every image has been parsed, this
+	 * is the size of the file or byte array that holds the data, which
+	 * is an upper bound on the size of the KTX data.
+	 */
 	size_t size;
 
 	/**
@@ -191,13 +197,30 @@ piglit_ktx_destroy(struct piglit_ktx *self);
 /**
  * \brief Read KTX data from a file.
  *
- * The file is read until EOF.
+ * Where supported, the file is mapped into memory rather than read. On other
+ * platforms, the file is read until EOF.
+ *
+ * Only the header is validated here. Each image is parsed, and its bounds
+ * validated, when it is first requested with piglit_ktx_get_image() or
+ * uploaded with piglit_ktx_load_texture().
  *
- * Return null on error, including I/O error and invalid data.
+ * Return null on error, including I/O error and an invalid header.
  */
 struct piglit_ktx*
 piglit_ktx_read_file(const char *filename);
 
+/**
+ * \brief Read and validate only the header of a KTX file.
+ *
+ * Neither the image data nor the remainder of the file is read. On success,
+ * \a info is filled from the header and piglit_ktx_info::size is the size of
+ * the file.
+ *
+ * Return false on error, including I/O error and an invalid header.
+ */
+bool
+piglit_ktx_read_file_info(const char *filename, struct piglit_ktx_info *info);
+
 /**
  * \brief Read KTX data from a byte array.
  *
@@ -235,6 +258,9 @@ piglit_ktx_get_info(struct piglit_ktx *self);
 /**
  * \brief Get a texture image from a KTX file.
  *
+ * The image, and all images preceding it in the file, are parsed if they
+ * have not been already. Return null if the image lies outside the data.
+ *
  * The given \a miplevel must be in the range `[0,
  * piglit_ktx_info::num_miplevels)`.  For cubemap non-array textures, \a
  * cube_face must be in the range [0, 5].  For all other textures, \a
@@ -265,6 +291,19 @@ piglit_ktx_load_texture(struct piglit_ktx *self,
 			GLuint *tex_name,
 			GLenum *gl_error);
 
+/**
+ * \brief Like piglit_ktx_load_texture(), but stream through a pixel unpack
+ * buffer.
+ *
+ * Each image is copied into a temporary GL_PIXEL_UNPACK_BUFFER before being
+ * passed to glTexImage(). If pixel unpack buffers are unsupported by the
+ * context, this is equivalent to piglit_ktx_load_texture().
+ */
+bool
+piglit_ktx_load_texture_streaming(struct piglit_ktx *self,
+				  GLuint *tex_name,
+				  GLenum *gl_error);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,10 @@
 #include <math.h>
 #include <assert.h>
 
+#if defined(__SSE2__) || defined(PIGLIT_HAS_X86_TARGET_ATTRIBUTE)
+#include <immintrin.h>
+#endif
+
 /*
  * UF10/UF11 packing code based on The OpenGL Programming Guide / 7th Edition, Appendix J,
  * with bugfix from gallium source.
@@ -153,3 +157,166 @@ unsigned float3_to_r11g11b10f(const float rgb[3])
           ((f32_to_uf11(rgb[1]) & 0x7ff) << 11) |
           ((f32_to_uf10(rgb[2]) & 0x3ff) << 22);
 }
+
+/* From the GL_EXT_packed_float spec:
+ *
+ *     "0.0,                      if E == 0 and M == 0,
+ *      2^-14 * (M / 64),         if E == 0 and M != 0,
+ *      2^(E-15) * (1 + M/64),    if 0 < E < 31,
+ *      INF,                      if E == 31 and M == 0, or
+ *      NaN,                      if E == 31 and M != 0,"
+ *
+ * and likewise for 10-bit values with 32 in place of 64.
+ */
+static float uf_to_f32(unsigned val, int mantissa_bits)
+{
+   const unsigned exponent = (val >> mantissa_bits) & 0x1f;
+   const unsigned mantissa = val & ((1 << mantissa_bits) - 1);
+
+   if (exponent == 0)
+      return ldexpf((float) mantissa, -14 - mantissa_bits);
+   else if (exponent == 31)
+      return mantissa ? NAN : INFINITY;
+   else
+      return ldexpf((float) ((1 << mantissa_bits) | mantissa),
+                    (int) exponent - 15 - mantissa_bits);
+}
+
+float uf11_to_f32(unsigned val)
+{
+   return uf_to_f32(val, UF11_EXPONENT_SHIFT);
+}
+
+float uf10_to_f32(unsigned val)
+{
+   return uf_to_f32(val, UF10_EXPONENT_SHIFT);
+}
+
+void r11g11b10f_to_float3(unsigned rgb, float retval[3])
+{
+   retval[0] = uf11_to_f32(rgb & 0x7ff);
+   retval[1] = uf11_to_f32((rgb >> 11) & 0x7ff);
+   retval[2] = uf10_to_f32((rgb >> 22) & 0x3ff);
+}
+
+#ifdef __SSE2__
+static __m128i select_epi32(__m128i mask, __m128i a, __m128i b)
+{
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/* f32_to_uf11() or f32_to_uf10() of four values, following the scalar
+ * code step by step.
+ */
+static __m128i f32_to_uf_sse2(__m128 val, int exponent_shift, float max,
+                              unsigned max_bits)
+{
+   const __m128i bits = _mm_castps_si128(val);
+   const __m128i abs = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+   const __m128i biased_exponent = _mm_srli_epi32(abs, 23);
+   const __m128i mantissa = _mm_and_si128(bits, _mm_set1_epi32(0x007fffff));
+   const __m128i max_exponent = _mm_set1_epi32(UF11_EXPONENT_BITS << exponent_shift);
+   __m128i uf;
+
+   /* Representable value, or 0 if the exponent is too small */
+   uf = _mm_or_si128(_mm_slli_epi32(_mm_sub_epi32(biased_exponent,
+                                                  _mm_set1_epi32(127 - 15)),
+                                    exponent_shift),
+                     _mm_srli_epi32(mantissa, 23 - exponent_shift));
+   uf = _mm_and_si128(uf, _mm_cmpgt_epi32(biased_exponent,
+                                          _mm_set1_epi32(127 - 15)));
+
+   uf = select_epi32(_mm_castps_si128(_mm_cmpgt_ps(val, _mm_set1_ps(max))),
+                     _mm_set1_epi32(max_bits), uf);
+
+   /* Negative values, including -INF, are 0 */
+   uf = _mm_andnot_si128(_mm_srai_epi32(bits, 31), uf);
+
+   uf = select_epi32(_mm_cmpeq_epi32(bits, _mm_set1_epi32(F32_INFINITY)),
+                     max_exponent, uf);
+   uf = select_epi32(_mm_cmpgt_epi32(abs, _mm_set1_epi32(F32_INFINITY)),
+                     _mm_or_si128(max_exponent, _mm_set1_epi32(1)), uf);
+
+   return uf;
+}
+
+static __m128 load_channel(const float *rgb, int c)
+{
+   return _mm_set_ps(rgb[9 + c], rgb[6 + c], rgb[3 + c], rgb[c]);
+}
+
+static void float3_to_r11g11b10f_sse2(const float *rgb, unsigned *retval)
+{
+   const __m128i r = f32_to_uf_sse2(load_channel(rgb, 0), UF11_EXPONENT_SHIFT,
+                                    65024.0f, UF11(30, 63));
+   const __m128i g = f32_to_uf_sse2(load_channel(rgb, 1), UF11_EXPONENT_SHIFT,
+                                    65024.0f, UF11(30, 63));
+   const __m128i b = f32_to_uf_sse2(load_channel(rgb, 2), UF10_EXPONENT_SHIFT,
+                                    64512.0f, UF10(30, 31));
+
+   _mm_storeu_si128((__m128i *) retval,
+                    _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 11)),
+                                 _mm_slli_epi32(b, 22)));
+}
+#endif /* __SSE2__ */
+
+#ifdef PIGLIT_HAS_X86_TARGET_ATTRIBUTE
+/* An 11- or 10-bit float shifted left by 4 or 5 bits is the half float
+ * of the same value, which F16C converts exactly.
+ */
+__attribute__((target("f16c")))
+static __m128 uf_to_f32_f16c(__m128i v, int shift, unsigned mask, int half_shift)
+{
+   const __m128i uf = _mm_and_si128(_mm_srli_epi32(v, shift), _mm_set1_epi32(mask));
+   const __m128i half = _mm_slli_epi32(uf, half_shift);
+
+   return _mm_cvtph_ps(_mm_packs_epi32(half, half));
+}
+
+__attribute__((target("f16c")))
+static void r11g11b10f_to_float3_f16c(const unsigned *rgb, float *retval)
+{
+   const __m128i v = _mm_loadu_si128((const __m128i *) rgb);
+   __m128 r = uf_to_f32_f16c(v, 0, 0x7ff, 4);
+   __m128 g = uf_to_f32_f16c(v, 11, 0x7ff, 4);
+   __m128 b = uf_to_f32_f16c(v, 22, 0x3ff, 5);
+   __m128 unused = _mm_setzero_ps();
+
+   _MM_TRANSPOSE4_PS(r, g, b, unused);
+   _mm_storeu_ps(retval + 0, r);
+   _mm_storeu_ps(retval + 3, g);
+   _mm_storeu_ps(retval + 6, b);
+   _mm_storel_pi((__m64 *) (retval + 9), unused);
+   _mm_store_ss(retval + 11, _mm_movehl_ps(unused, unused));
+}
+#endif /* PIGLIT_HAS_X86_TARGET_ATTRIBUTE */
+
+void float3_to_r11g11b10f_array(const float *rgb, unsigned count,
+                                unsigned *retval)
+{
+   unsigned i = 0;
+
+#ifdef __SSE2__
+   for (; i + 4 <= count; i += 4)
+      float3_to_r11g11b10f_sse2(&rgb[i * 3], &retval[i]);
+#endif
+
+   for (; i < count; i++)
+      retval[i] = float3_to_r11g11b10f(&rgb[i * 3]);
+}
+
+void r11g11b10f_to_float3_array(const unsigned *rgb, unsigned count,
+                                float *retval)
+{
+   unsigned i = 0;
+
+#ifdef PIGLIT_HAS_X86_TARGET_ATTRIBUTE
+   if (piglit_cpu_has_f16c()) {
+      for (; i + 4 <= count; i += 4)
+         r11g11b10f_to_float3_f16c(&rgb[i], &retval[i * 3]);
+   }
+#endif
+
+   for (; i < count; i++)
+      r11g11b10f_to_float3(rgb[i], &retval[i * 3]);
+}
@@ -27,6 +27,10 @@
 #include <math.h>
 #include <assert.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #define MAX2( A, B )   ( (A)>(B) ? (A) : (B) )
 
 /* XXX assuming little endian */
@@ -175,3 +179,138 @@ void rgb9e5_to_float3(unsigned rgb, float retval[3])
    retval[1] = v.field.g * scale;
    retval[2] = v.field.b * scale;
 }
+
+#ifdef __SSE2__
+/* The SSE2 versions below convert four texels at a time and give
+ * bit-identical results to the scalar code: every scaling is by a power
+ * of two, so the only rounding is the explicit one.
+ */
+
+static __m128 load_channel(const float *rgb, int c)
+{
+   return _mm_set_ps(rgb[9 + c], rgb[6 + c], rgb[3 + c], rgb[c]);
+}
+
+/* Store four texels given as a vector per channel. */
+static void store_float3(float *out, __m128 r, __m128 g, __m128 b)
+{
+   __m128 unused = _mm_setzero_ps();
+
+   _MM_TRANSPOSE4_PS(r, g, b, unused);
+   _mm_storeu_ps(out + 0, r);
+   _mm_storeu_ps(out + 3, g);
+   _mm_storeu_ps(out + 6, b);
+   _mm_storel_pi((__m64 *) (out + 9), unused);
+   _mm_store_ss(out + 11, _mm_movehl_ps(unused, unused));
+}
+
+/* floor(x + 0.5) for 0 <= x < 2^31, without the rounding error of
+ * adding 0.5 in single precision.
+ */
+static __m128i round_half_up(__m128 x)
+{
+   const __m128i i = _mm_cvttps_epi32(x);
+   const __m128 frac = _mm_sub_ps(x, _mm_cvtepi32_ps(i));
+
+   return _mm_sub_epi32(i, _mm_castps_si128(_mm_cmpge_ps(frac, _mm_set1_ps(0.5f))));
+}
+
+static __m128i select_epi32(__m128i mask, __m128i a, __m128i b)
+{
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static void float3_to_rgb9e5_sse2(const float *rgb, unsigned *retval)
+{
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 max = _mm_set1_ps(MAX_RGB9E5);
+   const __m128i min_exp = _mm_set1_epi32(-RGB9E5_EXP_BIAS - 1);
+   /* _mm_max_ps returns its second operand for NaN, so this clamps
+    * like ClampRange_for_rgb9e5().
+    */
+   const __m128 rc = _mm_min_ps(_mm_max_ps(load_channel(rgb, 0), zero), max);
+   const __m128 gc = _mm_min_ps(_mm_max_ps(load_channel(rgb, 1), zero), max);
+   const __m128 bc = _mm_min_ps(_mm_max_ps(load_channel(rgb, 2), zero), max);
+   const __m128 maxrgb = _mm_max_ps(_mm_max_ps(rc, gc), bc);
+   __m128i exp_shared, maxm, overflow, packed;
+   __m128 scale;
+
+   exp_shared = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(maxrgb), 23),
+                              _mm_set1_epi32(127));
+   exp_shared = select_epi32(_mm_cmplt_epi32(exp_shared, min_exp),
+                             min_exp, exp_shared);
+   exp_shared = _mm_add_epi32(exp_shared, _mm_set1_epi32(1 + RGB9E5_EXP_BIAS));
+
+   /* scale = 1 / denom, built from its exponent bits */
+   scale = _mm_castsi128_ps(_mm_slli_epi32(
+      _mm_sub_epi32(_mm_set1_epi32(127 + RGB9E5_EXP_BIAS + RGB9E5_MANTISSA_BITS),
+                    exp_shared), 23));
+
+   maxm = round_half_up(_mm_mul_ps(maxrgb, scale));
+   overflow = _mm_cmpeq_epi32(maxm, _mm_set1_epi32(MAX_RGB9E5_MANTISSA + 1));
+   exp_shared = _mm_sub_epi32(exp_shared, overflow);
+   scale = _mm_mul_ps(scale, _mm_castsi128_ps(
+      select_epi32(overflow, _mm_castps_si128(_mm_set1_ps(0.5f)),
+                   _mm_castps_si128(_mm_set1_ps(1.0f)))));
+
+   packed = round_half_up(_mm_mul_ps(rc, scale));
+   packed = _mm_or_si128(packed,
+                         _mm_slli_epi32(round_half_up(_mm_mul_ps(gc, scale)),
+                                        RGB9E5_MANTISSA_BITS));
+   packed = _mm_or_si128(packed,
+                         _mm_slli_epi32(round_half_up(_mm_mul_ps(bc, scale)),
+                                        2 * RGB9E5_MANTISSA_BITS));
+   packed = _mm_or_si128(packed,
+                         _mm_slli_epi32(exp_shared, 3 * RGB9E5_MANTISSA_BITS));
+
+   _mm_storeu_si128((__m128i *) retval, packed);
+}
+
+static void rgb9e5_to_float3_sse2(const unsigned *rgb, float *retval)
+{
+   const __m128i v = _mm_loadu_si128((const __m128i *) rgb);
+   const __m128i mask = _mm_set1_epi32(MAX_RGB9E5_MANTISSA);
+   const __m128i exponent =
+      _mm_add_epi32(_mm_srli_epi32(v, 3 * RGB9E5_MANTISSA_BITS),
+                    _mm_set1_epi32(127 - RGB9E5_EXP_BIAS - RGB9E5_MANTISSA_BITS));
+   const __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(exponent, 23));
+   __m128 r, g, b;
+
+   r = _mm_cvtepi32_ps(_mm_and_si128(v, mask));
+   g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, RGB9E5_MANTISSA_BITS),
+                                     mask));
+   b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 2 * RGB9E5_MANTISSA_BITS),
+                                     mask));
+
+   store_float3(retval, _mm_mul_ps(r, scale), _mm_mul_ps(g, scale),
+                _mm_mul_ps(b, scale));
+}
+#endif /* __SSE2__ */
+
+void float3_to_rgb9e5_array(const float *rgb, unsigned count,
+                            unsigned *retval)
+{
+   unsigned i = 0;
+
+#ifdef __SSE2__
+   for (; i + 4 <= count; i += 4)
+      float3_to_rgb9e5_sse2(&rgb[i * 3], &retval[i]);
+#endif
+
+   for (; i < count; i++)
+      retval[i] = float3_to_rgb9e5(&rgb[i * 3]);
+}
+
+void rgb9e5_to_float3_array(const unsigned *rgb, unsigned count,
+                            float *retval)
+{
+   unsigned i = 0;
+
+#ifdef __SSE2__
+   for (; i + 4 <= count; i += 4)
+      rgb9e5_to_float3_sse2(&rgb[i], &retval[i * 3]);
+#endif
+
+   for (; i < count; i++)
+      rgb9e5_to_float3(rgb[i], &retval[i * 3]);
+}
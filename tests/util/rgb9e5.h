@@ -31,6 +31,14 @@ extern "C" {
 void rgb9e5_to_float3(unsigned rgb, float retval[3]);
 unsigned float3_to_rgb9e5(const float rgb[3]);
 
+/* Convert \a count texels at once, with the same results as the
+ * functions above.
+ */
+void rgb9e5_to_float3_array(const unsigned *rgb, unsigned count,
+                            float *retval);
+void float3_to_rgb9e5_array(const float *rgb, unsigned count,
+                            unsigned *retval);
+
 #ifdef __cplusplus
 }
 #endif